@@ -95,3 +95,13 @@ static inline void od_atomic_u64_set(od_atomic_u64_t *atomic, uint64_t newValue)
 			break;
 	}
 }
+
+static inline void od_atomic_u32_set(od_atomic_u32_t *atomic, uint32_t newValue)
+{
+	for (;;) {
+		uint32_t oldValue = od_atomic_u32_of(atomic);
+
+		if (__sync_bool_compare_and_swap(atomic, oldValue, newValue))
+			break;
+	}
+}
@@ -30,6 +30,7 @@ od_attach_extended_try_endpoint(od_instance_t *instance, char *context,
 
 	od_server_t *server;
 	server = client->server;
+	server->endpoint = endpoint;
 	od_debug(&instance->logger, context, client, server,
 		 "attached to server %s%.*s", server->id.id_prefix,
 		 (int)sizeof(server->id.id), server->id.id);
@@ -58,7 +59,8 @@ int od_attach_extended(od_instance_t *instance, char *context,
 	od_rule_storage_t *storage = client->rule->storage;
 
 	od_endpoint_attach_candidate_t candidates[OD_STORAGE_MAX_ENDPOINTS];
-	od_frontend_attach_init_candidates(instance, storage, candidates,
+	od_frontend_attach_init_candidates(instance, client->route, storage,
+					   candidates,
 					   OD_TARGET_SESSION_ATTRS_ANY,
 					   1 /* prefer localhost */);
 
@@ -429,6 +429,36 @@ static inline int od_auth_frontend_md5(od_client_t *client)
 
 #ifdef POSTGRESQL_FOUND
 
+typedef struct {
+	od_scram_state_t *scram_state;
+	char *password;
+	char *user;
+} od_auth_scram_init_t;
+
+static int od_auth_scram_init_task(void *arg)
+{
+	od_auth_scram_init_t *init = arg;
+	return od_scram_init_from_plain_password(init->scram_state,
+						 init->password, init->user);
+}
+
+typedef struct {
+	od_scram_state_t *scram_state;
+	char *password;
+	char *auth_data;
+	size_t auth_data_size;
+	machine_msg_t *msg;
+} od_auth_scram_final_t;
+
+static int od_auth_scram_final_task(void *arg)
+{
+	od_auth_scram_final_t *final = arg;
+	final->msg = od_scram_create_client_final_message(
+		final->scram_state, final->password, final->auth_data,
+		final->auth_data_size);
+	return final->msg == NULL ? -1 : 0;
+}
+
 static inline int
 od_auth_frontend_scram_sha_256_internal(od_client_t *client,
 					od_scram_state_t *scram_state)
@@ -579,9 +609,16 @@ od_auth_frontend_scram_sha_256_internal(od_client_t *client,
 	}
 
 	rc = od_scram_parse_verifier(scram_state, query_password.password);
-	if (rc == -1)
-		rc = od_scram_init_from_plain_password(scram_state,
-						       query_password.password);
+	if (rc == -1) {
+		/* PBKDF2 runs on the crypto pool */
+		od_auth_scram_init_t init;
+		init.scram_state = scram_state;
+		init.password = query_password.password;
+		init.user = client->startup.user.value;
+		rc = od_crypto_pool_run(&client->global->crypto_pool,
+					OD_CRYPTO_SCRAM_FRONTEND,
+					od_auth_scram_init_task, &init);
+	}
 
 	if (rc == -1) {
 		od_frontend_error(
@@ -710,6 +747,7 @@ static inline int od_auth_frontend_scram_sha_256(od_client_t *client)
 {
 	od_scram_state_t scram_state;
 	od_scram_state_init(&scram_state);
+	scram_state.cache = client->rule->storage->scram_cache;
 
 	int rc = od_auth_frontend_scram_sha_256_internal(client, &scram_state);
 
@@ -865,7 +903,7 @@ static inline int od_auth_backend_cleartext(od_server_t *server,
 		return -1;
 	}
 #ifdef LDAP_FOUND
-	if (client->rule->ldap_storage_credentials_attr) {
+	if (client != NULL && client->rule->ldap_storage_credentials_attr) {
 		password = client->ldap_storage_password;
 		password_len = client->ldap_storage_password_len;
 	}
@@ -932,7 +970,7 @@ static inline int od_auth_backend_md5(od_server_t *server, char salt[4],
 		return -1;
 	}
 #ifdef LDAP_FOUND
-	if (client->rule->ldap_storage_credentials_attr) {
+	if (client != NULL && client->rule->ldap_storage_credentials_attr) {
 		user = client->ldap_storage_username;
 		user_len = client->ldap_storage_username_len;
 		password = client->ldap_storage_password;
@@ -995,8 +1033,8 @@ static inline int od_auth_backend_sasl(od_server_t *server, od_client_t *client)
 		 "requested SASL authentication");
 
 	if (!route->rule->storage_password && !route->rule->password &&
-	    (client == NULL || client->password.password == NULL) &&
-	    client->received_password.password == NULL) {
+	    (client == NULL || (client->password.password == NULL &&
+				client->received_password.password == NULL))) {
 		od_error(&instance->logger, "auth", NULL, server,
 			 "password required for route '%s.%s'",
 			 route->rule->db_name, route->rule->user_name);
@@ -1065,7 +1103,7 @@ static inline int od_auth_backend_sasl_continue(od_server_t *server,
 		return -1;
 	} else if (route->rule->password) {
 		password = route->rule->password;
-	} else if (client->received_password.password) {
+	} else if (client != NULL && client->received_password.password) {
 		password = client->received_password.password;
 	} else {
 		od_error(&instance->logger, "auth", NULL, server,
@@ -1075,7 +1113,7 @@ static inline int od_auth_backend_sasl_continue(od_server_t *server,
 		return -1;
 	}
 #ifdef LDAP_FOUND
-	if (client->rule->ldap_storage_credentials_attr) {
+	if (client != NULL && client->rule->ldap_storage_credentials_attr) {
 		password = client->ldap_storage_password;
 	}
 #endif
@@ -1083,8 +1121,17 @@ static inline int od_auth_backend_sasl_continue(od_server_t *server,
 		 "continue SASL authentication using password %s", password);
 
 	/* SASLResponse Message */
-	machine_msg_t *msg = od_scram_create_client_final_message(
-		&server->scram_state, password, auth_data, auth_data_size);
+	server->scram_state.cache = route->rule->storage->scram_cache;
+	od_auth_scram_final_t final;
+	final.scram_state = &server->scram_state;
+	final.password = password;
+	final.auth_data = auth_data;
+	final.auth_data_size = auth_data_size;
+	final.msg = NULL;
+	od_crypto_pool_run(&od_global_get()->crypto_pool,
+			   OD_CRYPTO_SCRAM_BACKEND, od_auth_scram_final_task,
+			   &final);
+	machine_msg_t *msg = final.msg;
 	if (msg == NULL) {
 		od_error(&instance->logger, "auth", NULL, server,
 			 "malformed SASLResponse message");
@@ -0,0 +1,350 @@
+
+/*
+ * Odyssey.
+ *
+ * Scalable PostgreSQL connection pooler.
+ */
+
+#include <kiwi.h>
+#include <machinarium.h>
+#include <odyssey.h>
+
+#define OD_AUTH_CACHE_DEFAULT_SZ 16
+
+/* waiters recheck entry state at least this often */
+#define OD_AUTH_CACHE_WAIT_MS 1000
+
+od_auth_cache_t *od_auth_cache_create(void)
+{
+	od_auth_cache_t *cache = od_malloc(sizeof(od_auth_cache_t));
+	if (cache == NULL) {
+		return NULL;
+	}
+	memset(cache, 0, sizeof(od_auth_cache_t));
+	cache->size = OD_AUTH_CACHE_DEFAULT_SZ;
+	cache->buckets = od_malloc(sizeof(od_auth_cache_entry_t *) *
+				   cache->size);
+	if (cache->buckets == NULL) {
+		od_free(cache);
+		return NULL;
+	}
+	memset(cache->buckets, 0,
+	       sizeof(od_auth_cache_entry_t *) * cache->size);
+	pthread_mutex_init(&cache->lock, NULL);
+	return cache;
+}
+
+static inline void od_auth_cache_entry_free(od_auth_cache_entry_t *entry)
+{
+	if (entry->passwd) {
+		od_free(entry->passwd);
+	}
+	machine_wait_list_destroy(entry->waiters);
+	od_free(entry);
+}
+
+void od_auth_cache_free(od_auth_cache_t *cache)
+{
+	for (uint32_t i = 0; i < cache->size; i++) {
+		od_auth_cache_entry_t *entry = cache->buckets[i];
+		while (entry) {
+			od_auth_cache_entry_t *next = entry->next;
+			od_auth_cache_entry_free(entry);
+			entry = next;
+		}
+	}
+	pthread_mutex_destroy(&cache->lock);
+	od_free(cache->buckets);
+	od_free(cache);
+}
+
+/* entry is not used by a lookup in progress */
+static inline int od_auth_cache_entry_idle(od_auth_cache_entry_t *entry)
+{
+	return !entry->inflight && entry->waiting == 0;
+}
+
+/*
+ * Drop idle entries, or only expired ones if policy is set. Keeps the
+ * cache from growing with every user name ever tried.
+ * Must be called under cache lock.
+ */
+static void od_auth_cache_prune(od_auth_cache_t *cache,
+				od_auth_cache_policy_t *policy, uint64_t now)
+{
+	for (uint32_t i = 0; i < cache->size; i++) {
+		od_auth_cache_entry_t **prev = &cache->buckets[i];
+		while (*prev) {
+			od_auth_cache_entry_t *entry = *prev;
+			int expired = od_auth_cache_entry_idle(entry);
+			if (expired && policy) {
+				uint64_t age = 0;
+				if (now > entry->timestamp) {
+					age = now - entry->timestamp;
+				}
+				if (entry->state == OD_AUTH_CACHE_PASSWORD) {
+					expired = age >= policy->ttl;
+				} else if (entry->state ==
+					   OD_AUTH_CACHE_NOT_FOUND) {
+					expired = age >= policy->negative_ttl;
+				}
+			}
+			if (!expired) {
+				prev = &entry->next;
+				continue;
+			}
+			*prev = entry->next;
+			od_auth_cache_entry_free(entry);
+			cache->count--;
+		}
+	}
+}
+
+void od_auth_cache_invalidate(od_auth_cache_t *cache)
+{
+	pthread_mutex_lock(&cache->lock);
+	od_auth_cache_prune(cache, NULL, 0);
+	/* entries being looked up now get the result of the new query */
+	for (uint32_t i = 0; i < cache->size; i++) {
+		od_auth_cache_entry_t *entry = cache->buckets[i];
+		for (; entry; entry = entry->next) {
+			if (entry->passwd) {
+				od_free(entry->passwd);
+				entry->passwd = NULL;
+			}
+			entry->passwd_len = 0;
+			entry->state = OD_AUTH_CACHE_EMPTY;
+		}
+	}
+	pthread_mutex_unlock(&cache->lock);
+}
+
+uint32_t od_auth_cache_count(od_auth_cache_t *cache)
+{
+	pthread_mutex_lock(&cache->lock);
+	uint32_t count = cache->count;
+	pthread_mutex_unlock(&cache->lock);
+	return count;
+}
+
+static inline void od_auth_cache_grow(od_auth_cache_t *cache)
+{
+	uint32_t size = cache->size * 2;
+	od_auth_cache_entry_t **buckets;
+	buckets = od_malloc(sizeof(od_auth_cache_entry_t *) * size);
+	if (buckets == NULL) {
+		/* keep longer chains */
+		return;
+	}
+	memset(buckets, 0, sizeof(od_auth_cache_entry_t *) * size);
+	for (uint32_t i = 0; i < cache->size; i++) {
+		od_auth_cache_entry_t *entry = cache->buckets[i];
+		while (entry) {
+			od_auth_cache_entry_t *next = entry->next;
+			uint32_t pos = entry->hash & (size - 1);
+			entry->next = buckets[pos];
+			buckets[pos] = entry;
+			entry = next;
+		}
+	}
+	od_free(cache->buckets);
+	cache->buckets = buckets;
+	cache->size = size;
+}
+
+/*
+ * Find or create user entry, expired entries are dropped before the
+ * table grows.
+ * Must be called under cache lock.
+ */
+static od_auth_cache_entry_t *
+od_auth_cache_lookup(od_auth_cache_t *cache, od_hash_t hash, char *user,
+		     uint32_t user_len, od_auth_cache_policy_t *policy,
+		     uint64_t now)
+{
+	uint32_t pos = hash & (cache->size - 1);
+	od_auth_cache_entry_t *entry = cache->buckets[pos];
+	for (; entry; entry = entry->next) {
+		if (entry->hash == hash && entry->user_len == user_len &&
+		    memcmp(entry->user, user, user_len) == 0) {
+			return entry;
+		}
+	}
+
+	entry = od_malloc(sizeof(od_auth_cache_entry_t) + user_len);
+	if (entry == NULL) {
+		return NULL;
+	}
+	memset(entry, 0, sizeof(od_auth_cache_entry_t));
+	atomic_init(&entry->version, 0);
+	entry->waiters = machine_wait_list_create(&entry->version);
+	if (entry->waiters == NULL) {
+		od_free(entry);
+		return NULL;
+	}
+	entry->hash = hash;
+	entry->state = OD_AUTH_CACHE_EMPTY;
+	entry->user_len = user_len;
+	memcpy(entry->user, user, user_len);
+
+	if (cache->count >= cache->size && policy) {
+		od_auth_cache_prune(cache, policy, now);
+	}
+	if (cache->count >= cache->size) {
+		od_auth_cache_grow(cache);
+	}
+	pos = hash & (cache->size - 1);
+	entry->next = cache->buckets[pos];
+	cache->buckets[pos] = entry;
+	cache->count++;
+	return entry;
+}
+
+static inline int od_auth_cache_copy(od_auth_cache_entry_t *entry,
+				     kiwi_password_t *result)
+{
+	result->password_len = entry->passwd_len;
+	result->password = NULL;
+	if (entry->passwd == NULL) {
+		return OK_RESPONSE;
+	}
+	result->password = od_malloc(entry->passwd_len + 1);
+	if (result->password == NULL) {
+		return NOT_OK_RESPONSE;
+	}
+	memcpy(result->password, entry->passwd, entry->passwd_len);
+	result->password[entry->passwd_len] = 0;
+	return OK_RESPONSE;
+}
+
+od_auth_cache_result_t od_auth_cache_get(od_auth_cache_t *cache, char *user,
+					 uint32_t user_len,
+					 od_auth_cache_policy_t *policy,
+					 uint64_t now, kiwi_password_t *result,
+					 int *refresh)
+{
+	od_hash_t hash = od_murmur_hash(user, user_len);
+	int waited = 0;
+	*refresh = 0;
+
+	for (;;) {
+		pthread_mutex_lock(&cache->lock);
+
+		od_auth_cache_entry_t *entry;
+		entry = od_auth_cache_lookup(cache, hash, user, user_len,
+					     policy, now);
+		if (entry == NULL) {
+			pthread_mutex_unlock(&cache->lock);
+			od_atomic_u64_inc(&cache->errors);
+			return OD_AUTH_CACHE_ERROR;
+		}
+
+		/* timestamp may be set by a machine with a fresher clock */
+		uint64_t age = 0;
+		if (now > entry->timestamp) {
+			age = now - entry->timestamp;
+		}
+
+		if (entry->state == OD_AUTH_CACHE_PASSWORD &&
+		    age < policy->ttl) {
+			int rc = od_auth_cache_copy(entry, result);
+			if (rc == OK_RESPONSE && policy->refresh &&
+			    age >= policy->refresh && !entry->inflight) {
+				/* stale-while-revalidate */
+				entry->inflight = 1;
+				*refresh = 1;
+				od_atomic_u64_inc(&cache->refreshes);
+			}
+			pthread_mutex_unlock(&cache->lock);
+			if (rc != OK_RESPONSE) {
+				od_atomic_u64_inc(&cache->errors);
+				return OD_AUTH_CACHE_ERROR;
+			}
+			od_atomic_u64_inc(&cache->hits);
+			return OD_AUTH_CACHE_HIT;
+		}
+
+		if (entry->state == OD_AUTH_CACHE_NOT_FOUND &&
+		    age < policy->negative_ttl) {
+			pthread_mutex_unlock(&cache->lock);
+			od_atomic_u64_inc(&cache->negative_hits);
+			return OD_AUTH_CACHE_HIT_NOT_FOUND;
+		}
+
+		if (!entry->inflight) {
+			/* become a leader */
+			entry->inflight = 1;
+			pthread_mutex_unlock(&cache->lock);
+			od_atomic_u64_inc(&cache->misses);
+			return OD_AUTH_CACHE_MISS;
+		}
+
+		/* park until leader stores the result,
+		 * entry is not dropped while someone waits on it */
+		uint64_t version = atomic_load(&entry->version);
+		entry->waiting++;
+		pthread_mutex_unlock(&cache->lock);
+
+		if (!waited) {
+			od_atomic_u64_inc(&cache->waits);
+			waited = 1;
+		}
+		machine_wait_list_compare_wait(entry->waiters, version,
+					       OD_AUTH_CACHE_WAIT_MS);
+
+		pthread_mutex_lock(&cache->lock);
+		entry->waiting--;
+		pthread_mutex_unlock(&cache->lock);
+	}
+}
+
+int od_auth_cache_put(od_auth_cache_t *cache, char *user, uint32_t user_len,
+		      od_auth_cache_state_t state, kiwi_password_t *password,
+		      uint64_t now)
+{
+	od_hash_t hash = od_murmur_hash(user, user_len);
+	int rc = OK_RESPONSE;
+
+	pthread_mutex_lock(&cache->lock);
+
+	od_auth_cache_entry_t *entry;
+	entry = od_auth_cache_lookup(cache, hash, user, user_len, NULL, now);
+	if (entry == NULL) {
+		pthread_mutex_unlock(&cache->lock);
+		return NOT_OK_RESPONSE;
+	}
+
+	char *passwd = NULL;
+	if (state == OD_AUTH_CACHE_PASSWORD && password->password != NULL) {
+		passwd = od_malloc(password->password_len);
+		if (passwd == NULL) {
+			state = OD_AUTH_CACHE_EMPTY;
+			rc = NOT_OK_RESPONSE;
+		} else {
+			memcpy(passwd, password->password,
+			       password->password_len);
+		}
+	}
+
+	if (state != OD_AUTH_CACHE_EMPTY) {
+		if (entry->passwd) {
+			od_free(entry->passwd);
+		}
+		entry->passwd = passwd;
+		entry->passwd_len = 0;
+		if (state == OD_AUTH_CACHE_PASSWORD) {
+			entry->passwd_len = password->password_len;
+		}
+		entry->state = state;
+		entry->timestamp = now;
+	}
+
+	entry->inflight = 0;
+	atomic_fetch_add(&entry->version, 1);
+	machine_wait_list_t *waiters = entry->waiters;
+
+	pthread_mutex_unlock(&cache->lock);
+
+	machine_wait_list_notify_all(waiters);
+	return rc;
+}
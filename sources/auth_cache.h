@@ -0,0 +1,98 @@
+#pragma once
+
+/*
+ * Odyssey.
+ *
+ * Scalable PostgreSQL connection pooler.
+ */
+
+/*
+ * auth_query cache.
+ *
+ * Maps user name to the password returned by auth_query. Lookups of
+ * the same user are single-flight: the first coroutine that misses
+ * becomes the leader and runs the query, others park on the entry
+ * wait list until the leader stores the result. The cache lock is
+ * never held across the query itself.
+ *
+ * Expired and negative entries are dropped before the table grows, so
+ * the cache is bounded by the names seen within their ttl.
+ */
+
+typedef struct od_auth_cache_entry od_auth_cache_entry_t;
+typedef struct od_auth_cache od_auth_cache_t;
+
+typedef enum {
+	OD_AUTH_CACHE_EMPTY,
+	OD_AUTH_CACHE_PASSWORD,
+	OD_AUTH_CACHE_NOT_FOUND
+} od_auth_cache_state_t;
+
+typedef enum {
+	/* password copied out */
+	OD_AUTH_CACHE_HIT,
+	/* auth query returned no rows recently */
+	OD_AUTH_CACHE_HIT_NOT_FOUND,
+	/* caller must run auth query and od_auth_cache_put() the result */
+	OD_AUTH_CACHE_MISS,
+	OD_AUTH_CACHE_ERROR
+} od_auth_cache_result_t;
+
+struct od_auth_cache_entry {
+	od_hash_t hash;
+	od_auth_cache_state_t state;
+	uint64_t timestamp;
+	char *passwd;
+	uint32_t passwd_len;
+	int inflight;
+	int waiting;
+	atomic_uint_fast64_t version;
+	machine_wait_list_t *waiters;
+	od_auth_cache_entry_t *next;
+	uint32_t user_len;
+	char user[];
+};
+
+struct od_auth_cache {
+	pthread_mutex_t lock;
+	od_auth_cache_entry_t **buckets;
+	uint32_t size;
+	uint32_t count;
+
+	od_atomic_u64_t hits;
+	od_atomic_u64_t negative_hits;
+	od_atomic_u64_t misses;
+	od_atomic_u64_t waits;
+	od_atomic_u64_t refreshes;
+	od_atomic_u64_t errors;
+};
+
+typedef struct {
+	/* all times are in microseconds, zero disables */
+	uint64_t ttl;
+	uint64_t negative_ttl;
+	uint64_t refresh;
+} od_auth_cache_policy_t;
+
+od_auth_cache_t *od_auth_cache_create(void);
+void od_auth_cache_free(od_auth_cache_t *);
+
+/* drop all cached passwords, e.g. on reload */
+void od_auth_cache_invalidate(od_auth_cache_t *);
+
+/*
+ * Lookup user password. On hit password is copied into result.
+ * If hit is older than policy refresh age, refresh is set and the
+ * caller must update the entry in background and od_auth_cache_put()
+ * it (possibly with OD_AUTH_CACHE_EMPTY on failure).
+ */
+od_auth_cache_result_t od_auth_cache_get(od_auth_cache_t *, char *, uint32_t,
+					 od_auth_cache_policy_t *, uint64_t,
+					 kiwi_password_t *, int *refresh);
+
+/* store lookup result and wake up waiters,
+ * OD_AUTH_CACHE_EMPTY keeps previous value */
+int od_auth_cache_put(od_auth_cache_t *, char *, uint32_t,
+		      od_auth_cache_state_t, kiwi_password_t *, uint64_t);
+
+uint32_t od_auth_cache_count(od_auth_cache_t *);
@@ -96,70 +96,17 @@ error:
 	return NOT_OK_RESPONSE;
 }
 
-int od_auth_query(od_client_t *client, char *peer)
+/*
+ * Run auth query for user on a fresh internal client.
+ * Returns OD_AUTH_QUERY_NOT_FOUND if query returned no rows.
+ */
+static int od_auth_query_do(od_global_t *global, od_rule_t *rule,
+			    od_client_t *client, kiwi_var_t *user, char *peer,
+			    kiwi_password_t *password)
 {
-	od_global_t *global = client->global;
-	od_rule_t *rule = client->rule;
-	od_rule_storage_t *storage = rule->storage;
-	kiwi_var_t *user = &client->startup.user;
-	kiwi_password_t *password = &client->password;
 	od_instance_t *instance = global->instance;
 	od_router_t *router = global->router;
 
-	/* check odyssey storage auh query cache before
-	* doing any actual work
-	*/
-	/* username -> password cache */
-	od_hashmap_elt_t *value;
-	od_hashmap_elt_t key;
-	od_auth_cache_value_t *cache_value;
-	od_hash_t keyhash;
-	uint64_t current_time;
-
-	key.data = user->value;
-	key.len = user->value_len;
-
-	keyhash = od_murmur_hash(key.data, key.len);
-	/* acquire hash map entry lock */
-	value = od_hashmap_lock_key(storage->acache, keyhash, &key);
-
-	if (value->data == NULL) {
-		/* one-time initialize */
-		value->len = sizeof(od_auth_cache_value_t);
-		value->data = od_malloc(value->len);
-		/* OOM */
-		if (value->data == NULL) {
-			goto error;
-		}
-		memset(((od_auth_cache_value_t *)(value->data)), 0, value->len);
-	}
-
-	cache_value = (od_auth_cache_value_t *)value->data;
-
-	current_time = machine_time_us();
-
-	if (/* password cached for 10 sec */
-	    current_time - cache_value->timestamp < 10 * interval_usec) {
-		od_debug(&instance->logger, "auth_query", NULL, NULL,
-			 "reusing cached password for user %.*s",
-			 user->value_len, user->value);
-		/* unlock hashmap entry */
-		password->password_len = cache_value->passwd_len;
-		if (cache_value->passwd_len > 0) {
-			/*  */
-			password->password =
-				od_malloc(password->password_len + 1);
-			if (password->password == NULL) {
-				goto error;
-			}
-			strncpy(password->password, cache_value->passwd,
-				cache_value->passwd_len);
-			password->password[password->password_len] = '\0';
-		}
-		od_hashmap_unlock_key(storage->acache, keyhash, &key);
-		return OK_RESPONSE;
-	}
-
 	/* create internal auth client */
 	od_client_t *auth_client;
 
@@ -168,7 +115,7 @@ int od_auth_query(od_client_t *client, char *peer)
 	if (auth_client == NULL) {
 		od_debug(&instance->logger, "auth_query", auth_client, NULL,
 			 "failed to allocate internal auth query client");
-		goto error;
+		return NOT_OK_RESPONSE;
 	}
 
 	od_debug(&instance->logger, "auth_query", auth_client, NULL,
@@ -182,9 +129,11 @@ int od_auth_query(od_client_t *client, char *peer)
 	kiwi_var_set(&auth_client->startup.database, KIWI_VAR_UNDEF,
 		     rule->auth_query_db, strlen(rule->auth_query_db) + 1);
 
-	/* set io from client */
+	/* set io from client, background refresh has none */
 	od_io_t auth_client_io = auth_client->io;
-	auth_client->io = client->io;
+	if (client) {
+		auth_client->io = client->io;
+	}
 
 	/* route */
 	od_router_status_t status;
@@ -198,7 +147,7 @@ int od_auth_query(od_client_t *client, char *peer)
 			 "failed to route internal auth query client: %s",
 			 od_router_status_to_str(status));
 		od_client_free(auth_client);
-		goto error;
+		return NOT_OK_RESPONSE;
 	}
 
 	int rc;
@@ -206,7 +155,7 @@ int od_auth_query(od_client_t *client, char *peer)
 	if (rc != OK_RESPONSE) {
 		od_router_unroute(router, auth_client);
 		od_client_free_extended(auth_client);
-		goto error;
+		return NOT_OK_RESPONSE;
 	}
 
 	od_server_t *server;
@@ -221,12 +170,19 @@ int od_auth_query(od_client_t *client, char *peer)
 
 	machine_msg_t *msg;
 	msg = od_query_do(server, "auth_query", query, user->value);
+	if (msg == NULL && od_server_synchronized(server)) {
+		/* query completed without rows, server is reusable */
+		od_debug(&instance->logger, "auth_query", auth_client, server,
+			 "auth query returned no rows for user %.*s",
+			 user->value_len, user->value);
+		od_router_detach(router, auth_client);
+		od_router_unroute(router, auth_client);
+		od_client_free_extended(auth_client);
+		return OD_AUTH_QUERY_NOT_FOUND;
+	}
 	if (msg == NULL) {
 		od_log(&instance->logger, "auth_query", auth_client, server,
 		       "auth query returned empty msg");
-		od_router_close(router, auth_client);
-		od_router_unroute(router, auth_client);
-		od_client_free_extended(auth_client);
 		goto error;
 	}
 	rc = od_auth_parse_passwd_from_datarow(&instance->logger, msg,
@@ -235,43 +191,166 @@ int od_auth_query(od_client_t *client, char *peer)
 	if (rc == NOT_OK_RESPONSE) {
 		od_debug(&instance->logger, "auth_query", auth_client, server,
 			 "auth query returned datarow in incompatible format");
-		od_router_close(router, auth_client);
-		od_router_unroute(router, auth_client);
-		od_client_free_extended(auth_client);
 		goto error;
 	}
 
-	/* save received password and receive timestamp */
-	if (cache_value->passwd != NULL) {
-		/* drop previous value */
-		od_free(cache_value->passwd);
-
-		/* there should be cache_value->passwd = NULL for sanity
-		* but this is meaninigless since we assign new value just below
-		*/
-	}
-	cache_value->passwd_len = password->password_len;
-	cache_value->passwd = od_malloc(password->password_len);
-	if (cache_value->passwd == NULL) {
-		od_router_close(router, auth_client);
-		od_router_unroute(router, auth_client);
-		od_client_free_extended(auth_client);
-		goto error;
-	}
-	strncpy(cache_value->passwd, password->password,
-		cache_value->passwd_len);
-
-	cache_value->timestamp = current_time;
-
 	/* detach and unroute */
 	od_router_detach(router, auth_client);
 	od_router_unroute(router, auth_client);
 	od_client_free_extended(auth_client);
-	od_hashmap_unlock_key(storage->acache, keyhash, &key);
 	return OK_RESPONSE;
 
 error:
-	/* unlock hashmap entry */
-	od_hashmap_unlock_key(storage->acache, keyhash, &key);
+	od_router_close(router, auth_client);
+	od_router_unroute(router, auth_client);
+	od_client_free_extended(auth_client);
 	return NOT_OK_RESPONSE;
 }
+
+static inline od_auth_cache_state_t od_auth_query_cache_state(int rc)
+{
+	switch (rc) {
+	case OK_RESPONSE:
+		return OD_AUTH_CACHE_PASSWORD;
+	case OD_AUTH_QUERY_NOT_FOUND:
+		return OD_AUTH_CACHE_NOT_FOUND;
+	default:
+		/* keep previous value on errors */
+		return OD_AUTH_CACHE_EMPTY;
+	}
+}
+
+typedef struct {
+	od_global_t *global;
+	od_rule_t *rule;
+	kiwi_var_t user;
+	char peer[128];
+} od_auth_query_refresh_t;
+
+static void od_auth_query_refresh(void *arg)
+{
+	od_auth_query_refresh_t *refresh = arg;
+	od_global_t *global = refresh->global;
+	od_instance_t *instance = global->instance;
+	od_router_t *router = global->router;
+	od_rule_t *rule = refresh->rule;
+	kiwi_var_t *user = &refresh->user;
+
+	od_debug(&instance->logger, "auth_query", NULL, NULL,
+		 "refreshing cached password for user %.*s", user->value_len,
+		 user->value);
+
+	kiwi_password_t password;
+	kiwi_password_init(&password);
+
+	int rc;
+	rc = od_auth_query_do(global, rule, NULL, user, refresh->peer,
+			      &password);
+	od_auth_cache_put(rule->storage->acache, user->value, user->value_len,
+			  od_auth_query_cache_state(rc), &password,
+			  machine_time_us());
+	kiwi_password_free(&password);
+
+	od_router_lock(router);
+	od_rules_unref(rule);
+	od_router_unlock(router);
+	od_free(refresh);
+}
+
+static inline void od_auth_query_refresh_start(od_global_t *global,
+					       od_rule_t *rule,
+					       kiwi_var_t *user, char *peer)
+{
+	od_instance_t *instance = global->instance;
+	od_auth_query_refresh_t *refresh;
+	refresh = od_malloc(sizeof(od_auth_query_refresh_t));
+	if (refresh == NULL) {
+		goto error;
+	}
+	refresh->global = global;
+	refresh->rule = rule;
+	kiwi_var_init(&refresh->user, NULL, 0);
+	kiwi_var_set(&refresh->user, KIWI_VAR_UNDEF, user->value,
+		     user->value_len);
+	od_snprintf(refresh->peer, sizeof(refresh->peer), "%s", peer);
+
+	/* refresh coroutine keeps rule and its cache alive */
+	od_rules_ref(rule);
+
+	int64_t coroutine_id;
+	coroutine_id = machine_coroutine_create(od_auth_query_refresh, refresh);
+	if (coroutine_id == -1) {
+		od_rules_unref(rule);
+		od_free(refresh);
+		goto error;
+	}
+	return;
+
+error:
+	od_error(&instance->logger, "auth_query", NULL, NULL,
+		 "failed to start password refresh for user %.*s",
+		 user->value_len, user->value);
+	od_auth_cache_put(rule->storage->acache, user->value, user->value_len,
+			  OD_AUTH_CACHE_EMPTY, NULL, machine_time_us());
+}
+
+int od_auth_query(od_client_t *client, char *peer)
+{
+	od_global_t *global = client->global;
+	od_rule_t *rule = client->rule;
+	od_auth_cache_t *cache = rule->storage->acache;
+	kiwi_var_t *user = &client->startup.user;
+	kiwi_password_t *password = &client->password;
+	od_instance_t *instance = global->instance;
+
+	int rc;
+	if (cache == NULL || rule->auth_query_cache_ttl <= 0) {
+		rc = od_auth_query_do(global, rule, client, user, peer,
+				      password);
+		return rc == OK_RESPONSE ? OK_RESPONSE : NOT_OK_RESPONSE;
+	}
+
+	od_auth_cache_policy_t policy;
+	policy.ttl = (uint64_t)rule->auth_query_cache_ttl * 1000;
+	policy.negative_ttl = 0;
+	if (rule->auth_query_cache_negative_ttl > 0) {
+		policy.negative_ttl =
+			(uint64_t)rule->auth_query_cache_negative_ttl * 1000;
+	}
+	policy.refresh = 0;
+	if (rule->auth_query_cache_refresh > 0) {
+		policy.refresh =
+			(uint64_t)rule->auth_query_cache_refresh * 1000;
+	}
+
+	/* concurrent lookups of the same user wait here for the leader */
+	int refresh;
+	od_auth_cache_result_t result;
+	result = od_auth_cache_get(cache, user->value, user->value_len, &policy,
+				   machine_time_us(), password, &refresh);
+	switch (result) {
+	case OD_AUTH_CACHE_HIT:
+		od_debug(&instance->logger, "auth_query", NULL, NULL,
+			 "reusing cached password for user %.*s",
+			 user->value_len, user->value);
+		if (refresh) {
+			od_auth_query_refresh_start(global, rule, user, peer);
+		}
+		return OK_RESPONSE;
+	case OD_AUTH_CACHE_HIT_NOT_FOUND:
+		od_debug(&instance->logger, "auth_query", NULL, NULL,
+			 "user %.*s is cached as not found", user->value_len,
+			 user->value);
+		return NOT_OK_RESPONSE;
+	case OD_AUTH_CACHE_ERROR:
+		return NOT_OK_RESPONSE;
+	case OD_AUTH_CACHE_MISS:
+		break;
+	}
+
+	rc = od_auth_query_do(global, rule, client, user, peer, password);
+	od_auth_cache_put(cache, user->value, user->value_len,
+			  od_auth_query_cache_state(rc), password,
+			  machine_time_us());
+	return rc == OK_RESPONSE ? OK_RESPONSE : NOT_OK_RESPONSE;
+}
@@ -8,4 +8,7 @@
 
 #define ODYSSEY_AUTH_QUERY_MAX_PASSWORD_LEN 4096
 
+/* auth query returned no rows */
+#define OD_AUTH_QUERY_NOT_FOUND 1
+
 int od_auth_query(od_client_t *, char *);
@@ -180,7 +180,8 @@ int od_backend_startup(od_server_t *server, kiwi_params_t *route_params,
 
 	/* update request count and sync state */
 	od_server_sync_request(server, 1);
-	assert(server->client);
+	/* prewarm starts servers with no client */
+	assert(client == NULL || server->client);
 
 	for (;;) {
 		msg = od_read(&server->io, UINT32_MAX);
@@ -745,7 +746,6 @@ od_retcode_t od_backend_query_send(od_server_t *server, char *context,
 
 	/* update server sync state */
 	od_server_sync_request(server, 1);
-	assert(server->client);
 	return OK_RESPONSE;
 }
 
@@ -39,10 +39,12 @@ struct od_client {
 
 	od_server_t *server;
 	od_route_t *route;
+	/* index in the route rule priority classes */
+	int priority_class;
 	char peer[OD_CLIENT_MAX_PEERLEN];
 
 	/* desc preparet statements ids */
-	od_hashmap_t *prep_stmt_ids;
+	od_pstmt_map_t *prep_stmt_ids;
 
 	/* passwd from config rule */
 	kiwi_password_t password;
@@ -52,6 +54,10 @@ struct od_client {
 	od_global_t *global;
 	od_list_t link_pool;
 	od_list_t link;
+	/* clients of the worker machine */
+	od_list_t link_worker;
+	/* io_cond was signaled by the worker, not by io */
+	int wakeup;
 
 	/* Used to kill client in kill_client or odyssey reload */
 	od_atomic_u64_t killed;
@@ -69,11 +75,9 @@ struct od_client {
 	char *external_id;
 };
 
-static const size_t OD_CLIENT_DEFAULT_HASHMAP_SZ = 420;
-
 static inline od_retcode_t od_client_init_hm(od_client_t *client)
 {
-	client->prep_stmt_ids = od_hashmap_create(OD_CLIENT_DEFAULT_HASHMAP_SZ);
+	client->prep_stmt_ids = od_pstmt_map_create(&client->global->pstmts);
 	if (client->prep_stmt_ids == NULL) {
 		return NOT_OK_RESPONSE;
 	}
@@ -91,6 +95,7 @@ static inline void od_client_init(od_client_t *client)
 	client->config_listen = NULL;
 	client->server = NULL;
 	client->route = NULL;
+	client->priority_class = 0;
 	client->global = NULL;
 	client->time_accept = 0;
 	client->time_setup = 0;
@@ -115,6 +120,8 @@ static inline void od_client_init(od_client_t *client)
 
 	od_list_init(&client->link_pool);
 	od_list_init(&client->link);
+	od_list_init(&client->link_worker);
+	client->wakeup = 0;
 
 	client->prep_stmt_ids = NULL;
 
@@ -136,6 +143,7 @@ static inline void od_client_free(od_client_t *client)
 	od_free(client->ldap_auth_dn);
 #endif
 
+	od_list_unlink(&client->link_worker);
 	od_relay_free(&client->relay);
 	od_io_free(&client->io);
 	if (client->io_cond)
@@ -144,7 +152,7 @@ static inline void od_client_free(od_client_t *client)
 	kiwi_password_free(&client->password);
 	kiwi_password_free(&client->received_password);
 	if (client->prep_stmt_ids) {
-		od_hashmap_free(client->prep_stmt_ids);
+		od_pstmt_map_free(client->prep_stmt_ids);
 	}
 	if (client->external_id) {
 		od_free(client->external_id);
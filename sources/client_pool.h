@@ -6,124 +6,87 @@
  * Scalable PostgreSQL connection pooler.
  */
 
+/*
+ * Clients of the route are linked into a single list, which is changed
+ * only when client joins or leaves the route (under the route lock).
+ *
+ * Transitions between pending, queue and active states happen on every
+ * transaction and do not take the route lock: client state is stored
+ * atomically and per-state counts are computed on demand.
+ */
+
 typedef int (*od_client_pool_cb_t)(od_client_t *, void **);
 
 struct od_client_pool {
-	od_list_t active;
-	od_list_t queue;
-	od_list_t pending;
-	int count_active;
-	int count_queue;
-	int count_pending;
+	od_list_t list;
+	/* clients in the list, guarded by the route lock */
+	int count;
 };
 
 static inline void od_client_pool_init(od_client_pool_t *pool)
 {
-	pool->count_active = 0;
-	pool->count_queue = 0;
-	pool->count_pending = 0;
-	od_list_init(&pool->active);
-	od_list_init(&pool->queue);
-	od_list_init(&pool->pending);
+	pool->count = 0;
+	od_list_init(&pool->list);
+}
+
+static inline od_client_state_t od_client_pool_state(od_client_t *client)
+{
+	return __atomic_load_n(&client->state, __ATOMIC_RELAXED);
 }
 
+/*
+ * Setting or leaving OD_CLIENT_UNDEF state changes the list and must be
+ * done under the route lock, other transitions are lock-free.
+ */
 static inline void od_client_pool_set(od_client_pool_t *pool,
 				      od_client_t *client,
 				      od_client_state_t state)
 {
-	if (client->state == state)
+	od_client_state_t prev = client->state;
+	if (prev == state)
 		return;
-	switch (client->state) {
-	case OD_CLIENT_UNDEF:
-		break;
-	case OD_CLIENT_ACTIVE:
-		pool->count_active--;
-		break;
-	case OD_CLIENT_QUEUE:
-		pool->count_queue--;
-		break;
-	case OD_CLIENT_PENDING:
-		pool->count_pending--;
-		break;
-	}
-	od_list_t *target = NULL;
-	switch (state) {
-	case OD_CLIENT_UNDEF:
-		break;
-	case OD_CLIENT_ACTIVE:
-		target = &pool->active;
-		pool->count_active++;
-		break;
-	case OD_CLIENT_QUEUE:
-		target = &pool->queue;
-		pool->count_queue++;
-		break;
-	case OD_CLIENT_PENDING:
-		target = &pool->pending;
-		pool->count_pending++;
-		break;
+
+	if (prev == OD_CLIENT_UNDEF) {
+		od_list_append(&pool->list, &client->link_pool);
+		pool->count++;
+	} else if (state == OD_CLIENT_UNDEF) {
+		od_list_unlink(&client->link_pool);
+		od_list_init(&client->link_pool);
+		pool->count--;
 	}
-	od_list_unlink(&client->link_pool);
-	od_list_init(&client->link_pool);
-	if (target)
-		od_list_append(target, &client->link_pool);
-	client->state = state;
+
+	__atomic_store_n(&client->state, state, __ATOMIC_RELAXED);
 }
 
 static inline od_client_t *od_client_pool_next(od_client_pool_t *pool,
 					       od_client_state_t state)
 {
-	int target_count = 0;
-	od_list_t *target = NULL;
-	switch (state) {
-	case OD_CLIENT_ACTIVE:
-		target = &pool->active;
-		target_count = pool->count_active;
-		break;
-	case OD_CLIENT_QUEUE:
-		target = &pool->queue;
-		target_count = pool->count_queue;
-		break;
-	case OD_CLIENT_PENDING:
-		target = &pool->pending;
-		target_count = pool->count_pending;
-		break;
-	case OD_CLIENT_UNDEF:
-		assert(0);
-		break;
+	assert(state != OD_CLIENT_UNDEF);
+	od_list_t *i;
+	od_list_foreach(&pool->list, i)
+	{
+		od_client_t *client;
+		client = od_container_of(i, od_client_t, link_pool);
+		if (od_client_pool_state(client) == state)
+			return client;
 	}
-	if (target_count == 0)
-		return NULL;
-	od_client_t *client;
-	client = od_container_of(target->next, od_client_t, link_pool);
-	return client;
+	return NULL;
 }
 
+/* OD_CLIENT_UNDEF matches clients in any state */
 static inline od_client_t *od_client_pool_foreach(od_client_pool_t *pool,
 						  od_client_state_t state,
 						  od_client_pool_cb_t callback,
 						  void **argv)
 {
-	od_list_t *target = NULL;
-	switch (state) {
-	case OD_CLIENT_ACTIVE:
-		target = &pool->active;
-		break;
-	case OD_CLIENT_QUEUE:
-		target = &pool->queue;
-		break;
-	case OD_CLIENT_PENDING:
-		target = &pool->pending;
-		break;
-	case OD_CLIENT_UNDEF:
-		assert(0);
-		break;
-	}
 	od_client_t *client;
 	od_list_t *i, *n;
-	od_list_foreach_safe(target, i, n)
+	od_list_foreach_safe(&pool->list, i, n)
 	{
 		client = od_container_of(i, od_client_t, link_pool);
+		if (state != OD_CLIENT_UNDEF &&
+		    od_client_pool_state(client) != state)
+			continue;
 		int rc;
 		rc = callback(client, argv);
 		if (rc) {
@@ -133,7 +96,24 @@ static inline od_client_t *od_client_pool_foreach(od_client_pool_t *pool,
 	return NULL;
 }
 
+/* caller must hold the route lock */
+static inline int od_client_pool_count(od_client_pool_t *pool,
+				       od_client_state_t state)
+{
+	int count = 0;
+	od_list_t *i;
+	od_list_foreach(&pool->list, i)
+	{
+		od_client_t *client;
+		client = od_container_of(i, od_client_t, link_pool);
+		if (od_client_pool_state(client) == state)
+			count++;
+	}
+	return count;
+}
+
+/* caller must hold the route lock */
 static inline int od_client_pool_total(od_client_pool_t *pool)
 {
-	return pool->count_active + pool->count_queue + pool->count_pending;
+	return pool->count;
 }
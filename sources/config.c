@@ -33,6 +33,8 @@ void od_config_init(od_config_t *config)
 	config->enable_online_restart_feature = 0;
 	config->online_restart_drop_options.drop_enabled = 1;
 	config->bindwith_reuseport = 0;
+	config->workers_reuseport = 0;
+	config->workers_reuseport_cpu = 0;
 	config->graceful_die_on_errors = 0;
 	config->unix_socket_mode = NULL;
 
@@ -41,6 +43,7 @@ void od_config_init(od_config_t *config)
 	config->log_syslog_facility = NULL;
 
 	config->readahead = 8192;
+	config->readahead_max = 65536;
 	config->nodelay = 1;
 
 	config->keepalive = 15;
@@ -49,6 +52,10 @@ void od_config_init(od_config_t *config)
 	config->keepalive_usr_timeout = 0; /* use sys default */
 
 	config->workers = 1;
+	config->workers_policy = OD_CONFIG_WORKERS_POLICY_ROUND_ROBIN;
+	config->poller = OD_CONFIG_POLLER_EPOLL;
+	config->crypto_workers = 0;
+	config->crypto_queue_limit = 0;
 	config->resolvers = 1;
 	config->client_max_set = 0;
 	config->client_max = 0;
@@ -57,6 +64,8 @@ void od_config_init(od_config_t *config)
 	config->cache_coroutine = 0;
 	config->cache_msg_gc_size = 0;
 	config->coroutine_stack_size = 4;
+	config->coroutine_stack_guard = 1;
+	config->client_coroutine_stack_size = 0;
 	config->hba_file = NULL;
 	config->max_sigterms_to_die = 3;
 	config->group_checker_interval = 7000; /* 7 seconds */
@@ -85,6 +94,7 @@ void od_config_reload(od_config_t *current_config, od_config_t *new_config)
 	current_config->max_sigterms_to_die = new_config->max_sigterms_to_die;
 	current_config->client_max_routing = new_config->client_max_routing;
 	current_config->server_login_retry = new_config->server_login_retry;
+	current_config->workers_policy = new_config->workers_policy;
 	current_config->backend_connect_timeout_ms =
 		new_config->backend_connect_timeout_ms;
 }
@@ -170,6 +180,13 @@ int od_config_validate(od_config_t *config, od_logger_t *logger)
 		return -1;
 	}
 
+	/* crypto pool */
+	if (config->crypto_workers < 0 || config->crypto_queue_limit < 0) {
+		od_error(logger, "config", NULL, NULL,
+			 "bad crypto_workers or crypto_queue_limit number");
+		return -1;
+	}
+
 	/* resolvers */
 	if (config->resolvers <= 0) {
 		od_error(logger, "config", NULL, NULL, "bad resolvers number");
@@ -183,6 +200,14 @@ int od_config_validate(od_config_t *config, od_logger_t *logger)
 		return -1;
 	}
 
+	/* client_coroutine_stack_size */
+	if (config->client_coroutine_stack_size != 0 &&
+	    config->client_coroutine_stack_size < 4) {
+		od_error(logger, "config", NULL, NULL,
+			 "bad client_coroutine_stack_size number");
+		return -1;
+	}
+
 	/* log format */
 	if (config->log_format == NULL) {
 		od_error(logger, "config", NULL, NULL, "log is not defined");
@@ -315,6 +340,8 @@ void od_config_print(od_config_t *config, od_logger_t *logger)
 	       config->stats_interval);
 	od_log(logger, "config", NULL, NULL, "readahead               %d",
 	       config->readahead);
+	od_log(logger, "config", NULL, NULL, "readahead_max           %d",
+	       config->readahead_max);
 	od_log(logger, "config", NULL, NULL, "nodelay                 %s",
 	       od_config_yes_no(config->nodelay));
 	od_log(logger, "config", NULL, NULL, "keepalive               %d",
@@ -332,8 +359,22 @@ void od_config_print(od_config_t *config, od_logger_t *logger)
 	       config->cache_coroutine);
 	od_log(logger, "config", NULL, NULL, "coroutine_stack_size    %d",
 	       config->coroutine_stack_size);
+	od_log(logger, "config", NULL, NULL, "coroutine_stack_guard   %s",
+	       od_config_yes_no(config->coroutine_stack_guard));
+	if (config->client_coroutine_stack_size)
+		od_log(logger, "config", NULL, NULL,
+		       "client_coroutine_stack_size %d",
+		       config->client_coroutine_stack_size);
 	od_log(logger, "config", NULL, NULL, "workers                 %d",
 	       config->workers);
+	od_log(logger, "config", NULL, NULL, "workers_policy          %s",
+	       od_config_workers_policy_to_str(config->workers_policy));
+	od_log(logger, "config", NULL, NULL, "poller                  %s",
+	       od_config_poller_to_str(config->poller));
+	od_log(logger, "config", NULL, NULL, "crypto_workers          %d",
+	       config->crypto_workers);
+	od_log(logger, "config", NULL, NULL, "crypto_queue_limit      %d",
+	       config->crypto_queue_limit);
 	od_log(logger, "config", NULL, NULL, "resolvers               %d",
 	       config->resolvers);
 	od_log(logger, "config", NULL, NULL, "backend_connect_timeout_ms %u",
@@ -353,6 +394,11 @@ void od_config_print(od_config_t *config, od_logger_t *logger)
 		od_log(logger, "config", NULL, NULL,
 		       "socket bind with:       SO_REUSEPORT");
 	}
+	if (config->workers_reuseport) {
+		od_log(logger, "config", NULL, NULL,
+		       "accept in workers:      SO_REUSEPORT%s",
+		       config->workers_reuseport_cpu ? " (cpu steering)" : "");
+	}
 
 	if (config->soft_oom.enabled) {
 		od_log(logger, "config", NULL, NULL,
@@ -402,6 +448,9 @@ void od_config_print(od_config_t *config, od_logger_t *logger)
 			od_log(logger, "config", NULL, NULL,
 			       "  tls_protocols %s",
 			       listen->tls_opts->tls_protocols);
+		if (listen->tls_opts->tls_ktls)
+			od_log(logger, "config", NULL, NULL,
+			       "  tls_ktls      yes");
 		od_log(logger, "config", NULL, NULL, "");
 	}
 }
@@ -44,6 +44,18 @@ struct od_config_soft_oom {
 	od_config_soft_oom_drop_t drop;
 };
 
+typedef enum {
+	OD_CONFIG_WORKERS_POLICY_ROUND_ROBIN,
+	OD_CONFIG_WORKERS_POLICY_LEAST_CLIENTS,
+	OD_CONFIG_WORKERS_POLICY_POWER_OF_TWO,
+	OD_CONFIG_WORKERS_POLICY_CPU,
+} od_config_workers_policy_t;
+
+typedef enum {
+	OD_CONFIG_POLLER_EPOLL,
+	OD_CONFIG_POLLER_IO_URING,
+} od_config_poller_t;
+
 struct od_config {
 	int daemonize;
 	int priority;
@@ -76,8 +88,11 @@ struct od_config {
 	int enable_online_restart_feature;
 	od_config_online_restart_drop_options_t online_restart_drop_options;
 	int bindwith_reuseport;
+	int workers_reuseport;
+	int workers_reuseport_cpu;
 	/*                         */
 	int readahead;
+	int readahead_max;
 	int nodelay;
 
 	/* TCP KEEPALIVE related settings */
@@ -87,6 +102,10 @@ struct od_config {
 	int keepalive_usr_timeout;
 	/*                                */
 	int workers;
+	od_config_workers_policy_t workers_policy;
+	od_config_poller_t poller;
+	int crypto_workers;
+	int crypto_queue_limit;
 	int resolvers;
 	/*         client                 */
 	int client_max_set;
@@ -98,6 +117,8 @@ struct od_config {
 	int cache_coroutine;
 	int cache_msg_gc_size;
 	int coroutine_stack_size;
+	int coroutine_stack_guard;
+	int client_coroutine_stack_size;
 	char *hba_file;
 	/* Soft interval between group checks */
 	int group_checker_interval;
@@ -123,3 +144,30 @@ int od_config_validate(od_config_t *, od_logger_t *);
 void od_config_print(od_config_t *, od_logger_t *);
 
 od_config_listen_t *od_config_listen_add(od_config_t *);
+
+static inline char *
+od_config_workers_policy_to_str(od_config_workers_policy_t policy)
+{
+	switch (policy) {
+	case OD_CONFIG_WORKERS_POLICY_ROUND_ROBIN:
+		return "round_robin";
+	case OD_CONFIG_WORKERS_POLICY_LEAST_CLIENTS:
+		return "least_clients";
+	case OD_CONFIG_WORKERS_POLICY_POWER_OF_TWO:
+		return "power_of_two";
+	case OD_CONFIG_WORKERS_POLICY_CPU:
+		return "cpu";
+	}
+	return "unknown";
+}
+
+static inline char *od_config_poller_to_str(od_config_poller_t poller)
+{
+	switch (poller) {
+	case OD_CONFIG_POLLER_EPOLL:
+		return "epoll";
+	case OD_CONFIG_POLLER_IO_URING:
+		return "io_uring";
+	}
+	return "unknown";
+}
@@ -42,6 +42,8 @@ typedef enum {
 	OD_LGRACEFUL_DIE_ON_ERRORS,
 	OD_LGRACEFUL_SHUTDOWN_TIMEOUT_MS,
 	OD_LBINDWITH_REUSEPORT,
+	OD_LWORKERS_REUSEPORT,
+	OD_LWORKERS_REUSEPORT_CPU,
 	OD_LLOG_SYSLOG,
 	OD_LLOG_SYSLOG_IDENT,
 	OD_LLOG_SYSLOG_FACILITY,
@@ -57,7 +59,12 @@ typedef enum {
 	OD_LKEEPALIVE_PROBES,
 	OD_LKEEPALIVE_USR_TIMEOUT,
 	OD_LREADAHEAD,
+	OD_LREADAHEAD_MAX,
 	OD_LWORKERS,
+	OD_LWORKERS_POLICY,
+	OD_LPOLLER,
+	OD_LCRYPTO_WORKERS,
+	OD_LCRYPTO_QUEUE_LIMIT,
 	OD_LRESOLVERS,
 	OD_LPIPELINE,
 	OD_LPACKET_READ_SIZE,
@@ -67,6 +74,8 @@ typedef enum {
 	OD_LCACHE_MSG_GC_SIZE,
 	OD_LCACHE_COROUTINE,
 	OD_LCOROUTINE_STACK_SIZE,
+	OD_LCOROUTINE_STACK_GUARD,
+	OD_LCLIENT_COROUTINE_STACK_SIZE,
 	OD_LCLIENT_MAX,
 	OD_LCLIENT_MAX_ROUTING,
 	OD_LMAX_SIGTERMS_TO_DIE,
@@ -77,6 +86,9 @@ typedef enum {
 	OD_LCLIENT_FWD_ERROR,
 	OD_LPRESERVE_SESSION_SERVER_CONN,
 	OD_LAPPLICATION_NAME_ADD_HOST,
+	OD_LPRIORITY_CLASS,
+	OD_LWEIGHT,
+	OD_LAPPLICATION_NAME,
 	OD_LBACKEND_CONNECT_TIMEOUT_MS,
 	OD_LSERVER_LIFETIME,
 	OD_LTLS,
@@ -84,9 +96,11 @@ typedef enum {
 	OD_LTLS_KEY_FILE,
 	OD_LTLS_CERT_FILE,
 	OD_LTLS_PROTOCOLS,
+	OD_LTLS_KTLS,
 	OD_LCOMPRESSION,
 	OD_LSTORAGE,
 	OD_LENDPOINTS_STATUS_POLL_INTERVAL,
+	OD_LENDPOINTS_BALANCING,
 	OD_LTYPE,
 	OD_LSERVERS_MAX_ROUTING,
 	OD_LDEFAULT,
@@ -113,6 +127,9 @@ typedef enum {
 	OD_LPOOL_CANCEL,
 	OD_LPOOL_ROLLBACK,
 	OD_LPOOL_RESERVE_PREPARED_STATEMENT,
+	OD_LPOOL_SIZE_ADAPTIVE,
+	OD_LPOOL_PREWARM,
+	OD_LPOOL_PREWARM_QUERY,
 	OD_LPOOL_CLIENT_IDLE_TIMEOUT,
 	OD_LPOOL_IDLE_IN_TRANSACTION_TIMEOUT,
 	OD_LSTORAGE_DB,
@@ -125,6 +142,9 @@ typedef enum {
 	OD_LAUTH_QUERY,
 	OD_LAUTH_QUERY_DB,
 	OD_LAUTH_QUERY_USER,
+	OD_LAUTH_QUERY_CACHE_TTL,
+	OD_LAUTH_QUERY_CACHE_NEGATIVE_TTL,
+	OD_LAUTH_QUERY_CACHE_REFRESH,
 	OD_LAUTH_LDAP_SERVICE,
 	OD_LAUTH_PASSWORD_PASSTHROUGH,
 	OD_LAUTH_MDB_IAMPROXY_ENABLE,
@@ -192,6 +212,8 @@ static od_keyword_t od_config_keywords[] = {
 	od_keyword("graceful_shutdown_timeout_ms",
 		   OD_LGRACEFUL_SHUTDOWN_TIMEOUT_MS),
 	od_keyword("bindwith_reuseport", OD_LBINDWITH_REUSEPORT),
+	od_keyword("workers_reuseport", OD_LWORKERS_REUSEPORT),
+	od_keyword("workers_reuseport_cpu", OD_LWORKERS_REUSEPORT_CPU),
 
 	od_keyword("online_restart_drop_options",
 		   OD_LONLINE_RESTART_DROP_OPTIONS),
@@ -237,7 +259,12 @@ static od_keyword_t od_config_keywords[] = {
 	od_keyword("max_sigterms_to_die", OD_LMAX_SIGTERMS_TO_DIE),
 
 	od_keyword("readahead", OD_LREADAHEAD),
+	od_keyword("readahead_max", OD_LREADAHEAD_MAX),
 	od_keyword("workers", OD_LWORKERS),
+	od_keyword("workers_policy", OD_LWORKERS_POLICY),
+	od_keyword("poller", OD_LPOLLER),
+	od_keyword("crypto_workers", OD_LCRYPTO_WORKERS),
+	od_keyword("crypto_queue_limit", OD_LCRYPTO_QUEUE_LIMIT),
 	od_keyword("resolvers", OD_LRESOLVERS),
 	od_keyword("pipeline", OD_LPIPELINE),
 	od_keyword("packet_read_size", OD_LPACKET_READ_SIZE),
@@ -247,6 +274,9 @@ static od_keyword_t od_config_keywords[] = {
 	od_keyword("cache_msg_gc_size", OD_LCACHE_MSG_GC_SIZE),
 	od_keyword("cache_coroutine", OD_LCACHE_COROUTINE),
 	od_keyword("coroutine_stack_size", OD_LCOROUTINE_STACK_SIZE),
+	od_keyword("coroutine_stack_guard", OD_LCOROUTINE_STACK_GUARD),
+	od_keyword("client_coroutine_stack_size",
+		   OD_LCLIENT_COROUTINE_STACK_SIZE),
 	/* client */
 	od_keyword("client_max", OD_LCLIENT_MAX),
 	od_keyword("client_max_routing", OD_LCLIENT_MAX_ROUTING),
@@ -256,6 +286,9 @@ static od_keyword_t od_config_keywords[] = {
 	od_keyword("reserve_session_server_connection",
 		   OD_LPRESERVE_SESSION_SERVER_CONN),
 	od_keyword("application_name_add_host", OD_LAPPLICATION_NAME_ADD_HOST),
+	od_keyword("priority_class", OD_LPRIORITY_CLASS),
+	od_keyword("weight", OD_LWEIGHT),
+	od_keyword("application_name", OD_LAPPLICATION_NAME),
 	od_keyword("server_lifetime", OD_LSERVER_LIFETIME),
 
 	od_keyword("backend_connect_timeout_ms",
@@ -267,12 +300,14 @@ static od_keyword_t od_config_keywords[] = {
 	od_keyword("tls_key_file", OD_LTLS_KEY_FILE),
 	od_keyword("tls_cert_file", OD_LTLS_CERT_FILE),
 	od_keyword("tls_protocols", OD_LTLS_PROTOCOLS),
+	od_keyword("tls_ktls", OD_LTLS_KTLS),
 	od_keyword("compression", OD_LCOMPRESSION),
 
 	/* storage */
 	od_keyword("storage", OD_LSTORAGE),
 	od_keyword("endpoints_status_poll_interval",
 		   OD_LENDPOINTS_STATUS_POLL_INTERVAL),
+	od_keyword("endpoints_balancing", OD_LENDPOINTS_BALANCING),
 	od_keyword("type", OD_LTYPE),
 	od_keyword("server_max_routing", OD_LSERVERS_MAX_ROUTING),
 	od_keyword("default", OD_LDEFAULT),
@@ -304,6 +339,9 @@ static od_keyword_t od_config_keywords[] = {
 	od_keyword("pool_rollback", OD_LPOOL_ROLLBACK),
 	od_keyword("pool_reserve_prepared_statement",
 		   OD_LPOOL_RESERVE_PREPARED_STATEMENT),
+	od_keyword("pool_size_adaptive", OD_LPOOL_SIZE_ADAPTIVE),
+	od_keyword("pool_prewarm", OD_LPOOL_PREWARM),
+	od_keyword("pool_prewarm_query", OD_LPOOL_PREWARM_QUERY),
 	od_keyword("pool_client_idle_timeout", OD_LPOOL_CLIENT_IDLE_TIMEOUT),
 	od_keyword("pool_idle_in_transaction_timeout",
 		   OD_LPOOL_IDLE_IN_TRANSACTION_TIMEOUT),
@@ -322,6 +360,10 @@ static od_keyword_t od_config_keywords[] = {
 	od_keyword("auth_query", OD_LAUTH_QUERY),
 	od_keyword("auth_query_db", OD_LAUTH_QUERY_DB),
 	od_keyword("auth_query_user", OD_LAUTH_QUERY_USER),
+	od_keyword("auth_query_cache_ttl", OD_LAUTH_QUERY_CACHE_TTL),
+	od_keyword("auth_query_cache_negative_ttl",
+		   OD_LAUTH_QUERY_CACHE_NEGATIVE_TTL),
+	od_keyword("auth_query_cache_refresh", OD_LAUTH_QUERY_CACHE_REFRESH),
 	od_keyword("auth_pam_service", OD_LAUTH_PAM_SERVICE),
 	od_keyword("auth_module", OD_LAUTH_MODULE),
 	od_keyword("password_passthrough", OD_LAUTH_PASSWORD_PASSTHROUGH),
@@ -609,6 +651,91 @@ static bool od_config_reader_number64(od_config_reader_t *reader,
 	return true;
 }
 
+static bool od_config_reader_poller(od_config_reader_t *reader,
+				    od_config_poller_t *out)
+{
+	char *tmp = NULL;
+
+	if (!od_config_reader_string(reader, &tmp)) {
+		return false;
+	}
+
+	if (strcmp(tmp, "epoll") == 0) {
+		*out = OD_CONFIG_POLLER_EPOLL;
+	} else if (strcmp(tmp, "io_uring") == 0) {
+		*out = OD_CONFIG_POLLER_IO_URING;
+	} else {
+		od_config_reader_error(reader, NULL, "unknown poller '%s'",
+				       tmp);
+		od_free(tmp);
+		return false;
+	}
+
+	od_free(tmp);
+
+	return true;
+}
+
+static bool
+od_config_reader_workers_policy(od_config_reader_t *reader,
+				od_config_workers_policy_t *out)
+{
+	char *tmp = NULL;
+
+	if (!od_config_reader_string(reader, &tmp)) {
+		return false;
+	}
+
+	if (strcmp(tmp, "round_robin") == 0) {
+		*out = OD_CONFIG_WORKERS_POLICY_ROUND_ROBIN;
+	} else if (strcmp(tmp, "least_clients") == 0) {
+		*out = OD_CONFIG_WORKERS_POLICY_LEAST_CLIENTS;
+	} else if (strcmp(tmp, "power_of_two") == 0) {
+		*out = OD_CONFIG_WORKERS_POLICY_POWER_OF_TWO;
+	} else if (strcmp(tmp, "cpu") == 0) {
+		*out = OD_CONFIG_WORKERS_POLICY_CPU;
+	} else {
+		od_config_reader_error(reader, NULL,
+				       "unknown workers policy '%s'", tmp);
+		od_free(tmp);
+		return false;
+	}
+
+	od_free(tmp);
+
+	return true;
+}
+
+static bool
+od_config_reader_endpoints_balancing(od_config_reader_t *reader,
+				     od_storage_balancing_t *out)
+{
+	char *tmp = NULL;
+
+	if (!od_config_reader_string(reader, &tmp)) {
+		return false;
+	}
+
+	if (strcmp(tmp, "random") == 0) {
+		*out = OD_STORAGE_BALANCING_RANDOM;
+	} else if (strcmp(tmp, "round_robin") == 0) {
+		*out = OD_STORAGE_BALANCING_ROUND_ROBIN;
+	} else if (strcmp(tmp, "least_connections") == 0) {
+		*out = OD_STORAGE_BALANCING_LEAST_CONNECTIONS;
+	} else if (strcmp(tmp, "latency") == 0) {
+		*out = OD_STORAGE_BALANCING_LATENCY;
+	} else {
+		od_config_reader_error(reader, NULL,
+				       "unknown endpoints balancing '%s'", tmp);
+		od_free(tmp);
+		return false;
+	}
+
+	od_free(tmp);
+
+	return true;
+}
+
 static bool
 od_config_reader_target_session_attrs(od_config_reader_t *reader,
 				      od_target_session_attrs_t *out)
@@ -1078,6 +1205,12 @@ static int od_config_reader_listen(od_config_reader_t *reader)
 				    reader, &listen->tls_opts->tls_protocols))
 				return NOT_OK_RESPONSE;
 			continue;
+		/* tls_ktls */
+		case OD_LTLS_KTLS:
+			if (!od_config_reader_yes_no(
+				    reader, &listen->tls_opts->tls_ktls))
+				return NOT_OK_RESPONSE;
+			continue;
 		/* compression */
 		case OD_LCOMPRESSION:
 			if (!od_config_reader_yes_no(reader,
@@ -1197,6 +1330,12 @@ static int od_config_reader_storage(od_config_reader_t *reader,
 				    reader, &storage->tls_opts->tls_protocols))
 				goto error;
 			continue;
+		/* tls_ktls */
+		case OD_LTLS_KTLS:
+			if (!od_config_reader_yes_no(
+				    reader, &storage->tls_opts->tls_ktls))
+				goto error;
+			continue;
 		/* server_max_routing */
 		case OD_LSERVERS_MAX_ROUTING:
 			if (!od_config_reader_number(
@@ -1230,6 +1369,13 @@ static int od_config_reader_storage(od_config_reader_t *reader,
 				goto error;
 			}
 			continue;
+		/* endpoints_balancing */
+		case OD_LENDPOINTS_BALANCING:
+			if (!od_config_reader_endpoints_balancing(
+				    reader, &storage->endpoints_balancing)) {
+				goto error;
+			}
+			continue;
 		default: {
 			od_config_reader_error(reader, &token,
 					       "unexpected parameter");
@@ -1423,6 +1569,93 @@ static inline int od_config_reader_backend_pgoptions(od_config_reader_t *reader,
 	}
 }
 
+static inline od_retcode_t
+od_config_reader_priority_class(od_config_reader_t *reader, od_rule_t *rule)
+{
+	/* name */
+	char *name = NULL;
+	if (!od_config_reader_string(reader, &name))
+		return NOT_OK_RESPONSE;
+	if (strlen(name) == 0) {
+		od_config_reader_error(reader, NULL,
+				       "empty priority_class definition");
+		od_free(name);
+		return NOT_OK_RESPONSE;
+	}
+
+	od_rule_priority_class_t *class;
+	class = od_rules_priority_class_add(rule, name);
+	if (class == NULL) {
+		od_config_reader_error(reader, NULL,
+				       "too many priority classes, max is %d",
+				       OD_RULE_PRIORITY_CLASS_NAMED_MAX);
+		od_free(name);
+		return NOT_OK_RESPONSE;
+	}
+	od_free(name);
+
+	/* { */
+	if (!od_config_reader_symbol(reader, '{'))
+		return NOT_OK_RESPONSE;
+
+	for (;;) {
+		od_token_t token;
+		int rc;
+		rc = od_parser_next(&reader->parser, &token);
+		switch (rc) {
+		case OD_PARSER_KEYWORD:
+			break;
+		case OD_PARSER_SYMBOL:
+			/* } */
+			if (token.value.num == '}')
+				return OK_RESPONSE;
+			/* fall through */
+		default:
+			od_config_reader_error(
+				reader, &token,
+				"incorrect or unexpected parameter");
+			return NOT_OK_RESPONSE;
+		}
+		od_keyword_t *keyword;
+		keyword = od_keyword_match(od_config_keywords, &token);
+		if (keyword == NULL) {
+			od_config_reader_error(reader, &token,
+					       "unknown parameter");
+			return NOT_OK_RESPONSE;
+		}
+
+		switch (keyword->id) {
+		/* weight */
+		case OD_LWEIGHT:
+			if (!od_config_reader_number(reader, &class->weight))
+				return NOT_OK_RESPONSE;
+			if (class->weight < 1) {
+				od_config_reader_error(
+					reader, NULL,
+					"weight of priority_class '%s' must be positive",
+					class->name);
+				return NOT_OK_RESPONSE;
+			}
+			continue;
+		/* application_name */
+		case OD_LAPPLICATION_NAME:
+			if (!od_config_reader_string(reader,
+						     &class->application_name))
+				return NOT_OK_RESPONSE;
+			continue;
+		/* port */
+		case OD_LPORT:
+			if (!od_config_reader_number(reader, &class->port))
+				return NOT_OK_RESPONSE;
+			continue;
+		default:
+			od_config_reader_error(reader, &token,
+					       "unexpected parameter");
+			return NOT_OK_RESPONSE;
+		}
+	}
+}
+
 #ifdef LDAP_FOUND
 
 static inline od_retcode_t
@@ -1683,6 +1916,25 @@ static int od_config_reader_rule_settings(od_config_reader_t *reader,
 						     &rule->auth_query_user))
 				return NOT_OK_RESPONSE;
 			break;
+		/* auth_query_cache_ttl */
+		case OD_LAUTH_QUERY_CACHE_TTL:
+			if (!od_config_reader_number(
+				    reader, &rule->auth_query_cache_ttl))
+				return NOT_OK_RESPONSE;
+			break;
+		/* auth_query_cache_negative_ttl */
+		case OD_LAUTH_QUERY_CACHE_NEGATIVE_TTL:
+			if (!od_config_reader_number(
+				    reader,
+				    &rule->auth_query_cache_negative_ttl))
+				return NOT_OK_RESPONSE;
+			break;
+		/* auth_query_cache_refresh */
+		case OD_LAUTH_QUERY_CACHE_REFRESH:
+			if (!od_config_reader_number(
+				    reader, &rule->auth_query_cache_refresh))
+				return NOT_OK_RESPONSE;
+			break;
 		/* auth_query_user */
 		case OD_LAUTH_PASSWORD_PASSTHROUGH:
 			if (!od_config_reader_yes_no(
@@ -1815,6 +2067,24 @@ static int od_config_reader_rule_settings(od_config_reader_t *reader,
 			if (!od_config_reader_number(reader, &rule->pool->size))
 				return NOT_OK_RESPONSE;
 			continue;
+		/* pool_size_adaptive */
+		case OD_LPOOL_SIZE_ADAPTIVE:
+			if (!od_config_reader_yes_no(
+				    reader, &rule->pool->size_adaptive))
+				return NOT_OK_RESPONSE;
+			continue;
+		/* pool_prewarm */
+		case OD_LPOOL_PREWARM:
+			if (!od_config_reader_number(reader,
+						     &rule->pool->prewarm))
+				return NOT_OK_RESPONSE;
+			continue;
+		/* pool_prewarm_query */
+		case OD_LPOOL_PREWARM_QUERY:
+			if (!od_config_reader_string(
+				    reader, &rule->pool->prewarm_query))
+				return NOT_OK_RESPONSE;
+			continue;
 		/* pool_timeout */
 		case OD_LPOOL_TIMEOUT:
 			if (!od_config_reader_number(reader,
@@ -1969,6 +2239,11 @@ static int od_config_reader_rule_settings(od_config_reader_t *reader,
 			return NOT_OK_RESPONSE;
 #endif
 		}
+		case OD_LPRIORITY_CLASS:
+			if (od_config_reader_priority_class(reader, rule) !=
+			    OK_RESPONSE)
+				return NOT_OK_RESPONSE;
+			continue;
 		case OD_LLDAP_STORAGE_CREDENTIALS: {
 #ifdef LDAP_FOUND
 			if (od_config_reader_ldap_storage_credentials(
@@ -2854,6 +3129,20 @@ static int od_config_reader_parse(od_config_reader_t *reader,
 				goto error;
 			}
 			continue;
+		/* workers_reuseport */
+		case OD_LWORKERS_REUSEPORT:
+			if (!od_config_reader_yes_no(
+				    reader, &config->workers_reuseport)) {
+				goto error;
+			}
+			continue;
+		/* workers_reuseport_cpu */
+		case OD_LWORKERS_REUSEPORT_CPU:
+			if (!od_config_reader_yes_no(
+				    reader, &config->workers_reuseport_cpu)) {
+				goto error;
+			}
+			continue;
 		/* enable_host_watcher */
 		case OD_LENABLE_HOST_WATCHER:
 			if (!od_config_reader_yes_no(
@@ -2975,6 +3264,13 @@ static int od_config_reader_parse(od_config_reader_t *reader,
 				goto error;
 			}
 			continue;
+		/* readahead_max */
+		case OD_LREADAHEAD_MAX:
+			if (!od_config_reader_number(reader,
+						     &config->readahead_max)) {
+				goto error;
+			}
+			continue;
 		/* nodelay */
 		case OD_LNODELAY:
 			if (!od_config_reader_yes_no(reader,
@@ -3084,6 +3380,34 @@ static int od_config_reader_parse(od_config_reader_t *reader,
 			}
 		}
 			continue;
+		/* workers_policy */
+		case OD_LWORKERS_POLICY:
+			if (!od_config_reader_workers_policy(
+				    reader, &config->workers_policy)) {
+				goto error;
+			}
+			continue;
+		/* poller */
+		case OD_LPOLLER:
+			if (!od_config_reader_poller(reader,
+						     &config->poller)) {
+				goto error;
+			}
+			continue;
+		/* crypto_workers */
+		case OD_LCRYPTO_WORKERS:
+			if (!od_config_reader_number(reader,
+						     &config->crypto_workers)) {
+				goto error;
+			}
+			continue;
+		/* crypto_queue_limit */
+		case OD_LCRYPTO_QUEUE_LIMIT:
+			if (!od_config_reader_number(
+				    reader, &config->crypto_queue_limit)) {
+				goto error;
+			}
+			continue;
 		/* resolvers */
 		case OD_LRESOLVERS:
 			if (!od_config_reader_number(reader,
@@ -3139,6 +3463,21 @@ static int od_config_reader_parse(od_config_reader_t *reader,
 				goto error;
 			}
 			continue;
+		/* coroutine_stack_guard */
+		case OD_LCOROUTINE_STACK_GUARD:
+			if (!od_config_reader_yes_no(
+				    reader, &config->coroutine_stack_guard)) {
+				goto error;
+			}
+			continue;
+		/* client_coroutine_stack_size */
+		case OD_LCLIENT_COROUTINE_STACK_SIZE:
+			if (!od_config_reader_number(
+				    reader,
+				    &config->client_coroutine_stack_size)) {
+				goto error;
+			}
+			continue;
 		/* listen */
 		case OD_LLISTEN:
 			rc = od_config_reader_listen(reader);
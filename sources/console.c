@@ -24,6 +24,8 @@ typedef enum {
 	OD_LDROP,
 	OD_LPOOLS,
 	OD_LPOOLS_EXTENDED,
+	OD_LPOOL_CLASSES,
+	OD_LPREWARM,
 	OD_LDATABASES,
 	OD_LMODULE,
 	OD_LERRORS,
@@ -33,11 +35,14 @@ typedef enum {
 	OD_LVERSION,
 	OD_LLISTEN,
 	OD_LSTORAGES,
+	OD_LAUTH_CACHE,
+	OD_LCRYPTO,
 	OD_LFDS,
 	OD_LPAUSE,
 	OD_LRESUME,
 	OD_LIS_PAUSED,
 	OD_LHOST_UTILIZATION,
+	OD_LWORKERS,
 } od_console_keywords_t;
 
 static od_keyword_t od_console_keywords[] = {
@@ -53,6 +58,8 @@ static od_keyword_t od_console_keywords[] = {
 	od_keyword("set", OD_LSET),
 	od_keyword("pools", OD_LPOOLS),
 	od_keyword("pools_extended", OD_LPOOLS_EXTENDED),
+	od_keyword("pool_classes", OD_LPOOL_CLASSES),
+	od_keyword("prewarm", OD_LPREWARM),
 	od_keyword("databases", OD_LDATABASES),
 	od_keyword("create", OD_LCREATE),
 	od_keyword("module", OD_LMODULE),
@@ -64,11 +71,14 @@ static od_keyword_t od_console_keywords[] = {
 	od_keyword("version", OD_LVERSION),
 	od_keyword("listen", OD_LLISTEN),
 	od_keyword("storages", OD_LSTORAGES),
+	od_keyword("auth_cache", OD_LAUTH_CACHE),
+	od_keyword("crypto", OD_LCRYPTO),
 	od_keyword("fds", OD_LFDS),
 	od_keyword("pause", OD_LPAUSE),
 	od_keyword("resume", OD_LRESUME),
 	od_keyword("is_paused", OD_LIS_PAUSED),
 	od_keyword("host_utilization", OD_LHOST_UTILIZATION),
+	od_keyword("workers", OD_LWORKERS),
 	{ 0, 0, 0 }
 };
 
@@ -293,8 +303,8 @@ static inline int od_console_show_help(machine_msg_t *stream)
 	char *message =
 		"\n"
 		"Console usage\n"
-		"\tSHOW STATS|HELP|POOLS|POOLS_EXTENDED|DATABASES|SERVER_PREP_STMTS|SERVERS|CLIENTS|HOST_UTILIZATION\n"
-		"\tSHOW LISTS|ERRORS|ERRORS_PER_ROUTE|VERSION|LISTEN|STORAGES\n"
+		"\tSHOW STATS|HELP|POOLS|POOLS_EXTENDED|POOL_CLASSES|PREWARM|DATABASES|SERVER_PREP_STMTS|SERVERS|CLIENTS|HOST_UTILIZATION\n"
+		"\tSHOW LISTS|ERRORS|ERRORS_PER_ROUTE|VERSION|LISTEN|STORAGES|AUTH_CACHE|CRYPTO|WORKERS\n"
 		"\tKILL_CLIENT <client_id>\n"
 		"\tRELOAD\n"
 		"\tSET key=arg\n"
@@ -600,14 +610,16 @@ static inline int od_console_show_pools_add_cb(od_route_t *route, void **argv)
 	int data_len;
 
 	/* cl_active */
-	data_len = od_snprintf(data, sizeof(data), "%d",
-			       route->client_pool.count_active);
+	data_len = od_snprintf(
+		data, sizeof(data), "%d",
+		od_client_pool_count(&route->client_pool, OD_CLIENT_ACTIVE));
 	rc = kiwi_be_write_data_row_add(stream, offset, data, data_len);
 	if (rc == NOT_OK_RESPONSE)
 		goto error;
 	/* cl_waiting */
-	data_len = od_snprintf(data, sizeof(data), "%d",
-			       route->client_pool.count_pending);
+	data_len = od_snprintf(
+		data, sizeof(data), "%d",
+		od_client_pool_count(&route->client_pool, OD_CLIENT_PENDING));
 	rc = kiwi_be_write_data_row_add(stream, offset, data, data_len);
 	if (rc == NOT_OK_RESPONSE)
 		goto error;
@@ -638,13 +650,17 @@ static inline int od_console_show_pools_add_cb(od_route_t *route, void **argv)
 	rc = kiwi_be_write_data_row_add(stream, offset, data, data_len);
 	if (rc == NOT_OK_RESPONSE)
 		goto error;
-	/* maxwait */
-	data_len = od_snprintf(data, sizeof(data), "%" PRIu64, 0UL);
+	/* maxwait, oldest client waiting for a server */
+	uint64_t maxwait = od_multi_pool_max_wait_us(route->server_pools,
+						     machine_time_us());
+	data_len = od_snprintf(data, sizeof(data), "%" PRIu64,
+			       maxwait / 1000000);
 	rc = kiwi_be_write_data_row_add(stream, offset, data, data_len);
 	if (rc == NOT_OK_RESPONSE)
 		goto error;
 	/* maxwait_us */
-	data_len = od_snprintf(data, sizeof(data), "%" PRIu64, 0UL);
+	data_len = od_snprintf(data, sizeof(data), "%" PRIu64,
+			       maxwait % 1000000);
 	rc = kiwi_be_write_data_row_add(stream, offset, data, data_len);
 	if (rc == NOT_OK_RESPONSE)
 		goto error;
@@ -670,16 +686,65 @@ static inline int od_console_show_pools_add_cb(od_route_t *route, void **argv)
 	if (rc == NOT_OK_RESPONSE)
 		goto error;
 
+	/* wait_count, wait_avg_us, wait_p99_us */
+	uint64_t wait_stat[] = {
+		od_atomic_u64_of(&route->wait_hist.count),
+		od_hist_avg(&route->wait_hist),
+		od_hist_quantile(&route->wait_hist, 0.99),
+	};
+	for (size_t i = 0; i < sizeof(wait_stat) / sizeof(wait_stat[0]); i++) {
+		data_len = od_snprintf(data, sizeof(data), "%" PRIu64,
+				       wait_stat[i]);
+		rc = kiwi_be_write_data_row_add(stream, offset, data, data_len);
+		if (rc == NOT_OK_RESPONSE)
+			goto error;
+	}
+
+	/* pool_size, pool_size_decision */
+	data_len = od_snprintf(data, sizeof(data), "%d",
+			       od_route_pool_size(route));
+	rc = kiwi_be_write_data_row_add(stream, offset, data, data_len);
+	if (rc == NOT_OK_RESPONSE)
+		goto error;
+	char *decision = "static";
+	if (route->rule->pool->size_adaptive) {
+		decision = od_pool_size_decision_to_str(
+			route->pool_controller.decision);
+	}
+	rc = kiwi_be_write_data_row_add(stream, offset, decision,
+					strlen(decision));
+	if (rc == NOT_OK_RESPONSE)
+		goto error;
+
+	/* sv_reset, reset_avg_us, reset_p99_us */
+	uint64_t reset_stat[] = {
+		od_atomic_u32_of(&route->resets),
+		od_hist_avg(&route->reset_hist),
+		od_hist_quantile(&route->reset_hist, 0.99),
+	};
+	for (size_t i = 0; i < sizeof(reset_stat) / sizeof(reset_stat[0]);
+	     i++) {
+		data_len = od_snprintf(data, sizeof(data), "%" PRIu64,
+				       reset_stat[i]);
+		rc = kiwi_be_write_data_row_add(stream, offset, data, data_len);
+		if (rc == NOT_OK_RESPONSE)
+			goto error;
+	}
+
 	if (*extended) {
+		od_stat_t current;
+		od_stat_init(&current);
+		od_stat_copy(&current, &route->stats);
+
 		/* bytes received */
 		data_len = od_snprintf(data, sizeof(data), "%" PRIu64,
-				       route->stats.recv_client);
+				       current.recv_client);
 		rc = kiwi_be_write_data_row_add(stream, offset, data, data_len);
 		if (rc == NOT_OK_RESPONSE)
 			goto error;
 		/* bytes sent */
 		data_len = od_snprintf(data, sizeof(data), "%" PRIu64,
-				       route->stats.recv_server);
+				       current.recv_server);
 		rc = kiwi_be_write_data_row_add(stream, offset, data, data_len);
 		if (rc == NOT_OK_RESPONSE)
 			goto error;
@@ -695,6 +760,7 @@ static inline int od_console_show_pools_add_cb(od_route_t *route, void **argv)
 		queries_hgram = td_new(QUANTILES_COMPRESSION);
 		freeze_hgram = td_new(QUANTILES_COMPRESSION);
 		if (route->stats.enable_quantiles) {
+			od_stat_merge_shards(&route->stats);
 			for (size_t i = 0; i < QUANTILES_WINDOW; ++i) {
 				td_copy(freeze_hgram,
 					route->stats.transaction_hgram[i]);
@@ -809,9 +875,7 @@ static inline int od_console_show_databases_add_cb(od_route_t *route,
 
 	/* current_connections */
 	data_len = od_snprintf(data, sizeof(data), "%d",
-			       route->client_pool.count_active +
-				       route->client_pool.count_pending +
-				       route->client_pool.count_queue);
+			       od_client_pool_total(&route->client_pool));
 
 	rc = kiwi_be_write_data_row_add(stream, offset, data, data_len);
 	if (rc == NOT_OK_RESPONSE)
@@ -870,11 +934,13 @@ static inline int od_console_show_pools(od_client_t *client,
 	int quantiles_count = route->rule->quantiles_count;
 
 	machine_msg_t *msg;
-	msg = kiwi_be_write_row_descriptionf(stream, "ssllllllllls", "database",
-					     "user", "cl_active", "cl_waiting",
-					     "sv_active", "sv_idle", "sv_used",
-					     "sv_tested", "sv_login", "maxwait",
-					     "maxwait_us", "pool_mode");
+	msg = kiwi_be_write_row_descriptionf(
+		stream, "sslllllllllsllllslll", "database", "user", "cl_active",
+		"cl_waiting", "sv_active", "sv_idle", "sv_used", "sv_tested",
+		"sv_login", "maxwait", "maxwait_us", "pool_mode", "wait_count",
+		"wait_avg_us", "wait_p99_us", "pool_size",
+		"pool_size_decision", "sv_reset", "reset_avg_us",
+		"reset_p99_us");
 	if (msg == NULL)
 		return NOT_OK_RESPONSE;
 
@@ -950,7 +1016,7 @@ static inline int od_console_show_pools(od_client_t *client,
 		if (rc == NOT_OK_RESPONSE) {
 			goto error;
 		}
-		const size_t rest_columns_count = 13;
+		const size_t rest_columns_count = 21;
 		for (size_t i = 0; i < rest_columns_count; ++i) {
 			rc = kiwi_be_write_data_row_add(stream, offset, NULL,
 							NULL_MSG_LEN);
@@ -974,6 +1040,191 @@ error:
 	return NOT_OK_RESPONSE;
 }
 
+static inline int od_console_pool_classes_count_cb(od_client_t *client,
+						   void **argv)
+{
+	int *waiting = argv[0];
+	waiting[client->priority_class]++;
+	return 0;
+}
+
+static inline int od_console_show_pool_classes_add_cb(od_route_t *route,
+						      void **argv)
+{
+	machine_msg_t *stream = argv[0];
+	od_rule_t *rule = route->rule;
+
+	/* queued clients of every class */
+	int waiting[OD_RULE_PRIORITY_CLASS_MAX];
+	memset(waiting, 0, sizeof(waiting));
+	void *count_argv[] = { waiting };
+	od_route_lock(route);
+	od_client_pool_foreach(&route->client_pool, OD_CLIENT_QUEUE,
+			       od_console_pool_classes_count_cb, count_argv);
+	od_route_unlock(route);
+
+	for (int k = 0; k < rule->priority_classes_count; k++) {
+		od_rule_priority_class_t *class = &rule->priority_classes[k];
+		od_hist_t *hist = &route->class_wait_hist[k];
+
+		int offset;
+		machine_msg_t *msg;
+		msg = kiwi_be_write_data_row(stream, &offset);
+		if (msg == NULL)
+			return NOT_OK_RESPONSE;
+		int rc;
+		rc = kiwi_be_write_data_row_add(stream, offset,
+						route->id.database,
+						route->id.database_len - 1);
+		if (rc == NOT_OK_RESPONSE)
+			return rc;
+		rc = kiwi_be_write_data_row_add(stream, offset, route->id.user,
+						route->id.user_len - 1);
+		if (rc == NOT_OK_RESPONSE)
+			return rc;
+		rc = kiwi_be_write_data_row_add(stream, offset, class->name,
+						strlen(class->name));
+		if (rc == NOT_OK_RESPONSE)
+			return rc;
+
+		uint64_t values[] = {
+			class->weight,
+			waiting[k],
+			od_atomic_u64_of(&hist->count),
+			od_hist_avg(hist),
+			od_hist_quantile(hist, 0.99),
+		};
+		for (size_t j = 0; j < sizeof(values) / sizeof(values[0]);
+		     j++) {
+			char data[64];
+			int data_len;
+			data_len = od_snprintf(data, sizeof(data), "%" PRIu64,
+					       values[j]);
+			rc = kiwi_be_write_data_row_add(stream, offset, data,
+							data_len);
+			if (rc == NOT_OK_RESPONSE)
+				return rc;
+		}
+	}
+	return OK_RESPONSE;
+}
+
+static inline int od_console_show_pool_classes(od_client_t *client,
+					       machine_msg_t *stream)
+{
+	assert(stream);
+	od_router_t *router = client->global->router;
+
+	machine_msg_t *msg;
+	msg = kiwi_be_write_row_descriptionf(
+		stream, "ssslllll", "database", "user", "class", "weight",
+		"cl_waiting", "wait_count", "wait_avg_us", "wait_p99_us");
+	if (msg == NULL)
+		return NOT_OK_RESPONSE;
+
+	void *argv[] = { stream };
+	int rc;
+	rc = od_router_foreach(router, od_console_show_pool_classes_add_cb,
+			       argv);
+	if (rc == NOT_OK_RESPONSE)
+		return rc;
+	return kiwi_be_write_complete(stream, "SHOW", 5);
+}
+
+static inline int od_console_show_prewarm_add_cb(od_route_t *route,
+						 void **argv)
+{
+	machine_msg_t *stream = argv[0];
+	od_route_prewarm_t *prewarm = &route->prewarm;
+
+	if (route->rule->pool->prewarm == 0)
+		return 0;
+
+	int offset;
+	machine_msg_t *msg;
+	msg = kiwi_be_write_data_row(stream, &offset);
+	if (msg == NULL)
+		return NOT_OK_RESPONSE;
+	int rc;
+	rc = kiwi_be_write_data_row_add(stream, offset, route->id.database,
+					route->id.database_len - 1);
+	if (rc == NOT_OK_RESPONSE)
+		return rc;
+	rc = kiwi_be_write_data_row_add(stream, offset, route->id.user,
+					route->id.user_len - 1);
+	if (rc == NOT_OK_RESPONSE)
+		return rc;
+	char *state;
+	state = od_prewarm_state_to_str(od_atomic_u32_of(&prewarm->state));
+	rc = kiwi_be_write_data_row_add(stream, offset, state, strlen(state));
+	if (rc == NOT_OK_RESPONSE)
+		return rc;
+
+	uint64_t start_us = od_atomic_u64_of(&prewarm->start_us);
+	uint64_t done_us = od_atomic_u64_of(&prewarm->done_us);
+	uint64_t time_ms = 0;
+	if (start_us)
+		time_ms = ((done_us ? done_us : machine_time_us()) - start_us) /
+			  1000;
+
+	uint64_t values[] = {
+		od_atomic_u32_of(&prewarm->target),
+		od_atomic_u32_of(&prewarm->opened),
+		od_atomic_u32_of(&prewarm->failed),
+		od_atomic_u32_of(&prewarm->inflight),
+		time_ms,
+	};
+	for (size_t j = 0; j < sizeof(values) / sizeof(values[0]); j++) {
+		char data[64];
+		int data_len;
+		data_len = od_snprintf(data, sizeof(data), "%" PRIu64,
+				       values[j]);
+		rc = kiwi_be_write_data_row_add(stream, offset, data,
+						data_len);
+		if (rc == NOT_OK_RESPONSE)
+			return rc;
+	}
+	return OK_RESPONSE;
+}
+
+static inline int od_console_show_prewarm(od_client_t *client,
+					  machine_msg_t *stream)
+{
+	assert(stream);
+	od_router_t *router = client->global->router;
+
+	machine_msg_t *msg;
+	msg = kiwi_be_write_row_descriptionf(stream, "ssslllll", "database",
+					     "user", "state", "target",
+					     "opened", "failed", "pending",
+					     "time_ms");
+	if (msg == NULL)
+		return NOT_OK_RESPONSE;
+
+	void *argv[] = { stream };
+	int rc;
+	rc = od_router_foreach(router, od_console_show_prewarm_add_cb, argv);
+	if (rc == NOT_OK_RESPONSE)
+		return rc;
+	return kiwi_be_write_complete(stream, "SHOW", 5);
+}
+
+/* kernel tls offloads in use by the connection */
+static inline size_t od_console_ktls(machine_io_t *io, char *data, int size)
+{
+	int ktls = 0;
+	if (io)
+		ktls = machine_io_ktls(io);
+	char *value = "";
+	if (ktls == (MACHINE_KTLS_SEND | MACHINE_KTLS_RECV))
+		value = "tx,rx";
+	else if (ktls & MACHINE_KTLS_SEND)
+		value = "tx";
+	else if (ktls & MACHINE_KTLS_RECV)
+		value = "rx";
+	return od_snprintf(data, size, "%s", value);
+}
+
 static inline int od_console_show_servers_server_cb(od_server_t *server,
 						    void **argv)
 {
@@ -1080,11 +1331,40 @@ static inline int od_console_show_servers_server_cb(od_server_t *server,
 	data_len = od_snprintf(data, sizeof(data), "%s",
 			       route->rule->storage->tls_opts->tls);
 	rc = kiwi_be_write_data_row_add(msg, offset, data, data_len);
+	if (rc == NOT_OK_RESPONSE)
+		return NOT_OK_RESPONSE;
+	/* ktls */
+	data_len = od_console_ktls(server->io.io, data, sizeof(data));
+	rc = kiwi_be_write_data_row_add(msg, offset, data, data_len);
 	if (rc == NOT_OK_RESPONSE)
 		return NOT_OK_RESPONSE;
 	/* offline */
 	data_len = od_snprintf(data, sizeof(data), "%d", server->offline);
 	rc = kiwi_be_write_data_row_add(msg, offset, data, data_len);
+	if (rc == NOT_OK_RESPONSE)
+		return NOT_OK_RESPONSE;
+	/* endpoint latency */
+	uint64_t connect_ewma_us = 0;
+	uint64_t query_ewma_us = 0;
+	if (server->endpoint) {
+		od_storage_endpoint_stat_t *stat = &server->endpoint->stat;
+		connect_ewma_us = od_atomic_u64_of(&stat->connect_ewma_us);
+		query_ewma_us = od_atomic_u64_of(&stat->query_ewma_us);
+	}
+	/* connect_ewma_us */
+	data_len = od_snprintf(data, sizeof(data), "%" PRIu64, connect_ewma_us);
+	rc = kiwi_be_write_data_row_add(msg, offset, data, data_len);
+	if (rc == NOT_OK_RESPONSE)
+		return NOT_OK_RESPONSE;
+	/* query_ewma_us */
+	data_len = od_snprintf(data, sizeof(data), "%" PRIu64, query_ewma_us);
+	rc = kiwi_be_write_data_row_add(msg, offset, data, data_len);
+	if (rc == NOT_OK_RESPONSE)
+		return NOT_OK_RESPONSE;
+	/* readahead */
+	data_len = od_snprintf(data, sizeof(data), "%d",
+			       server->io.readahead.size);
+	rc = kiwi_be_write_data_row_add(msg, offset, data, data_len);
 	if (rc == NOT_OK_RESPONSE)
 		return NOT_OK_RESPONSE;
 	return 0;
@@ -1135,99 +1415,84 @@ static inline int od_console_show_fds_server_cb(od_server_t *server,
 	return 0;
 }
 
-static inline int od_console_show_server_prep_stmt_cb(od_server_t *server,
-						      void **argv)
+static inline int od_console_show_server_prep_stmt_row(od_pstmt_t *stmt,
+						       void **argv)
 {
+	machine_msg_t *stream = argv[0];
+	od_server_t *server = argv[1];
 	od_route_t *route = server->route;
-	od_hashmap_t *hm = server->prep_stmts;
-
-	for (size_t i = 0; i < hm->size; ++i) {
-		od_hashmap_bucket_t *bucket = hm->buckets[i];
-		pthread_mutex_lock(&bucket->mu);
-
-		od_list_t *i;
-		od_list_foreach(&(bucket->nodes->link), i)
-		{
-			int offset;
-			machine_msg_t *stream = argv[0];
-			machine_msg_t *msg;
-			msg = kiwi_be_write_data_row(stream, &offset);
-			if (msg == NULL) {
-				goto error;
-			}
 
-			/* type */
-			char data[64];
-			size_t data_len;
-			data_len = od_snprintf(data, sizeof(data), "S");
-
-			int rc;
-			rc = kiwi_be_write_data_row_add(stream, offset, data,
-							data_len);
-			if (rc == NOT_OK_RESPONSE) {
-				goto error;
-			}
+	int offset;
+	machine_msg_t *msg;
+	msg = kiwi_be_write_data_row(stream, &offset);
+	if (msg == NULL) {
+		return NOT_OK_RESPONSE;
+	}
 
-			/* user */
-			rc = kiwi_be_write_data_row_add(stream, offset,
-							route->id.user,
-							route->id.user_len - 1);
-			if (rc == NOT_OK_RESPONSE) {
-				goto error;
-			}
+	/* type */
+	char data[64];
+	size_t data_len;
+	data_len = od_snprintf(data, sizeof(data), "S");
 
-			/* database */
-			rc = kiwi_be_write_data_row_add(
-				stream, offset, route->id.database,
-				route->id.database_len - 1);
-			if (rc == NOT_OK_RESPONSE) {
-				goto error;
-			}
+	int rc;
+	rc = kiwi_be_write_data_row_add(stream, offset, data, data_len);
+	if (rc == NOT_OK_RESPONSE) {
+		return NOT_OK_RESPONSE;
+	}
 
-			/* sid */
-			data_len = od_snprintf(data, sizeof(data), "%s%.*s",
-					       server->id.id_prefix,
-					       (signed)sizeof(server->id.id),
-					       server->id.id);
-			rc = kiwi_be_write_data_row_add(msg, offset, data,
-							data_len);
-			if (rc == NOT_OK_RESPONSE) {
-				goto error;
-			}
+	/* user */
+	rc = kiwi_be_write_data_row_add(stream, offset, route->id.user,
+					route->id.user_len - 1);
+	if (rc == NOT_OK_RESPONSE) {
+		return NOT_OK_RESPONSE;
+	}
 
-			od_hashmap_list_item_t *item;
-			item = od_container_of(i, od_hashmap_list_item_t, link);
-			od_hashmap_elt_t *prep_stmt = &item->key;
-			od_hashmap_elt_t *prep_stmt_desc = &item->value;
+	/* database */
+	rc = kiwi_be_write_data_row_add(stream, offset, route->id.database,
+					route->id.database_len - 1);
+	if (rc == NOT_OK_RESPONSE) {
+		return NOT_OK_RESPONSE;
+	}
 
-			/* description */
-			rc = kiwi_be_write_data_row_add(stream, offset,
-							prep_stmt->data,
-							prep_stmt->len);
-			if (rc == NOT_OK_RESPONSE) {
-				goto error;
-			}
+	/* sid */
+	data_len = od_snprintf(data, sizeof(data), "%s%.*s",
+			       server->id.id_prefix,
+			       (signed)sizeof(server->id.id), server->id.id);
+	rc = kiwi_be_write_data_row_add(msg, offset, data, data_len);
+	if (rc == NOT_OK_RESPONSE) {
+		return NOT_OK_RESPONSE;
+	}
 
-			/*refcount */
-			data_len = od_snprintf(data, sizeof(data), "%d",
-					       prep_stmt_desc->data);
-			rc = kiwi_be_write_data_row_add(stream, offset, data,
-							data_len);
-			if (rc == NOT_OK_RESPONSE) {
-				goto error;
-			}
-		}
+	/* description */
+	rc = kiwi_be_write_data_row_add(stream, offset, stmt->data, stmt->len);
+	if (rc == NOT_OK_RESPONSE) {
+		return NOT_OK_RESPONSE;
+	}
 
-		pthread_mutex_unlock(&bucket->mu);
-		continue;
-	error:
-		pthread_mutex_unlock(&bucket->mu);
+	/* refcount: clients and servers holding the statement */
+	data_len = od_snprintf(data, sizeof(data), "%u",
+			       od_atomic_u32_of(&stmt->refs));
+	rc = kiwi_be_write_data_row_add(stream, offset, data, data_len);
+	if (rc == NOT_OK_RESPONSE) {
 		return NOT_OK_RESPONSE;
 	}
 
 	return 0;
 }
 
+static inline int od_console_show_server_prep_stmt_cb(od_server_t *server,
+						      void **argv)
+{
+	if (server->prep_stmts == NULL) {
+		return 0;
+	}
+
+	void *argv_row[] = { argv[0], server };
+	return od_pstmt_map_foreach(server->prep_stmts,
+				    od_console_show_server_prep_stmt_row,
+				    argv_row);
+}
+
 static inline int od_console_show_servers_cb(od_route_t *route, void **argv)
 {
 	od_route_lock(route);
@@ -1279,10 +1544,11 @@ static inline int od_console_show_servers(od_client_t *client,
 
 	machine_msg_t *msg;
 	msg = kiwi_be_write_row_descriptionf(
-		stream, "sssssdsdssddssdss", "type", "user", "database",
+		stream, "sssssdsdssddssdssslld", "type", "user", "database",
 		"state", "addr", "port", "local_addr", "local_port",
 		"connect_time", "request_time", "wait", "wait_us", "ptr",
-		"link", "remote_pid", "tls", "offline");
+		"link", "remote_pid", "tls", "ktls", "offline",
+		"connect_ewma_us", "query_ewma_us", "readahead");
 	if (msg == NULL)
 		return NOT_OK_RESPONSE;
 
@@ -1389,6 +1655,81 @@ static inline int od_console_show_host_utilization(od_client_t *client,
 				      sizeof("HOST_UTILIZATION"));
 }
 
+static inline int od_console_show_workers(od_client_t *client,
+					  machine_msg_t *stream)
+{
+	od_worker_pool_t *worker_pool = client->global->worker_pool;
+
+	machine_msg_t *msg;
+	msg = kiwi_be_write_row_descriptionf(
+		stream, "sllflllll", "worker", "clients_active",
+		"clients_processed", "cpu", "stacks", "stacks_hot",
+		"stacks_reclaimed", "stack_hwm", "readahead_pooled");
+	if (msg == NULL)
+		return NOT_OK_RESPONSE;
+
+	for (uint32_t i = 0; i < worker_pool->count; i++) {
+		od_worker_t *worker = &worker_pool->pool[i];
+
+		int offset;
+		if (kiwi_be_write_data_row(stream, &offset) == NULL)
+			return NOT_OK_RESPONSE;
+
+		char data[64];
+		int data_len;
+		int rc;
+		data_len = od_snprintf(data, sizeof(data), "worker[%d]",
+				       worker->id);
+		rc = kiwi_be_write_data_row_add(stream, offset, data,
+						data_len);
+		if (rc != OK_RESPONSE)
+			return rc;
+
+		data_len = od_snprintf(
+			data, sizeof(data), "%" PRIu32,
+			od_atomic_u32_of(&worker->clients_active));
+		rc = kiwi_be_write_data_row_add(stream, offset, data,
+						data_len);
+		if (rc != OK_RESPONSE)
+			return rc;
+
+		data_len = od_snprintf(data, sizeof(data), "%" PRIu64,
+				       worker->clients_processed);
+		rc = kiwi_be_write_data_row_add(stream, offset, data,
+						data_len);
+		if (rc != OK_RESPONSE)
+			return rc;
+
+		/* cpu load is kept in per mille */
+		data_len = od_snprintf(data, sizeof(data), "%.1f",
+				       od_atomic_u32_of(&worker->cpu_load) /
+					       10.0);
+		rc = kiwi_be_write_data_row_add(stream, offset, data,
+						data_len);
+		if (rc != OK_RESPONSE)
+			return rc;
+
+		/* maintained by the worker machine */
+		od_atomic_u64_t *stacks[] = { &worker->stacks_used,
+					      &worker->stacks_hot,
+					      &worker->stacks_reclaimed,
+					      &worker->stack_hwm,
+					      &worker->readahead_pool.pooled };
+		for (size_t j = 0; j < sizeof(stacks) / sizeof(stacks[0]);
+		     j++) {
+			data_len = od_snprintf(data, sizeof(data),
+					       "%" PRIu64,
+					       od_atomic_u64_of(stacks[j]));
+			rc = kiwi_be_write_data_row_add(stream, offset, data,
+							data_len);
+			if (rc != OK_RESPONSE)
+				return rc;
+		}
+	}
+
+	return kiwi_be_write_complete(stream, "SHOW", 5);
+}
+
 static inline int od_console_show_clients_callback(od_client_t *client,
 						   void **argv)
 {
@@ -1507,6 +1848,47 @@ static inline int od_console_show_clients_callback(od_client_t *client,
 	/* tls */
 	data_len = od_snprintf(data, sizeof(data), "%s", "");
 	rc = kiwi_be_write_data_row_add(stream, offset, data, data_len);
+	if (rc == NOT_OK_RESPONSE)
+		return NOT_OK_RESPONSE;
+	/* ktls */
+	data_len = od_console_ktls(client->io.io, data, sizeof(data));
+	rc = kiwi_be_write_data_row_add(stream, offset, data, data_len);
+	if (rc == NOT_OK_RESPONSE)
+		return NOT_OK_RESPONSE;
+	/* compression */
+	uint64_t tx_raw, tx, rx_raw, rx;
+	char algorithm;
+	algorithm = machine_compression_stat(client->io.io, &tx_raw, &tx,
+					     &rx_raw, &rx);
+	data_len = 0;
+	if (algorithm != MM_ZPQ_NO_COMPRESSION)
+		data_len = od_snprintf(data, sizeof(data), "%c", algorithm);
+	rc = kiwi_be_write_data_row_add(stream, offset, data, data_len);
+	if (rc == NOT_OK_RESPONSE)
+		return NOT_OK_RESPONSE;
+	/* compression_ratio */
+	double ratio = 1;
+	if (tx + rx > 0)
+		ratio = (double)(tx_raw + rx_raw) / (tx + rx);
+	data_len = od_snprintf(data, sizeof(data), "%.2f", ratio);
+	rc = kiwi_be_write_data_row_add(stream, offset, data, data_len);
+	if (rc == NOT_OK_RESPONSE)
+		return NOT_OK_RESPONSE;
+	/* compressed_bytes */
+	data_len = od_snprintf(data, sizeof(data), "%" PRIu64, tx + rx);
+	rc = kiwi_be_write_data_row_add(stream, offset, data, data_len);
+	if (rc == NOT_OK_RESPONSE)
+		return NOT_OK_RESPONSE;
+	/* raw_bytes */
+	data_len = od_snprintf(data, sizeof(data), "%" PRIu64,
+			       tx_raw + rx_raw);
+	rc = kiwi_be_write_data_row_add(stream, offset, data, data_len);
+	if (rc == NOT_OK_RESPONSE)
+		return NOT_OK_RESPONSE;
+	/* readahead */
+	data_len = od_snprintf(data, sizeof(data), "%d",
+			       client->io.readahead.size);
+	rc = kiwi_be_write_data_row_add(stream, offset, data, data_len);
 	if (rc == NOT_OK_RESPONSE)
 		return NOT_OK_RESPONSE;
 	return 0;
@@ -1538,10 +1920,12 @@ static inline int od_console_show_clients(od_client_t *client,
 
 	machine_msg_t *msg;
 	msg = kiwi_be_write_row_descriptionf(
-		stream, "ssssssdsdssddssdds", "type", "user", "database",
+		stream, "ssssssdsdssddssddsssflld", "type", "user", "database",
 		"state", "storage_user", "addr", "port", "local_addr",
 		"local_port", "connect_time", "request_time", "wait", "wait_us",
-		"id", "ptr", "coro", "remote_pid", "tls");
+		"id", "ptr", "coro", "remote_pid", "tls", "ktls", "compression",
+		"compression_ratio", "compressed_bytes", "raw_bytes",
+		"readahead");
 	if (msg == NULL)
 		return NOT_OK_RESPONSE;
 
@@ -1598,7 +1982,7 @@ static inline int od_console_show_lists(od_client_t *client,
 	   router_used_servers can be inconsistent here, since it depends on
 	   separate route locks.
 	*/
-	od_router_lock(router);
+	od_router_rdlock(router);
 
 	int router_used_servers = 0;
 	int router_free_servers = 0;
@@ -1873,6 +2257,154 @@ error:
 	return rc;
 }
 
+static inline int od_console_show_auth_cache(od_client_t *client,
+					     machine_msg_t *stream)
+{
+	assert(stream);
+	od_router_t *router = client->global->router;
+
+	machine_msg_t *msg;
+	msg = kiwi_be_write_row_descriptionf(
+		stream, "sslllllll", "database", "user", "entries", "hits",
+		"negative_hits", "misses", "waits", "refreshes", "errors");
+	if (msg == NULL) {
+		return NOT_OK_RESPONSE;
+	}
+
+	od_rules_t *rules = &router->rules;
+
+	int rc = OK_RESPONSE;
+	int offset;
+
+	pthread_mutex_lock(&rules->mu);
+
+	od_list_t *i;
+	od_list_foreach(&rules->rules, i)
+	{
+		od_rule_t *rule;
+		rule = od_container_of(i, od_rule_t, link);
+		if (rule->obsolete || rule->auth_query == NULL ||
+		    rule->storage == NULL || rule->storage->acache == NULL) {
+			continue;
+		}
+		od_auth_cache_t *cache = rule->storage->acache;
+
+		msg = kiwi_be_write_data_row(stream, &offset);
+		if (msg == NULL) {
+			rc = NOT_OK_RESPONSE;
+			goto error;
+		}
+
+		rc = kiwi_be_write_data_row_add(stream, offset, rule->db_name,
+						strlen(rule->db_name));
+		if (rc == NOT_OK_RESPONSE) {
+			goto error;
+		}
+		rc = kiwi_be_write_data_row_add(stream, offset,
+						rule->user_name,
+						strlen(rule->user_name));
+		if (rc == NOT_OK_RESPONSE) {
+			goto error;
+		}
+
+		uint64_t values[] = {
+			od_auth_cache_count(cache),
+			od_atomic_u64_of(&cache->hits),
+			od_atomic_u64_of(&cache->negative_hits),
+			od_atomic_u64_of(&cache->misses),
+			od_atomic_u64_of(&cache->waits),
+			od_atomic_u64_of(&cache->refreshes),
+			od_atomic_u64_of(&cache->errors),
+		};
+		for (size_t j = 0; j < sizeof(values) / sizeof(values[0]);
+		     j++) {
+			char data[64];
+			int data_len;
+			data_len = od_snprintf(data, sizeof(data), "%" PRIu64,
+					       values[j]);
+			rc = kiwi_be_write_data_row_add(stream, offset, data,
+							data_len);
+			if (rc == NOT_OK_RESPONSE) {
+				goto error;
+			}
+		}
+	}
+
+	pthread_mutex_unlock(&rules->mu);
+	return kiwi_be_write_complete(stream, "SHOW", 5);
+error:
+	pthread_mutex_unlock(&rules->mu);
+	return rc;
+}
+
+static inline int od_console_show_crypto(od_client_t *client,
+					 machine_msg_t *stream)
+{
+	assert(stream);
+	od_crypto_pool_t *pool = &client->global->crypto_pool;
+
+	machine_msg_t *msg;
+	msg = kiwi_be_write_row_descriptionf(
+		stream, "slllllll", "stage", "count", "inline", "queue_avg_us",
+		"queue_p99_us", "exec_avg_us", "exec_p50_us", "exec_p99_us");
+	if (msg == NULL) {
+		return NOT_OK_RESPONSE;
+	}
+
+	for (int stage = 0; stage < OD_CRYPTO_STAGE_MAX; stage++) {
+		od_crypto_stat_t *stat = &pool->stat[stage];
+
+		int offset;
+		msg = kiwi_be_write_data_row(stream, &offset);
+		if (msg == NULL) {
+			return NOT_OK_RESPONSE;
+		}
+
+		char *name = od_crypto_stage_to_str(stage);
+		int rc;
+		rc = kiwi_be_write_data_row_add(stream, offset, name,
+						strlen(name));
+		if (rc == NOT_OK_RESPONSE) {
+			return rc;
+		}
+
+		uint64_t count = od_atomic_u64_of(&stat->exec.count);
+		uint64_t queued = od_atomic_u64_of(&stat->queue.count);
+		uint64_t queue_avg = 0;
+		if (queued) {
+			queue_avg =
+				od_atomic_u64_of(&stat->queue.sum_us) / queued;
+		}
+		uint64_t exec_avg = 0;
+		if (count) {
+			exec_avg = od_atomic_u64_of(&stat->exec.sum_us) / count;
+		}
+		uint64_t values[] = {
+			count,
+			od_atomic_u64_of(&stat->inline_count),
+			queue_avg,
+			od_hist_quantile(&stat->queue, 0.99),
+			exec_avg,
+			od_hist_quantile(&stat->exec, 0.5),
+			od_hist_quantile(&stat->exec, 0.99),
+		};
+		for (size_t j = 0; j < sizeof(values) / sizeof(values[0]);
+		     j++) {
+			char data[64];
+			int data_len;
+			data_len = od_snprintf(data, sizeof(data), "%" PRIu64,
+					       values[j]);
+			rc = kiwi_be_write_data_row_add(stream, offset, data,
+							data_len);
+			if (rc == NOT_OK_RESPONSE) {
+				return rc;
+			}
+		}
+	}
+
+	return kiwi_be_write_complete(stream, "SHOW", 5);
+}
+
 static inline int od_console_show(od_client_t *client, machine_msg_t *stream,
 				  od_parser_t *parser)
 {
@@ -1900,6 +2432,10 @@ static inline int od_console_show(od_client_t *client, machine_msg_t *stream,
 		return od_console_show_pools(client, stream, false);
 	case OD_LPOOLS_EXTENDED:
 		return od_console_show_pools(client, stream, true);
+	case OD_LPOOL_CLASSES:
+		return od_console_show_pool_classes(client, stream);
+	case OD_LPREWARM:
+		return od_console_show_prewarm(client, stream);
 	case OD_LDATABASES:
 		return od_console_show_databases(client, stream);
 	case OD_LSERVER_PREP_STMTS:
@@ -1920,12 +2456,18 @@ static inline int od_console_show(od_client_t *client, machine_msg_t *stream,
 		return od_console_show_listen(client, stream);
 	case OD_LSTORAGES:
 		return od_console_show_storages(client, stream);
+	case OD_LAUTH_CACHE:
+		return od_console_show_auth_cache(client, stream);
+	case OD_LCRYPTO:
+		return od_console_show_crypto(client, stream);
 	case OD_LFDS:
 		return od_console_show_fds(client, stream);
 	case OD_LIS_PAUSED:
 		return od_console_show_is_paused(client, stream);
 	case OD_LHOST_UTILIZATION:
 		return od_console_show_host_utilization(client, stream);
+	case OD_LWORKERS:
+		return od_console_show_workers(client, stream);
 	}
 	return NOT_OK_RESPONSE;
 }
@@ -1937,6 +2479,7 @@ static inline int od_console_pause(od_client_t *client, machine_msg_t *stream)
 	od_log(&instance->logger, "pause", client, NULL, "global pause is on");
 
 	od_global_pause(client->global);
+	od_worker_pool_wakeup(client->global->worker_pool);
 
 	return kiwi_be_write_complete(stream, "PAUSE", 6);
 }
@@ -1968,6 +2511,7 @@ static inline int od_console_kill_client(od_client_t *client,
 	memcpy(id.id, token.value.string.pointer + 1, sizeof(id.id));
 
 	od_router_kill(client->global->router, &id);
+	od_worker_pool_wakeup(client->global->worker_pool);
 	return 0;
 }
 
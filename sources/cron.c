@@ -36,6 +36,9 @@ static int od_cron_stat_cb(od_route_t *route, od_stat_t *current,
 		uint64_t avg_query_time;
 		uint64_t avg_recv_client;
 		uint64_t avg_recv_server;
+		od_auth_cache_t *auth_cache;
+		od_rule_storage_t *storage;
+		int endpoint_active[OD_STORAGE_MAX_ENDPOINTS];
 	} info;
 
 	od_route_lock(route);
@@ -58,6 +61,24 @@ static int od_cron_stat_cb(od_route_t *route, od_stat_t *current,
 	info.avg_recv_server = avg->recv_server;
 	info.avg_recv_client = avg->recv_client;
 
+	info.auth_cache = NULL;
+	if (route->rule->auth_query) {
+		info.auth_cache = route->rule->storage->acache;
+	}
+
+	info.storage = route->rule->storage;
+	for (size_t i = 0; i < info.storage->endpoints_count; ++i) {
+		od_storage_endpoint_t *endpoint = &info.storage->endpoints[i];
+		od_multi_pool_element_t *element;
+		element = od_multi_pool_get(route->server_pools,
+					    &endpoint->address);
+		info.endpoint_active[i] = 0;
+		if (element != NULL) {
+			info.endpoint_active[i] =
+				od_multi_pool_element_count_active(element);
+		}
+	}
+
 	od_route_unlock(route);
 
 #ifdef PROM_FOUND
@@ -69,6 +90,35 @@ static int od_cron_stat_cb(od_route_t *route, od_stat_t *current,
 			info.avg_count_tx, info.avg_tx_time,
 			info.avg_count_query, info.avg_query_time,
 			info.avg_recv_client, info.avg_recv_server);
+		if (info.auth_cache) {
+			od_auth_cache_t *cache = info.auth_cache;
+			od_prom_metrics_write_auth_cache_stat(
+				metrics, info.user, info.database,
+				od_atomic_u64_of(&cache->hits),
+				od_atomic_u64_of(&cache->negative_hits),
+				od_atomic_u64_of(&cache->misses),
+				od_atomic_u64_of(&cache->waits),
+				od_atomic_u64_of(&cache->refreshes));
+		}
+		od_prom_metrics_write_pool_wait_stat(metrics, info.user,
+						     info.database,
+						     &route->wait_hist);
+		od_prom_metrics_write_reset_stat(
+			metrics, info.user, info.database,
+			od_atomic_u32_of(&route->resets), &route->reset_hist);
+		for (size_t i = 0; i < info.storage->endpoints_count; ++i) {
+			od_storage_endpoint_t *endpoint;
+			endpoint = &info.storage->endpoints[i];
+			od_storage_endpoint_stat_t *stat = &endpoint->stat;
+			char addr[256];
+			od_address_to_str(&endpoint->address, addr,
+					  sizeof(addr) - 1);
+			od_prom_metrics_write_endpoint_stat(
+				metrics, info.user, info.database, addr,
+				od_atomic_u64_of(&stat->connect_ewma_us),
+				od_atomic_u64_of(&stat->query_ewma_us),
+				info.endpoint_active[i]);
+		}
 		if (instance->config.log_route_stats_prom) {
 			char *prom_log =
 				(char *)od_prom_metrics_get_stat_cb(metrics);
@@ -117,6 +167,57 @@ static inline void request_worker_stats(od_worker_pool_t *worker_pool)
 	}
 }
 
+static inline void od_cron_crypto_stat(od_cron_t *cron)
+{
+	od_instance_t *instance = cron->global->instance;
+	od_crypto_pool_t *pool = &cron->global->crypto_pool;
+
+	for (int stage = 0; stage < OD_CRYPTO_STAGE_MAX; stage++) {
+		od_crypto_stat_t *stat = &pool->stat[stage];
+		uint64_t count = od_atomic_u64_of(&stat->exec.count);
+		if (count == 0)
+			continue;
+		char *name = od_crypto_stage_to_str(stage);
+#ifdef PROM_FOUND
+		if (instance->config.log_general_stats_prom)
+			od_prom_metrics_write_crypto_stat(cron->metrics, name,
+							  stat);
+#endif
+		od_log(&instance->logger, "stats", NULL, NULL,
+		       "crypto %s: %" PRIu64 " tasks (%" PRIu64
+		       " inline), exec p50 %" PRIu64 " us, p99 %" PRIu64
+		       " us, queue p99 %" PRIu64 " us",
+		       name, count, od_atomic_u64_of(&stat->inline_count),
+		       od_hist_quantile(&stat->exec, 0.5),
+		       od_hist_quantile(&stat->exec, 0.99),
+		       od_hist_quantile(&stat->queue, 0.99));
+	}
+}
+
+static inline void od_cron_readahead_stat(od_cron_t *cron)
+{
+	od_instance_t *instance = cron->global->instance;
+	od_worker_pool_t *worker_pool = cron->global->worker_pool;
+
+	/* per pool held may wrap, since servers move between workers */
+	uint64_t held = od_readahead_held_unpooled();
+	uint64_t pooled = 0;
+	for (uint32_t i = 0; i < worker_pool->count; i++) {
+		od_readahead_pool_t *pool;
+		pool = &worker_pool->pool[i].readahead_pool;
+		held += od_atomic_u64_of(&pool->held);
+		pooled += od_atomic_u64_of(&pool->pooled);
+	}
+#ifdef PROM_FOUND
+	if (instance->config.log_general_stats_prom)
+		od_prom_metrics_write_readahead_stat(cron->metrics, held,
+						     pooled);
+#endif
+	od_log(&instance->logger, "stats", NULL, NULL,
+	       "readahead: %" PRIu64 " bytes held, %" PRIu64 " bytes pooled",
+	       held, pooled);
+}
+
 static inline void od_cron_stat(od_cron_t *cron)
 {
 	od_router_t *router = cron->global->router;
@@ -163,6 +264,10 @@ static inline void od_cron_stat(od_cron_t *cron)
 		/* request stats per worker */
 		request_worker_stats(worker_pool);
 
+		od_cron_crypto_stat(cron);
+
+		od_cron_readahead_stat(cron);
+
 		request_logger_stats(&instance->logger);
 
 		od_log(&instance->logger, "stats", NULL, NULL, "clients %d",
@@ -281,6 +386,9 @@ static void od_cron(void *arg)
 		/* create server connections if pool size is less than min_pool_size */
 		od_cron_keep_min_pool_sizes(cron);
 
+		/* adjust adaptive pool sizes */
+		od_router_pool_size_step(cron->global->router);
+
 		/* update statistics */
 		if (++stats_tick >= instance->config.stats_interval) {
 			od_cron_stat(cron);
@@ -289,6 +397,9 @@ static void od_cron(void *arg)
 
 		od_cron_err_stat(cron);
 
+		/* update workers load for dispatching */
+		od_worker_pool_update_load(cron->global->worker_pool);
+
 		/* 1 second soft interval */
 		machine_sleep(1000);
 	}
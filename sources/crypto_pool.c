@@ -0,0 +1,287 @@
+
+/*
+ * Odyssey.
+ *
+ * Scalable PostgreSQL connection pooler.
+ */
+
+#include <kiwi.h>
+#include <machinarium.h>
+#include <odyssey.h>
+
+/* queued task is abandoned by the caller after this time, in ms */
+#define OD_CRYPTO_QUEUE_TIMEOUT 1000
+
+typedef enum {
+	OD_CRYPTO_TASK_QUEUED,
+	OD_CRYPTO_TASK_RUNNING,
+	OD_CRYPTO_TASK_CANCELLED
+} od_crypto_task_state_t;
+
+typedef struct {
+	od_atomic_u32_t state;
+	od_crypto_pool_t *pool;
+	od_crypto_stage_t stage;
+	od_crypto_function_t function;
+	void *arg;
+	int rc;
+	uint64_t time_queued_us;
+	machine_channel_t *reply;
+} od_crypto_task_t;
+
+char *od_crypto_stage_to_str(od_crypto_stage_t stage)
+{
+	switch (stage) {
+	case OD_CRYPTO_SCRAM_FRONTEND:
+		return "scram_frontend";
+	case OD_CRYPTO_SCRAM_BACKEND:
+		return "scram_backend";
+	case OD_CRYPTO_TLS_FRONTEND:
+		return "tls_frontend";
+	case OD_CRYPTO_TLS_BACKEND:
+		return "tls_backend";
+	default:
+		return "unknown";
+	}
+}
+
+void od_crypto_pool_init(od_crypto_pool_t *pool)
+{
+	memset(pool, 0, sizeof(od_crypto_pool_t));
+}
+
+static inline void od_crypto_task_free(od_crypto_task_t *task)
+{
+	machine_channel_free(task->reply);
+	od_free(task);
+}
+
+/*
+ * Take the task from the queue. Cancelled task was abandoned by the
+ * caller and is freed by the reader of its message.
+ */
+static inline int od_crypto_task_take(od_crypto_task_t *task)
+{
+	uint32_t state;
+	state = od_atomic_u32_cas(&task->state, OD_CRYPTO_TASK_QUEUED,
+				  OD_CRYPTO_TASK_RUNNING);
+	if (state == OD_CRYPTO_TASK_QUEUED)
+		return 1;
+	assert(state == OD_CRYPTO_TASK_CANCELLED);
+	od_crypto_task_free(task);
+	return 0;
+}
+
+static inline void od_crypto_task_reply(od_crypto_task_t *task)
+{
+	/* task is owned by the caller and must not be used after reply */
+	machine_channel_t *reply = task->reply;
+	machine_msg_t *msg = machine_msg_create(0);
+	if (msg == NULL)
+		abort();
+	machine_msg_set_type(msg, OD_MSG_CRYPTO_TASK);
+	machine_channel_write(reply, msg);
+}
+
+static void od_crypto_task_run(void *arg)
+{
+	od_crypto_task_t *task = arg;
+	od_crypto_stat_t *stat = &task->pool->stat[task->stage];
+
+	uint64_t start = machine_time_us();
+	uint64_t wait = 0;
+	if (start > task->time_queued_us)
+		wait = start - task->time_queued_us;
+	od_hist_observe(&stat->queue, wait);
+	od_atomic_u32_dec(&task->pool->queued);
+
+	task->rc = task->function(task->arg);
+	od_hist_observe(&stat->exec, machine_time_us() - start);
+
+	od_crypto_task_reply(task);
+}
+
+static void od_crypto_worker(void *arg)
+{
+	od_crypto_pool_t *pool = arg;
+
+	for (;;) {
+		machine_msg_t *msg;
+		msg = machine_channel_read(pool->channel, UINT32_MAX);
+		if (msg == NULL)
+			continue;
+
+		od_msg_t msg_type = machine_msg_type(msg);
+		if (msg_type == OD_MSG_SHUTDOWN) {
+			machine_msg_free(msg);
+			break;
+		}
+		assert(msg_type == OD_MSG_CRYPTO_TASK);
+
+		od_crypto_task_t *task;
+		task = *(od_crypto_task_t **)machine_msg_data(msg);
+		machine_msg_free(msg);
+		if (!od_crypto_task_take(task))
+			continue;
+
+		int64_t id;
+		id = machine_coroutine_create(od_crypto_task_run, task);
+		if (id == -1) {
+			/* caller is waiting, run it here */
+			od_crypto_task_run(task);
+		}
+	}
+
+	/* do not wait for handshakes still in progress */
+	machine_stop_current();
+}
+
+int od_crypto_pool_start(od_crypto_pool_t *pool, int count, int queue_limit)
+{
+	pool->queue_limit = queue_limit;
+	if (count <= 0)
+		return OK_RESPONSE;
+
+	pool->channel = machine_channel_create();
+	if (pool->channel == NULL)
+		return NOT_OK_RESPONSE;
+	pool->machines = od_malloc(sizeof(int64_t) * count);
+	if (pool->machines == NULL)
+		return NOT_OK_RESPONSE;
+
+	for (int i = 0; i < count; i++) {
+		char name[32];
+		od_snprintf(name, sizeof(name), "crypto: %d", i);
+		pool->machines[i] = machine_create(name, od_crypto_worker,
+						   pool);
+		if (pool->machines[i] == -1)
+			return NOT_OK_RESPONSE;
+		/* tasks are offloaded only once a machine is running */
+		pool->count = i + 1;
+	}
+	return OK_RESPONSE;
+}
+
+void od_crypto_pool_stop(od_crypto_pool_t *pool)
+{
+	/* new tasks run inline, workers finish tasks queued before */
+	od_atomic_u32_set(&pool->stopping, 1);
+	for (int i = 0; i < pool->count; i++) {
+		machine_msg_t *msg;
+		msg = machine_msg_create(0);
+		if (msg == NULL)
+			return;
+		machine_msg_set_type(msg, OD_MSG_SHUTDOWN);
+		machine_channel_write(pool->channel, msg);
+	}
+}
+
+void od_crypto_pool_free(od_crypto_pool_t *pool)
+{
+	for (int i = 0; i < pool->count; i++)
+		machine_wait(pool->machines[i]);
+	pool->count = 0;
+
+	/* fail tasks queued after workers have stopped */
+	if (pool->channel) {
+		machine_msg_t *msg;
+		while ((msg = machine_channel_read(pool->channel, 0))) {
+			od_crypto_task_t *task = NULL;
+			if (machine_msg_type(msg) == OD_MSG_CRYPTO_TASK)
+				task = *(od_crypto_task_t **)machine_msg_data(
+					msg);
+			machine_msg_free(msg);
+			if (task == NULL || !od_crypto_task_take(task))
+				continue;
+			od_atomic_u32_dec(&pool->queued);
+			task->rc = -1;
+			od_crypto_task_reply(task);
+		}
+		machine_channel_free(pool->channel);
+	}
+	if (pool->machines)
+		od_free(pool->machines);
+	pool->channel = NULL;
+	pool->machines = NULL;
+}
+
+static inline int od_crypto_pool_run_inline(od_crypto_pool_t *pool,
+					    od_crypto_stage_t stage,
+					    od_crypto_function_t function,
+					    void *arg)
+{
+	od_crypto_stat_t *stat = &pool->stat[stage];
+	od_atomic_u64_inc(&stat->inline_count);
+	uint64_t start = machine_time_us();
+	int rc = function(arg);
+	od_hist_observe(&stat->exec, machine_time_us() - start);
+	return rc;
+}
+
+int od_crypto_pool_run(od_crypto_pool_t *pool, od_crypto_stage_t stage,
+		       od_crypto_function_t function, void *arg)
+{
+	if (!od_crypto_pool_enabled(pool) || od_atomic_u32_of(&pool->stopping))
+		return od_crypto_pool_run_inline(pool, stage, function, arg);
+
+	uint32_t queued = od_atomic_u32_inc(&pool->queued);
+	if (pool->queue_limit > 0 && queued >= (uint32_t)pool->queue_limit) {
+		od_atomic_u32_dec(&pool->queued);
+		return od_crypto_pool_run_inline(pool, stage, function, arg);
+	}
+
+	od_crypto_task_t *task;
+	task = od_malloc(sizeof(od_crypto_task_t));
+	if (task == NULL)
+		goto fallback;
+	task->state = OD_CRYPTO_TASK_QUEUED;
+	task->pool = pool;
+	task->stage = stage;
+	task->function = function;
+	task->arg = arg;
+	task->rc = -1;
+	task->reply = machine_channel_create();
+	if (task->reply == NULL) {
+		od_free(task);
+		goto fallback;
+	}
+
+	machine_msg_t *msg;
+	msg = machine_msg_create(sizeof(od_crypto_task_t *));
+	if (msg == NULL) {
+		od_crypto_task_free(task);
+		goto fallback;
+	}
+	machine_msg_set_type(msg, OD_MSG_CRYPTO_TASK);
+	memcpy(machine_msg_data(msg), &task, sizeof(task));
+
+	task->time_queued_us = machine_time_us();
+	machine_channel_write(pool->channel, msg);
+
+	/*
+	 * Task still queued after the timeout is abandoned to the reader of
+	 * its message and run here. Once taken, the task may use the caller
+	 * data, so wait for the reply whatever happens.
+	 */
+	machine_msg_t *reply;
+	for (;;) {
+		reply = machine_channel_read(task->reply,
+					     OD_CRYPTO_QUEUE_TIMEOUT);
+		if (reply)
+			break;
+		uint32_t state;
+		state = od_atomic_u32_cas(&task->state, OD_CRYPTO_TASK_QUEUED,
+					  OD_CRYPTO_TASK_CANCELLED);
+		if (state == OD_CRYPTO_TASK_QUEUED)
+			goto fallback;
+	}
+	machine_msg_free(reply);
+
+	int rc = task->rc;
+	od_crypto_task_free(task);
+	return rc;
+
+fallback:
+	od_atomic_u32_dec(&pool->queued);
+	return od_crypto_pool_run_inline(pool, stage, function, arg);
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+/*
+ * Odyssey.
+ *
+ * Scalable PostgreSQL connection pooler.
+ */
+
+/*
+ * Crypto pool.
+ *
+ * Dedicated machines for CPU-heavy authentication steps (SCRAM key
+ * derivation, TLS handshakes), so a login burst does not stall relay
+ * of established clients on the worker. The calling coroutine passes
+ * a task through the shared channel and suspends on its reply channel.
+ * Task not picked up by a crypto machine in time is run by the caller.
+ * Every task runs in its own coroutine on the crypto machine, so TLS
+ * handshakes waiting for the peer do not block each other.
+ *
+ * With zero crypto workers, or when queue limit is reached, tasks run
+ * inline on the caller worker.
+ */
+
+typedef struct od_crypto_pool od_crypto_pool_t;
+typedef struct od_crypto_stat od_crypto_stat_t;
+
+typedef enum {
+	OD_CRYPTO_SCRAM_FRONTEND,
+	OD_CRYPTO_SCRAM_BACKEND,
+	OD_CRYPTO_TLS_FRONTEND,
+	OD_CRYPTO_TLS_BACKEND,
+	OD_CRYPTO_STAGE_MAX
+} od_crypto_stage_t;
+
+struct od_crypto_stat {
+	/* time task waited for a crypto worker */
+	od_hist_t queue;
+	/* time task was executed */
+	od_hist_t exec;
+	/* tasks executed on the caller worker */
+	od_atomic_u64_t inline_count;
+};
+
+typedef int (*od_crypto_function_t)(void *);
+
+struct od_crypto_pool {
+	int count;
+	int queue_limit;
+	int64_t *machines;
+	machine_channel_t *channel;
+	od_atomic_u32_t queued;
+	od_atomic_u32_t stopping;
+	od_crypto_stat_t stat[OD_CRYPTO_STAGE_MAX];
+};
+
+void od_crypto_pool_init(od_crypto_pool_t *);
+int od_crypto_pool_start(od_crypto_pool_t *, int count, int queue_limit);
+void od_crypto_pool_stop(od_crypto_pool_t *);
+/* wait for stopped workers */
+void od_crypto_pool_free(od_crypto_pool_t *);
+
+static inline int od_crypto_pool_enabled(od_crypto_pool_t *pool)
+{
+	return pool->count > 0;
+}
+
+/* run function on the crypto pool and return its result */
+int od_crypto_pool_run(od_crypto_pool_t *, od_crypto_stage_t,
+		       od_crypto_function_t, void *);
+
+char *od_crypto_stage_to_str(od_crypto_stage_t);
@@ -19,6 +19,12 @@ int od_deploy(od_client_t *client, char *context)
 		return 0;
 	}
 
+	/* vars did not change since the last deploy with nothing to set */
+	if (od_server_vars_synced(server, &client->vars)) {
+		server->synced_settings = true;
+		return 0;
+	}
+
 	/* compare and set options which are differs from server */
 	int query_count;
 	query_count = 0;
@@ -48,6 +54,8 @@ int od_deploy(od_client_t *client, char *context)
 			 "deploy: %s", query);
 	} else {
 		client->server->synced_settings = true;
+		server->synced_client_vars = client->vars.fingerprint;
+		server->synced_server_vars = server->vars.fingerprint;
 	}
 
 	return query_count;
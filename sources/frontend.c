@@ -193,7 +193,13 @@ static inline int candidate_cmp_desc(const void *v1, const void *v2)
 	const od_endpoint_attach_candidate_t *c1 = v1;
 	const od_endpoint_attach_candidate_t *c2 = v2;
 
-	return c2->priority - c1->priority;
+	if (c1->priority != c2->priority) {
+		return c2->priority - c1->priority;
+	}
+	if (c1->score != c2->score) {
+		return c1->score < c2->score ? -1 : 1;
+	}
+	return 0;
 }
 
 static inline int od_frontend_attach_candidate_get_priority(
@@ -206,14 +212,15 @@ static inline int od_frontend_attach_candidate_get_priority(
 	 * - prefer_localhost: for serice accounts connections
 	 * - az: we should use same az as of odyssey instance if it is possible
 	 * - tsa match: even if it is outdated, rw state of endpoint doesn't change frequently
-	 * - random number: to select host randomly between several suitable hosts
 	 * 
 	 * so:
 	 * + 1000 priority by localhost address
 	 * + 500 priority by matched az
 	 * + 200 priority by matched tsa
-	 * + [0..100) shuffle coeff
 	 * 
+	 * endpoints of the same priority are ordered by score of
+	 * endpoints_balancing
+	 *
 	 * also negative priority will mean endpoints, that is not suitable,
 	 * ex: endpoints which read-write status certanly doesn't fit tsa
 	 */
@@ -222,8 +229,6 @@ static inline int od_frontend_attach_candidate_get_priority(
 
 	int priority = 0;
 
-	priority += machine_lrand48() % 100;
-
 	od_storage_endpoint_status_t status;
 	od_storage_endpoint_status_init(&status);
 	od_storage_endpoint_status_get(&endpoint->status, &status);
@@ -252,8 +257,61 @@ static inline int od_frontend_attach_candidate_get_priority(
 	return priority;
 }
 
+static inline void
+od_frontend_attach_candidates_score(od_route_t *route,
+				    od_rule_storage_t *storage,
+				    od_endpoint_attach_candidate_t *candidates)
+{
+	size_t count = storage->endpoints_count;
+
+	if (storage->endpoints_balancing == OD_STORAGE_BALANCING_RANDOM) {
+		for (size_t i = 0; i < count; ++i) {
+			candidates[i].score = machine_lrand48();
+		}
+		return;
+	}
+
+	if (storage->endpoints_balancing == OD_STORAGE_BALANCING_ROUND_ROBIN) {
+		size_t start = atomic_fetch_add(&storage->rr_counter, 1);
+		start %= count;
+		for (size_t i = 0; i < count; ++i) {
+			candidates[i].score = (i + count - start) % count;
+		}
+		return;
+	}
+
+	/* servers attached to clients or connecting, per endpoint */
+	int active[OD_STORAGE_MAX_ENDPOINTS];
+	for (size_t i = 0; i < count; ++i) {
+		od_multi_pool_element_t *element;
+		element = od_multi_pool_get(route->server_pools,
+					    &candidates[i].endpoint->address);
+		active[i] = 0;
+		if (element != NULL) {
+			active[i] = od_multi_pool_element_count_active(element);
+		}
+	}
+
+	for (size_t i = 0; i < count; ++i) {
+		uint64_t cost = active[i];
+		if (storage->endpoints_balancing ==
+		    OD_STORAGE_BALANCING_LATENCY) {
+			/*
+			 * expected wait of a new query, endpoints without
+			 * samples go first to get measured
+			 */
+			cost = od_storage_endpoint_latency(
+				       candidates[i].endpoint) *
+			       (active[i] + 1);
+		}
+		/* low bits break ties randomly */
+		candidates[i].score = (cost << 16) |
+				      (machine_lrand48() & 0xffff);
+	}
+}
+
 void od_frontend_attach_init_candidates(
-	od_instance_t *instance, od_rule_storage_t *storage,
+	od_instance_t *instance, od_route_t *route, od_rule_storage_t *storage,
 	od_endpoint_attach_candidate_t *candidates,
 	od_target_session_attrs_t tsa, int prefer_localhost)
 {
@@ -262,6 +320,7 @@ void od_frontend_attach_init_candidates(
 	for (size_t i = 0; i < count; ++i) {
 		candidates[i].endpoint = &storage->endpoints[i];
 		candidates[i].priority = 0;
+		candidates[i].score = 0;
 	}
 
 	if (count == 1) {
@@ -275,6 +334,8 @@ void od_frontend_attach_init_candidates(
 				prefer_localhost);
 	}
 
+	od_frontend_attach_candidates_score(route, storage, candidates);
+
 	qsort(candidates, count, sizeof(od_endpoint_attach_candidate_t),
 	      candidate_cmp_desc);
 }
@@ -303,6 +364,7 @@ static inline od_frontend_status_t od_frontend_attach_to_endpoint(
 		}
 
 		od_server_t *server = client->server;
+		server->endpoint = endpoint;
 		if (server->io.io && !machine_connected(server->io.io)) {
 			od_log(&instance->logger, context, client, server,
 			       "server disconnected, close connection and retry attach");
@@ -325,11 +387,19 @@ static inline od_frontend_status_t od_frontend_attach_to_endpoint(
 			od_atomic_u32_inc(&router->servers_routing);
 
 			assert(client->config_listen != NULL);
+			uint64_t connect_start = machine_time_us();
+			uint64_t connect_timeout_us =
+				instance->config.backend_connect_timeout_ms *
+				1000ULL;
 			rc = od_backend_connect(server, context, route_params,
 						client);
 
 			od_atomic_u32_dec(&router->servers_routing);
 			if (rc == NOT_OK_RESPONSE) {
+				/* failed endpoint looks as slow as timeout */
+				od_storage_endpoint_ewma_update(
+					&endpoint->stat.connect_ewma_us,
+					connect_timeout_us);
 				/* In case of 'too many connections' error, retry attach attempt by
 				* waiting for a idle server connection for pool_timeout ms
 				*/
@@ -348,6 +418,9 @@ static inline od_frontend_status_t od_frontend_attach_to_endpoint(
 				}
 				return OD_ESERVER_CONNECT;
 			}
+			od_storage_endpoint_ewma_update(
+				&endpoint->stat.connect_ewma_us,
+				machine_time_us() - connect_start);
 		}
 
 		int rc = od_backend_startup_preallocated(server, route_params,
@@ -387,8 +460,8 @@ od_frontend_attach(od_client_t *client, char *context,
 	od_target_session_attrs_t tsa = od_tsa_get_effective(client);
 
 	od_endpoint_attach_candidate_t candidates[OD_STORAGE_MAX_ENDPOINTS];
-	od_frontend_attach_init_candidates(instance, storage, candidates, tsa,
-					   0 /* prefer localhost */);
+	od_frontend_attach_init_candidates(instance, route, storage, candidates,
+					   tsa, 0 /* prefer localhost */);
 
 	od_frontend_status_t status = OD_EATTACH;
 
@@ -1075,6 +1148,11 @@ od_frontend_remote_server_handle_packet(od_relay_t *relay, char *data, int size)
 		int64_t query_time = 0;
 		od_stat_query_end(&route->stats, &server->stats_state,
 				  server->is_transaction, &query_time);
+		if (server->endpoint && query_time > 0) {
+			od_storage_endpoint_ewma_update(
+				&server->endpoint->stat.query_ewma_us,
+				query_time);
+		}
 		if (instance->config.log_debug && query_time > 0) {
 			od_debug(&instance->logger, "main", server->client,
 				 server, "query time: %" PRIi64 " microseconds",
@@ -1106,7 +1184,7 @@ od_frontend_remote_server_handle_packet(od_relay_t *relay, char *data, int size)
 		}
 	} else {
 		if (is_ready_for_query && od_server_synchronized(server) &&
-		    server->parse_msg == NULL) {
+		    server->parse_stmt == NULL) {
 			if (od_frontend_should_detach_on_ready_for_query(
 				    route, server)) {
 				return OD_DETACH;
@@ -1249,32 +1327,26 @@ od_frontend_rewrite_msg(char *data, int size, int opname_start_offset,
 
 static od_frontend_status_t od_frontend_deploy_prepared_stmt(
 	od_server_t *server, __attribute__((unused)) od_relay_t *relay,
-	char *ctx, char *data, int size /* to adcance or to write? */,
-	od_hash_t body_hash, char *opname, int opnamelen)
+	char *ctx, od_pstmt_t *stmt, char *opname, int opnamelen)
 {
 	od_route_t *route = server->route;
 	od_instance_t *instance = server->global->instance;
 	od_client_t *client = server->client;
 
-	od_hashmap_elt_t desc;
-	desc.data = data;
-	desc.len = size;
-
 	od_debug(&instance->logger, ctx, client, server,
-		 "statement: %.*s, hash: %08x", desc.len, desc.data, body_hash);
-
-	int refcnt = 0;
-	od_hashmap_elt_t value;
-	value.data = &refcnt;
-	value.len = sizeof(int);
-	od_hashmap_elt_t *value_ptr = &value;
+		 "statement: %.*s, hash: %08x", stmt->len, stmt->data,
+		 stmt->hash);
 
 	/* send parse msg if needed */
-	if (od_hashmap_insert(server->prep_stmts, body_hash, &desc,
-			      &value_ptr) == 0) {
+	int rc;
+	rc = od_pstmt_map_add(server->prep_stmts, stmt);
+	if (rc == -1) {
+		return OD_ESERVER_WRITE;
+	}
+	if (rc == 1) {
 		od_debug(&instance->logger, ctx, client, server,
-			 "deploy %.*s operator %.*s to server", desc.len,
-			 desc.data, opnamelen, opname);
+			 "deploy %.*s operator %.*s to server", stmt->len,
+			 stmt->data, opnamelen, opname);
 		/*
 		 * rewrite msg
 		 * allocate prepered statement under name equal to body hash
@@ -1284,7 +1356,7 @@ static od_frontend_status_t od_frontend_deploy_prepared_stmt(
 
 		machine_msg_t *pmsg;
 		pmsg = kiwi_fe_write_parse_description(NULL, opname, opnamelen,
-						       desc.data, desc.len);
+						       stmt->data, stmt->len);
 		if (pmsg == NULL) {
 			return OD_ESERVER_WRITE;
 		}
@@ -1306,10 +1378,6 @@ static od_frontend_status_t od_frontend_deploy_prepared_stmt(
 
 		return OD_OK;
 	} else {
-		int *refcnt;
-		refcnt = value_ptr->data;
-		*refcnt = 1 + *refcnt;
-
 		od_stat_parse_reuse(&route->stats);
 		return OD_OK;
 	}
@@ -1320,17 +1388,14 @@ od_frontend_deploy_prepared_stmt_msg(od_server_t *server, od_relay_t *relay,
 				     char *ctx)
 {
 	od_frontend_status_t rc;
-	char *data = machine_msg_data(server->parse_msg);
-	int size = machine_msg_size(server->parse_msg);
-
-	od_hash_t body_hash = od_murmur_hash(data, size);
 	char opname[OD_HASH_LEN];
-	od_snprintf(opname, OD_HASH_LEN, "%08x", body_hash);
-	rc = od_frontend_deploy_prepared_stmt(server, relay, ctx, data, size,
-					      body_hash, opname, OD_HASH_LEN);
+	od_snprintf(opname, OD_HASH_LEN, "%08x", server->parse_stmt->hash);
+	rc = od_frontend_deploy_prepared_stmt(server, relay, ctx,
+					      server->parse_stmt, opname,
+					      OD_HASH_LEN);
 
-	machine_msg_free(server->parse_msg);
-	server->parse_msg = NULL;
+	od_pstmt_store_release(&server->global->pstmts, server->parse_stmt);
+	server->parse_stmt = NULL;
 	return rc;
 }
 
@@ -1628,7 +1693,7 @@ od_frontend_remote_client_handle_packet(od_relay_t *relay, char *data, int size)
 	   configuration */
 	od_server_t *server = client->server;
 	assert(server != NULL);
-	assert(server->parse_msg == NULL);
+	assert(server->parse_stmt == NULL);
 
 	/* XXX: reset query state on transaction block bound here.  */
 	switch (type) {
@@ -1668,7 +1733,7 @@ od_frontend_remote_client_handle_packet(od_relay_t *relay, char *data, int size)
 				od_debug(&instance->logger, "simple query",
 					 client, server,
 					 "discard detected, invalidate caches");
-				od_hashmap_empty(server->prep_stmts);
+				od_pstmt_map_empty(server->prep_stmts);
 			}
 		}
 
@@ -1710,34 +1775,27 @@ od_frontend_remote_client_handle_packet(od_relay_t *relay, char *data, int size)
 			assert(client->prep_stmt_ids);
 			retstatus = OD_SKIP;
 
-			od_hashmap_elt_t key;
-			key.len = operator_name_len;
-			key.data = operator_name;
+			od_pstmt_t *stmt = od_pstmt_map_find(
+				client->prep_stmt_ids, operator_name,
+				operator_name_len);
 
-			od_hash_t keyhash = od_murmur_hash(key.data, key.len);
-			od_hashmap_elt_t *desc = od_hashmap_find(
-				client->prep_stmt_ids, keyhash, &key);
-
-			if (desc == NULL) {
+			if (stmt == NULL) {
 				od_debug(
 					&instance->logger, "remote client",
 					client, server,
-					"%.*s (len %d) (%u) operator was not prepared by this client",
+					"%.*s (len %d) operator was not prepared by this client",
 					operator_name_len, operator_name,
-					operator_name_len, keyhash);
+					operator_name_len);
 				return OD_ESERVER_WRITE;
 			}
 
-			od_hash_t body_hash =
-				od_murmur_hash(desc->data, desc->len);
 			char opname[OD_HASH_LEN];
-			od_snprintf(opname, OD_HASH_LEN, "%08x", body_hash);
+			od_snprintf(opname, OD_HASH_LEN, "%08x", stmt->hash);
 
 			/* fill internals structs in, send parse if needed */
 			if (od_frontend_deploy_prepared_stmt(
 				    server, &server->relay, "parse before bind",
-				    desc->data, desc->len, body_hash, opname,
-				    OD_HASH_LEN) != OD_OK) {
+				    stmt, opname, OD_HASH_LEN) != OD_OK) {
 				return OD_ESERVER_WRITE;
 			}
 
@@ -1777,44 +1835,44 @@ od_frontend_remote_client_handle_packet(od_relay_t *relay, char *data, int size)
 				return OD_ECLIENT_READ;
 			}
 
-			od_hash_t keyhash = od_murmur_hash(
-				desc.operator_name, desc.operator_name_len);
+			od_hash_t body_hash = od_murmur_hash(
+				desc.description, desc.description_len);
 			od_debug(&instance->logger, "parse", client, server,
-				 "saving %.*s operator hash %u",
+				 "saving %.*s operator body hash %08x",
 				 desc.operator_name_len, desc.operator_name,
-				 keyhash);
-
-			od_hashmap_elt_t key;
-			key.len = desc.operator_name_len;
-			key.data = desc.operator_name;
+				 body_hash);
 
-			od_hashmap_elt_t value;
-			value.len = desc.description_len;
-			value.data = desc.description;
-
-			od_hashmap_elt_t *value_ptr = &value;
-
-			server->parse_msg =
-				machine_msg_create(desc.description_len);
-			if (server->parse_msg == NULL) {
+			od_pstmt_t *stmt = od_pstmt_store_acquire(
+				&client->global->pstmts, body_hash,
+				desc.description, desc.description_len);
+			if (stmt == NULL) {
 				return OD_ESERVER_WRITE;
 			}
-			memcpy(machine_msg_data(server->parse_msg),
-			       desc.description, desc.description_len);
 
 			assert(client->prep_stmt_ids);
-			if (od_hashmap_insert(client->prep_stmt_ids, keyhash,
-					      &key, &value_ptr)) {
-				if (value_ptr->len != desc.description_len ||
-				    strncmp(desc.description, value_ptr->data,
-					    value_ptr->len) != 0) {
-					/*
-					* Raise error:
-					* client allocated prepared stmt with same name
-					*/
-					return OD_ESERVER_WRITE;
-				}
+			rc = od_pstmt_map_set(client->prep_stmt_ids,
+					      desc.operator_name,
+					      desc.operator_name_len, stmt);
+			if (rc == 1) {
+				/* name is used by another statement */
+				od_frontend_error(
+					client, KIWI_DUPLICATE_PSTATEMENT,
+					"prepared statement \"%.*s\" already exists",
+					desc.operator_name_len,
+					desc.operator_name);
 			}
+			if (rc != OK_RESPONSE) {
+				od_pstmt_store_release(&client->global->pstmts,
+						       stmt);
+				return OD_ESERVER_WRITE;
+			}
+
+			/* deployed on sync point, keeps the reference */
+			if (server->parse_stmt) {
+				od_pstmt_store_release(&client->global->pstmts,
+						       server->parse_stmt);
+			}
+			server->parse_stmt = stmt;
 
 			server->sync_point_deploy_msg =
 				kiwi_be_write_parse_complete(NULL);
@@ -1841,25 +1899,18 @@ od_frontend_remote_client_handle_packet(od_relay_t *relay, char *data, int size)
 				return OD_ECLIENT_READ;
 			}
 
-			od_hashmap_elt_t key;
-			key.len = operator_name_len;
-			key.data = operator_name;
-
-			od_hash_t keyhash = od_murmur_hash(key.data, key.len);
-
-			od_hashmap_elt_t *desc =
-				(od_hashmap_elt_t *)od_hashmap_find(
-					client->prep_stmt_ids, keyhash, &key);
-			if (desc == NULL) {
+			od_pstmt_t *stmt = od_pstmt_map_find(
+				client->prep_stmt_ids, operator_name,
+				operator_name_len);
+			if (stmt == NULL) {
 				char errbuf[OD_QRY_MAX_SZ];
 				int errlen;
 
 				od_debug(
 					&instance->logger, "remote client",
 					client, server,
-					"%.*s (%u) operator was not prepared by this client",
-					operator_name_len, operator_name,
-					keyhash);
+					"%.*s operator was not prepared by this client",
+					operator_name_len, operator_name);
 
 				assert(server->sync_point_deploy_msg == NULL);
 
@@ -1877,13 +1928,10 @@ od_frontend_remote_client_handle_packet(od_relay_t *relay, char *data, int size)
 				return OD_REQ_SYNC;
 			}
 
-			od_hash_t body_hash =
-				od_murmur_hash(desc->data, desc->len);
-
 			int invalidate = 0;
 
-			if (desc->len >= 7) {
-				if (strncmp(desc->data, "DISCARD", 7) == 0) {
+			if (stmt->len >= 7) {
+				if (strncmp(stmt->data, "DISCARD", 7) == 0) {
 					od_debug(
 						&instance->logger,
 						"rewrite bind", client, server,
@@ -1893,13 +1941,12 @@ od_frontend_remote_client_handle_packet(od_relay_t *relay, char *data, int size)
 			}
 
 			char opname[OD_HASH_LEN];
-			od_snprintf(opname, OD_HASH_LEN, "%08x", body_hash);
+			od_snprintf(opname, OD_HASH_LEN, "%08x", stmt->hash);
 
 			/* fill internals structs in, send parse if needed */
 			if (od_frontend_deploy_prepared_stmt(
 				    server, &server->relay, "parse before bind",
-				    desc->data, desc->len, body_hash, opname,
-				    OD_HASH_LEN) != OD_OK) {
+				    stmt, opname, OD_HASH_LEN) != OD_OK) {
 				return OD_ESERVER_WRITE;
 			}
 
@@ -1911,7 +1958,7 @@ od_frontend_remote_client_handle_packet(od_relay_t *relay, char *data, int size)
 
 			machine_msg_t *msg;
 			if (invalidate) {
-				od_hashmap_empty(server->prep_stmts);
+				od_pstmt_map_empty(server->prep_stmts);
 			}
 
 			msg = od_frontend_rewrite_msg(data, size,
@@ -2091,12 +2138,6 @@ od_frontend_remote_process_server(od_client_t *client, bool await_read)
 		od_relay_detach(&client->relay);
 		od_relay_stop(&server->relay);
 
-		/* cleanup server */
-		rc = od_reset(server);
-		if (rc != 1) {
-			return OD_ESERVER_WRITE;
-		}
-
 		od_debug(&instance->logger, "detach", client, server,
 			 "client %s%.*s detached from %s%.*s",
 			 client->id.id_prefix,
@@ -2104,8 +2145,21 @@ od_frontend_remote_process_server(od_client_t *client, bool await_read)
 			 server->id.id_prefix,
 			 (int)sizeof(server->id.id_prefix), server->id.id);
 
-		/* push server connection back to route pool */
 		od_router_t *router = client->global->router;
+
+		/* discard queries are run while client goes on */
+		if (od_reset_deferrable(server)) {
+			od_router_detach_reset(router, client);
+			return OD_OK;
+		}
+
+		/* cleanup server */
+		rc = od_reset(server);
+		if (rc != 1) {
+			return OD_ESERVER_WRITE;
+		}
+
+		/* push server connection back to route pool */
 		od_router_detach(router, client);
 		server = NULL;
 	} else if (status != OD_OK) {
@@ -2150,10 +2204,77 @@ od_frontend_check_replica_catchup(od_instance_t *instance, od_client_t *client)
 	return status;
 }
 
+/*
+ * Idle clients are not polled: they wait for io without timeout, or
+ * until the nearest idle timeout deadline. Kill, pause and shutdown
+ * wake them up through the worker.
+ */
+static inline uint32_t od_frontend_activity_timeout(od_client_t *client)
+{
+	od_instance_t *instance = client->global->instance;
+	od_server_t *server = client->server;
+	od_rule_pool_t *pool = client->rule->pool;
+
+	/* connections are dropped on restart with a rate, retry */
+	if (od_unlikely(instance->shutdown_worker_id != INVALID_COROUTINE_ID))
+		return 1000;
+
+	if (pool->pool_type != OD_RULE_POOL_SESSION || server == NULL ||
+	    !od_server_synchronized(server))
+		return UINT32_MAX;
+
+	uint64_t timeout_us = server->is_transaction ?
+				      pool->idle_in_transaction_timeout :
+				      pool->client_idle_timeout;
+	if (timeout_us == 0)
+		return UINT32_MAX;
+
+	uint64_t now_us = machine_time_us();
+	uint64_t deadline_us = client->time_last_active + timeout_us;
+	if (deadline_us < now_us)
+		return 1;
+	/* connection is dropped when deadline has passed */
+	uint64_t timeout_ms = (deadline_us - now_us) / 1000 + 1;
+	if (timeout_ms >= UINT32_MAX)
+		return UINT32_MAX;
+	return timeout_ms;
+}
+
+static inline int od_frontend_io_ready(od_relay_t *relay)
+{
+	if (relay->src == NULL || relay->src->on_read == NULL)
+		return 0;
+	if (!machine_cond_try(relay->src->on_read))
+		return 0;
+	/* leave the event to the relay step */
+	machine_cond_signal(relay->src->on_read);
+	return 1;
+}
+
 static int wait_client_activity(od_client_t *client)
 {
+	uint32_t timeout_ms = od_frontend_activity_timeout(client);
+
+	/* no query in flight, read buffers are taken again on io */
+	od_server_t *server = client->server;
+	if (server == NULL || od_server_synchronized(server)) {
+		od_relay_release(&client->relay);
+		if (server != NULL)
+			od_relay_release(&server->relay);
+	}
+
 	/* io_cond is set up by client or server relay */
-	if (machine_cond_wait(client->io_cond, 10 * 1000 /* 10 sec */) == 0) {
+	if (machine_cond_wait(client->io_cond, timeout_ms) == 0) {
+		if (client->wakeup) {
+			/* kill, pause or shutdown, not a client activity,
+			 * unless io arrived in the same io_cond signal */
+			client->wakeup = 0;
+			server = client->server;
+			if (!od_frontend_io_ready(&client->relay) &&
+			    (server == NULL ||
+			     !od_frontend_io_ready(&server->relay)))
+				return 1;
+		}
 		client->time_last_active = machine_time_us();
 		od_dbg_printf_on_dvl_lvl(
 			1, "change client last active time %lld\n",
@@ -2361,7 +2482,7 @@ static od_frontend_status_t od_frontend_remote(od_client_t *client)
 			}
 
 			/* If we have pending parse message, do deploy */
-			if (server->parse_msg != NULL) {
+			if (server->parse_stmt != NULL) {
 				/* fill internals structs in */
 				if (od_frontend_deploy_prepared_stmt_msg(
 					    server, &server->relay,
@@ -2461,7 +2582,6 @@ static void od_frontend_cleanup(od_client_t *client, char *context,
 	od_router_t *router = client->global->router;
 	od_route_t *route = client->route;
 	char peer[128];
-	int rc;
 
 	od_server_t *server = client->server;
 
@@ -2487,14 +2607,8 @@ static void od_frontend_cleanup(od_client_t *client, char *context,
 		if (!client->server)
 			break;
 
-		rc = od_reset(server);
-		if (rc != 1) {
-			/* close backend connection */
-			od_router_close(router, client);
-			break;
-		}
-		/* push server to router server pool */
-		od_router_detach(router, client);
+		/* client is gone, reset server in background */
+		od_router_detach_reset(router, client);
 		break;
 
 	case OD_EOOM:
@@ -2550,16 +2664,8 @@ static void od_frontend_cleanup(od_client_t *client, char *context,
 		       od_frontend_status_to_str(status));
 		if (!client->server)
 			break;
-		rc = od_reset(server);
-		if (rc != 1) {
-			/* close backend connection */
-			od_log(&instance->logger, context, client, server,
-			       "reset unsuccessful, closing server connection");
-			od_router_close(router, client);
-			break;
-		}
-		/* push server to router server pool */
-		od_router_detach(router, client);
+		/* client is gone, reset server in background */
+		od_router_detach_reset(router, client);
 		break;
 
 	case OD_ESERVER_CONNECT:
@@ -2628,6 +2734,28 @@ static void od_frontend_cleanup(od_client_t *client, char *context,
 	}
 }
 
+static void od_frontend_priority_class(od_client_t *client)
+{
+	od_rule_t *rule = client->route->rule;
+	if (rule->priority_classes_count == 1)
+		return;
+
+	char appname[KIWI_MAX_VAR_SIZE + 1];
+	char *appname_ptr = NULL;
+	kiwi_var_t *var;
+	var = kiwi_vars_get(&client->vars, KIWI_VAR_APPLICATION_NAME);
+	if (var) {
+		memcpy(appname, var->value, var->value_len);
+		appname[var->value_len] = 0;
+		appname_ptr = appname;
+	}
+	int port = 0;
+	if (client->config_listen)
+		port = client->config_listen->port;
+	client->priority_class =
+		od_rules_priority_class_match(rule, appname_ptr, port);
+}
+
 static void od_application_name_add_host(od_client_t *client)
 {
 	if (client == NULL || client->io.io == NULL)
@@ -2749,6 +2877,8 @@ void od_frontend(void *arg)
 			goto cleanup;
 		}
 
+		od_frontend_priority_class(client);
+
 		char peer[128];
 		od_getpeername(client->io.io, peer, sizeof(peer), 1, 0);
 
@@ -83,10 +83,12 @@ void od_frontend(void *);
 typedef struct {
 	od_storage_endpoint_t *endpoint;
 	int priority;
+	/* order within the same priority, lower is better */
+	uint64_t score;
 } od_endpoint_attach_candidate_t;
 
 void od_frontend_attach_init_candidates(
-	od_instance_t *instance, od_rule_storage_t *storage,
+	od_instance_t *instance, od_route_t *route, od_rule_storage_t *storage,
 	od_endpoint_attach_candidate_t *candidates,
 	od_target_session_attrs_t tsa, int prefer_localhost);
 
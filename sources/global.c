@@ -31,6 +31,14 @@ int od_global_init(od_global_t *global, od_instance_t *instance,
 
 	memset(&global->host_watcher, 0, sizeof(global->host_watcher));
 
+	od_crypto_pool_init(&global->crypto_pool);
+
+	if (od_pstmt_store_init(&global->pstmts) != OK_RESPONSE) {
+		od_pstmt_store_free(&global->pstmts);
+		machine_wait_list_destroy(global->resume_waiters);
+		return 1;
+	}
+
 	return 0;
 }
 
@@ -79,6 +87,15 @@ od_instance_t *od_global_get_instance()
 	return global->instance;
 }
 
+int od_global_get_workers_count()
+{
+	od_global_t *global = od_global_get();
+	if (global == NULL || global->worker_pool == NULL)
+		return 0;
+
+	return (int)global->worker_pool->count;
+}
+
 int od_global_is_in_soft_oom(od_global_t *global, uint64_t *used_memory)
 {
 	od_config_t *config = &global->instance->config;
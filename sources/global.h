@@ -19,6 +19,12 @@ struct od_global {
 
 	od_host_watcher_t host_watcher;
 
+	/* prepared statements shared by clients and servers */
+	od_pstmt_store_t pstmts;
+
+	/* machines for scram and tls handshakes */
+	od_crypto_pool_t crypto_pool;
+
 	od_atomic_u64_t pause;
 	machine_wait_list_t *resume_waiters;
 };
@@ -41,9 +47,12 @@ od_logger_t *od_global_get_logger();
 
 od_instance_t *od_global_get_instance();
 
+int od_global_get_workers_count();
+
 static inline void od_global_destroy(od_global_t *global)
 {
 	machine_wait_list_destroy(global->resume_waiters);
+	od_pstmt_store_free(&global->pstmts);
 	od_free(global);
 	od_global_set(NULL);
 }
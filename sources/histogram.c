@@ -0,0 +1,48 @@
+
+/*
+ * Odyssey.
+ *
+ * Scalable PostgreSQL connection pooler.
+ */
+
+#include <kiwi.h>
+#include <machinarium.h>
+#include <odyssey.h>
+
+uint64_t od_hist_bucket_le(int bucket)
+{
+	if (bucket >= OD_HIST_BUCKETS - 1)
+		return 0;
+	return 1ULL << (bucket + OD_HIST_MIN_SHIFT);
+}
+
+uint64_t od_hist_quantile(od_hist_t *hist, double q)
+{
+	uint64_t count = od_atomic_u64_of(&hist->count);
+	if (count == 0)
+		return 0;
+	uint64_t rank = (uint64_t)(q * count);
+	uint64_t total = 0;
+	int bucket = 0;
+	for (; bucket < OD_HIST_BUCKETS - 1; bucket++) {
+		total += od_atomic_u64_of(&hist->buckets[bucket]);
+		if (total > rank)
+			break;
+	}
+	if (bucket == OD_HIST_BUCKETS - 1) {
+		/* report +Inf bucket by its lower bound */
+		return od_hist_bucket_le(bucket - 1);
+	}
+	return od_hist_bucket_le(bucket);
+}
+
+void od_hist_observe(od_hist_t *hist, uint64_t time_us)
+{
+	int bucket = 0;
+	while (bucket < OD_HIST_BUCKETS - 1 &&
+	       time_us > od_hist_bucket_le(bucket))
+		bucket++;
+	od_atomic_u64_inc(&hist->buckets[bucket]);
+	od_atomic_u64_inc(&hist->count);
+	od_atomic_u64_add(&hist->sum_us, time_us);
+}
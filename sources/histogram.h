@@ -0,0 +1,44 @@
+#pragma once
+
+/*
+ * Odyssey.
+ *
+ * Scalable PostgreSQL connection pooler.
+ */
+
+/*
+ * Lock-free latency histogram with log2 buckets from 64us up to ~16s,
+ * the last bucket is +Inf.
+ */
+
+#define OD_HIST_BUCKETS 20
+#define OD_HIST_MIN_SHIFT 6
+
+typedef struct od_hist od_hist_t;
+
+struct od_hist {
+	od_atomic_u64_t buckets[OD_HIST_BUCKETS];
+	od_atomic_u64_t count;
+	od_atomic_u64_t sum_us;
+};
+
+static inline void od_hist_init(od_hist_t *hist)
+{
+	memset(hist, 0, sizeof(od_hist_t));
+}
+
+void od_hist_observe(od_hist_t *, uint64_t time_us);
+
+/* upper bound of the bucket in microseconds, 0 for +Inf */
+uint64_t od_hist_bucket_le(int);
+
+/* approximate quantile as upper bound of the bucket it falls into */
+uint64_t od_hist_quantile(od_hist_t *, double);
+
+static inline uint64_t od_hist_avg(od_hist_t *hist)
+{
+	uint64_t count = od_atomic_u64_of(&hist->count);
+	if (count == 0)
+		return 0;
+	return od_atomic_u64_of(&hist->sum_us) / count;
+}
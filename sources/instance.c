@@ -317,9 +317,12 @@ int od_instance_main(od_instance_t *instance, int argc, char **argv)
 
 	/* initialize machinarium */
 	machinarium_set_stack_size(instance->config.coroutine_stack_size);
+	machinarium_set_stack_guard(instance->config.coroutine_stack_guard);
 	machinarium_set_pool_size(instance->config.resolvers);
 	machinarium_set_coroutine_cache_size(instance->config.cache_coroutine);
 	machinarium_set_msg_cache_gc_size(instance->config.cache_msg_gc_size);
+	if (instance->config.poller == OD_CONFIG_POLLER_IO_URING)
+		machinarium_set_poller(MACHINE_POLLER_IO_URING);
 	rc = machinarium_init();
 	if (rc == -1) {
 		od_error(&instance->logger, "init", NULL, NULL,
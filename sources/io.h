@@ -141,6 +141,10 @@ static inline int od_io_read(od_io_t *io, char *dest, int size,
 		if (!read_started)
 			machine_cond_signal(io->on_read);
 
+		rc = od_readahead_acquire(&io->readahead);
+		if (rc == -1)
+			return -1;
+
 		for (;;) {
 			rc = machine_cond_wait(io->on_read, time_ms);
 			if (rc == -1)
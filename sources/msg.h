@@ -9,8 +9,11 @@
 typedef enum {
 	OD_MSG_STAT,
 	OD_MSG_CLIENT_NEW,
+	OD_MSG_SYSTEM_SERVER_NEW,
 	OD_MSG_LOG,
 	OD_MSG_SHUTDOWN,
 	OD_MSG_SIGNAL_RECEIVED,
 	OD_MSG_GRAC_SHUTDOWN_FINISHED,
+	OD_MSG_CRYPTO_TASK,
+	OD_MSG_CLIENT_WAKEUP,
 } od_msg_t;
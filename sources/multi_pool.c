@@ -9,7 +9,15 @@
 void od_multi_pool_element_init(od_multi_pool_element_t *element)
 {
 	od_address_init(&element->address);
+	element->hash = 0;
+	pthread_mutex_init(&element->lock, NULL);
 	od_server_pool_init(&element->pool);
+	for (int k = 0; k < OD_RULE_PRIORITY_CLASS_MAX; k++) {
+		od_list_init(&element->waiters[k]);
+		element->pass[k] = 0;
+	}
+	element->pass_current = 0;
+	element->waiters_count = 0;
 }
 
 void od_multi_pool_element_destroy(od_multi_pool_element_t *element,
@@ -17,6 +25,7 @@ void od_multi_pool_element_destroy(od_multi_pool_element_t *element,
 {
 	od_address_destroy(&element->address);
 	free_fn(&element->pool);
+	pthread_mutex_destroy(&element->lock);
 }
 
 od_multi_pool_t *od_multi_pool_create(size_t max_keys,
@@ -32,9 +41,23 @@ od_multi_pool_t *od_multi_pool_create(size_t max_keys,
 	mpool->pool_free_fn = free_fn;
 	pthread_spin_init(&mpool->lock, PTHREAD_PROCESS_PRIVATE);
 
+	/* keep index at most half full, so probe sequences stay short */
+	uint32_t index_size = 2;
+	while (index_size < mpool->capacity * 2) {
+		index_size <<= 1;
+	}
+	mpool->index_mask = index_size - 1;
+	mpool->index = od_malloc(index_size * sizeof(uint32_t));
+	if (mpool->index == NULL) {
+		od_free(mpool);
+		return NULL;
+	}
+	memset(mpool->index, 0, index_size * sizeof(uint32_t));
+
 	mpool->pools =
 		od_malloc(mpool->capacity * sizeof(od_multi_pool_element_t));
 	if (mpool->pools == NULL) {
+		od_free(mpool->index);
 		od_free(mpool);
 		return NULL;
 	}
@@ -54,34 +77,75 @@ void od_multi_pool_destroy(od_multi_pool_t *mpool)
 	}
 
 	pthread_spin_destroy(&mpool->lock);
+	od_free(mpool->index);
 	od_free(mpool->pools);
 	od_free(mpool);
 }
 
-od_multi_pool_element_t *od_multi_pool_get_internal(od_multi_pool_t *mpool,
-						    const od_address_t *address)
+/* inline fnv-1a, lookup is done on every attach */
+static inline od_hash_t od_multi_pool_hash(const od_address_t *address)
 {
-	for (size_t i = 0; i < mpool->size; ++i) {
-		od_multi_pool_element_t *element = &mpool->pools[i];
-		if (od_address_cmp(&element->address, address) == 0) {
+	od_hash_t hash = 2166136261u ^ address->type;
+	if (address->host != NULL) {
+		for (const char *c = address->host; *c; ++c) {
+			hash = (hash ^ (unsigned char)*c) * 16777619u;
+		}
+	}
+	/* unix socket addresses are compared by path only */
+	if (address->type == OD_ADDRESS_TYPE_TCP) {
+		hash = (hash ^ (od_hash_t)address->port) * 16777619u;
+	}
+	return hash;
+}
+
+/*
+ * Lookup without the lock: index slots are published after the element
+ * is filled and are never changed afterwards.
+ */
+static inline od_multi_pool_element_t *
+od_multi_pool_get_internal(od_multi_pool_t *mpool, const od_address_t *address,
+			   od_hash_t hash, uint32_t *free_slot)
+{
+	uint32_t slot = hash & mpool->index_mask;
+	for (;;) {
+		uint32_t pos = __atomic_load_n(&mpool->index[slot],
+					       __ATOMIC_ACQUIRE);
+		if (pos == 0) {
+			break;
+		}
+		od_multi_pool_element_t *element = &mpool->pools[pos - 1];
+		if (element->hash == hash &&
+		    od_address_cmp(&element->address, address) == 0) {
 			return element;
 		}
+		slot = (slot + 1) & mpool->index_mask;
 	}
 
+	if (free_slot) {
+		*free_slot = slot;
+	}
 	return NULL;
 }
 
 static inline od_multi_pool_element_t *
-od_multi_pool_add_internal(od_multi_pool_t *mpool, const od_address_t *address)
+od_multi_pool_add_internal(od_multi_pool_t *mpool, const od_address_t *address,
+			   od_hash_t hash, uint32_t slot)
 {
+	if (mpool->size == mpool->capacity) {
+		return NULL;
+	}
+
 	od_multi_pool_element_t *element = &mpool->pools[mpool->size];
 
 	int rc = od_address_copy(&element->address, address);
 	if (rc != OK_RESPONSE) {
 		return NULL;
 	}
+	element->hash = hash;
 
-	++mpool->size;
+	__atomic_store_n(&mpool->size, mpool->size + 1, __ATOMIC_RELEASE);
+	__atomic_store_n(&mpool->index[slot], (uint32_t)mpool->size,
+			 __ATOMIC_RELEASE);
 
 	return element;
 }
@@ -89,27 +153,28 @@ od_multi_pool_add_internal(od_multi_pool_t *mpool, const od_address_t *address)
 od_multi_pool_element_t *od_multi_pool_get(od_multi_pool_t *mpool,
 					   const od_address_t *address)
 {
-	od_multi_pool_element_t *el = NULL;
-
-	pthread_spin_lock(&mpool->lock);
-
-	el = od_multi_pool_get_internal(mpool, address);
-
-	pthread_spin_unlock(&mpool->lock);
-
-	return el;
+	return od_multi_pool_get_internal(mpool, address,
+					  od_multi_pool_hash(address), NULL);
 }
 
 od_multi_pool_element_t *
 od_multi_pool_get_or_create(od_multi_pool_t *mpool, const od_address_t *address)
 {
-	od_multi_pool_element_t *el = NULL;
+	od_hash_t hash = od_multi_pool_hash(address);
+
+	od_multi_pool_element_t *el;
+	el = od_multi_pool_get_internal(mpool, address, hash, NULL);
+	if (el != NULL) {
+		return el;
+	}
 
 	pthread_spin_lock(&mpool->lock);
 
-	el = od_multi_pool_get_internal(mpool, address);
+	/* retry, the address could be added concurrently */
+	uint32_t slot;
+	el = od_multi_pool_get_internal(mpool, address, hash, &slot);
 	if (el == NULL) {
-		el = od_multi_pool_add_internal(mpool, address);
+		el = od_multi_pool_add_internal(mpool, address, hash, slot);
 	}
 
 	pthread_spin_unlock(&mpool->lock);
@@ -121,9 +186,14 @@ od_server_t *od_multi_pool_foreach(od_multi_pool_t *mpool,
 				   od_server_state_t state,
 				   od_server_pool_cb_t callback, void **argv)
 {
-	for (size_t i = 0; i < mpool->size; ++i) {
+	size_t size = od_multi_pool_size(mpool);
+
+	for (size_t i = 0; i < size; ++i) {
+		od_multi_pool_element_t *element = &mpool->pools[i];
+		od_multi_pool_element_lock(element);
 		od_server_t *server = od_server_pool_foreach(
-			&mpool->pools[i].pool, state, callback, argv);
+			&element->pool, state, callback, argv);
+		od_multi_pool_element_unlock(element);
 		if (server != NULL) {
 			return server;
 		}
@@ -132,12 +202,35 @@ od_server_t *od_multi_pool_foreach(od_multi_pool_t *mpool,
 	return NULL;
 }
 
+int od_multi_pool_foreach_element(od_multi_pool_t *mpool,
+				  od_multi_pool_element_cb_t callback,
+				  void **argv)
+{
+	size_t size = od_multi_pool_size(mpool);
+
+	for (size_t i = 0; i < size; ++i) {
+		od_multi_pool_element_t *element = &mpool->pools[i];
+		od_multi_pool_element_lock(element);
+		int rc = callback(element, argv);
+		od_multi_pool_element_unlock(element);
+		if (rc) {
+			return rc;
+		}
+	}
+
+	return 0;
+}
+
 int od_multi_pool_count_active(od_multi_pool_t *mpool)
 {
+	size_t size = od_multi_pool_size(mpool);
 	int count = 0;
 
-	for (size_t i = 0; i < mpool->size; ++i) {
-		count += mpool->pools[i].pool.count_active;
+	for (size_t i = 0; i < size; ++i) {
+		od_multi_pool_element_t *element = &mpool->pools[i];
+		od_multi_pool_element_lock(element);
+		count += element->pool.count_active;
+		od_multi_pool_element_unlock(element);
 	}
 
 	return count;
@@ -145,10 +238,14 @@ int od_multi_pool_count_active(od_multi_pool_t *mpool)
 
 int od_multi_pool_count_idle(od_multi_pool_t *mpool)
 {
+	size_t size = od_multi_pool_size(mpool);
 	int count = 0;
 
-	for (size_t i = 0; i < mpool->size; ++i) {
-		count += mpool->pools[i].pool.count_idle;
+	for (size_t i = 0; i < size; ++i) {
+		od_multi_pool_element_t *element = &mpool->pools[i];
+		od_multi_pool_element_lock(element);
+		count += element->pool.count_idle;
+		od_multi_pool_element_unlock(element);
 	}
 
 	return count;
@@ -156,11 +253,55 @@ int od_multi_pool_count_idle(od_multi_pool_t *mpool)
 
 int od_multi_pool_total(od_multi_pool_t *mpool)
 {
+	size_t size = od_multi_pool_size(mpool);
+	int count = 0;
+
+	for (size_t i = 0; i < size; ++i) {
+		od_multi_pool_element_t *element = &mpool->pools[i];
+		od_multi_pool_element_lock(element);
+		count += od_server_pool_total(&element->pool);
+		od_multi_pool_element_unlock(element);
+	}
+
+	return count;
+}
+
+int od_multi_pool_count_waiting(od_multi_pool_t *mpool)
+{
+	size_t size = od_multi_pool_size(mpool);
 	int count = 0;
 
-	for (size_t i = 0; i < mpool->size; ++i) {
-		count += od_server_pool_total(&mpool->pools[i].pool);
+	for (size_t i = 0; i < size; ++i) {
+		od_multi_pool_element_t *element = &mpool->pools[i];
+		od_multi_pool_element_lock(element);
+		count += element->waiters_count;
+		od_multi_pool_element_unlock(element);
 	}
 
 	return count;
 }
+
+uint64_t od_multi_pool_max_wait_us(od_multi_pool_t *mpool, uint64_t now_us)
+{
+	size_t size = od_multi_pool_size(mpool);
+	uint64_t max_wait = 0;
+
+	for (size_t i = 0; i < size; ++i) {
+		od_multi_pool_element_t *element = &mpool->pools[i];
+		od_multi_pool_element_lock(element);
+		for (int k = 0; k < OD_RULE_PRIORITY_CLASS_MAX; k++) {
+			if (od_list_empty(&element->waiters[k]))
+				continue;
+			od_multi_pool_waiter_t *waiter;
+			waiter = od_container_of(element->waiters[k].next,
+						 od_multi_pool_waiter_t, link);
+			if (now_us > waiter->start_us &&
+			    now_us - waiter->start_us > max_wait) {
+				max_wait = now_us - waiter->start_us;
+			}
+		}
+		od_multi_pool_element_unlock(element);
+	}
+
+	return max_wait;
+}
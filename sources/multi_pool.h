@@ -8,13 +8,48 @@
 
 /*
  * address -> pool 'map'
+ *
+ * Elements are never removed while the map is alive, so lookup probes
+ * the hashed index without locks and the spinlock only serializes
+ * inserts. Every element has its own lock for the server lists and
+ * counters, clients of different endpoints attach and detach without
+ * contending for a single route-wide lock.
+ *
+ * Clients which found no idle server wait in the element queues, one
+ * FIFO queue per rule priority class. Released server is handed to the
+ * oldest waiter of the class chosen by stride scheduling, so classes
+ * share servers in proportion to their weights, and only that waiter
+ * is woken.
+ *
+ * Lock order: route lock, then element lock.
  */
 
 typedef void (*od_server_pool_free_fn_t)(od_server_pool_t *);
 
+#define OD_MULTI_POOL_STRIDE (1 << 20)
+
+typedef struct {
+	od_list_t link;
+	machine_wait_flag_t *flag;
+	uint64_t start_us;
+	int priority_class;
+	int weight;
+	/* set under the element lock on wakeup */
+	int woken;
+	/* handed off server, NULL if woken to retry */
+	od_server_t *server;
+} od_multi_pool_waiter_t;
+
 struct od_multi_pool_element {
 	od_address_t address;
+	od_hash_t hash;
+	pthread_mutex_t lock;
 	od_server_pool_t pool;
+	od_list_t waiters[OD_RULE_PRIORITY_CLASS_MAX];
+	/* stride scheduling, next pass of every class and of the queue */
+	uint64_t pass[OD_RULE_PRIORITY_CLASS_MAX];
+	uint64_t pass_current;
+	int waiters_count;
 };
 
 typedef int (*od_multi_pool_element_cb_t)(od_multi_pool_element_t *, void **);
@@ -23,14 +58,111 @@ void od_multi_pool_element_init(od_multi_pool_element_t *element);
 void od_multi_pool_element_destroy(od_multi_pool_element_t *element,
 				   od_server_pool_free_fn_t free_fn);
 
+static inline void od_multi_pool_element_lock(od_multi_pool_element_t *element)
+{
+	pthread_mutex_lock(&element->lock);
+}
+
+static inline void
+od_multi_pool_element_unlock(od_multi_pool_element_t *element)
+{
+	pthread_mutex_unlock(&element->lock);
+}
+
+static inline int
+od_multi_pool_element_count_active(od_multi_pool_element_t *element)
+{
+	od_multi_pool_element_lock(element);
+	int count = od_server_pool_active(&element->pool);
+	od_multi_pool_element_unlock(element);
+	return count;
+}
+
+static inline int
+od_multi_pool_element_total(od_multi_pool_element_t *element)
+{
+	od_multi_pool_element_lock(element);
+	int count = od_server_pool_total(&element->pool);
+	od_multi_pool_element_unlock(element);
+	return count;
+}
+
+/* element lock is held */
+static inline void od_multi_pool_element_wait(od_multi_pool_element_t *element,
+					      od_multi_pool_waiter_t *waiter)
+{
+	od_list_t *queue = &element->waiters[waiter->priority_class];
+	/* idle class does not save up passes */
+	if (od_list_empty(queue) &&
+	    element->pass[waiter->priority_class] < element->pass_current)
+		element->pass[waiter->priority_class] = element->pass_current;
+	waiter->woken = 0;
+	waiter->server = NULL;
+	od_list_init(&waiter->link);
+	od_list_append(queue, &waiter->link);
+	element->waiters_count++;
+}
+
+/* element lock is held, removes waiter from the queue unless woken */
+static inline void
+od_multi_pool_element_wait_cancel(od_multi_pool_element_t *element,
+				  od_multi_pool_waiter_t *waiter)
+{
+	if (waiter->woken)
+		return;
+	od_list_unlink(&waiter->link);
+	element->waiters_count--;
+}
+
+/*
+ * Wake the oldest waiter of the class with the lowest pass, passing it
+ * the server (or NULL to retry).
+ * Element lock is held, the flag is set under it, so the waiter does not
+ * free it before the wakeup is done.
+ */
+static inline od_multi_pool_waiter_t *
+od_multi_pool_element_wake(od_multi_pool_element_t *element,
+			   od_server_t *server)
+{
+	if (element->waiters_count == 0)
+		return NULL;
+	int class = -1;
+	for (int k = 0; k < OD_RULE_PRIORITY_CLASS_MAX; k++) {
+		if (od_list_empty(&element->waiters[k]))
+			continue;
+		if (class == -1 || element->pass[k] < element->pass[class])
+			class = k;
+	}
+	od_multi_pool_waiter_t *waiter;
+	waiter = od_container_of(element->waiters[class].next,
+				 od_multi_pool_waiter_t, link);
+	element->pass_current = element->pass[class];
+	element->pass[class] += OD_MULTI_POOL_STRIDE / waiter->weight;
+	od_list_unlink(&waiter->link);
+	element->waiters_count--;
+	waiter->woken = 1;
+	waiter->server = server;
+	machine_wait_flag_set(waiter->flag);
+	return waiter;
+}
+
 struct od_multi_pool {
 	size_t size;
 	size_t capacity;
 	od_multi_pool_element_t *pools;
+	/* open addressing, element position + 1, zero is an empty slot */
+	uint32_t *index;
+	uint32_t index_mask;
 	od_server_pool_free_fn_t pool_free_fn;
 	pthread_spinlock_t lock;
 };
 
+/* number of elements, safe without the lock */
+static inline size_t od_multi_pool_size(od_multi_pool_t *mpool)
+{
+	return __atomic_load_n(&mpool->size, __ATOMIC_ACQUIRE);
+}
+
 od_multi_pool_t *od_multi_pool_create(size_t max_keys,
 				      od_server_pool_free_fn_t pool_free_fn);
 void od_multi_pool_destroy(od_multi_pool_t *mpool);
@@ -39,9 +171,17 @@ od_multi_pool_get_or_create(od_multi_pool_t *mpool,
 			    const od_address_t *address);
 od_multi_pool_element_t *od_multi_pool_get(od_multi_pool_t *mpool,
 					   const od_address_t *address);
+/* callback is called with the element lock held */
 od_server_t *od_multi_pool_foreach(od_multi_pool_t *mpool,
 				   od_server_state_t state,
 				   od_server_pool_cb_t callback, void **argv);
+/* callback is called with the element lock held */
+int od_multi_pool_foreach_element(od_multi_pool_t *mpool,
+				  od_multi_pool_element_cb_t callback,
+				  void **argv);
 int od_multi_pool_count_active(od_multi_pool_t *mpool);
 int od_multi_pool_count_idle(od_multi_pool_t *mpool);
 int od_multi_pool_total(od_multi_pool_t *mpool);
+int od_multi_pool_count_waiting(od_multi_pool_t *mpool);
+/* wait time of the oldest waiting client */
+uint64_t od_multi_pool_max_wait_us(od_multi_pool_t *mpool, uint64_t now_us);
@@ -51,6 +51,9 @@
 /* hash */
 #include "sources/murmurhash.h"
 #include "sources/hashmap.h"
+#include "sources/pstmt.h"
+#include "sources/auth_cache.h"
+#include "sources/scram_cache.h"
 
 #include "sources/pid.h"
 #include "sources/id.h"
@@ -60,6 +63,8 @@
 
 #include "sources/address.h"
 
+#include "sources/histogram.h"
+#include "sources/crypto_pool.h"
 #include "sources/global.h"
 #include "sources/tls_config.h"
 #include "sources/config.h"
@@ -75,6 +80,9 @@
 #include "sources/storage.h"
 #include "sources/group.h"
 #include "sources/pool.h"
+#include "sources/pool_controller.h"
+#include "sources/prewarm.h"
+#include "sources/rules_index.h"
 #include "sources/rules.h"
 #include "sources/hba_rule.h"
 
@@ -95,12 +103,12 @@
 
 #include "sources/relay.h"
 
-#include "sources/tdigest.h"
-#include "sources/stat.h"
-
 /* server */
 #include "sources/ejection.h"
 #include "sources/thread_global.h"
+
+#include "sources/tdigest.h"
+#include "sources/stat.h"
 #include "sources/server.h"
 
 /* client */
@@ -21,6 +21,7 @@ od_rule_pool_t *od_rule_pool_alloc()
 	pool->discard = 1;
 	pool->smart_discard = 0;
 	pool->discard_query = NULL;
+	pool->prewarm_query = NULL;
 	pool->cancel = 1;
 	pool->rollback = 1;
 
@@ -38,6 +39,9 @@ int od_rule_pool_free(od_rule_pool_t *pool)
 	if (pool->discard_query) {
 		od_free(pool->discard_query);
 	}
+	if (pool->prewarm_query) {
+		od_free(pool->prewarm_query);
+	}
 	od_free(pool);
 	return OK_RESPONSE;
 }
@@ -56,6 +60,10 @@ int od_rule_pool_compare(od_rule_pool_t *a, od_rule_pool_t *b)
 	if (a->size != b->size)
 		return 0;
 
+	/* size_adaptive */
+	if (a->size_adaptive != b->size_adaptive)
+		return 0;
+
 	/* timeout */
 	if (a->timeout != b->timeout)
 		return 0;
@@ -32,9 +32,14 @@ struct od_rule_pool {
 	char *pool_type_str;
 	char *routing_type;
 	char *discard_query;
+	char *prewarm_query;
 
 	int min_size;
 	int size;
+	/* size is the upper bound of the adaptive route pool size */
+	int size_adaptive;
+	/* server connections opened on startup and reload */
+	int prewarm;
 	int timeout;
 	int ttl;
 	int discard;
@@ -0,0 +1,115 @@
+
+/*
+ * Odyssey.
+ *
+ * Scalable PostgreSQL connection pooler.
+ */
+
+#include <kiwi.h>
+#include <machinarium.h>
+#include <odyssey.h>
+
+static inline int od_pool_controller_clamp(int value, int min, int max)
+{
+	if (value < min)
+		return min;
+	if (value > max)
+		return max;
+	return value;
+}
+
+void od_pool_controller_init(od_pool_controller_t *controller, int min,
+			     int max)
+{
+	memset(controller, 0, sizeof(*controller));
+	if (min < 1)
+		min = 1;
+	controller->target = od_pool_controller_clamp(min, 1, max);
+	controller->decision = OD_POOL_SIZE_HOLD;
+}
+
+static inline int od_pool_controller_sqrt(int value)
+{
+	int root = 1;
+	while ((root + 1) * (root + 1) <= value)
+		root++;
+	return root;
+}
+
+od_pool_size_decision_t od_pool_controller_step(od_pool_controller_t *controller,
+						od_pool_sample_t *sample,
+						int min, int max)
+{
+	od_pool_sample_t *prev = &controller->prev;
+	if (min < 1)
+		min = 1;
+
+	uint64_t waits = sample->wait_count - prev->wait_count;
+	controller->wait_avg_us = 0;
+	if (waits)
+		controller->wait_avg_us =
+			(sample->wait_sum_us - prev->wait_sum_us) / waits;
+
+	uint64_t queries = sample->query_count - prev->query_count;
+	controller->latency_us = 0;
+	if (queries)
+		controller->latency_us =
+			(sample->query_time_us - prev->query_time_us) / queries;
+	*prev = *sample;
+
+	/* baseline follows latency down at once and up slowly */
+	uint64_t base = controller->latency_base_us;
+	if (controller->latency_us) {
+		if (base == 0 || controller->latency_us < base)
+			base = controller->latency_us;
+		else
+			base += base / 32 + 1;
+		controller->latency_base_us = base;
+	}
+
+	int target = controller->target;
+	od_pool_size_decision_t decision = OD_POOL_SIZE_HOLD;
+
+	int saturated = base && controller->latency_us >
+					base * OD_POOL_CONTROLLER_SATURATION_RATIO;
+	int queued = sample->waiting > 0 ||
+		     controller->wait_avg_us >= OD_POOL_CONTROLLER_WAIT_US;
+
+	if (saturated) {
+		if (target > min) {
+			int next = target - target / 4;
+			target = next < target ? next : target - 1;
+			decision = OD_POOL_SIZE_BACKOFF;
+		}
+	} else if (queued) {
+		if (target < max) {
+			target += od_pool_controller_sqrt(target);
+			decision = OD_POOL_SIZE_GROW;
+		}
+	} else if (waits == 0 && sample->idle * 2 > target) {
+		if (target > min) {
+			target--;
+			decision = OD_POOL_SIZE_SHRINK;
+		}
+	}
+
+	target = od_pool_controller_clamp(target, min, max);
+	__atomic_store_n(&controller->target, target, __ATOMIC_RELAXED);
+	controller->decision = decision;
+	return decision;
+}
+
+char *od_pool_size_decision_to_str(od_pool_size_decision_t decision)
+{
+	switch (decision) {
+	case OD_POOL_SIZE_HOLD:
+		return "hold";
+	case OD_POOL_SIZE_GROW:
+		return "grow";
+	case OD_POOL_SIZE_SHRINK:
+		return "shrink";
+	case OD_POOL_SIZE_BACKOFF:
+		return "backoff";
+	}
+	return "unknown";
+}
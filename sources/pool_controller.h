@@ -0,0 +1,65 @@
+#pragma once
+
+/*
+ * Odyssey.
+ *
+ * Scalable PostgreSQL connection pooler.
+ */
+
+/*
+ * Adaptive route pool size.
+ *
+ * Every second the controller moves the route target pool size between
+ * min_pool_size and pool_size (AIMD). While clients wait for a server
+ * and query latency stays near its baseline, the target grows by the
+ * square root of its value. Once latency exceeds twice the baseline the
+ * backend is considered saturated and the target is cut by a quarter.
+ * Servers idle without any waiting client are released one per step.
+ */
+
+typedef struct od_pool_controller od_pool_controller_t;
+
+typedef enum {
+	OD_POOL_SIZE_HOLD,
+	OD_POOL_SIZE_GROW,
+	OD_POOL_SIZE_SHRINK,
+	OD_POOL_SIZE_BACKOFF,
+} od_pool_size_decision_t;
+
+/* clients waiting in total makes a queue */
+#define OD_POOL_CONTROLLER_WAIT_US 1000
+/* latency over baseline * ratio is a saturated backend */
+#define OD_POOL_CONTROLLER_SATURATION_RATIO 2
+
+typedef struct {
+	/* cumulative route counters */
+	uint64_t wait_count;
+	uint64_t wait_sum_us;
+	uint64_t query_count;
+	uint64_t query_time_us;
+	/* clients queued and idle servers at the moment */
+	int waiting;
+	int idle;
+} od_pool_sample_t;
+
+struct od_pool_controller {
+	int target;
+	od_pool_size_decision_t decision;
+	od_pool_sample_t prev;
+	/* last step */
+	uint64_t wait_avg_us;
+	uint64_t latency_us;
+	/* lowest recent query latency */
+	uint64_t latency_base_us;
+};
+
+void od_pool_controller_init(od_pool_controller_t *, int min, int max);
+od_pool_size_decision_t od_pool_controller_step(od_pool_controller_t *,
+						od_pool_sample_t *, int min,
+						int max);
+char *od_pool_size_decision_to_str(od_pool_size_decision_t);
+
+static inline int od_pool_controller_target(od_pool_controller_t *controller)
+{
+	return __atomic_load_n(&controller->target, __ATOMIC_RELAXED);
+}
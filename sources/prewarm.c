@@ -0,0 +1,313 @@
+
+/*
+ * Odyssey.
+ *
+ * Scalable PostgreSQL connection pooler.
+ */
+
+#include <kiwi.h>
+#include <machinarium.h>
+#include <odyssey.h>
+
+typedef struct {
+	od_route_t *route;
+	od_multi_pool_element_t *element;
+	/* connections not yet started and being opened */
+	int count;
+	int running;
+} od_prewarm_task_t;
+
+typedef struct {
+	od_global_t *global;
+	od_prewarm_task_t *tasks;
+	int tasks_count;
+	int tasks_allocated;
+	/* connections of the pass and parallel connects allowed */
+	int total;
+	int concurrency;
+	int opened;
+	int failed;
+	machine_wait_group_t *done;
+} od_prewarm_pass_t;
+
+void od_prewarm_init(od_prewarm_t *prewarm)
+{
+	memset(prewarm, 0, sizeof(*prewarm));
+}
+
+char *od_prewarm_state_to_str(od_prewarm_state_t state)
+{
+	switch (state) {
+	case OD_PREWARM_NONE:
+		return "none";
+	case OD_PREWARM_RUNNING:
+		return "running";
+	case OD_PREWARM_READY:
+		return "ready";
+	case OD_PREWARM_FAILED:
+		return "failed";
+	}
+	return "unknown";
+}
+
+static inline int od_prewarm_task_add(od_prewarm_pass_t *pass,
+				      od_route_t *route,
+				      od_multi_pool_element_t *element,
+				      int count)
+{
+	if (pass->tasks_count == pass->tasks_allocated) {
+		int allocated = pass->tasks_allocated ?
+					pass->tasks_allocated * 2 :
+					16;
+		od_prewarm_task_t *tasks = od_realloc(
+			pass->tasks, sizeof(od_prewarm_task_t) * allocated);
+		if (tasks == NULL)
+			return NOT_OK_RESPONSE;
+		pass->tasks = tasks;
+		pass->tasks_allocated = allocated;
+	}
+
+	od_prewarm_task_t *task = &pass->tasks[pass->tasks_count++];
+	task->route = route;
+	task->element = element;
+	task->count = count;
+	task->running = 0;
+	pass->total += count;
+
+	/* rule may become obsolete and be freed by reload during the pass */
+	od_rules_ref(route->rule);
+	return OK_RESPONSE;
+}
+
+/* route lock is held */
+static inline int od_prewarm_collect_route(od_prewarm_pass_t *pass,
+					   od_route_t *route)
+{
+	od_rule_t *rule = route->rule;
+	od_rule_storage_t *storage = rule->storage;
+
+	int prewarm = rule->pool->prewarm;
+	if (rule->pool->size > 0 && prewarm > od_route_pool_size(route))
+		prewarm = od_route_pool_size(route);
+
+	int need = 0;
+	for (size_t i = 0; i < storage->endpoints_count; ++i) {
+		od_multi_pool_element_t *element = od_multi_pool_get_or_create(
+			route->server_pools, &storage->endpoints[i].address);
+		if (element == NULL)
+			return NOT_OK_RESPONSE;
+
+		int count = prewarm - od_multi_pool_element_total(element);
+		if (count <= 0)
+			continue;
+		if (od_prewarm_task_add(pass, route, element, count) ==
+		    NOT_OK_RESPONSE)
+			return NOT_OK_RESPONSE;
+		need += count;
+	}
+
+	od_route_prewarm_t *stat = &route->prewarm;
+	if (need == 0) {
+		/* warm already, or warmed up by clients */
+		if (od_atomic_u32_of(&stat->state) == OD_PREWARM_NONE)
+			od_atomic_u32_set(&stat->state, OD_PREWARM_READY);
+		return OK_RESPONSE;
+	}
+
+	od_atomic_u32_set(&stat->target, need);
+	od_atomic_u32_set(&stat->opened, 0);
+	od_atomic_u32_set(&stat->failed, 0);
+	od_atomic_u32_add(&stat->inflight, need);
+	od_atomic_u64_set(&stat->start_us, machine_time_us());
+	od_atomic_u64_set(&stat->done_us, 0);
+	od_atomic_u32_set(&stat->state, OD_PREWARM_RUNNING);
+
+	if (pass->concurrency == 0 ||
+	    storage->server_max_routing < pass->concurrency)
+		pass->concurrency = storage->server_max_routing;
+	return OK_RESPONSE;
+}
+
+static inline int od_prewarm_collect(od_prewarm_pass_t *pass)
+{
+	od_router_t *router = pass->global->router;
+	int rc = OK_RESPONSE;
+
+	od_router_lock(router);
+
+	od_list_t *i;
+	od_list_foreach(&router->rules.rules, i)
+	{
+		od_rule_t *rule = od_container_of(i, od_rule_t, link);
+		if (rule->pool->prewarm == 0 || rule->obsolete)
+			continue;
+
+		/* dont know for which user preallocate the connections */
+		if (rule->user_is_default || rule->db_is_default)
+			continue;
+
+		od_route_t *route = od_router_route_for_rule(router, rule);
+		if (route == NULL) {
+			rc = NOT_OK_RESPONSE;
+			break;
+		}
+
+		od_route_lock(route);
+		rc = od_prewarm_collect_route(pass, route);
+		od_route_unlock(route);
+		if (rc == NOT_OK_RESPONSE)
+			break;
+	}
+
+	od_router_unlock(router);
+	return rc;
+}
+
+static inline od_prewarm_task_t *od_prewarm_next(od_prewarm_pass_t *pass)
+{
+	/* coroutines of the pass share a machine, no locking needed */
+	for (int i = 0; i < pass->tasks_count; i++) {
+		od_prewarm_task_t *task = &pass->tasks[i];
+		if (task->count > 0) {
+			task->count--;
+			task->running++;
+			return task;
+		}
+	}
+	return NULL;
+}
+
+static inline void od_prewarm_route_done(od_route_t *route)
+{
+	od_route_prewarm_t *stat = &route->prewarm;
+	if (od_atomic_u32_dec(&stat->inflight) != 1)
+		return;
+
+	od_prewarm_state_t state = OD_PREWARM_READY;
+	if (od_atomic_u32_of(&stat->failed) > 0)
+		state = OD_PREWARM_FAILED;
+	od_atomic_u64_set(&stat->done_us, machine_time_us());
+	od_atomic_u32_set(&stat->state, state);
+}
+
+static inline void od_prewarm_run_tasks(od_prewarm_pass_t *pass)
+{
+	od_router_t *router = pass->global->router;
+
+	od_prewarm_task_t *task;
+	while ((task = od_prewarm_next(pass)) != NULL) {
+		od_route_t *route = task->route;
+		od_rule_t *rule = route->rule;
+		int rc = od_router_prewarm_server(router, route, task->element);
+		if (rc == OK_RESPONSE) {
+			od_atomic_u32_inc(&route->prewarm.opened);
+			pass->opened++;
+		} else {
+			od_atomic_u32_inc(&route->prewarm.failed);
+			pass->failed++;
+		}
+		od_prewarm_route_done(route);
+
+		/* obsolete rule may be freed and unlinked from router rules */
+		task->running--;
+		if (task->count == 0 && task->running == 0) {
+			od_router_lock(router);
+			od_rules_unref(rule);
+			od_router_unlock(router);
+		}
+	}
+}
+
+static void od_prewarm_worker(void *arg)
+{
+	od_prewarm_pass_t *pass = arg;
+	od_prewarm_run_tasks(pass);
+	machine_wait_group_done(pass->done);
+}
+
+static inline void od_prewarm_pass(od_global_t *global)
+{
+	od_instance_t *instance = global->instance;
+
+	od_prewarm_pass_t pass;
+	memset(&pass, 0, sizeof(pass));
+	pass.global = global;
+
+	uint64_t start_us = machine_time_us();
+	int rc = od_prewarm_collect(&pass);
+	if (rc == NOT_OK_RESPONSE)
+		od_error(&instance->logger, "prewarm", NULL, NULL,
+			 "failed to collect routes to warm up");
+
+	if (pass.total == 0) {
+		od_free(pass.tasks);
+		return;
+	}
+
+	int concurrency = pass.concurrency;
+	if (concurrency < 1)
+		concurrency = 1;
+	if (concurrency > pass.total)
+		concurrency = pass.total;
+
+	od_log(&instance->logger, "prewarm", NULL, NULL,
+	       "opening %d server connections, %d at once", pass.total,
+	       concurrency);
+
+	/* pass coroutine is a worker too */
+	pass.done = machine_wait_group_create();
+	for (int i = 1; pass.done != NULL && i < concurrency; i++) {
+		machine_wait_group_add(pass.done);
+		int64_t id = machine_coroutine_create(od_prewarm_worker, &pass);
+		if (id == INVALID_COROUTINE_ID) {
+			machine_wait_group_done(pass.done);
+			break;
+		}
+	}
+	od_prewarm_run_tasks(&pass);
+	if (pass.done != NULL) {
+		machine_wait_group_wait(pass.done, UINT32_MAX);
+		machine_wait_group_destroy(pass.done);
+	}
+	od_free(pass.tasks);
+
+	od_log(&instance->logger, "prewarm", NULL, NULL,
+	       "%s: %d connections opened, %d failed in %" PRIu64 " ms",
+	       pass.failed ? "pools are partially warm" : "pools are ready",
+	       pass.opened, pass.failed, (machine_time_us() - start_us) / 1000);
+}
+
+static void od_prewarm(void *arg)
+{
+	od_global_t *global = arg;
+	od_prewarm_t *prewarm = &global->router->prewarm;
+
+	do {
+		od_atomic_u32_set(&prewarm->rerun, 0);
+		od_prewarm_pass(global);
+		od_atomic_u32_set(&prewarm->running, 0);
+		/* reload came during the pass and did not start its own */
+	} while (od_atomic_u32_of(&prewarm->rerun) &&
+		 od_atomic_u32_cas(&prewarm->running, 0, 1) == 0);
+}
+
+int od_prewarm_start(od_global_t *global)
+{
+	od_instance_t *instance = global->instance;
+	od_prewarm_t *prewarm = &global->router->prewarm;
+
+	od_atomic_u32_set(&prewarm->rerun, 1);
+	if (od_atomic_u32_cas(&prewarm->running, 0, 1) != 0) {
+		/* running pass repeats itself */
+		return OK_RESPONSE;
+	}
+
+	int64_t id = machine_coroutine_create(od_prewarm, global);
+	if (id == INVALID_COROUTINE_ID) {
+		od_atomic_u32_set(&prewarm->running, 0);
+		od_error(&instance->logger, "prewarm", NULL, NULL,
+			 "failed to start prewarm coroutine");
+		return NOT_OK_RESPONSE;
+	}
+	return OK_RESPONSE;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+/*
+ * Odyssey.
+ *
+ * Scalable PostgreSQL connection pooler.
+ */
+
+/*
+ * Pool pre-warm.
+ *
+ * On startup and config reload routes of rules with pool_prewarm get
+ * their server connections opened before the first client comes. A
+ * pass starts connections in parallel coroutines, no more than storage
+ * server_max_routing at once, performs backend startup and the
+ * optional warm-up query and leaves servers idle in the route pool.
+ */
+
+typedef struct od_prewarm od_prewarm_t;
+typedef struct od_route_prewarm od_route_prewarm_t;
+
+typedef enum {
+	OD_PREWARM_NONE,
+	OD_PREWARM_RUNNING,
+	OD_PREWARM_READY,
+	OD_PREWARM_FAILED,
+} od_prewarm_state_t;
+
+/* warm-up query must complete in */
+#define OD_PREWARM_QUERY_TIMEOUT_MS 10000
+
+/* route progress of the last pass */
+struct od_route_prewarm {
+	od_atomic_u32_t state;
+	od_atomic_u32_t target;
+	od_atomic_u32_t opened;
+	od_atomic_u32_t failed;
+	/* connections of the pass not yet tried, keeps route from gc */
+	od_atomic_u32_t inflight;
+	od_atomic_u64_t start_us;
+	od_atomic_u64_t done_us;
+};
+
+struct od_prewarm {
+	/* pass coroutine is running and reload asked for one more pass */
+	od_atomic_u32_t running;
+	od_atomic_u32_t rerun;
+};
+
+void od_prewarm_init(od_prewarm_t *);
+/* run a pass in a coroutine of the current machine */
+int od_prewarm_start(od_global_t *);
+char *od_prewarm_state_to_str(od_prewarm_state_t);
+
+static inline void od_route_prewarm_init(od_route_prewarm_t *prewarm)
+{
+	memset(prewarm, 0, sizeof(*prewarm));
+}
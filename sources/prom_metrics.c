@@ -163,6 +163,96 @@ int od_prom_metrics_init(struct od_prom_metrics *self)
 			       "Number of processed clients", 1, worker_label);
 	prom_collector_add_metric(stat_worker_metrics_collector,
 				  self->clients_processed);
+	self->clients_active =
+		prom_gauge_new("clients_active",
+			       "Number of clients served by worker", 1,
+			       worker_label);
+	prom_collector_add_metric(stat_worker_metrics_collector,
+				  self->clients_active);
+	self->worker_cpu_load = prom_gauge_new(
+		"worker_cpu_load", "Worker thread cpu load in percents", 1,
+		worker_label);
+	prom_collector_add_metric(stat_worker_metrics_collector,
+				  self->worker_cpu_load);
+
+	/* coroutine stacks, per stack size */
+	const char *stack_labels[2] = { "worker", "stack_size" };
+	self->stacks_used = prom_gauge_new("stacks_used",
+					   "Coroutine stacks in use", 2,
+					   stack_labels);
+	prom_collector_add_metric(stat_worker_metrics_collector,
+				  self->stacks_used);
+	self->stacks_hot = prom_gauge_new(
+		"stacks_hot", "Idle coroutine stacks kept committed", 2,
+		stack_labels);
+	prom_collector_add_metric(stat_worker_metrics_collector,
+				  self->stacks_hot);
+	self->stacks_reclaimed = prom_gauge_new(
+		"stacks_reclaimed", "Idle coroutine stacks given back", 2,
+		stack_labels);
+	prom_collector_add_metric(stat_worker_metrics_collector,
+				  self->stacks_reclaimed);
+	self->stack_mapped = prom_gauge_new(
+		"stack_mapped", "Address space mapped for coroutine stacks", 2,
+		stack_labels);
+	prom_collector_add_metric(stat_worker_metrics_collector,
+				  self->stack_mapped);
+	self->stack_hwm = prom_gauge_new(
+		"stack_hwm", "Deepest coroutine stack use in bytes", 2,
+		stack_labels);
+	prom_collector_add_metric(stat_worker_metrics_collector,
+				  self->stack_hwm);
+
+	/* readahead buffers, over all workers */
+	self->readahead_held = prom_gauge_new(
+		"readahead_held", "Readahead bytes held by connections", 1,
+		worker_label);
+	prom_collector_add_metric(stat_worker_metrics_collector,
+				  self->readahead_held);
+	self->readahead_pooled = prom_gauge_new(
+		"readahead_pooled", "Readahead bytes kept in worker pools", 1,
+		worker_label);
+	prom_collector_add_metric(stat_worker_metrics_collector,
+				  self->readahead_pooled);
+
+	/* crypto pool latency histograms, in microseconds */
+	const char *stage_label[1] = { "stage" };
+	const char *stage_le_labels[2] = { "stage", "le" };
+	self->crypto_queue_bucket = prom_gauge_new(
+		"crypto_queue_time_us_bucket",
+		"Crypto tasks waited for a crypto worker", 2, stage_le_labels);
+	prom_collector_add_metric(stat_worker_metrics_collector,
+				  self->crypto_queue_bucket);
+	self->crypto_queue_sum =
+		prom_gauge_new("crypto_queue_time_us_sum",
+			       "Total crypto tasks queue time", 1, stage_label);
+	prom_collector_add_metric(stat_worker_metrics_collector,
+				  self->crypto_queue_sum);
+	self->crypto_queue_count = prom_gauge_new(
+		"crypto_queue_time_us_count", "Crypto tasks queued", 1,
+		stage_label);
+	prom_collector_add_metric(stat_worker_metrics_collector,
+				  self->crypto_queue_count);
+	self->crypto_exec_bucket = prom_gauge_new(
+		"crypto_exec_time_us_bucket", "Crypto tasks execution time", 2,
+		stage_le_labels);
+	prom_collector_add_metric(stat_worker_metrics_collector,
+				  self->crypto_exec_bucket);
+	self->crypto_exec_sum = prom_gauge_new(
+		"crypto_exec_time_us_sum", "Total crypto tasks execution time",
+		1, stage_label);
+	prom_collector_add_metric(stat_worker_metrics_collector,
+				  self->crypto_exec_sum);
+	self->crypto_exec_count =
+		prom_gauge_new("crypto_exec_time_us_count",
+			       "Crypto tasks executed", 1, stage_label);
+	prom_collector_add_metric(stat_worker_metrics_collector,
+				  self->crypto_exec_count);
+	self->crypto_inline = prom_gauge_new(
+		"crypto_inline", "Crypto tasks executed on client worker", 1,
+		stage_label);
+	prom_collector_add_metric(stat_worker_metrics_collector,
+				  self->crypto_inline);
 
 	self->stat_route_metrics =
 		prom_collector_registry_new("stat_route_metrics");
@@ -214,6 +304,89 @@ int od_prom_metrics_init(struct od_prom_metrics *self)
 		"avg_recv_server", "Average out bytes/sec", 2, user_labels);
 	prom_collector_add_metric(stat_route_metrics_collector,
 				  self->avg_recv_server);
+	self->auth_cache_hits = prom_gauge_new(
+		"auth_cache_hits", "auth_query cache hits", 2, user_labels);
+	prom_collector_add_metric(stat_route_metrics_collector,
+				  self->auth_cache_hits);
+	self->auth_cache_negative_hits =
+		prom_gauge_new("auth_cache_negative_hits",
+			       "auth_query cache hits of missing users", 2,
+			       user_labels);
+	prom_collector_add_metric(stat_route_metrics_collector,
+				  self->auth_cache_negative_hits);
+	self->auth_cache_misses = prom_gauge_new(
+		"auth_cache_misses", "auth_query cache misses", 2, user_labels);
+	prom_collector_add_metric(stat_route_metrics_collector,
+				  self->auth_cache_misses);
+	self->auth_cache_waits =
+		prom_gauge_new("auth_cache_waits",
+			       "Lookups waited for in-flight auth_query", 2,
+			       user_labels);
+	prom_collector_add_metric(stat_route_metrics_collector,
+				  self->auth_cache_waits);
+	self->auth_cache_refreshes =
+		prom_gauge_new("auth_cache_refreshes",
+			       "Background auth_query cache refreshes", 2,
+			       user_labels);
+	prom_collector_add_metric(stat_route_metrics_collector,
+				  self->auth_cache_refreshes);
+	const char *endpoint_labels[3] = { "user", "database", "endpoint" };
+	self->endpoint_connect_ewma = prom_gauge_new(
+		"endpoint_connect_ewma_us",
+		"Smoothed connect time of storage endpoint", 3,
+		endpoint_labels);
+	prom_collector_add_metric(stat_route_metrics_collector,
+				  self->endpoint_connect_ewma);
+	self->endpoint_query_ewma = prom_gauge_new(
+		"endpoint_query_ewma_us",
+		"Smoothed query time of storage endpoint", 3, endpoint_labels);
+	prom_collector_add_metric(stat_route_metrics_collector,
+				  self->endpoint_query_ewma);
+	self->endpoint_server_active = prom_gauge_new(
+		"endpoint_server_active",
+		"Servers of storage endpoint attached to clients", 3,
+		endpoint_labels);
+	prom_collector_add_metric(stat_route_metrics_collector,
+				  self->endpoint_server_active);
+	/* clients waited for a server, in microseconds */
+	const char *user_le_labels[3] = { "user", "database", "le" };
+	self->pool_wait_bucket = prom_gauge_new(
+		"pool_wait_time_us_bucket", "Clients waited for a server", 3,
+		user_le_labels);
+	prom_collector_add_metric(stat_route_metrics_collector,
+				  self->pool_wait_bucket);
+	self->pool_wait_sum =
+		prom_gauge_new("pool_wait_time_us_sum",
+			       "Total clients wait time for a server", 2,
+			       user_labels);
+	prom_collector_add_metric(stat_route_metrics_collector,
+				  self->pool_wait_sum);
+	self->pool_wait_count =
+		prom_gauge_new("pool_wait_time_us_count",
+			       "Clients waited for a server", 2, user_labels);
+	prom_collector_add_metric(stat_route_metrics_collector,
+				  self->pool_wait_count);
+	/* server resets, in microseconds */
+	self->reset_bucket =
+		prom_gauge_new("server_reset_time_us_bucket",
+			       "Server resets duration", 3, user_le_labels);
+	prom_collector_add_metric(stat_route_metrics_collector,
+				  self->reset_bucket);
+	self->reset_sum = prom_gauge_new("server_reset_time_us_sum",
+					 "Total server resets duration", 2,
+					 user_labels);
+	prom_collector_add_metric(stat_route_metrics_collector,
+				  self->reset_sum);
+	self->reset_count = prom_gauge_new("server_reset_time_us_count",
+					   "Server resets done", 2,
+					   user_labels);
+	prom_collector_add_metric(stat_route_metrics_collector,
+				  self->reset_count);
+	self->resets_in_flight =
+		prom_gauge_new("server_resets_in_flight",
+			       "Server resets in progress", 2, user_labels);
+	prom_collector_add_metric(stat_route_metrics_collector,
+				  self->resets_in_flight);
 
 	prom_collector_registry_default_init();
 	prom_collector_registry_register_collector(
@@ -272,7 +445,8 @@ int od_prom_metrics_write_worker_stat(
 	struct od_prom_metrics *self, int worker_id, u_int64_t msg_allocated,
 	u_int64_t msg_cache_count, u_int64_t msg_cache_gc_count,
 	u_int64_t msg_cache_size, u_int64_t count_coroutine,
-	u_int64_t count_coroutine_cache, u_int64_t clients_processed)
+	u_int64_t count_coroutine_cache, u_int64_t clients_processed,
+	u_int64_t clients_active, u_int64_t cpu_load)
 {
 	if (self == NULL)
 		return 1;
@@ -308,6 +482,53 @@ int od_prom_metrics_write_worker_stat(
 			     labels);
 	if (err)
 		return err;
+	err = prom_gauge_set(self->clients_active, (double)clients_active,
+			     labels);
+	if (err)
+		return err;
+	/* cpu load is kept in per mille */
+	err = prom_gauge_set(self->worker_cpu_load, (double)cpu_load / 10,
+			     labels);
+	if (err)
+		return err;
+	return 0;
+}
+
+int od_prom_metrics_write_worker_stack_stat(struct od_prom_metrics *self,
+					    int worker_id,
+					    machine_stack_stat_t *stat,
+					    int count)
+{
+	if (self == NULL)
+		return 1;
+	char worker_label[12];
+	sprintf(worker_label, "worker[%d]", worker_id);
+	int err;
+	for (int i = 0; i < count; i++) {
+		char size_label[24];
+		sprintf(size_label, "%" PRIu64, stat[i].size);
+		const char *labels[2] = { worker_label, size_label };
+		err = prom_gauge_set(self->stacks_used,
+				     (double)stat[i].count_used, labels);
+		if (err)
+			return err;
+		err = prom_gauge_set(self->stacks_hot,
+				     (double)stat[i].count_hot, labels);
+		if (err)
+			return err;
+		err = prom_gauge_set(self->stacks_reclaimed,
+				     (double)stat[i].count_reclaimed, labels);
+		if (err)
+			return err;
+		err = prom_gauge_set(self->stack_mapped,
+				     (double)stat[i].mapped, labels);
+		if (err)
+			return err;
+		err = prom_gauge_set(self->stack_hwm, (double)stat[i].hwm,
+				     labels);
+		if (err)
+			return err;
+	}
 	return 0;
 }
 
@@ -376,6 +597,161 @@ int od_prom_metrics_write_stat_cb(
 	return 0;
 }
 
+int od_prom_metrics_write_auth_cache_stat(od_prom_metrics_t *self,
+					  const char *user,
+					  const char *database, u_int64_t hits,
+					  u_int64_t negative_hits,
+					  u_int64_t misses, u_int64_t waits,
+					  u_int64_t refreshes)
+{
+	if (self == NULL)
+		return 1;
+	const char *user_database_label[2] = { user, database };
+	int err = prom_gauge_set(self->auth_cache_hits, (double)hits,
+				 user_database_label);
+	if (err)
+		return err;
+	err = prom_gauge_set(self->auth_cache_negative_hits,
+			     (double)negative_hits, user_database_label);
+	if (err)
+		return err;
+	err = prom_gauge_set(self->auth_cache_misses, (double)misses,
+			     user_database_label);
+	if (err)
+		return err;
+	err = prom_gauge_set(self->auth_cache_waits, (double)waits,
+			     user_database_label);
+	if (err)
+		return err;
+	err = prom_gauge_set(self->auth_cache_refreshes, (double)refreshes,
+			     user_database_label);
+	if (err)
+		return err;
+	return 0;
+}
+
+/* bucket gauge has one more label than sum and count: "le" */
+#define OD_PROM_HIST_MAX_LABELS 2
+
+static inline int od_prom_metrics_write_hist(prom_gauge_t *bucket,
+					     prom_gauge_t *sum,
+					     prom_gauge_t *count,
+					     const char **labels,
+					     int labels_count, od_hist_t *hist)
+{
+	assert(labels_count <= OD_PROM_HIST_MAX_LABELS);
+	const char *bucket_labels[OD_PROM_HIST_MAX_LABELS + 1];
+	for (int i = 0; i < labels_count; i++) {
+		bucket_labels[i] = labels[i];
+	}
+
+	/* prometheus buckets are cumulative */
+	uint64_t total = 0;
+	for (int i = 0; i < OD_HIST_BUCKETS; i++) {
+		total += od_atomic_u64_of(&hist->buckets[i]);
+		char le[32];
+		uint64_t bound = od_hist_bucket_le(i);
+		if (bound) {
+			od_snprintf(le, sizeof(le), "%" PRIu64, bound);
+		} else {
+			od_snprintf(le, sizeof(le), "+Inf");
+		}
+		bucket_labels[labels_count] = le;
+		int err = prom_gauge_set(bucket, (double)total, bucket_labels);
+		if (err)
+			return err;
+	}
+	int err = prom_gauge_set(sum, (double)od_atomic_u64_of(&hist->sum_us),
+				 labels);
+	if (err)
+		return err;
+	return prom_gauge_set(count, (double)od_atomic_u64_of(&hist->count),
+			      labels);
+}
+
+int od_prom_metrics_write_crypto_stat(od_prom_metrics_t *self,
+				      const char *stage,
+				      struct od_crypto_stat *stat)
+{
+	if (self == NULL)
+		return 1;
+	const char *labels[1] = { stage };
+	int err = od_prom_metrics_write_hist(
+		self->crypto_queue_bucket, self->crypto_queue_sum,
+		self->crypto_queue_count, labels, 1, &stat->queue);
+	if (err)
+		return err;
+	err = od_prom_metrics_write_hist(
+		self->crypto_exec_bucket, self->crypto_exec_sum,
+		self->crypto_exec_count, labels, 1, &stat->exec);
+	if (err)
+		return err;
+	return prom_gauge_set(self->crypto_inline,
+			      (double)od_atomic_u64_of(&stat->inline_count),
+			      labels);
+}
+
+int od_prom_metrics_write_readahead_stat(od_prom_metrics_t *self,
+					 u_int64_t held, u_int64_t pooled)
+{
+	if (self == NULL)
+		return 1;
+	const char *labels[1] = { "general" };
+	int err = prom_gauge_set(self->readahead_held, (double)held, labels);
+	if (err)
+		return err;
+	return prom_gauge_set(self->readahead_pooled, (double)pooled, labels);
+}
+
+int od_prom_metrics_write_endpoint_stat(od_prom_metrics_t *self,
+					const char *user, const char *database,
+					const char *endpoint,
+					u_int64_t connect_ewma_us,
+					u_int64_t query_ewma_us,
+					u_int64_t server_active)
+{
+	if (self == NULL)
+		return 1;
+	const char *labels[3] = { user, database, endpoint };
+	int err = prom_gauge_set(self->endpoint_connect_ewma,
+				 (double)connect_ewma_us, labels);
+	if (err)
+		return err;
+	err = prom_gauge_set(self->endpoint_query_ewma, (double)query_ewma_us,
+			     labels);
+	if (err)
+		return err;
+	return prom_gauge_set(self->endpoint_server_active,
+			      (double)server_active, labels);
+}
+
+int od_prom_metrics_write_pool_wait_stat(od_prom_metrics_t *self,
+					 const char *user, const char *database,
+					 struct od_hist *hist)
+{
+	if (self == NULL)
+		return 1;
+	const char *labels[2] = { user, database };
+	return od_prom_metrics_write_hist(
+		self->pool_wait_bucket, self->pool_wait_sum,
+		self->pool_wait_count, labels, 2, hist);
+}
+
+int od_prom_metrics_write_reset_stat(od_prom_metrics_t *self,
+				     const char *user, const char *database,
+				     u_int64_t in_flight, struct od_hist *hist)
+{
+	if (self == NULL)
+		return 1;
+	const char *labels[2] = { user, database };
+	int err = prom_gauge_set(self->resets_in_flight, (double)in_flight,
+				 labels);
+	if (err)
+		return err;
+	return od_prom_metrics_write_hist(self->reset_bucket, self->reset_sum,
+					  self->reset_count, labels, 2, hist);
+}
+
 extern const char *od_prom_metrics_get_stat_cb(od_prom_metrics_t *self)
 {
 	if (self == NULL)
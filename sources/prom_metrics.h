@@ -7,9 +7,13 @@
  */
 
 #include <prom.h>
+#include <machinarium.h>
 
 typedef struct od_prom_metrics od_prom_metrics_t;
 
+struct od_crypto_stat;
+struct od_hist;
+
 struct od_prom_metrics {
 	prom_collector_registry_t *stat_general_metrics;
 	prom_gauge_t *database_len;
@@ -23,6 +27,22 @@ struct od_prom_metrics {
 	prom_gauge_t *count_coroutine;
 	prom_gauge_t *count_coroutine_cache;
 	prom_gauge_t *clients_processed;
+	prom_gauge_t *clients_active;
+	prom_gauge_t *worker_cpu_load;
+	prom_gauge_t *stacks_used;
+	prom_gauge_t *stacks_hot;
+	prom_gauge_t *stacks_reclaimed;
+	prom_gauge_t *stack_mapped;
+	prom_gauge_t *stack_hwm;
+	prom_gauge_t *readahead_held;
+	prom_gauge_t *readahead_pooled;
+	prom_gauge_t *crypto_queue_bucket;
+	prom_gauge_t *crypto_queue_sum;
+	prom_gauge_t *crypto_queue_count;
+	prom_gauge_t *crypto_exec_bucket;
+	prom_gauge_t *crypto_exec_sum;
+	prom_gauge_t *crypto_exec_count;
+	prom_gauge_t *crypto_inline;
 
 	prom_collector_registry_t *stat_route_metrics;
 	prom_gauge_t *client_pool_total;
@@ -32,6 +52,21 @@ struct od_prom_metrics {
 	prom_gauge_t *avg_query_time;
 	prom_gauge_t *avg_recv_client;
 	prom_gauge_t *avg_recv_server;
+	prom_gauge_t *auth_cache_hits;
+	prom_gauge_t *auth_cache_negative_hits;
+	prom_gauge_t *auth_cache_misses;
+	prom_gauge_t *auth_cache_waits;
+	prom_gauge_t *auth_cache_refreshes;
+	prom_gauge_t *endpoint_connect_ewma;
+	prom_gauge_t *endpoint_query_ewma;
+	prom_gauge_t *endpoint_server_active;
+	prom_gauge_t *pool_wait_bucket;
+	prom_gauge_t *pool_wait_sum;
+	prom_gauge_t *pool_wait_count;
+	prom_gauge_t *reset_bucket;
+	prom_gauge_t *reset_sum;
+	prom_gauge_t *reset_count;
+	prom_gauge_t *resets_in_flight;
 
 	struct MHD_Daemon *http_server;
 	int port;
@@ -57,7 +92,12 @@ extern int od_prom_metrics_write_worker_stat(
 	struct od_prom_metrics *self, int worker_id, u_int64_t msg_allocated,
 	u_int64_t msg_cache_count, u_int64_t msg_cache_gc_count,
 	u_int64_t msg_cache_size, u_int64_t count_coroutine,
-	u_int64_t count_coroutine_cache, u_int64_t clients_processed);
+	u_int64_t count_coroutine_cache, u_int64_t clients_processed,
+	u_int64_t clients_active, u_int64_t cpu_load);
+
+extern int od_prom_metrics_write_worker_stack_stat(
+	struct od_prom_metrics *self, int worker_id,
+	machine_stack_stat_t *stat, int count);
 
 extern const char *od_prom_metrics_get_stat(od_prom_metrics_t *self);
 
@@ -69,6 +109,35 @@ extern int od_prom_metrics_write_stat_cb(
 	u_int64_t avg_query_count, u_int64_t avg_query_time,
 	u_int64_t avg_recv_client, u_int64_t avg_recv_server);
 
+extern int od_prom_metrics_write_auth_cache_stat(
+	od_prom_metrics_t *self, const char *user, const char *database,
+	u_int64_t hits, u_int64_t negative_hits, u_int64_t misses,
+	u_int64_t waits, u_int64_t refreshes);
+
+extern int od_prom_metrics_write_endpoint_stat(
+	od_prom_metrics_t *self, const char *user, const char *database,
+	const char *endpoint, u_int64_t connect_ewma_us,
+	u_int64_t query_ewma_us, u_int64_t server_active);
+
+extern int od_prom_metrics_write_pool_wait_stat(od_prom_metrics_t *self,
+						const char *user,
+						const char *database,
+						struct od_hist *hist);
+
+extern int od_prom_metrics_write_reset_stat(od_prom_metrics_t *self,
+					    const char *user,
+					    const char *database,
+					    u_int64_t in_flight,
+					    struct od_hist *hist);
+
+extern int od_prom_metrics_write_crypto_stat(od_prom_metrics_t *self,
+					     const char *stage,
+					     struct od_crypto_stat *stat);
+
+extern int od_prom_metrics_write_readahead_stat(od_prom_metrics_t *self,
+						u_int64_t held,
+						u_int64_t pooled);
+
 extern const char *od_prom_metrics_get_stat_cb(od_prom_metrics_t *self);
 
 extern int od_prom_metrics_destroy(od_prom_metrics_t *self);
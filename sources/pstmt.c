@@ -0,0 +1,383 @@
+
+/*
+ * Odyssey.
+ *
+ * Scalable PostgreSQL connection pooler.
+ */
+
+#include <kiwi.h>
+#include <machinarium.h>
+#include <odyssey.h>
+
+#define OD_PSTMT_STORE_STRIPE_SZ 64
+
+static inline od_pstmt_store_stripe_t *
+od_pstmt_store_stripe(od_pstmt_store_t *store, od_hash_t hash)
+{
+	return &store->stripes[hash % OD_PSTMT_STORE_STRIPES];
+}
+
+static inline uint32_t od_pstmt_store_bucket(od_pstmt_store_stripe_t *stripe,
+					     od_hash_t hash)
+{
+	return (hash / OD_PSTMT_STORE_STRIPES) & (stripe->size - 1);
+}
+
+int od_pstmt_store_init(od_pstmt_store_t *store)
+{
+	memset(store, 0, sizeof(od_pstmt_store_t));
+	for (int i = 0; i < OD_PSTMT_STORE_STRIPES; i++) {
+		od_pstmt_store_stripe_t *stripe = &store->stripes[i];
+		pthread_mutex_init(&stripe->lock, NULL);
+		stripe->size = OD_PSTMT_STORE_STRIPE_SZ;
+		stripe->count = 0;
+		stripe->buckets =
+			od_malloc(sizeof(od_pstmt_t *) * stripe->size);
+		if (stripe->buckets == NULL) {
+			return NOT_OK_RESPONSE;
+		}
+		memset(stripe->buckets, 0, sizeof(od_pstmt_t *) * stripe->size);
+	}
+	return OK_RESPONSE;
+}
+
+void od_pstmt_store_free(od_pstmt_store_t *store)
+{
+	for (int i = 0; i < OD_PSTMT_STORE_STRIPES; i++) {
+		od_pstmt_store_stripe_t *stripe = &store->stripes[i];
+		if (stripe->buckets == NULL) {
+			continue;
+		}
+		for (uint32_t j = 0; j < stripe->size; j++) {
+			od_pstmt_t *stmt = stripe->buckets[j];
+			while (stmt) {
+				od_pstmt_t *next = stmt->next;
+				od_free(stmt);
+				stmt = next;
+			}
+		}
+		od_free(stripe->buckets);
+		stripe->buckets = NULL;
+		pthread_mutex_destroy(&stripe->lock);
+	}
+}
+
+static inline void od_pstmt_store_grow(od_pstmt_store_stripe_t *stripe)
+{
+	uint32_t size = stripe->size * 2;
+	od_pstmt_t **buckets = od_malloc(sizeof(od_pstmt_t *) * size);
+	if (buckets == NULL) {
+		/* keep longer chains */
+		return;
+	}
+	memset(buckets, 0, sizeof(od_pstmt_t *) * size);
+	for (uint32_t i = 0; i < stripe->size; i++) {
+		od_pstmt_t *stmt = stripe->buckets[i];
+		while (stmt) {
+			od_pstmt_t *next = stmt->next;
+			uint32_t pos = (stmt->hash / OD_PSTMT_STORE_STRIPES) &
+				       (size - 1);
+			stmt->next = buckets[pos];
+			buckets[pos] = stmt;
+			stmt = next;
+		}
+	}
+	od_free(stripe->buckets);
+	stripe->buckets = buckets;
+	stripe->size = size;
+}
+
+od_pstmt_t *od_pstmt_store_acquire(od_pstmt_store_t *store, od_hash_t hash,
+				   char *data, uint32_t len)
+{
+	od_pstmt_store_stripe_t *stripe = od_pstmt_store_stripe(store, hash);
+	pthread_mutex_lock(&stripe->lock);
+
+	uint32_t pos = od_pstmt_store_bucket(stripe, hash);
+	od_pstmt_t *stmt = stripe->buckets[pos];
+	for (; stmt; stmt = stmt->next) {
+		if (stmt->hash == hash && stmt->len == len &&
+		    memcmp(stmt->data, data, len) == 0) {
+			od_atomic_u32_inc(&stmt->refs);
+			pthread_mutex_unlock(&stripe->lock);
+			return stmt;
+		}
+	}
+
+	stmt = od_malloc(sizeof(od_pstmt_t) + len);
+	if (stmt == NULL) {
+		pthread_mutex_unlock(&stripe->lock);
+		return NULL;
+	}
+	stmt->hash = hash;
+	stmt->refs = 1;
+	stmt->len = len;
+	memcpy(stmt->data, data, len);
+	stmt->next = stripe->buckets[pos];
+	stripe->buckets[pos] = stmt;
+	stripe->count++;
+
+	if (stripe->count > stripe->size * 2) {
+		od_pstmt_store_grow(stripe);
+	}
+
+	pthread_mutex_unlock(&stripe->lock);
+	return stmt;
+}
+
+void od_pstmt_store_ref(od_pstmt_store_t *store, od_pstmt_t *stmt)
+{
+	od_pstmt_store_stripe_t *stripe =
+		od_pstmt_store_stripe(store, stmt->hash);
+	pthread_mutex_lock(&stripe->lock);
+	od_atomic_u32_inc(&stmt->refs);
+	pthread_mutex_unlock(&stripe->lock);
+}
+
+void od_pstmt_store_release(od_pstmt_store_t *store, od_pstmt_t *stmt)
+{
+	od_pstmt_store_stripe_t *stripe =
+		od_pstmt_store_stripe(store, stmt->hash);
+	pthread_mutex_lock(&stripe->lock);
+
+	if (od_atomic_u32_dec(&stmt->refs) > 1) {
+		pthread_mutex_unlock(&stripe->lock);
+		return;
+	}
+
+	od_pstmt_t **prev = &stripe->buckets[od_pstmt_store_bucket(
+		stripe, stmt->hash)];
+	while (*prev != stmt) {
+		prev = &(*prev)->next;
+	}
+	*prev = stmt->next;
+	stripe->count--;
+
+	pthread_mutex_unlock(&stripe->lock);
+	od_free(stmt);
+}
+
+uint64_t od_pstmt_store_count(od_pstmt_store_t *store)
+{
+	uint64_t count = 0;
+	for (int i = 0; i < OD_PSTMT_STORE_STRIPES; i++) {
+		od_pstmt_store_stripe_t *stripe = &store->stripes[i];
+		pthread_mutex_lock(&stripe->lock);
+		count += stripe->count;
+		pthread_mutex_unlock(&stripe->lock);
+	}
+	return count;
+}
+
+od_pstmt_map_t *od_pstmt_map_create(od_pstmt_store_t *store)
+{
+	od_pstmt_map_t *map = od_malloc(sizeof(od_pstmt_map_t));
+	if (map == NULL) {
+		return NULL;
+	}
+	map->store = store;
+	map->size = OD_PSTMT_MAP_DEFAULT_SZ;
+	map->count = 0;
+	map->entries = od_malloc(sizeof(od_pstmt_map_entry_t) * map->size);
+	if (map->entries == NULL) {
+		od_free(map);
+		return NULL;
+	}
+	memset(map->entries, 0, sizeof(od_pstmt_map_entry_t) * map->size);
+	pthread_mutex_init(&map->lock, NULL);
+	return map;
+}
+
+static inline void od_pstmt_map_entry_free(od_pstmt_map_t *map,
+					   od_pstmt_map_entry_t *entry)
+{
+	if (entry->stmt == NULL) {
+		return;
+	}
+	if (entry->name) {
+		od_free(entry->name);
+	}
+	od_pstmt_store_release(map->store, entry->stmt);
+	memset(entry, 0, sizeof(od_pstmt_map_entry_t));
+}
+
+void od_pstmt_map_empty(od_pstmt_map_t *map)
+{
+	pthread_mutex_lock(&map->lock);
+	for (uint32_t i = 0; i < map->size; i++) {
+		od_pstmt_map_entry_free(map, &map->entries[i]);
+	}
+	map->count = 0;
+	pthread_mutex_unlock(&map->lock);
+}
+
+void od_pstmt_map_free(od_pstmt_map_t *map)
+{
+	od_pstmt_map_empty(map);
+	pthread_mutex_destroy(&map->lock);
+	od_free(map->entries);
+	od_free(map);
+}
+
+/* linear probing, entries are never removed one by one */
+static inline od_pstmt_map_entry_t *
+od_pstmt_map_lookup(od_pstmt_map_t *map, od_hash_t hash, char *name,
+		    uint32_t name_len, od_pstmt_t *stmt)
+{
+	uint32_t mask = map->size - 1;
+	uint32_t pos = hash & mask;
+	for (;;) {
+		od_pstmt_map_entry_t *entry = &map->entries[pos];
+		if (entry->stmt == NULL) {
+			return entry;
+		}
+		if (entry->hash == hash) {
+			if (stmt && entry->stmt == stmt) {
+				return entry;
+			}
+			if (stmt == NULL && entry->name_len == name_len &&
+			    memcmp(entry->name, name, name_len) == 0) {
+				return entry;
+			}
+		}
+		pos = (pos + 1) & mask;
+	}
+}
+
+static inline int od_pstmt_map_grow(od_pstmt_map_t *map)
+{
+	/* keep load factor under 3/4 */
+	if ((map->count + 1) * 4 <= map->size * 3) {
+		return OK_RESPONSE;
+	}
+
+	od_pstmt_map_entry_t *entries = map->entries;
+	uint32_t size = map->size;
+	map->entries = od_malloc(sizeof(od_pstmt_map_entry_t) * size * 2);
+	if (map->entries == NULL) {
+		map->entries = entries;
+		return NOT_OK_RESPONSE;
+	}
+	memset(map->entries, 0, sizeof(od_pstmt_map_entry_t) * size * 2);
+	map->size = size * 2;
+
+	for (uint32_t i = 0; i < size; i++) {
+		od_pstmt_map_entry_t *entry = &entries[i];
+		if (entry->stmt == NULL) {
+			continue;
+		}
+		uint32_t pos = entry->hash & (map->size - 1);
+		while (map->entries[pos].stmt) {
+			pos = (pos + 1) & (map->size - 1);
+		}
+		map->entries[pos] = *entry;
+	}
+	od_free(entries);
+	return OK_RESPONSE;
+}
+
+od_pstmt_t *od_pstmt_map_find(od_pstmt_map_t *map, char *name,
+			      uint32_t name_len)
+{
+	od_hash_t hash = od_murmur_hash(name, name_len);
+	pthread_mutex_lock(&map->lock);
+	od_pstmt_map_entry_t *entry =
+		od_pstmt_map_lookup(map, hash, name, name_len, NULL);
+	od_pstmt_t *stmt = entry->stmt;
+	pthread_mutex_unlock(&map->lock);
+	return stmt;
+}
+
+int od_pstmt_map_set(od_pstmt_map_t *map, char *name, uint32_t name_len,
+		     od_pstmt_t *stmt)
+{
+	od_hash_t hash = od_murmur_hash(name, name_len);
+	pthread_mutex_lock(&map->lock);
+
+	od_pstmt_map_entry_t *entry =
+		od_pstmt_map_lookup(map, hash, name, name_len, NULL);
+	if (entry->stmt) {
+		int rc = OK_RESPONSE;
+		if (entry->stmt == stmt) {
+			/* same body, nothing to do */
+		} else if (name_len == 0 || name[0] == '\0') {
+			/* unnamed statement is replaced by each parse */
+			od_pstmt_store_ref(map->store, stmt);
+			od_pstmt_store_release(map->store, entry->stmt);
+			entry->stmt = stmt;
+		} else {
+			rc = 1;
+		}
+		pthread_mutex_unlock(&map->lock);
+		return rc;
+	}
+
+	if (od_pstmt_map_grow(map) != OK_RESPONSE) {
+		pthread_mutex_unlock(&map->lock);
+		return NOT_OK_RESPONSE;
+	}
+	entry = od_pstmt_map_lookup(map, hash, name, name_len, NULL);
+
+	char *copy = od_malloc(name_len + 1);
+	if (copy == NULL) {
+		pthread_mutex_unlock(&map->lock);
+		return NOT_OK_RESPONSE;
+	}
+	memcpy(copy, name, name_len);
+	copy[name_len] = 0;
+
+	od_pstmt_store_ref(map->store, stmt);
+	entry->hash = hash;
+	entry->name = copy;
+	entry->name_len = name_len;
+	entry->stmt = stmt;
+	map->count++;
+
+	pthread_mutex_unlock(&map->lock);
+	return OK_RESPONSE;
+}
+
+int od_pstmt_map_add(od_pstmt_map_t *map, od_pstmt_t *stmt)
+{
+	pthread_mutex_lock(&map->lock);
+
+	od_pstmt_map_entry_t *entry =
+		od_pstmt_map_lookup(map, stmt->hash, NULL, 0, stmt);
+	if (entry->stmt) {
+		pthread_mutex_unlock(&map->lock);
+		return 0;
+	}
+
+	if (od_pstmt_map_grow(map) != OK_RESPONSE) {
+		pthread_mutex_unlock(&map->lock);
+		return -1;
+	}
+	entry = od_pstmt_map_lookup(map, stmt->hash, NULL, 0, stmt);
+
+	od_pstmt_store_ref(map->store, stmt);
+	entry->hash = stmt->hash;
+	entry->stmt = stmt;
+	map->count++;
+
+	pthread_mutex_unlock(&map->lock);
+	return 1;
+}
+
+int od_pstmt_map_foreach(od_pstmt_map_t *map, od_pstmt_map_cb_t cb,
+			 void **argv)
+{
+	int rc = 0;
+	pthread_mutex_lock(&map->lock);
+	for (uint32_t i = 0; i < map->size; i++) {
+		od_pstmt_map_entry_t *entry = &map->entries[i];
+		if (entry->stmt == NULL) {
+			continue;
+		}
+		rc = cb(entry->stmt, argv);
+		if (rc != 0) {
+			break;
+		}
+	}
+	pthread_mutex_unlock(&map->lock);
+	return rc;
+}
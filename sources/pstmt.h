@@ -5,3 +5,82 @@
  *
  * Scalable PostgreSQL connection pooler.
  */
+
+/*
+ * Prepared statements store.
+ *
+ * Statement descriptions (query text and parameter types) are interned
+ * in a global store, keyed by murmur hash of the body and reference
+ * counted. Clients and servers keep small open addressing maps of
+ * pointers into the store: client map is keyed by client statement
+ * name, server map is a set of statements deployed on the server.
+ */
+
+typedef struct od_pstmt od_pstmt_t;
+typedef struct od_pstmt_store_stripe od_pstmt_store_stripe_t;
+typedef struct od_pstmt_store od_pstmt_store_t;
+typedef struct od_pstmt_map_entry od_pstmt_map_entry_t;
+typedef struct od_pstmt_map od_pstmt_map_t;
+
+struct od_pstmt {
+	od_hash_t hash;
+	od_atomic_u32_t refs;
+	uint32_t len;
+	od_pstmt_t *next;
+	char data[];
+};
+
+#define OD_PSTMT_STORE_STRIPES 64
+
+struct od_pstmt_store_stripe {
+	pthread_mutex_t lock;
+	od_pstmt_t **buckets;
+	uint32_t size;
+	uint32_t count;
+};
+
+struct od_pstmt_store {
+	od_pstmt_store_stripe_t stripes[OD_PSTMT_STORE_STRIPES];
+};
+
+int od_pstmt_store_init(od_pstmt_store_t *);
+void od_pstmt_store_free(od_pstmt_store_t *);
+od_pstmt_t *od_pstmt_store_acquire(od_pstmt_store_t *, od_hash_t, char *,
+				   uint32_t);
+void od_pstmt_store_ref(od_pstmt_store_t *, od_pstmt_t *);
+void od_pstmt_store_release(od_pstmt_store_t *, od_pstmt_t *);
+uint64_t od_pstmt_store_count(od_pstmt_store_t *);
+
+struct od_pstmt_map_entry {
+	od_hash_t hash;
+	uint32_t name_len;
+	char *name;
+	od_pstmt_t *stmt;
+};
+
+struct od_pstmt_map {
+	od_pstmt_store_t *store;
+	pthread_mutex_t lock;
+	od_pstmt_map_entry_t *entries;
+	uint32_t size;
+	uint32_t count;
+};
+
+#define OD_PSTMT_MAP_DEFAULT_SZ 8
+
+od_pstmt_map_t *od_pstmt_map_create(od_pstmt_store_t *);
+void od_pstmt_map_free(od_pstmt_map_t *);
+void od_pstmt_map_empty(od_pstmt_map_t *);
+
+/* client map: statement name -> statement,
+ * set returns 1 if named statement exists with other body, -1 on error */
+od_pstmt_t *od_pstmt_map_find(od_pstmt_map_t *, char *, uint32_t);
+int od_pstmt_map_set(od_pstmt_map_t *, char *, uint32_t, od_pstmt_t *);
+
+/* server map: set of deployed statements,
+ * returns 1 if statement is new, 0 if already added, -1 on error */
+int od_pstmt_map_add(od_pstmt_map_t *, od_pstmt_t *);
+
+typedef int (*od_pstmt_map_cb_t)(od_pstmt_t *, void **);
+
+int od_pstmt_map_foreach(od_pstmt_map_t *, od_pstmt_map_cb_t, void **);
@@ -0,0 +1,157 @@
+
+/*
+ * Odyssey.
+ *
+ * Scalable PostgreSQL connection pooler.
+ */
+
+#include <kiwi.h>
+#include <machinarium.h>
+#include <odyssey.h>
+
+/* buffers taken by machines without a pool, like the system one */
+static od_atomic_u64_t od_readahead_held_global = 0;
+
+/* pool of the worker running on this thread */
+static __thread od_readahead_pool_t *od_readahead_pool_local = NULL;
+
+void od_readahead_pool_init(od_readahead_pool_t *pool, int size,
+			    int size_max)
+{
+	pool->count = 0;
+	pool->size = size;
+	/* readahead_max below readahead disables growth */
+	if (size_max < size)
+		size_max = size;
+	pool->size_max = size_max;
+	pool->held = 0;
+	pool->pooled = 0;
+}
+
+static inline void od_readahead_pool_flush(od_readahead_pool_t *pool)
+{
+	for (int i = 0; i < pool->count; i++)
+		machine_msg_free(pool->free[i]);
+	pool->count = 0;
+	od_atomic_u64_set(&pool->pooled, 0);
+}
+
+void od_readahead_pool_free(od_readahead_pool_t *pool)
+{
+	od_readahead_pool_flush(pool);
+}
+
+uint64_t od_readahead_held_unpooled(void)
+{
+	return od_atomic_u64_of(&od_readahead_held_global);
+}
+
+void od_readahead_pool_attach(od_readahead_pool_t *pool)
+{
+	od_readahead_pool_local = pool;
+}
+
+static inline od_readahead_pool_t *od_readahead_pool_current(void)
+{
+	return od_readahead_pool_local;
+}
+
+static inline machine_msg_t *od_readahead_pool_get(od_readahead_pool_t *pool,
+						   int size)
+{
+	machine_msg_t *buf;
+	if (pool == NULL) {
+		buf = machine_msg_create(size);
+		if (buf != NULL)
+			od_atomic_u64_add(&od_readahead_held_global, size);
+		return buf;
+	}
+
+	if (size == pool->size && pool->count > 0) {
+		buf = pool->free[--pool->count];
+		od_atomic_u64_sub(&pool->pooled, size);
+	} else {
+		buf = machine_msg_create(size);
+		if (buf == NULL)
+			return NULL;
+	}
+	od_atomic_u64_add(&pool->held, size);
+	return buf;
+}
+
+static inline void od_readahead_pool_put(od_readahead_pool_t *pool,
+					 machine_msg_t *buf, int size)
+{
+	if (pool == NULL) {
+		od_atomic_u64_sub(&od_readahead_held_global, size);
+		machine_msg_free(buf);
+		return;
+	}
+	od_atomic_u64_sub(&pool->held, size);
+
+	if (size != pool->size || pool->count == OD_READAHEAD_POOL_MAX) {
+		machine_msg_free(buf);
+		return;
+	}
+	pool->free[pool->count++] = buf;
+	od_atomic_u64_add(&pool->pooled, size);
+}
+
+int od_readahead_acquire(od_readahead_t *readahead)
+{
+	if (readahead->buf != NULL)
+		return 0;
+	od_readahead_pool_t *pool = od_readahead_pool_current();
+	readahead->buf = od_readahead_pool_get(pool, readahead->size_default);
+	if (readahead->buf == NULL)
+		return -1;
+	readahead->size = readahead->size_default;
+	readahead->pos = 0;
+	readahead->pos_read = 0;
+	return 0;
+}
+
+void od_readahead_release(od_readahead_t *readahead)
+{
+	if (readahead->buf == NULL)
+		return;
+	/* not at a packet boundary */
+	if (readahead->pos != readahead->pos_read)
+		return;
+	od_readahead_pool_put(od_readahead_pool_current(), readahead->buf,
+			      readahead->size);
+	readahead->buf = NULL;
+	readahead->size = 0;
+	readahead->pos = 0;
+	readahead->pos_read = 0;
+}
+
+/*
+ * Called on reuse, when no one points into the buffer. Buffer size is
+ * doubled and the unread bytes of next packet header are moved.
+ */
+int od_readahead_grow(od_readahead_t *readahead)
+{
+	od_readahead_pool_t *pool = od_readahead_pool_current();
+	if (pool == NULL || readahead->size >= pool->size_max)
+		return -1;
+
+	int size = readahead->size * 2;
+	if (size > pool->size_max)
+		size = pool->size_max;
+	machine_msg_t *buf = machine_msg_create(size);
+	if (buf == NULL)
+		return -1;
+	od_atomic_u64_add(&pool->held, size);
+
+	int unread = readahead->pos - readahead->pos_read;
+	char *data = machine_msg_data(readahead->buf);
+	memcpy(machine_msg_data(buf), data + readahead->pos_read, unread);
+	od_readahead_pool_put(pool, readahead->buf, readahead->size);
+
+	readahead->buf = buf;
+	readahead->size = size;
+	readahead->pos = unread;
+	readahead->pos_read = 0;
+	return 0;
+}
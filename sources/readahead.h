@@ -6,35 +6,69 @@
  * Scalable PostgreSQL connection pooler.
  */
 
+/*
+ * Readahead buffer is taken from the worker pool on first read and is
+ * given back when connection is idle at a packet boundary. Connections
+ * streaming large results double their buffer up to readahead_max,
+ * grown buffers are freed on release.
+ */
+
 typedef struct od_readahead od_readahead_t;
+typedef struct od_readahead_pool od_readahead_pool_t;
+
+/* free buffers kept by a worker */
+#define OD_READAHEAD_POOL_MAX 256
+
+struct od_readahead_pool {
+	machine_msg_t *free[OD_READAHEAD_POOL_MAX];
+	int count;
+	int size;
+	int size_max;
+	/*
+	 * bytes taken minus bytes given back by the machine, connections
+	 * move between workers, so only the sum over pools makes sense
+	 */
+	od_atomic_u64_t held;
+	od_atomic_u64_t pooled;
+};
 
 struct od_readahead {
 	machine_msg_t *buf;
 	int size;
+	int size_default;
 	int pos;
 	int pos_read;
 };
 
+void od_readahead_pool_init(od_readahead_pool_t *, int, int);
+void od_readahead_pool_free(od_readahead_pool_t *);
+void od_readahead_pool_attach(od_readahead_pool_t *);
+uint64_t od_readahead_held_unpooled(void);
+
+int od_readahead_acquire(od_readahead_t *);
+void od_readahead_release(od_readahead_t *);
+int od_readahead_grow(od_readahead_t *);
+
 static inline void od_readahead_init(od_readahead_t *readahead)
 {
 	readahead->buf = NULL;
 	readahead->size = 0;
+	readahead->size_default = 0;
 	readahead->pos = 0;
 	readahead->pos_read = 0;
 }
 
 static inline void od_readahead_free(od_readahead_t *readahead)
 {
-	if (readahead->buf)
-		machine_msg_free(readahead->buf);
+	readahead->pos = 0;
+	readahead->pos_read = 0;
+	od_readahead_release(readahead);
 }
 
 static inline int od_readahead_prepare(od_readahead_t *readahead, int size)
 {
-	readahead->buf = machine_msg_create_or_advance(readahead->buf, size);
-	if (readahead->buf == NULL)
-		return -1;
-	readahead->size = size;
+	/* buffer is allocated on first read */
+	readahead->size_default = size;
 	return 0;
 }
 
@@ -79,6 +113,10 @@ static inline void od_readahead_reuse(od_readahead_t *readahead)
 	size_t unread = od_readahead_unread(readahead);
 	if (unread > sizeof(sizeof(kiwi_header_t)))
 		return;
+	/* buffer was filled up, client is streaming */
+	if (readahead->size > 0 && readahead->pos == readahead->size &&
+	    od_readahead_grow(readahead) == 0)
+		return;
 	if (unread == 0) {
 		readahead->pos = 0;
 		readahead->pos_read = 0;
@@ -112,9 +112,18 @@ static inline void od_relay_free(od_relay_t *relay)
 
 static inline bool od_relay_data_pending(od_relay_t *relay)
 {
-	char *current = od_readahead_pos_read(&relay->src->readahead);
-	char *end = od_readahead_pos(&relay->src->readahead);
-	return current < end;
+	return od_readahead_unread(&relay->src->readahead) > 0;
+}
+
+/*
+ * Give readahead buffer back to the worker pool, if all read data is
+ * processed and nothing in iov points into the buffer
+ */
+static inline void od_relay_release(od_relay_t *relay)
+{
+	if (relay->iov != NULL && machine_iov_pending(relay->iov))
+		return;
+	od_readahead_release(&relay->src->readahead);
 }
 
 od_frontend_status_t od_relay_start_client_to_server(od_client_t *client,
@@ -279,6 +288,9 @@ od_relay_process(od_relay_t *relay, int *progress, char *data, int size)
 
 static inline od_frontend_status_t od_relay_pipeline(od_relay_t *relay)
 {
+	if (!od_relay_data_pending(relay))
+		return OD_OK;
+
 	char *current = od_readahead_pos_read(&relay->src->readahead);
 	char *end = od_readahead_pos(&relay->src->readahead);
 	while (current < end) {
@@ -330,6 +342,9 @@ void od_relay_update_stats(od_relay_t *relay, int size);
  */
 static inline od_frontend_status_t od_relay_read(od_relay_t *relay)
 {
+	if (od_readahead_acquire(&relay->src->readahead) == -1)
+		return OD_EOOM;
+
 	int to_read;
 	to_read = od_readahead_left(&relay->src->readahead);
 	if (to_read == 0) {
@@ -9,7 +9,7 @@
 #include <machinarium.h>
 #include <odyssey.h>
 
-int od_reset(od_server_t *server)
+static inline int od_reset_server(od_server_t *server)
 {
 	od_instance_t *instance = server->global->instance;
 	od_route_t *route = server->route;
@@ -193,3 +193,33 @@ drop:
 error:
 	return -1;
 }
+
+int od_reset(od_server_t *server)
+{
+	od_route_t *route = server->route;
+
+	od_atomic_u32_inc(&route->resets);
+	uint64_t start = machine_time_us();
+	int rc = od_reset_server(server);
+	od_hist_observe(&route->reset_hist, machine_time_us() - start);
+	od_atomic_u32_dec(&route->resets);
+	return rc;
+}
+
+/*
+ * Reset of synchronized server out of transaction only sends discard
+ * queries, client does not depend on their result and may go on
+ * without waiting for them.
+ */
+bool od_reset_deferrable(od_server_t *server)
+{
+	od_rule_pool_t *pool = server->route->rule->pool;
+
+	if (!od_server_synchronized(server) || server->is_transaction)
+		return false;
+	if (server->in_out_response_received !=
+	    server->done_fail_response_received)
+		return false;
+	return pool->discard || pool->smart_discard ||
+	       pool->discard_query != NULL;
+}
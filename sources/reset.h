@@ -7,3 +7,4 @@
  */
 
 int od_reset(od_server_t *);
+bool od_reset_deferrable(od_server_t *);
@@ -21,12 +21,24 @@ struct od_route {
 	kiwi_params_lock_t params;
 	int64_t tcp_connections;
 	int last_heartbeat;
-	machine_wait_list_t *wait_bus;
+	/* time clients waited for a server, in total and per priority class */
+	od_hist_t wait_hist;
+	od_hist_t class_wait_hist[OD_RULE_PRIORITY_CLASS_MAX];
+	/* server resets in progress and their duration */
+	od_atomic_u32_t resets;
+	od_hist_t reset_hist;
+	/* target pool size of adaptive pool */
+	od_pool_controller_t pool_controller;
+	od_route_prewarm_t prewarm;
 	pthread_mutex_t lock;
 
 	od_error_logger_t *err_logger;
 	bool extra_logging_enabled;
 
+	/* route pool hash index */
+	od_hash_t hash;
+	od_list_t hash_link;
+
 	od_list_t link;
 };
 
@@ -60,7 +72,14 @@ static inline int od_route_init(od_route_t *route, bool extra_route_logging)
 	od_stat_init(&route->stats_prev);
 	kiwi_params_lock_init(&route->params);
 	od_list_init(&route->link);
-	route->wait_bus = NULL;
+	route->hash = 0;
+	od_list_init(&route->hash_link);
+	od_hist_init(&route->wait_hist);
+	route->resets = 0;
+	od_hist_init(&route->reset_hist);
+	for (int k = 0; k < OD_RULE_PRIORITY_CLASS_MAX; k++)
+		od_hist_init(&route->class_wait_hist[k]);
+	od_route_prewarm_init(&route->prewarm);
 	pthread_mutex_init(&route->lock, NULL);
 
 	return OK_RESPONSE;
@@ -73,11 +92,7 @@ static inline void od_route_free(od_route_t *route)
 	od_multi_pool_destroy(route->server_pools);
 
 	kiwi_params_lock_free(&route->params);
-	if (route->wait_bus)
-		machine_wait_list_destroy(route->wait_bus);
-	if (route->stats.enable_quantiles) {
-		od_stat_free(&route->stats);
-	}
+	od_stat_free(&route->stats);
 
 	if (route->extra_logging_enabled) {
 		od_err_logger_free(route->err_logger);
@@ -97,11 +112,6 @@ static inline od_route_t *od_route_allocate()
 		od_route_free(route);
 		return NULL;
 	}
-	route->wait_bus = machine_wait_list_create(NULL);
-	if (route->wait_bus == NULL) {
-		od_route_free(route);
-		return NULL;
-	}
 	return route;
 }
 
@@ -115,6 +125,15 @@ static inline void od_route_unlock(od_route_t *route)
 	pthread_mutex_unlock(&route->lock);
 }
 
+/* server pool size limit of every route endpoint, zero is unlimited */
+static inline int od_route_pool_size(od_route_t *route)
+{
+	od_rule_pool_t *pool = route->rule->pool;
+	if (pool->size_adaptive)
+		return od_pool_controller_target(&route->pool_controller);
+	return pool->size;
+}
+
 static inline int od_route_is_dynamic(od_route_t *route)
 {
 	return route->rule->db_is_default || route->rule->user_is_default;
@@ -129,21 +148,9 @@ static inline int od_route_match_compare_client_cb(od_client_t *client,
 static inline od_client_t *od_route_match_client(od_route_t *route, od_id_t *id)
 {
 	void *argv[] = { id };
-	od_client_t *match;
-	match = od_client_pool_foreach(&route->client_pool, OD_CLIENT_ACTIVE,
-				       od_route_match_compare_client_cb, argv);
-	if (match)
-		return match;
-	match = od_client_pool_foreach(&route->client_pool, OD_CLIENT_QUEUE,
-				       od_route_match_compare_client_cb, argv);
-	if (match)
-		return match;
-	match = od_client_pool_foreach(&route->client_pool, OD_CLIENT_PENDING,
-				       od_route_match_compare_client_cb, argv);
-	if (match)
-		return match;
-
-	return NULL;
+	/* single pass, clients change state without the route lock */
+	return od_client_pool_foreach(&route->client_pool, OD_CLIENT_UNDEF,
+				      od_route_match_compare_client_cb, argv);
 }
 
 static inline void od_route_kill_client(od_route_t *route, od_id_t *id)
@@ -177,11 +184,7 @@ static inline int od_route_reload_cb(od_server_t *server, void **argv)
 
 static inline void od_route_kill_client_pool(od_route_t *route)
 {
-	od_client_pool_foreach(&route->client_pool, OD_CLIENT_ACTIVE,
-			       od_route_kill_cb, NULL);
-	od_client_pool_foreach(&route->client_pool, OD_CLIENT_PENDING,
-			       od_route_kill_cb, NULL);
-	od_client_pool_foreach(&route->client_pool, OD_CLIENT_QUEUE,
+	od_client_pool_foreach(&route->client_pool, OD_CLIENT_UNDEF,
 			       od_route_kill_cb, NULL);
 }
 
@@ -200,16 +203,3 @@ static inline void od_route_reload_pool(od_route_t *route)
 	od_multi_pool_foreach(route->server_pools, OD_SERVER_IDLE,
 			      od_route_reload_cb, NULL);
 }
-
-static inline int od_route_wait(od_route_t *route, uint32_t time_ms)
-{
-	int rc;
-	rc = machine_wait_list_wait(route->wait_bus, time_ms);
-	return rc;
-}
-
-static inline int od_route_signal(od_route_t *route)
-{
-	machine_wait_list_notify(route->wait_bus);
-	return 0;
-}
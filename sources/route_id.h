@@ -68,3 +68,12 @@ static inline int od_route_id_compare(od_route_id_t *a, od_route_id_t *b)
 	}
 	return 0;
 }
+
+static inline od_hash_t od_route_id_hash(od_route_id_t *id)
+{
+	od_hash_t hash;
+	hash = od_murmur_hash(id->database, id->database_len);
+	hash ^= od_murmur_hash(id->user, id->user_len) * 31;
+	hash ^= (od_hash_t)id->physical_rep << 1 | (od_hash_t)id->logical_rep;
+	return hash;
+}
@@ -25,6 +25,8 @@ typedef int (*od_route_pool_cb_t)(od_route_t *, void **);
 
 typedef struct od_route_pool od_route_pool_t;
 
+#define OD_ROUTE_POOL_BUCKETS_MIN 64
+
 struct od_route_pool {
 	/* used for counting error for client without concrete route
 	 * like default_db.usr1, db1.default, etc
@@ -34,6 +36,14 @@ struct od_route_pool {
 	pthread_mutex_t lock;
 
 	od_list_t list;
+
+	/*
+	 * hash index of routes by route id, readers are allowed
+	 * to lookup concurrently under shared router lock,
+	 * modifications require exclusive router lock
+	 */
+	od_list_t *buckets;
+	size_t buckets_count;
 };
 
 #define od_route_pool_lock(route_pool) pthread_mutex_lock(&route_pool.lock);
@@ -42,12 +52,27 @@ struct od_route_pool {
 typedef od_retcode_t (*od_route_pool_stat_frontend_error_cb_t)(
 	od_route_pool_t *pool, void **argv);
 
+static inline od_list_t *od_route_pool_buckets_create(size_t count)
+{
+	od_list_t *buckets = od_malloc(sizeof(od_list_t) * count);
+	if (buckets == NULL)
+		return NULL;
+	for (size_t i = 0; i < count; ++i)
+		od_list_init(&buckets[i]);
+	return buckets;
+}
+
 static inline void od_route_pool_init(od_route_pool_t *pool)
 {
 	od_list_init(&pool->list);
 	pool->err_logger = od_err_logger_create_default();
 	pool->count = 0;
 	pthread_mutex_init(&pool->lock, NULL);
+
+	pool->buckets_count = OD_ROUTE_POOL_BUCKETS_MIN;
+	pool->buckets = od_route_pool_buckets_create(pool->buckets_count);
+	if (pool->buckets == NULL)
+		pool->buckets_count = 0;
 }
 
 static inline void od_route_pool_free(od_route_pool_t *pool)
@@ -65,6 +90,55 @@ static inline void od_route_pool_free(od_route_pool_t *pool)
 		route = od_container_of(i, od_route_t, link);
 		od_route_free(route);
 	}
+
+	if (pool->buckets)
+		od_free(pool->buckets);
+	pool->buckets = NULL;
+	pool->buckets_count = 0;
+}
+
+static inline od_list_t *od_route_pool_bucket(od_route_pool_t *pool,
+					      od_hash_t hash)
+{
+	return &pool->buckets[hash & (pool->buckets_count - 1)];
+}
+
+/* keep average chain length at most 2, resize is done under exclusive lock */
+static inline void od_route_pool_rehash(od_route_pool_t *pool)
+{
+	if (pool->buckets_count != 0 &&
+	    (size_t)pool->count <= pool->buckets_count * 2)
+		return;
+
+	size_t count = pool->buckets_count ? pool->buckets_count * 2 :
+					     OD_ROUTE_POOL_BUCKETS_MIN;
+	od_list_t *buckets = od_route_pool_buckets_create(count);
+	if (buckets == NULL)
+		return;
+
+	if (pool->buckets)
+		od_free(pool->buckets);
+	pool->buckets = buckets;
+	pool->buckets_count = count;
+
+	od_list_t *i;
+	od_list_foreach(&pool->list, i)
+	{
+		od_route_t *route;
+		route = od_container_of(i, od_route_t, link);
+		od_list_init(&route->hash_link);
+		od_list_append(od_route_pool_bucket(pool, route->hash),
+			       &route->hash_link);
+	}
+}
+
+static inline void od_route_pool_unlink(od_route_pool_t *pool,
+					od_route_t *route)
+{
+	assert(pool->count > 0);
+	pool->count--;
+	od_list_unlink(&route->link);
+	od_list_unlink(&route->hash_link);
 }
 
 static inline od_route_t *od_route_pool_new(od_route_pool_t *pool,
@@ -80,6 +154,8 @@ static inline od_route_t *od_route_pool_new(od_route_pool_t *pool,
 		return NULL;
 	}
 	route->rule = rule;
+	od_pool_controller_init(&route->pool_controller, rule->pool->min_size,
+				rule->pool->size);
 	if (rule->quantiles_count) {
 		route->stats.enable_quantiles = true;
 		for (size_t i = 0; i < QUANTILES_WINDOW; ++i) {
@@ -89,8 +165,26 @@ static inline od_route_t *od_route_pool_new(od_route_pool_t *pool,
 				td_new(QUANTILES_COMPRESSION);
 		}
 	}
+
+	int workers = od_global_get_workers_count();
+	if (od_stat_shards_create(&route->stats, workers) != OK_RESPONSE) {
+		od_route_free(route);
+		return NULL;
+	}
+
+	route->hash = od_route_id_hash(&route->id);
 	od_list_append(&pool->list, &route->link);
 	pool->count++;
+
+	od_route_pool_rehash(pool);
+	if (pool->buckets_count == 0) {
+		/* index is unavailable, route is still reachable by list */
+		return route;
+	}
+	if (od_list_empty(&route->hash_link)) {
+		od_list_append(od_route_pool_bucket(pool, route->hash),
+			       &route->hash_link);
+	}
 	return route;
 }
 
@@ -117,11 +211,25 @@ static inline od_route_t *
 od_route_pool_match(od_route_pool_t *pool, od_route_id_t *key, od_rule_t *rule)
 {
 	od_list_t *i;
-	od_list_foreach(&pool->list, i)
+	if (od_unlikely(pool->buckets_count == 0)) {
+		od_list_foreach(&pool->list, i)
+		{
+			od_route_t *route;
+			route = od_container_of(i, od_route_t, link);
+			if (route->rule == rule &&
+			    od_route_id_compare(&route->id, key)) {
+				return route;
+			}
+		}
+		return NULL;
+	}
+
+	od_hash_t hash = od_route_id_hash(key);
+	od_list_foreach(od_route_pool_bucket(pool, hash), i)
 	{
 		od_route_t *route;
-		route = od_container_of(i, od_route_t, link);
-		if (route->rule == rule &&
+		route = od_container_of(i, od_route_t, hash_link);
+		if (route->hash == hash && route->rule == rule &&
 		    od_route_id_compare(&route->id, key)) {
 			return route;
 		}
@@ -152,11 +260,14 @@ static inline void od_route_pool_stat(od_route_pool_t *pool,
 		od_stat_t avg;
 		od_stat_init(&avg);
 		if (route->stats.enable_quantiles) {
+			od_route_lock(route);
+			od_stat_merge_shards(&route->stats);
 			uint8_t current_tdigest = route->stats.current_tdigest;
 			next_tdigest = (current_tdigest + 1) % QUANTILES_WINDOW;
 			td_reset(route->stats.transaction_hgram[next_tdigest]);
 			td_reset(route->stats.query_hgram[next_tdigest]);
 			route->stats.current_tdigest = next_tdigest;
+			od_route_unlock(route);
 		}
 
 		od_stat_average(&avg, &current, &route->stats_prev,
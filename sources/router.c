@@ -11,13 +11,14 @@
 
 void od_router_init(od_router_t *router, od_global_t *global)
 {
-	pthread_mutex_init(&router->lock, NULL);
+	pthread_rwlock_init(&router->lock, NULL);
 	od_rules_init(&router->rules);
 	od_list_init(&router->servers);
 	od_route_pool_init(&router->route_pool);
 	router->clients = 0;
 	router->clients_routing = 0;
 	router->servers_routing = 0;
+	od_prewarm_init(&router->prewarm);
 
 	router->global = global;
 
@@ -63,14 +64,15 @@ void od_router_free(od_router_t *router)
 	od_router_foreach(router, od_router_immed_close_cb, NULL);
 	od_route_pool_free(&router->route_pool);
 	od_rules_free(&router->rules);
-	pthread_mutex_destroy(&router->lock);
+	pthread_rwlock_destroy(&router->lock);
 	od_err_logger_free(router->router_err_logger);
 }
 
 int od_router_foreach(od_router_t *router, od_route_pool_cb_t callback,
 		      void **argv)
 {
-	od_router_lock(router);
+	/* callbacks must not modify route pool itself */
+	od_router_rdlock(router);
 	int rc;
 	rc = od_route_pool_foreach(&router->route_pool, callback, argv);
 	od_router_unlock(router);
@@ -244,11 +246,25 @@ static inline int od_router_lifetime_expired(od_server_t *server,
 	return server_life >= max_lifetime;
 }
 
+/* idle server over the adaptive pool target size, element lock is held */
+static inline int od_router_pool_size_exceeded(od_server_t *server)
+{
+	od_route_t *route = server->route;
+
+	if (!route->rule->pool->size_adaptive) {
+		return 0;
+	}
+
+	od_server_pool_t *pool = &server->pool_element->pool;
+	return od_server_pool_total(pool) > od_route_pool_size(route);
+}
+
 static inline int od_router_server_expired(od_server_t *server,
 					   uint64_t *now_us)
 {
 	return od_router_pool_ttl_expired(server) ||
-	       od_router_lifetime_expired(server, now_us);
+	       od_router_lifetime_expired(server, now_us) ||
+	       od_router_pool_size_exceeded(server);
 }
 
 static inline int od_router_expire_server_tick_cb(od_server_t *server,
@@ -302,8 +318,9 @@ static inline int od_router_expire_cb(od_route_t *route, void **argv)
 
 	int pool_ttl_disabled = route->rule->pool->ttl == 0;
 	int server_lifetime_disabled = route->rule->server_lifetime_us == 0;
+	int pool_size_fixed = !route->rule->pool->size_adaptive;
 
-	if (pool_ttl_disabled && server_lifetime_disabled) {
+	if (pool_ttl_disabled && server_lifetime_disabled && pool_size_fixed) {
 		od_route_unlock(route);
 		return 0;
 	}
@@ -324,6 +341,36 @@ int od_router_expire(od_router_t *router, od_list_t *expire_list)
 	return count;
 }
 
+/*
+ * Element lock is held. Give released server to the oldest waiting
+ * client, the server stays active, or put it into idle list.
+ */
+static inline void od_router_release_server(od_multi_pool_element_t *element,
+					    od_server_t *server)
+{
+	if (od_multi_pool_element_wake(element, server) != NULL)
+		return;
+	od_server_set_pool_state(server, OD_SERVER_IDLE);
+}
+
+/* element lock is held, server is removed from the pool */
+static inline void od_router_drop_server(od_multi_pool_element_t *element,
+					 od_server_t *server)
+{
+	od_server_set_pool_state(server, OD_SERVER_UNDEF);
+	/* pool got capacity for a new connection */
+	od_multi_pool_element_wake(element, NULL);
+}
+
+/* free server connection, which was never put into the pool */
+static inline void od_router_free_unpooled_server(od_server_t *server)
+{
+	od_backend_close_connection(server);
+	server->route = NULL;
+	server->pool_element = NULL;
+	od_backend_close(server);
+}
+
 static inline od_server_t *
 od_router_create_connected_server(od_route_t *route,
 				  od_multi_pool_element_t *pool)
@@ -352,7 +399,7 @@ od_router_create_connected_server(od_route_t *route,
 	od_route_lock(route);
 
 	if (rc != OK_RESPONSE) {
-		od_backend_close(server);
+		od_router_free_unpooled_server(server);
 		return NULL;
 	}
 
@@ -375,7 +422,9 @@ static inline int od_router_create_idle_server(od_route_t *route,
 		return NOT_OK_RESPONSE;
 	}
 
+	od_multi_pool_element_lock(pool);
 	if (od_server_pool_total(&pool->pool) >= min_pool_size) {
+		od_multi_pool_element_unlock(pool);
 		/*
 		 * min pool size was reached in some other way
 		 * while we was connecting to server
@@ -383,14 +432,14 @@ static inline int od_router_create_idle_server(od_route_t *route,
 		 * so just release this connection and exit
 		 */
 
-		od_backend_close_connection(server);
-		od_backend_close(server);
+		od_router_free_unpooled_server(server);
 
 		return NOT_OK_RESPONSE;
 	}
 
 	/* the pool still need in that connection */
-	od_server_set_pool_state(server, OD_SERVER_IDLE);
+	od_router_release_server(pool, server);
+	od_multi_pool_element_unlock(pool);
 
 	od_logger_t *logger = &server->global->instance->logger;
 	od_log(logger, "idle-preallocate", NULL, server,
@@ -400,6 +449,69 @@ static inline int od_router_create_idle_server(od_route_t *route,
 	return OK_RESPONSE;
 }
 
+/*
+ * Open server connection of the route in advance: connect, perform
+ * startup and the warm-up query and put the server idle into the pool.
+ */
+int od_router_prewarm_server(od_router_t *router, od_route_t *route,
+			     od_multi_pool_element_t *element)
+{
+	od_instance_t *instance = router->global->instance;
+	od_rule_pool_t *rule_pool = route->rule->pool;
+
+	/* share server_max_routing with attaching clients */
+	od_atomic_u32_inc(&router->servers_routing);
+
+	od_route_lock(route);
+	od_server_t *server = od_router_create_connected_server(route, element);
+	od_route_unlock(route);
+	if (server == NULL) {
+		od_atomic_u32_dec(&router->servers_routing);
+		return NOT_OK_RESPONSE;
+	}
+
+	kiwi_params_t params;
+	kiwi_params_init(&params);
+	int rc = od_backend_startup(server, &params, NULL);
+	if (rc == 0 && rule_pool->prewarm_query) {
+		rc = od_backend_query(server, "prewarm",
+				      rule_pool->prewarm_query, NULL,
+				      strlen(rule_pool->prewarm_query) + 1,
+				      OD_PREWARM_QUERY_TIMEOUT_MS, 0);
+	}
+	od_atomic_u32_dec(&router->servers_routing);
+
+	if (rc != 0) {
+		kiwi_params_free(&params);
+		od_router_free_unpooled_server(server);
+		return NOT_OK_RESPONSE;
+	}
+
+	/* attach skips startup of this server, cache parameters for clients */
+	if (!kiwi_params_lock_set_once(&route->params, &params))
+		kiwi_params_free(&params);
+
+	/* idle servers are attached by the client machine */
+	od_io_detach(&server->io);
+
+	od_multi_pool_element_lock(element);
+	int pool_size = od_route_pool_size(route);
+	int total = od_server_pool_total(&element->pool);
+	if (pool_size > 0 && total >= pool_size) {
+		/* clients filled the pool meanwhile */
+		od_multi_pool_element_unlock(element);
+		od_router_free_unpooled_server(server);
+		return OK_RESPONSE;
+	}
+	od_router_release_server(element, server);
+	od_multi_pool_element_unlock(element);
+
+	od_debug(&instance->logger, "prewarm", NULL, server,
+		 "server connection warmed up for %s.%s", route->id.database,
+		 route->id.user);
+	return OK_RESPONSE;
+}
+
 /* returns number of allocated connections or -1 for errors */
 static inline int
 od_router_keep_min_size_for_pool(od_multi_pool_element_t *element,
@@ -407,11 +519,12 @@ od_router_keep_min_size_for_pool(od_multi_pool_element_t *element,
 {
 	int min_pool_size = route->rule->pool->min_size;
 
-	if (od_server_pool_total(&element->pool) >= min_pool_size) {
+	int total = od_multi_pool_element_total(element);
+	if (total >= min_pool_size) {
 		return 0;
 	}
 
-	int need = min_pool_size - od_server_pool_total(&element->pool);
+	int need = min_pool_size - total;
 	int created = 0;
 
 	if (max_created > need) {
@@ -468,8 +581,8 @@ static inline int od_router_keep_min_pool_size_for_route(od_route_t *route,
 	return total;
 }
 
-/* returns number of allocated connections or -1 for errors */
-int od_router_keep_min_pool_size_for_rule(od_router_t *router, od_rule_t *rule)
+/* router lock is held */
+od_route_t *od_router_route_for_rule(od_router_t *router, od_rule_t *rule)
 {
 	od_route_id_t id = {
 		.database = rule->db_name,
@@ -494,9 +607,19 @@ int od_router_keep_min_pool_size_for_rule(od_router_t *router, od_rule_t *rule)
 	route = od_route_pool_match(&router->route_pool, &id, rule);
 	if (route == NULL) {
 		route = od_route_pool_new(&router->route_pool, &id, rule);
-		if (route == NULL) {
-			return -1;
-		}
+		/* route holds rule until gc, as routes of clients do */
+		if (route)
+			od_rules_ref(rule);
+	}
+	return route;
+}
+
+/* returns number of allocated connections or -1 for errors */
+int od_router_keep_min_pool_size_for_rule(od_router_t *router, od_rule_t *rule)
+{
+	od_route_t *route = od_router_route_for_rule(router, rule);
+	if (route == NULL) {
+		return -1;
 	}
 
 	od_rules_ref(rule);
@@ -546,6 +669,79 @@ void od_router_keep_min_pool_size_step(od_router_t *router)
 	od_router_unlock(router);
 }
 
+static inline int od_router_pool_size_wake_cb(od_multi_pool_element_t *element,
+					      void **argv)
+{
+	od_route_t *route = argv[0];
+
+	/* let waiters recheck the grown capacity */
+	int spare = od_route_pool_size(route) -
+		    od_server_pool_total(&element->pool);
+	while (spare-- > 0) {
+		if (od_multi_pool_element_wake(element, NULL) == NULL)
+			break;
+	}
+	return 0;
+}
+
+static inline int od_router_pool_size_cb(od_route_t *route, void **argv)
+{
+	od_instance_t *instance = argv[0];
+	od_rule_pool_t *rule_pool = route->rule->pool;
+
+	if (!rule_pool->size_adaptive || route->rule->obsolete) {
+		return 0;
+	}
+
+	od_stat_t current;
+	od_stat_init(&current);
+	od_stat_copy(&current, &route->stats);
+
+	int elements = (int)od_multi_pool_size(route->server_pools);
+	od_pool_sample_t sample = {
+		.wait_count = od_atomic_u64_of(&route->wait_hist.count),
+		.wait_sum_us = od_atomic_u64_of(&route->wait_hist.sum_us),
+		.query_count = current.count_query,
+		.query_time_us = current.query_time,
+		.waiting = od_multi_pool_count_waiting(route->server_pools),
+		.idle = od_multi_pool_count_idle(route->server_pools) /
+			(elements ? elements : 1),
+	};
+
+	od_pool_controller_t *controller = &route->pool_controller;
+	int prev = od_pool_controller_target(controller);
+	od_pool_size_decision_t decision;
+	decision = od_pool_controller_step(controller, &sample,
+					   rule_pool->min_size,
+					   rule_pool->size);
+	if (decision == OD_POOL_SIZE_HOLD) {
+		return 0;
+	}
+
+	od_log(&instance->logger, "pool", NULL, NULL,
+	       "%s.%s pool size %d -> %d (%s), %d waiting, wait avg %" PRIu64
+	       " us, query %" PRIu64 " us, baseline %" PRIu64 " us",
+	       route->id.database, route->id.user, prev,
+	       od_pool_controller_target(controller),
+	       od_pool_size_decision_to_str(decision), sample.waiting,
+	       controller->wait_avg_us, controller->latency_us,
+	       controller->latency_base_us);
+
+	if (decision == OD_POOL_SIZE_GROW) {
+		void *wake_argv[] = { route };
+		od_multi_pool_foreach_element(route->server_pools,
+					      od_router_pool_size_wake_cb,
+					      wake_argv);
+	}
+	return 0;
+}
+
+void od_router_pool_size_step(od_router_t *router)
+{
+	void *argv[] = { router->global->instance };
+	od_router_foreach(router, od_router_pool_size_cb, argv);
+}
+
 static inline int od_router_gc_cb(od_route_t *route, void **argv)
 {
 	od_route_pool_t *pool = argv[0];
@@ -555,13 +751,15 @@ static inline int od_router_gc_cb(od_route_t *route, void **argv)
 	    od_client_pool_total(&route->client_pool) > 0)
 		goto done;
 
+	/* prewarm coroutine still holds the route */
+	if (od_atomic_u32_of(&route->prewarm.inflight) > 0)
+		goto done;
+
 	if (!od_route_is_dynamic(route) && !route->rule->obsolete)
 		goto done;
 
 	/* remove route from route pool */
-	assert(pool->count > 0);
-	pool->count--;
-	od_list_unlink(&route->link);
+	od_route_pool_unlink(pool, route);
 
 	od_route_unlock(route);
 
@@ -577,7 +775,9 @@ done:
 void od_router_gc(od_router_t *router)
 {
 	void *argv[] = { &router->route_pool };
-	od_router_foreach(router, od_router_gc_cb, argv);
+	od_router_lock(router);
+	od_route_pool_foreach(&router->route_pool, od_router_gc_cb, argv);
+	od_router_unlock(router);
 }
 
 void od_router_stat(od_router_t *router, uint64_t prev_time_us,
@@ -617,7 +817,17 @@ od_router_status_t od_router_route(od_router_t *router, od_client_t *client)
 	assert(startup->database.value_len);
 	assert(startup->user.value_len);
 
-	od_router_lock(router);
+	/*
+	 * fast path: rule and existing route lookup under shared lock,
+	 * fallback to exclusive lock if route must be created
+	 */
+	bool exclusive = false;
+retry:
+	if (exclusive) {
+		od_router_lock(router);
+	} else {
+		od_router_rdlock(router);
+	}
 
 	/* match latest version of route rule */
 	od_rule_t *rule =
@@ -682,6 +892,12 @@ od_router_status_t od_router_route(od_router_t *router, od_client_t *client)
 		}
 	}
 #ifdef LDAP_FOUND
+	if (rule->ldap_storage_credentials_attr && !exclusive) {
+		/* ldap credentials are stored into the rule */
+		od_router_unlock(router);
+		exclusive = true;
+		goto retry;
+	}
 	if (rule->ldap_storage_credentials_attr) {
 		od_ldap_server_t *ldap_server = NULL;
 		ldap_server =
@@ -755,6 +971,11 @@ od_router_status_t od_router_route(od_router_t *router, od_client_t *client)
 	od_route_t *route;
 	route = od_route_pool_match(&router->route_pool, &id, rule);
 	if (route == NULL) {
+		if (!exclusive) {
+			od_router_unlock(router);
+			exclusive = true;
+			goto retry;
+		}
 		route = od_route_pool_new(&router->route_pool, &id, rule);
 		/*od_debug() */
 		if (route == NULL) {
@@ -834,7 +1055,19 @@ bool od_should_not_spun_connection_yet(int connections_in_pool, int pool_size,
 	return currently_routing >= max_routing;
 }
 
-#define MAX_BUZYLOOP_RETRY 10
+/* recheck period while concurrent server connects are in progress */
+#define OD_ROUTER_ROUTING_RECHECK_MS 1
+
+static inline void od_router_wait_done(od_route_t *route,
+				       od_client_t *client, uint64_t start_us)
+{
+	if (start_us) {
+		uint64_t wait_us = machine_time_us() - start_us;
+		od_hist_observe(&route->wait_hist, wait_us);
+		od_hist_observe(&route->class_wait_hist[client->priority_class],
+				wait_us);
+	}
+}
 
 od_router_status_t od_router_attach(od_router_t *router, od_client_t *client,
 				    bool wait_for_idle,
@@ -844,8 +1077,10 @@ od_router_status_t od_router_attach(od_router_t *router, od_client_t *client,
 	od_route_t *route = client->route;
 	assert(route != NULL);
 
-	od_route_lock(route);
-
+	/*
+	 * only the endpoint pool is locked here, client state changes
+	 * do not need the route lock
+	 */
 	od_multi_pool_element_t *pool_element =
 		od_multi_pool_get_or_create(route->server_pools, address);
 	if (pool_element == NULL) {
@@ -854,87 +1089,125 @@ od_router_status_t od_router_attach(od_router_t *router, od_client_t *client,
 
 	od_server_pool_t *pool = &pool_element->pool;
 
-	/* enqueue client (pending -> queue) */
-	od_client_pool_set(&route->client_pool, client, OD_CLIENT_QUEUE);
+	od_multi_pool_element_lock(pool_element);
 
 	/* get client server from route server pool */
 	bool restart_read = false;
+	bool read_stopped = false;
+	uint64_t wait_start_us = 0;
+	uint32_t timeout = route->rule->pool->timeout;
 	od_server_t *server;
-	int busyloop_sleep = 0;
-	int busyloop_retry = 0;
 	for (;;) {
-		server = od_pg_server_pool_next(pool, OD_SERVER_IDLE);
+		server = od_pg_server_pool_next_vars(pool, &client->vars);
 		if (server)
 			goto attach;
 
+		uint32_t wait_ms = UINT32_MAX;
 		if (wait_for_idle) {
 			/* special case, when we are interested only in an idle connection
 			 * and do not want to start a new one */
 			if (pool->count_active == 0) {
-				od_route_unlock(route);
+				od_multi_pool_element_unlock(pool_element);
+				od_router_wait_done(route, client,
+						    wait_start_us);
 				return OD_ROUTER_ERROR_TIMEDOUT;
 			}
 		} else {
 			/* Maybe start new connection, if pool_size is zero */
 			/* Maybe start new connection, if we still have capacity for it */
 			int connections_in_pool = od_server_pool_total(pool);
-			int pool_size = route->rule->pool->size;
+			int pool_size = od_route_pool_size(route);
 			uint32_t currently_routing =
 				od_atomic_u32_of(&router->servers_routing);
 			uint32_t max_routing = (uint32_t)route->rule->storage
 						       ->server_max_routing;
 			if (pool_size == 0 || connections_in_pool < pool_size) {
-				if (od_should_not_spun_connection_yet(
+				if (!od_should_not_spun_connection_yet(
 					    connections_in_pool, pool_size,
 					    (int)currently_routing,
 					    (int)max_routing)) {
-					/* concurrent server connection in progress. */
-					od_route_unlock(route);
-					machine_sleep(busyloop_sleep);
-					busyloop_retry++;
-					/* TODO: support this opt in configure file */
-					if (busyloop_retry > MAX_BUZYLOOP_RETRY)
-						busyloop_sleep = 1;
-					od_route_lock(route);
-					continue;
-				} else {
 					/* We are allowed to spun new server connection */
 					break;
 				}
+				/*
+				 * concurrent server connection in progress,
+				 * wait for a release or recheck shortly
+				 */
+				wait_ms = OD_ROUTER_ROUTING_RECHECK_MS;
 			}
 		}
 
+		/* enqueue client (pending -> queue) */
+		if (wait_start_us == 0) {
+			wait_start_us = machine_time_us();
+			od_client_pool_set(&route->client_pool, client,
+					   OD_CLIENT_QUEUE);
+		}
+
 		/*
 		 * unsubscribe from pending client read events during the time we wait
-		 * for an available server
+		 * for an available server, then recheck the pool
 		 */
-		restart_read =
-			restart_read || (bool)od_io_read_active(&client->io);
-		od_route_unlock(route);
+		if (!read_stopped) {
+			restart_read = (bool)od_io_read_active(&client->io);
+			od_multi_pool_element_unlock(pool_element);
+			int rc = od_io_read_stop(&client->io);
+			if (rc == -1) {
+				return OD_ROUTER_ERROR;
+			}
+			read_stopped = true;
+			od_multi_pool_element_lock(pool_element);
+			continue;
+		}
 
-		int rc = od_io_read_stop(&client->io);
-		if (rc == -1) {
-			return OD_ROUTER_ERROR;
+		/* wait no longer than pool_timeout milliseconds in total */
+		if (timeout) {
+			uint64_t waited_ms =
+				(machine_time_us() - wait_start_us) / 1000;
+			if (waited_ms >= timeout) {
+				od_multi_pool_element_unlock(pool_element);
+				od_router_wait_done(route, client,
+						    wait_start_us);
+				return OD_ROUTER_ERROR_TIMEDOUT;
+			}
+			if (timeout - waited_ms < wait_ms) {
+				wait_ms = timeout - waited_ms;
+			}
 		}
 
 		/*
-		 * Wait wakeup condition for pool_timeout milliseconds.
-		 *
-		 * The condition triggered when a server connection
-		 * put into idle state by DETACH events.
+		 * Wait in the endpoint queue of the client priority class.
+		 * Detach hands released server to a waiter directly.
 		 */
-		uint32_t timeout = route->rule->pool->timeout;
-		if (timeout == 0)
-			timeout = UINT32_MAX;
-		rc = od_route_wait(route, timeout);
-		if (rc == -1) {
-			return OD_ROUTER_ERROR_TIMEDOUT;
+		od_multi_pool_waiter_t waiter;
+		waiter.start_us = wait_start_us;
+		waiter.priority_class = client->priority_class;
+		waiter.weight = 1;
+		od_rule_t *rule = route->rule;
+		if (waiter.priority_class < rule->priority_classes_count)
+			waiter.weight =
+				rule->priority_classes[waiter.priority_class]
+					.weight;
+		waiter.flag = machine_wait_flag_create();
+		if (waiter.flag == NULL) {
+			od_multi_pool_element_unlock(pool_element);
+			return OD_ROUTER_ERROR;
 		}
+		od_multi_pool_element_wait(pool_element, &waiter);
+		od_multi_pool_element_unlock(pool_element);
+
+		machine_wait_flag_wait(waiter.flag, wait_ms);
 
-		od_route_lock(route);
+		od_multi_pool_element_lock(pool_element);
+		od_multi_pool_element_wait_cancel(pool_element, &waiter);
+		machine_wait_flag_destroy(waiter.flag);
+
+		server = waiter.server;
+		if (server)
+			goto attach;
 	}
 
-	od_route_unlock(route);
+	od_multi_pool_element_unlock(pool_element);
 
 	/* create new server object */
 	server = od_server_allocate(
@@ -950,7 +1223,7 @@ od_router_status_t od_router_attach(od_router_t *router, od_client_t *client,
 	server->route = route;
 	server->pool_element = pool_element;
 
-	od_route_lock(route);
+	od_multi_pool_element_lock(pool_element);
 
 attach:
 	od_server_set_pool_state(server, OD_SERVER_ACTIVE);
@@ -975,7 +1248,9 @@ attach:
 
 	*/
 
-	od_route_unlock(route);
+	od_multi_pool_element_unlock(pool_element);
+
+	od_router_wait_done(route, client, wait_start_us);
 
 	/* attach server io to clients machine context */
 	if (server->io.io) {
@@ -989,6 +1264,35 @@ attach:
 	return OD_ROUTER_OK;
 }
 
+/* element lock is held, server is clean and has no client */
+static inline void
+od_router_return_server(od_route_t *route,
+			od_multi_pool_element_t *pool_element,
+			od_server_t *server)
+{
+	if (od_likely(!server->offline)) {
+		od_instance_t *instance = server->global->instance;
+		if (route->id.physical_rep || route->id.logical_rep) {
+			od_debug(&instance->logger, "expire-replication", NULL,
+				 server, "closing replication connection");
+			server->route = NULL;
+			od_backend_close_connection(server);
+			od_router_drop_server(pool_element, server);
+			od_backend_close(server);
+		} else {
+			od_router_release_server(pool_element, server);
+		}
+	} else {
+		od_instance_t *instance = server->global->instance;
+		od_debug(&instance->logger, "expire", NULL, server,
+			 "closing obsolete server connection");
+		server->route = NULL;
+		od_backend_close_connection(server);
+		od_router_drop_server(pool_element, server);
+		od_backend_close(server);
+	}
+}
+
 void od_router_detach(od_router_t *router, od_client_t *client)
 {
 	(void)router;
@@ -1000,9 +1304,12 @@ void od_router_detach(od_router_t *router, od_client_t *client)
 
 	assert(server != NULL);
 	assert(od_server_synchronized(server));
+	/* idle server does not need a read buffer */
+	od_relay_release(&server->relay);
 	od_io_detach(&server->io);
 
-	od_route_lock(route);
+	od_multi_pool_element_t *pool_element = server->pool_element;
+	od_multi_pool_element_lock(pool_element);
 
 	client->server = NULL;
 	server->client = NULL;
@@ -1010,36 +1317,74 @@ void od_router_detach(od_router_t *router, od_client_t *client)
 	machine_cond_propagate(server->io.on_read, NULL);
 	machine_cond_propagate(server->io.on_write, NULL);
 
-	if (od_likely(!server->offline)) {
-		od_instance_t *instance = server->global->instance;
-		if (route->id.physical_rep || route->id.logical_rep) {
-			od_debug(&instance->logger, "expire-replication", NULL,
-				 server, "closing replication connection");
-			server->route = NULL;
-			od_backend_close_connection(server);
-			od_server_set_pool_state(server, OD_SERVER_UNDEF);
-			od_backend_close(server);
-		} else {
-			od_server_set_pool_state(server, OD_SERVER_IDLE);
-		}
-	} else {
-		od_instance_t *instance = server->global->instance;
-		od_debug(&instance->logger, "expire", NULL, server,
-			 "closing obsolete server connection");
-		server->route = NULL;
-		od_backend_close_connection(server);
-		od_server_set_pool_state(server, OD_SERVER_UNDEF);
-		od_backend_close(server);
-	}
-	od_client_pool_set(&route->client_pool, client, OD_CLIENT_PENDING);
+	od_router_return_server(route, pool_element, server);
 
-	int signal = route->client_pool.count_queue > 0;
-	od_route_unlock(route);
+	od_multi_pool_element_unlock(pool_element);
 
-	/* notify waiters */
-	if (signal) {
-		od_route_signal(route);
+	od_client_pool_set(&route->client_pool, client, OD_CLIENT_PENDING);
+}
+
+static void od_router_reset_server(void *arg)
+{
+	od_server_t *server = arg;
+	od_route_t *route = server->route;
+	od_instance_t *instance = server->global->instance;
+	od_multi_pool_element_t *pool_element = server->pool_element;
+
+	int rc = od_reset(server);
+	if (rc == 1) {
+		od_relay_release(&server->relay);
+		od_io_detach(&server->io);
+
+		od_multi_pool_element_lock(pool_element);
+		od_router_return_server(route, pool_element, server);
+		od_multi_pool_element_unlock(pool_element);
+		return;
 	}
+
+	od_log(&instance->logger, "reset", NULL, server,
+	       "reset unsuccessful, closing server connection");
+	od_backend_close_connection(server);
+
+	od_multi_pool_element_lock(pool_element);
+	od_router_drop_server(pool_element, server);
+	server->route = NULL;
+	od_multi_pool_element_unlock(pool_element);
+
+	od_server_free(server);
+}
+
+/*
+ * Unlink server from the client and reset it in a separate coroutine of
+ * the worker, so client does not wait for it. Server stays active in the
+ * pool until the reset is done.
+ */
+void od_router_detach_reset(od_router_t *router, od_client_t *client)
+{
+	(void)router;
+	od_route_t *route = client->route;
+	assert(route != NULL);
+
+	od_server_t *server = client->server;
+	assert(server != NULL);
+
+	od_multi_pool_element_t *pool_element = server->pool_element;
+	od_multi_pool_element_lock(pool_element);
+
+	client->server = NULL;
+	server->client = NULL;
+
+	machine_cond_propagate(server->io.on_read, NULL);
+	machine_cond_propagate(server->io.on_write, NULL);
+
+	od_multi_pool_element_unlock(pool_element);
+
+	od_client_pool_set(&route->client_pool, client, OD_CLIENT_PENDING);
+
+	int64_t coroutine_id;
+	coroutine_id = machine_coroutine_create(od_router_reset_server, server);
+	if (coroutine_id == -1)
+		od_router_reset_server(server);
 }
 
 void od_router_close(od_router_t *router, od_client_t *client)
@@ -1052,15 +1397,17 @@ void od_router_close(od_router_t *router, od_client_t *client)
 
 	od_backend_close_connection(server);
 
-	od_route_lock(route);
+	od_multi_pool_element_t *pool_element = server->pool_element;
+	od_multi_pool_element_lock(pool_element);
 
-	od_client_pool_set(&route->client_pool, client, OD_CLIENT_PENDING);
-	od_server_set_pool_state(server, OD_SERVER_UNDEF);
+	od_router_drop_server(pool_element, server);
 	client->server = NULL;
 	server->client = NULL;
 	server->route = NULL;
 
-	od_route_unlock(route);
+	od_multi_pool_element_unlock(pool_element);
+
+	od_client_pool_set(&route->client_pool, client, OD_CLIENT_PENDING);
 
 	assert(server->io.io == NULL);
 	od_server_free(server);
@@ -1069,8 +1416,19 @@ void od_router_close(od_router_t *router, od_client_t *client)
 static inline int od_router_cancel_cmp(od_server_t *server, void **argv)
 {
 	/* check that server is attached and has corresponding cancellation key */
-	return (server->client != NULL) &&
-	       kiwi_key_cmp(&server->key_client, argv[0]);
+	if (server->client == NULL ||
+	    !kiwi_key_cmp(&server->key_client, argv[0]))
+		return 0;
+
+	/*
+	 * copy while element lock is held, server may be closed and freed
+	 * right after it is released
+	 */
+	od_router_cancel_t *cancel = argv[1];
+	cancel->id = server->id;
+	cancel->key = server->key;
+	cancel->address = od_server_pool_address(server);
+	return 1;
 }
 
 static inline int od_router_cancel_cb(od_route_t *route, void **argv)
@@ -1082,10 +1440,7 @@ static inline int od_router_cancel_cb(od_route_t *route, void **argv)
 				       od_router_cancel_cmp, argv);
 	if (server) {
 		od_router_cancel_t *cancel = argv[1];
-		cancel->id = server->id;
-		cancel->key = server->key;
 		cancel->storage = od_rules_storage_copy(route->rule->storage);
-		cancel->address = od_server_pool_address(server);
 		od_route_unlock(route);
 		if (cancel->storage == NULL)
 			return -1;
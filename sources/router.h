@@ -7,7 +7,11 @@
  */
 
 struct od_router {
-	pthread_mutex_t lock;
+	/*
+	 * route lookup for existing routes is done under shared lock,
+	 * rules modification and routes creation/removal requires exclusive one
+	 */
+	pthread_rwlock_t lock;
 
 	od_rules_t rules;
 	od_route_pool_t route_pool;
@@ -16,6 +20,8 @@ struct od_router {
 	od_atomic_u32_t clients_routing;
 	/* servers */
 	od_atomic_u32_t servers_routing;
+	/* pool pre-warm passes */
+	od_prewarm_t prewarm;
 	/* error logging */
 	od_error_logger_t *router_err_logger;
 
@@ -26,8 +32,9 @@ struct od_router {
 	od_list_t servers;
 };
 
-#define od_router_lock(router) pthread_mutex_lock(&router->lock);
-#define od_router_unlock(router) pthread_mutex_unlock(&router->lock);
+#define od_router_lock(router) pthread_rwlock_wrlock(&router->lock);
+#define od_router_rdlock(router) pthread_rwlock_rdlock(&router->lock);
+#define od_router_unlock(router) pthread_rwlock_unlock(&router->lock);
 
 void od_router_init(od_router_t *, od_global_t *);
 void od_router_free(od_router_t *);
@@ -35,6 +42,12 @@ void od_router_free(od_router_t *);
 int od_router_reconfigure(od_router_t *, od_rules_t *);
 int od_router_expire(od_router_t *, od_list_t *);
 void od_router_keep_min_pool_size_step(od_router_t *);
+/* match or create route of the rule, router lock is held */
+od_route_t *od_router_route_for_rule(od_router_t *, od_rule_t *);
+int od_router_prewarm_server(od_router_t *, od_route_t *,
+			     od_multi_pool_element_t *);
+/* adjust adaptive pool sizes, once a second */
+void od_router_pool_size_step(od_router_t *);
 void od_router_gc(od_router_t *);
 void od_router_stat(od_router_t *, uint64_t,
 #ifdef PROM_FOUND
@@ -51,6 +64,7 @@ void od_router_unroute(od_router_t *, od_client_t *);
 od_router_status_t od_router_attach(od_router_t *, od_client_t *, bool,
 				    const od_address_t *);
 void od_router_detach(od_router_t *, od_client_t *);
+void od_router_detach_reset(od_router_t *, od_client_t *);
 void od_router_close(od_router_t *, od_client_t *);
 
 od_router_status_t od_router_cancel(od_router_t *, kiwi_key_t *,
@@ -17,6 +17,7 @@ void od_rules_init(od_rules_t *rules)
 	od_list_init(&rules->ldap_endpoints);
 #endif
 	od_list_init(&rules->rules);
+	od_rules_index_init(&rules->index);
 
 	rules->destroy_flag = machine_wait_flag_create();
 	if (rules->destroy_flag == NULL) {
@@ -32,6 +33,7 @@ void od_rules_free(od_rules_t *rules)
 	machine_wait_flag_set(rules->destroy_flag);
 
 	pthread_mutex_destroy(&rules->mu);
+	od_rules_index_free(&rules->index);
 	od_list_t *i, *n;
 	od_list_foreach_safe(&rules->rules, i, n)
 	{
@@ -472,6 +474,9 @@ od_rule_t *od_rules_add(od_rules_t *rules)
 
 	rule->auth_common_name_default = 0;
 	rule->auth_common_names_count = 0;
+	rule->auth_query_cache_ttl = 10000;
+	rule->auth_query_cache_negative_ttl = 0;
+	rule->auth_query_cache_refresh = 0;
 	rule->server_lifetime_us = 3600 * 1000000L;
 	rule->reserve_session_server_connection = 1;
 #ifdef PAM_FOUND
@@ -494,6 +499,14 @@ od_rule_t *od_rules_add(od_rules_t *rules)
 	od_list_append(&rules->rules, &rule->link);
 
 	rule->quantiles = NULL;
+
+	rule->priority_classes_count = 1;
+	rule->priority_classes[0].name = strdup("default");
+	rule->priority_classes[0].weight = 1;
+	if (rule->priority_classes[0].name == NULL) {
+		od_rules_rule_free(rule);
+		return NULL;
+	}
 	return rule;
 }
 
@@ -565,6 +578,13 @@ void od_rules_rule_free(od_rule_t *rule)
 	if (rule->quantiles) {
 		od_free(rule->quantiles);
 	}
+	for (int k = 0; k < rule->priority_classes_count; k++) {
+		od_rule_priority_class_t *class = &rule->priority_classes[k];
+		if (class->name)
+			od_free(class->name);
+		if (class->application_name)
+			od_free(class->application_name);
+	}
 
 	if (rule->group_checker_machine_id != -1) {
 		machine_join(rule->group_checker_machine_id);
@@ -576,16 +596,17 @@ void od_rules_rule_free(od_rule_t *rule)
 
 void od_rules_ref(od_rule_t *rule)
 {
-	rule->refs++;
+	/* routing may ref rule concurrently under shared router lock */
+	od_atomic_u32_inc(&rule->refs);
 }
 
 void od_rules_unref(od_rule_t *rule)
 {
-	assert(rule->refs > 0);
-	rule->refs--;
+	uint32_t refs = od_atomic_u32_sub(&rule->refs, 1);
+	assert(refs != UINT32_MAX);
 	if (!rule->obsolete)
 		return;
-	if (rule->refs == 0)
+	if (refs == 0)
 		od_rules_rule_free(rule);
 }
 
@@ -725,6 +746,11 @@ od_rule_t *od_rules_forward(od_rules_t *rules, char *db_name, char *user_name,
 			    struct sockaddr_storage *user_addr,
 			    int pool_internal, int sequential)
 {
+	if (rules->index.valid) {
+		return od_rules_index_forward(&rules->index, db_name, user_name,
+					      user_addr, pool_internal,
+					      sequential);
+	}
 	if (sequential) {
 		return od_rules_forward_sequential(rules, db_name, user_name,
 						   user_addr, pool_internal);
@@ -814,6 +840,10 @@ static inline int od_rules_storage_compare(od_rule_storage_t *a,
 	if (a->port != b->port)
 		return 0;
 
+	/* endpoints_balancing */
+	if (a->endpoints_balancing != b->endpoints_balancing)
+		return 0;
+
 	/* tls_opts->tls_mode */
 	if (a->tls_opts->tls_mode != b->tls_opts->tls_mode)
 		return 0;
@@ -854,6 +884,10 @@ static inline int od_rules_storage_compare(od_rule_storage_t *a,
 		return 0;
 	}
 
+	/* tls_opts->tls_ktls */
+	if (a->tls_opts->tls_ktls != b->tls_opts->tls_ktls)
+		return 0;
+
 	return 1;
 }
 
@@ -889,6 +923,24 @@ int od_rules_rule_compare(od_rule_t *a, od_rule_t *b)
 		return 0;
 	}
 
+	/* priority classes */
+	if (a->priority_classes_count != b->priority_classes_count)
+		return 0;
+	for (int k = 0; k < a->priority_classes_count; k++) {
+		od_rule_priority_class_t *ac = &a->priority_classes[k];
+		od_rule_priority_class_t *bc = &b->priority_classes[k];
+		if (strcmp(ac->name, bc->name) != 0 ||
+		    ac->weight != bc->weight || ac->port != bc->port)
+			return 0;
+		if (ac->application_name && bc->application_name) {
+			if (strcmp(ac->application_name,
+				   bc->application_name) != 0)
+				return 0;
+		} else if (ac->application_name || bc->application_name) {
+			return 0;
+		}
+	}
+
 	/* auth */
 	if (a->auth_mode != b->auth_mode)
 		return 0;
@@ -917,6 +969,15 @@ int od_rules_rule_compare(od_rule_t *a, od_rule_t *b)
 		return 0;
 	}
 
+	/* auth query cache */
+	if (a->auth_query_cache_ttl != b->auth_query_cache_ttl)
+		return 0;
+	if (a->auth_query_cache_negative_ttl !=
+	    b->auth_query_cache_negative_ttl)
+		return 0;
+	if (a->auth_query_cache_refresh != b->auth_query_cache_refresh)
+		return 0;
+
 	/* auth common name default */
 	if (a->auth_common_name_default != b->auth_common_name_default)
 		return 0;
@@ -1041,7 +1102,8 @@ __attribute__((hot)) int od_rules_merge(od_rules_t *rules, od_rules_t *src,
 		rule = od_container_of(i, od_rule_t, link);
 		rule->mark = 1;
 		count_mark++;
-		od_hashmap_empty(rule->storage->acache);
+		od_auth_cache_invalidate(rule->storage->acache);
+		od_scram_cache_invalidate(rule->storage->scram_cache);
 	}
 
 	/* select dropped rules */
@@ -1194,7 +1256,7 @@ __attribute__((hot)) int od_rules_merge(od_rules_t *rules, od_rules_t *src,
 			if (is_obsolete) {
 				if (rule->group) {
 					rule->group->online = 0;
-				} else if (rule->refs == 0) {
+				} else if (od_atomic_u32_of(&rule->refs) == 0) {
 					od_rules_rule_free(rule);
 					count_deleted++;
 					count_mark--;
@@ -1223,6 +1285,9 @@ __attribute__((hot)) int od_rules_merge(od_rules_t *rules, od_rules_t *src,
 	}
 	od_free(sorted);
 
+	/* rebuild routing index, linear scan is used if it fails */
+	od_rules_index_build(&rules->index, &rules->rules);
+
 	return count_new + count_mark + count_deleted;
 }
 
@@ -1275,6 +1340,22 @@ int od_pool_validate(od_logger_t *logger, od_rule_pool_t *pool, char *db_name,
 		return NOT_OK_RESPONSE;
 	}
 
+	if (pool->size_adaptive && pool->size == 0) {
+		od_error(
+			logger, "rules", NULL, NULL,
+			"rule '%s.%s %s': adaptive pool size requires pool_size as upper bound",
+			db_name, user_name, address_range->string_value);
+		return NOT_OK_RESPONSE;
+	}
+
+	if (pool->prewarm < 0 || (pool->size && pool->prewarm > pool->size)) {
+		od_error(
+			logger, "rules", NULL, NULL,
+			"rule '%s.%s %s': pool_prewarm must be between 0 and pool_size",
+			db_name, user_name, address_range->string_value);
+		return NOT_OK_RESPONSE;
+	}
+
 	/* reserve prepare statement feature */
 	if (pool->reserve_prepared_statement &&
 	    pool->pool_type == OD_RULE_POOL_SESSION) {
@@ -1732,12 +1813,15 @@ int od_rules_validate(od_rules_t *rules, od_config_t *config,
 		}
 
 #ifdef LDAP_FOUND
+		/* ldap auth runs in the client coroutine */
+		int stack_size = config->client_coroutine_stack_size;
+		if (stack_size == 0)
+			stack_size = config->coroutine_stack_size;
 		if (rule->ldap_endpoint != NULL &&
-		    config->coroutine_stack_size <
-			    LDAP_MIN_COROUTINE_STACK_SIZE) {
+		    stack_size < LDAP_MIN_COROUTINE_STACK_SIZE) {
 			od_error(
 				logger, "rules", NULL, NULL,
-				"rule '%s.%s %s' use ldap_endpoint. coroutine_stack_size must be >= %d",
+				"rule '%s.%s %s' use ldap_endpoint. client coroutine stack size must be >= %d",
 				rule->db_name, rule->user_name,
 				rule->address_range.string_value,
 				LDAP_MIN_COROUTINE_STACK_SIZE);
@@ -1804,6 +1888,10 @@ void od_rules_print(od_rules_t *rules, od_logger_t *logger)
 		od_log(logger, "storage", NULL, NULL, "  port          %d",
 		       storage->port);
 
+		od_log(logger, "storage", NULL, NULL, "  balancing     %s",
+		       od_storage_balancing_to_str(
+			       storage->endpoints_balancing));
+
 		if (storage->tls_opts->tls)
 			od_log(logger, "storage", NULL, NULL,
 			       "  tls             %s", storage->tls_opts->tls);
@@ -1823,6 +1911,9 @@ void od_rules_print(od_rules_t *rules, od_logger_t *logger)
 			od_log(logger, "storage", NULL, NULL,
 			       "  tls_protocols   %s",
 			       storage->tls_opts->tls_protocols);
+		if (storage->tls_opts->tls_ktls)
+			od_log(logger, "storage", NULL, NULL,
+			       "  tls_ktls        yes");
 		if (storage->watchdog) {
 			if (storage->watchdog->query)
 				od_log(logger, "storage", NULL, NULL,
@@ -1869,6 +1960,17 @@ void od_rules_print(od_rules_t *rules, od_logger_t *logger)
 			od_log(logger, "rules", NULL, NULL,
 			       "  auth_query_user                   %s",
 			       rule->auth_query_user);
+		if (rule->auth_query) {
+			od_log(logger, "rules", NULL, NULL,
+			       "  auth_query_cache_ttl              %d",
+			       rule->auth_query_cache_ttl);
+			od_log(logger, "rules", NULL, NULL,
+			       "  auth_query_cache_negative_ttl     %d",
+			       rule->auth_query_cache_negative_ttl);
+			od_log(logger, "rules", NULL, NULL,
+			       "  auth_query_cache_refresh          %d",
+			       rule->auth_query_cache_refresh);
+		}
 
 		/* pool  */
 		od_log(logger, "rules", NULL, NULL,
@@ -1882,6 +1984,19 @@ void od_rules_print(od_rules_t *rules, od_logger_t *logger)
 		od_log(logger, "rules", NULL, NULL,
 		       "  pool size                         %d",
 		       rule->pool->size);
+		od_log(logger, "rules", NULL, NULL,
+		       "  pool size adaptive                %s",
+		       rule->pool->size_adaptive ? "yes" : "no");
+		if (rule->pool->prewarm) {
+			od_log(logger, "rules", NULL, NULL,
+			       "  pool prewarm                      %d",
+			       rule->pool->prewarm);
+		}
+		if (rule->pool->prewarm_query) {
+			od_log(logger, "rules", NULL, NULL,
+			       "  pool prewarm query                %s",
+			       rule->pool->prewarm_query);
+		}
 		od_log(logger, "rules", NULL, NULL,
 		       "  pool timeout                      %d",
 		       rule->pool->timeout);
@@ -1917,6 +2032,18 @@ void od_rules_print(od_rules_t *rules, od_logger_t *logger)
 			od_log(logger, "rules", NULL, NULL,
 			       "  client_max                        %d",
 			       rule->client_max);
+		for (int k = 0; k < rule->priority_classes_count; k++) {
+			od_rule_priority_class_t *class;
+			class = &rule->priority_classes[k];
+			od_log(logger, "rules", NULL, NULL,
+			       "  priority_class %s weight %d "
+			       "application_name %s port %d",
+			       class->name, class->weight,
+			       class->application_name ?
+				       class->application_name :
+				       "(any)",
+			       class->port);
+		}
 		od_log(logger, "rules", NULL, NULL,
 		       "  client_fwd_error                  %s",
 		       od_rules_yes_no(rule->client_fwd_error));
@@ -2039,3 +2166,47 @@ bool od_name_in_rule(od_rule_t *rule, char *name)
 		return strcmp(rule->user_name, name) == 0;
 	}
 }
+
+od_rule_priority_class_t *od_rules_priority_class_add(od_rule_t *rule,
+						      char *name)
+{
+	for (int k = 0; k < rule->priority_classes_count; k++) {
+		if (strcmp(rule->priority_classes[k].name, name) == 0)
+			return &rule->priority_classes[k];
+	}
+	if (rule->priority_classes_count == OD_RULE_PRIORITY_CLASS_MAX)
+		return NULL;
+	od_rule_priority_class_t *class;
+	class = &rule->priority_classes[rule->priority_classes_count];
+	memset(class, 0, sizeof(*class));
+	class->name = strdup(name);
+	if (class->name == NULL)
+		return NULL;
+	class->weight = 1;
+	rule->priority_classes_count++;
+	return class;
+}
+
+/* first matching class in config order, default one otherwise */
+int od_rules_priority_class_match(od_rule_t *rule, char *application_name,
+				  int port)
+{
+	for (int k = 1; k < rule->priority_classes_count; k++) {
+		od_rule_priority_class_t *class = &rule->priority_classes[k];
+		if (class->port && class->port != port)
+			continue;
+		char *pattern = class->application_name;
+		if (pattern == NULL)
+			return k;
+		if (application_name == NULL)
+			continue;
+		size_t len = strlen(pattern);
+		if (len && pattern[len - 1] == '*') {
+			if (strncmp(application_name, pattern, len - 1) == 0)
+				return k;
+		} else if (strcmp(application_name, pattern) == 0) {
+			return k;
+		}
+	}
+	return 0;
+}
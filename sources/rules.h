@@ -7,7 +7,6 @@
  */
 
 typedef struct od_rule_auth od_rule_auth_t;
-typedef struct od_rule od_rule_t;
 typedef struct od_rules od_rules_t;
 
 typedef enum {
@@ -38,6 +37,26 @@ typedef enum {
 	OD_RULE_ROLE_UNDEF,
 } od_rule_role_type_t;
 
+/*
+ * Client priority classes of a rule. Class 0 is the default one, clients
+ * matching no other class belong to it. Waiting clients of the classes
+ * are served in proportion to class weights.
+ */
+#define OD_RULE_PRIORITY_CLASS_NAMED_MAX 8
+/* named classes and the default one */
+#define OD_RULE_PRIORITY_CLASS_MAX (OD_RULE_PRIORITY_CLASS_NAMED_MAX + 1)
+
+typedef struct od_rule_priority_class od_rule_priority_class_t;
+
+struct od_rule_priority_class {
+	char *name;
+	int weight;
+	/* exact match, or prefix match if ends with '*' */
+	char *application_name;
+	/* listen port, 0 matches any */
+	int port;
+};
+
 typedef struct od_rule_key od_rule_key_t;
 
 struct od_rule_key {
@@ -64,7 +83,7 @@ struct od_rule {
 	/* versioning */
 	int mark;
 	int obsolete;
-	int refs;
+	od_atomic_u32_t refs;
 	int order;
 
 	/* id */
@@ -83,6 +102,10 @@ struct od_rule {
 	char *auth_query;
 	char *auth_query_db;
 	char *auth_query_user;
+	/* auth_query cache ttls, in milliseconds */
+	int auth_query_cache_ttl;
+	int auth_query_cache_negative_ttl;
+	int auth_query_cache_refresh;
 	int auth_common_name_default;
 	od_list_t auth_common_names;
 	int auth_common_names_count;
@@ -151,6 +174,8 @@ struct od_rule {
 	double *quantiles;
 	int quantiles_count;
 	uint64_t server_lifetime_us;
+	od_rule_priority_class_t priority_classes[OD_RULE_PRIORITY_CLASS_MAX];
+	int priority_classes_count;
 
 	od_target_session_attrs_t target_session_attrs;
 
@@ -171,6 +196,7 @@ struct od_rules {
 	od_list_t ldap_endpoints;
 #endif
 	od_list_t rules;
+	od_rules_index_t index;
 
 	machine_wait_flag_t *destroy_flag;
 };
@@ -233,3 +259,9 @@ od_retcode_t od_rules_groups_checkers_run(od_logger_t *logger,
 					  od_rules_t *rules);
 
 bool od_name_in_rule(od_rule_t *rule, char *name);
+
+/* priority classes */
+od_rule_priority_class_t *od_rules_priority_class_add(od_rule_t *rule,
+						      char *name);
+int od_rules_priority_class_match(od_rule_t *rule, char *application_name,
+				  int port);
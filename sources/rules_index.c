@@ -0,0 +1,390 @@
+/*
+ * Odyssey.
+ *
+ * Scalable PostgreSQL connection pooler.
+ */
+
+#include <kiwi.h>
+#include <machinarium.h>
+#include <odyssey.h>
+
+static inline void od_rules_index_entry_init(od_rules_index_entry_t *entry)
+{
+	memset(entry, 0, sizeof(*entry));
+}
+
+static inline void od_rules_index_entry_free(od_rules_index_entry_t *entry)
+{
+	if (entry->rules)
+		od_free(entry->rules);
+	entry->rules = NULL;
+	entry->count = 0;
+	entry->size = 0;
+}
+
+static inline int od_rules_index_entry_add(od_rules_index_entry_t *entry,
+					   od_rule_t *rule)
+{
+	if (entry->count == entry->size) {
+		int size = entry->size ? entry->size * 2 : 4;
+		od_rule_t **rules;
+		rules = od_realloc(entry->rules, sizeof(od_rule_t *) * size);
+		if (rules == NULL)
+			return -1;
+		entry->rules = rules;
+		entry->size = size;
+	}
+	entry->rules[entry->count++] = rule;
+	return 0;
+}
+
+static inline od_hash_t od_rules_index_hash(char *db_name, int db_is_default,
+					    char *user_name,
+					    int user_is_default)
+{
+	od_hash_t hash = (od_hash_t)db_is_default << 1 |
+			 (od_hash_t)user_is_default;
+	if (!db_is_default)
+		hash ^= od_murmur_hash(db_name, strlen(db_name));
+	if (!user_is_default)
+		hash ^= od_murmur_hash(user_name, strlen(user_name)) * 31;
+	return hash;
+}
+
+static inline od_rules_index_entry_t *
+od_rules_index_find(od_rules_index_t *index, char *db_name, int db_is_default,
+		    char *user_name, int user_is_default)
+{
+	od_hash_t hash = od_rules_index_hash(db_name, db_is_default, user_name,
+					     user_is_default);
+	od_rules_index_entry_t *entry;
+	entry = index->buckets[hash & (index->buckets_count - 1)];
+	for (; entry; entry = entry->next) {
+		if (entry->hash != hash)
+			continue;
+		if (entry->db_is_default != db_is_default ||
+		    entry->user_is_default != user_is_default)
+			continue;
+		if (!db_is_default && strcmp(entry->db_name, db_name) != 0)
+			continue;
+		if (!user_is_default &&
+		    strcmp(entry->user_name, user_name) != 0)
+			continue;
+		return entry;
+	}
+	return NULL;
+}
+
+static inline od_rules_index_entry_t *
+od_rules_index_get_or_create(od_rules_index_t *index, od_rule_t *rule)
+{
+	od_rules_index_entry_t *entry;
+	entry = od_rules_index_find(index, rule->db_name, rule->db_is_default,
+				    rule->user_name, rule->user_is_default);
+	if (entry)
+		return entry;
+
+	entry = od_malloc(sizeof(od_rules_index_entry_t));
+	if (entry == NULL)
+		return NULL;
+	od_rules_index_entry_init(entry);
+	entry->db_name = rule->db_name;
+	entry->db_is_default = rule->db_is_default;
+	entry->user_name = rule->user_name;
+	entry->user_is_default = rule->user_is_default;
+	entry->hash = od_rules_index_hash(rule->db_name, rule->db_is_default,
+					  rule->user_name,
+					  rule->user_is_default);
+
+	size_t bucket = entry->hash & (index->buckets_count - 1);
+	entry->next = index->buckets[bucket];
+	index->buckets[bucket] = entry;
+	return entry;
+}
+
+void od_rules_index_init(od_rules_index_t *index)
+{
+	index->valid = 0;
+	index->buckets = NULL;
+	index->buckets_count = 0;
+	od_rules_index_entry_init(&index->groups);
+}
+
+void od_rules_index_free(od_rules_index_t *index)
+{
+	for (size_t i = 0; i < index->buckets_count; i++) {
+		od_rules_index_entry_t *entry = index->buckets[i];
+		while (entry) {
+			od_rules_index_entry_t *next = entry->next;
+			od_rules_index_entry_free(entry);
+			od_free(entry);
+			entry = next;
+		}
+	}
+	if (index->buckets)
+		od_free(index->buckets);
+	od_rules_index_entry_free(&index->groups);
+	od_rules_index_init(index);
+}
+
+int od_rules_index_build(od_rules_index_t *index, od_list_t *rules)
+{
+	od_rules_index_free(index);
+
+	size_t count = 0;
+	od_list_t *i;
+	od_list_foreach(rules, i)
+	{
+		count++;
+	}
+
+	/* keep at most one key per bucket in average */
+	index->buckets_count = 16;
+	while (index->buckets_count < count)
+		index->buckets_count *= 2;
+	index->buckets =
+		od_calloc(index->buckets_count, sizeof(od_rules_index_entry_t *));
+	if (index->buckets == NULL) {
+		index->buckets_count = 0;
+		return NOT_OK_RESPONSE;
+	}
+
+	/* rules list is sorted by order, so are the index entries */
+	od_list_foreach(rules, i)
+	{
+		od_rule_t *rule;
+		rule = od_container_of(i, od_rule_t, link);
+		if (rule->obsolete)
+			continue;
+
+		od_rules_index_entry_t *entry;
+		if (rule->group) {
+			entry = &index->groups;
+		} else {
+			entry = od_rules_index_get_or_create(index, rule);
+			if (entry == NULL)
+				goto error;
+		}
+		if (od_rules_index_entry_add(entry, rule) == -1)
+			goto error;
+	}
+
+	index->valid = 1;
+	return OK_RESPONSE;
+
+error:
+	od_rules_index_free(index);
+	return NOT_OK_RESPONSE;
+}
+
+/* cursor over rules of the entry, which are applicable to the client */
+typedef struct {
+	od_rules_index_entry_t *entry;
+	int pos;
+} od_rules_index_cursor_t;
+
+static inline int od_rules_index_applicable(od_rule_t *rule, char *db_name,
+					    char *user_name, int pool_internal)
+{
+	if (pool_internal) {
+		if (rule->pool->routing != OD_RULE_POOL_INTERNAL)
+			return 0;
+	} else {
+		if (rule->pool->routing != OD_RULE_POOL_CLIENT_VISIBLE)
+			return 0;
+	}
+
+	/* group members are not indexed */
+	if (rule->group) {
+		if (!rule->db_is_default && strcmp(rule->db_name, db_name) != 0)
+			return 0;
+		return od_name_in_rule(rule, user_name);
+	}
+	return 1;
+}
+
+static inline int od_rules_index_address_match(od_rule_t *rule,
+					       struct sockaddr_storage *addr)
+{
+	return rule->address_range.is_default ||
+	       od_address_validate(&rule->address_range, addr);
+}
+
+/*
+ * Sequential routing: first rule in config order, matching the client.
+ *
+ * Candidate entries are merged by rule order, so address validation
+ * (which might resolve hostnames) is performed in the same order as
+ * with full rules scan.
+ */
+static od_rule_t *
+od_rules_index_forward_sequential(od_rules_index_cursor_t *cursors,
+				  int cursors_count, char *db_name,
+				  char *user_name,
+				  struct sockaddr_storage *user_addr,
+				  int pool_internal)
+{
+	for (;;) {
+		od_rules_index_cursor_t *next = NULL;
+		for (int i = 0; i < cursors_count; i++) {
+			od_rules_index_cursor_t *cursor = &cursors[i];
+			if (cursor->entry == NULL ||
+			    cursor->pos >= cursor->entry->count)
+				continue;
+			if (next == NULL ||
+			    cursor->entry->rules[cursor->pos]->order <
+				    next->entry->rules[next->pos]->order)
+				next = cursor;
+		}
+		if (next == NULL)
+			return NULL;
+
+		od_rule_t *rule = next->entry->rules[next->pos++];
+		if (!od_rules_index_applicable(rule, db_name, user_name,
+					       pool_internal))
+			continue;
+		if (od_rules_index_address_match(rule, user_addr))
+			return rule;
+	}
+}
+
+/*
+ * Default routing: last matching rule within a class, see
+ * od_rules_forward_default() for the classes precedence.
+ */
+static inline void od_rules_index_last_match(od_rules_index_entry_t *entry,
+					     char *db_name, char *user_name,
+					     struct sockaddr_storage *user_addr,
+					     int pool_internal,
+					     od_rule_t **addr_default,
+					     od_rule_t **addr)
+{
+	if (entry == NULL)
+		return;
+
+	od_rule_t *match_default = NULL;
+	od_rule_t *match_addr = NULL;
+	for (int i = entry->count - 1; i >= 0; i--) {
+		if (match_default && match_addr)
+			break;
+		od_rule_t *rule = entry->rules[i];
+		if (!od_rules_index_applicable(rule, db_name, user_name,
+					       pool_internal))
+			continue;
+		if (rule->address_range.is_default) {
+			if (match_default == NULL)
+				match_default = rule;
+		} else if (match_addr == NULL &&
+			   od_address_validate(&rule->address_range,
+					       user_addr)) {
+			match_addr = rule;
+		}
+	}
+
+	if (match_default && (*addr_default == NULL ||
+			      (*addr_default)->order < match_default->order))
+		*addr_default = match_default;
+	if (match_addr && (*addr == NULL || (*addr)->order < match_addr->order))
+		*addr = match_addr;
+}
+
+od_rule_t *od_rules_index_forward(od_rules_index_t *index, char *db_name,
+				  char *user_name,
+				  struct sockaddr_storage *user_addr,
+				  int pool_internal, int sequential)
+{
+	assert(index->valid);
+
+	od_rules_index_entry_t *db_user;
+	od_rules_index_entry_t *db_default;
+	od_rules_index_entry_t *default_user;
+	od_rules_index_entry_t *default_default;
+	db_user = od_rules_index_find(index, db_name, 0, user_name, 0);
+	db_default = od_rules_index_find(index, db_name, 0, NULL, 1);
+	default_user = od_rules_index_find(index, NULL, 1, user_name, 0);
+	default_default = od_rules_index_find(index, NULL, 1, NULL, 1);
+
+	if (sequential) {
+		od_rules_index_cursor_t cursors[] = {
+			{ db_user, 0 },	     { db_default, 0 },
+			{ default_user, 0 }, { default_default, 0 },
+			{ &index->groups, 0 }
+		};
+		return od_rules_index_forward_sequential(
+			cursors, sizeof(cursors) / sizeof(cursors[0]), db_name,
+			user_name, user_addr, pool_internal);
+	}
+
+	od_rule_t *rule_db_user_default = NULL;
+	od_rule_t *rule_db_default_default = NULL;
+	od_rule_t *rule_default_user_default = NULL;
+	od_rule_t *rule_default_default_default = NULL;
+	od_rule_t *rule_db_user_addr = NULL;
+	od_rule_t *rule_db_default_addr = NULL;
+	od_rule_t *rule_default_user_addr = NULL;
+	od_rule_t *rule_default_default_addr = NULL;
+
+	od_rules_index_last_match(db_user, db_name, user_name, user_addr,
+				  pool_internal, &rule_db_user_default,
+				  &rule_db_user_addr);
+	od_rules_index_last_match(db_default, db_name, user_name, user_addr,
+				  pool_internal, &rule_db_default_default,
+				  &rule_db_default_addr);
+	od_rules_index_last_match(default_user, db_name, user_name, user_addr,
+				  pool_internal, &rule_default_user_default,
+				  &rule_default_user_addr);
+	od_rules_index_last_match(default_default, db_name, user_name,
+				  user_addr, pool_internal,
+				  &rule_default_default_default,
+				  &rule_default_default_addr);
+
+	/* group rules are always matched by user name */
+	od_rules_index_entry_t *groups = &index->groups;
+	for (int i = 0; i < groups->count; i++) {
+		od_rule_t *rule = groups->rules[i];
+		if (!od_rules_index_applicable(rule, db_name, user_name,
+					       pool_internal))
+			continue;
+		od_rule_t **addr_default;
+		od_rule_t **addr;
+		if (rule->db_is_default) {
+			addr_default = &rule_default_user_default;
+			addr = &rule_default_user_addr;
+		} else {
+			addr_default = &rule_db_user_default;
+			addr = &rule_db_user_addr;
+		}
+		if (rule->address_range.is_default) {
+			if (*addr_default == NULL ||
+			    (*addr_default)->order < rule->order)
+				*addr_default = rule;
+		} else if ((*addr == NULL || (*addr)->order < rule->order) &&
+			   od_address_validate(&rule->address_range,
+					       user_addr)) {
+			*addr = rule;
+		}
+	}
+
+	if (rule_db_user_addr)
+		return rule_db_user_addr;
+
+	if (rule_db_user_default)
+		return rule_db_user_default;
+
+	if (rule_db_default_addr)
+		return rule_db_default_addr;
+
+	if (rule_default_user_addr)
+		return rule_default_user_addr;
+
+	if (rule_db_default_default)
+		return rule_db_default_default;
+
+	if (rule_default_user_default)
+		return rule_default_user_default;
+
+	if (rule_default_default_addr)
+		return rule_default_default_addr;
+
+	return rule_default_default_default;
+}
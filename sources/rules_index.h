@@ -0,0 +1,49 @@
+#pragma once
+
+/*
+ * Odyssey.
+ *
+ * Scalable PostgreSQL connection pooler.
+ */
+
+/*
+ * Compiled form of the active rules list, used by rules forwarding
+ * to avoid scanning every rule on each login.
+ *
+ * Rules are grouped by (db, user) key, where db and user might be
+ * default. Group rules are kept aside, since members of the group are
+ * updated in runtime. Every group keeps rules in the config order.
+ */
+
+typedef struct od_rules_index_entry od_rules_index_entry_t;
+typedef struct od_rules_index od_rules_index_t;
+
+struct od_rules_index_entry {
+	char *db_name;
+	int db_is_default;
+	char *user_name;
+	int user_is_default;
+	od_hash_t hash;
+
+	od_rule_t **rules;
+	int count;
+	int size;
+
+	od_rules_index_entry_t *next;
+};
+
+struct od_rules_index {
+	int valid;
+	od_rules_index_entry_t **buckets;
+	size_t buckets_count;
+	od_rules_index_entry_t groups;
+};
+
+void od_rules_index_init(od_rules_index_t *);
+void od_rules_index_free(od_rules_index_t *);
+int od_rules_index_build(od_rules_index_t *, od_list_t *rules);
+
+od_rule_t *od_rules_index_forward(od_rules_index_t *, char *db_name,
+				  char *user_name,
+				  struct sockaddr_storage *user_addr,
+				  int pool_internal, int sequential);
@@ -116,8 +116,36 @@ error:
 	return -1;
 }
 
+/*
+ * Keys derived from a plain password are cached by iterations, password
+ * digest and user name (frontend) or salt (backend), so cache never
+ * holds plain passwords.
+ */
+#define OD_SCRAM_CACHE_KEY_EXTRA_MAX 256
+
+static inline uint32_t od_scram_cache_key(uint8_t *key, char type,
+					  int iterations, const char *password,
+					  const void *extra, size_t extra_len)
+{
+	if (extra_len > OD_SCRAM_CACHE_KEY_EXTRA_MAX)
+		return 0;
+	uint8_t *pos = key;
+	*pos++ = type;
+	memcpy(pos, &iterations, sizeof(iterations));
+	pos += sizeof(iterations);
+	SHA256((const unsigned char *)password, strlen(password), pos);
+	pos += SHA256_DIGEST_LENGTH;
+	memcpy(pos, extra, extra_len);
+	pos += extra_len;
+	return pos - key;
+}
+
+#define OD_SCRAM_CACHE_KEY_MAX                    \
+	(1 + sizeof(int) + SHA256_DIGEST_LENGTH + \
+	 OD_SCRAM_CACHE_KEY_EXTRA_MAX)
+
 int od_scram_init_from_plain_password(od_scram_state_t *scram_state,
-				      char *plain_password)
+				      char *plain_password, char *user)
 {
 	char *prep_password = NULL;
 
@@ -131,31 +159,59 @@ int od_scram_init_from_plain_password(od_scram_state_t *scram_state,
 	else
 		password = plain_password;
 
-	char salt[SCRAM_DEFAULT_SALT_LEN];
-	RAND_bytes((uint8_t *)salt, sizeof(salt));
-
 	scram_state->iterations = OD_SCRAM_SHA_256_DEFAULT_ITERATIONS;
 
-	int salt_dst_len = pg_b64_enc_len(sizeof(salt)) + 1;
+	/* salt is stable per user while keys are cached */
+	struct {
+		char salt[SCRAM_DEFAULT_SALT_LEN];
+		uint8_t stored_key[OD_SCRAM_MAX_KEY_LEN];
+		uint8_t server_key[OD_SCRAM_MAX_KEY_LEN];
+	} keys;
+
+	uint8_t key[OD_SCRAM_CACHE_KEY_MAX];
+	uint32_t key_len = 0;
+	int cached = 0;
+	if (scram_state->cache && user) {
+		key_len = od_scram_cache_key(key, 'F', scram_state->iterations,
+					     password, user, strlen(user));
+		if (key_len)
+			cached = od_scram_cache_get(scram_state->cache, key,
+						    key_len, &keys,
+						    sizeof(keys));
+	}
+
+	if (!cached) {
+		RAND_bytes((uint8_t *)keys.salt, sizeof(keys.salt));
+
+		const char *errstr = NULL;
+		/* usage exists depending of pg version */
+		(void)errstr;
+
+		uint8_t salted_password[OD_SCRAM_MAX_KEY_LEN];
+		od_scram_SaltedPassword(password, keys.salt, sizeof(keys.salt),
+					scram_state->iterations,
+					salted_password, &errstr);
+		od_scram_ClientKey(salted_password, keys.stored_key, &errstr);
+		od_scram_H(keys.stored_key, OD_SCRAM_MAX_KEY_LEN,
+			   keys.stored_key, &errstr);
+		od_scram_ServerKey(salted_password, keys.server_key, &errstr);
+
+		if (key_len)
+			od_scram_cache_put(scram_state->cache, key, key_len,
+					   &keys, sizeof(keys));
+	}
+
+	int salt_dst_len = pg_b64_enc_len(sizeof(keys.salt)) + 1;
 	scram_state->salt = od_malloc(salt_dst_len);
 	if (!scram_state->salt)
 		goto error;
 
-	int base64_salt_len = od_b64_encode(salt, sizeof(salt),
+	int base64_salt_len = od_b64_encode(keys.salt, sizeof(keys.salt),
 					    scram_state->salt, salt_dst_len);
 	scram_state->salt[base64_salt_len] = '\0';
-	const char *errstr = NULL;
-	/* usage exists depending of pg version */
-	(void)errstr;
 
-	uint8_t salted_password[OD_SCRAM_MAX_KEY_LEN];
-	od_scram_SaltedPassword(password, salt, sizeof(salt),
-				scram_state->iterations, salted_password,
-				&errstr);
-	od_scram_ClientKey(salted_password, scram_state->stored_key, &errstr);
-	od_scram_H(scram_state->stored_key, OD_SCRAM_MAX_KEY_LEN,
-		   scram_state->stored_key, &errstr);
-	od_scram_ServerKey(salted_password, scram_state->server_key, &errstr);
+	memcpy(scram_state->stored_key, keys.stored_key, OD_SCRAM_MAX_KEY_LEN);
+	memcpy(scram_state->server_key, keys.server_key, OD_SCRAM_MAX_KEY_LEN);
 
 	if (prep_password)
 		od_free(prep_password);
@@ -310,9 +366,29 @@ static int calculate_client_proof(od_scram_state_t *scram_state,
 	/* usage exists depending of pg version */
 	(void)errstr;
 
-	od_scram_SaltedPassword(prepared_password, salt, SCRAM_DEFAULT_SALT_LEN,
-				iterations, scram_state->salted_password,
-				&errstr);
+	uint8_t key[OD_SCRAM_CACHE_KEY_MAX];
+	uint32_t key_len = 0;
+	int cached = 0;
+	if (scram_state->cache) {
+		key_len = od_scram_cache_key(key, 'B', iterations,
+					     prepared_password, salt,
+					     SCRAM_DEFAULT_SALT_LEN);
+		if (key_len)
+			cached = od_scram_cache_get(
+				scram_state->cache, key, key_len,
+				scram_state->salted_password,
+				OD_SCRAM_MAX_KEY_LEN);
+	}
+
+	if (!cached) {
+		od_scram_SaltedPassword(prepared_password, salt,
+					SCRAM_DEFAULT_SALT_LEN, iterations,
+					scram_state->salted_password, &errstr);
+		if (key_len)
+			od_scram_cache_put(scram_state->cache, key, key_len,
+					   scram_state->salted_password,
+					   OD_SCRAM_MAX_KEY_LEN);
+	}
 
 	uint8_t client_key[OD_SCRAM_MAX_KEY_LEN];
 	od_scram_ClientKey(scram_state->salted_password, client_key, &errstr);
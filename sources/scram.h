@@ -130,6 +130,9 @@ struct od_scram_state {
 
 	uint8_t stored_key[32];
 	uint8_t server_key[32];
+
+	/* optional derived keys cache, not owned */
+	od_scram_cache_t *cache;
 };
 
 static inline void od_scram_state_init(od_scram_state_t *state)
@@ -178,7 +181,7 @@ int od_scram_verify_client_proof(od_scram_state_t *scram_state,
 int od_scram_parse_verifier(od_scram_state_t *scram_state, char *verifier);
 
 int od_scram_init_from_plain_password(od_scram_state_t *scram_state,
-				      char *plain_password);
+				      char *plain_password, char *user);
 
 int od_scram_read_client_first_message(od_scram_state_t *scram_state,
 				       char *auth_data, size_t auth_data_size);
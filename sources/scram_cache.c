@@ -0,0 +1,154 @@
+
+/*
+ * Odyssey.
+ *
+ * Scalable PostgreSQL connection pooler.
+ */
+
+#include <kiwi.h>
+#include <machinarium.h>
+#include <odyssey.h>
+
+od_scram_cache_t *od_scram_cache_create(void)
+{
+	od_scram_cache_t *cache = od_malloc(sizeof(od_scram_cache_t));
+	if (cache == NULL) {
+		return NULL;
+	}
+	memset(cache, 0, sizeof(od_scram_cache_t));
+	pthread_mutex_init(&cache->lock, NULL);
+	return cache;
+}
+
+static inline void od_scram_cache_entry_free(od_scram_cache_entry_t *entry)
+{
+	/* cached keys are password equivalents */
+	memset(entry->data, 0, entry->key_len + entry->value_len);
+	od_free(entry);
+}
+
+static inline void od_scram_cache_empty(od_scram_cache_t *cache)
+{
+	if (cache->slots == NULL) {
+		return;
+	}
+	for (uint32_t i = 0; i < OD_SCRAM_CACHE_SZ; i++) {
+		if (cache->slots[i] == NULL) {
+			continue;
+		}
+		od_scram_cache_entry_free(cache->slots[i]);
+		cache->slots[i] = NULL;
+	}
+}
+
+void od_scram_cache_free(od_scram_cache_t *cache)
+{
+	od_scram_cache_empty(cache);
+	if (cache->slots) {
+		od_free(cache->slots);
+	}
+	pthread_mutex_destroy(&cache->lock);
+	od_free(cache);
+}
+
+void od_scram_cache_invalidate(od_scram_cache_t *cache)
+{
+	pthread_mutex_lock(&cache->lock);
+	od_scram_cache_empty(cache);
+	pthread_mutex_unlock(&cache->lock);
+}
+
+static inline int od_scram_cache_match(od_scram_cache_entry_t *entry,
+				       od_hash_t hash, void *key,
+				       uint32_t key_len)
+{
+	return entry && entry->hash == hash && entry->key_len == key_len &&
+	       memcmp(entry->data, key, key_len) == 0;
+}
+
+int od_scram_cache_get(od_scram_cache_t *cache, void *key, uint32_t key_len,
+		       void *value, uint32_t value_len)
+{
+	od_hash_t hash = od_murmur_hash(key, key_len);
+	int found = 0;
+
+	pthread_mutex_lock(&cache->lock);
+	if (cache->slots) {
+		od_scram_cache_entry_t **set;
+		set = &cache->slots[(hash % (OD_SCRAM_CACHE_SZ /
+					     OD_SCRAM_CACHE_WAYS)) *
+				    OD_SCRAM_CACHE_WAYS];
+		for (int i = 0; i < OD_SCRAM_CACHE_WAYS; i++) {
+			od_scram_cache_entry_t *entry = set[i];
+			if (!od_scram_cache_match(entry, hash, key, key_len) ||
+			    entry->value_len != value_len) {
+				continue;
+			}
+			memcpy(value, entry->data + key_len, value_len);
+			/* move to front */
+			memmove(&set[1], &set[0], sizeof(*set) * i);
+			set[0] = entry;
+			found = 1;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&cache->lock);
+
+	if (found) {
+		od_atomic_u64_inc(&cache->hits);
+	} else {
+		od_atomic_u64_inc(&cache->misses);
+	}
+	return found;
+}
+
+int od_scram_cache_put(od_scram_cache_t *cache, void *key, uint32_t key_len,
+		       void *value, uint32_t value_len)
+{
+	od_scram_cache_entry_t *entry;
+	entry = od_malloc(sizeof(od_scram_cache_entry_t) + key_len + value_len);
+	if (entry == NULL) {
+		return NOT_OK_RESPONSE;
+	}
+	entry->hash = od_murmur_hash(key, key_len);
+	entry->key_len = key_len;
+	entry->value_len = value_len;
+	memcpy(entry->data, key, key_len);
+	memcpy(entry->data + key_len, value, value_len);
+
+	pthread_mutex_lock(&cache->lock);
+	if (cache->slots == NULL) {
+		cache->slots = od_malloc(sizeof(od_scram_cache_entry_t *) *
+					 OD_SCRAM_CACHE_SZ);
+		if (cache->slots == NULL) {
+			pthread_mutex_unlock(&cache->lock);
+			od_scram_cache_entry_free(entry);
+			return NOT_OK_RESPONSE;
+		}
+		memset(cache->slots, 0,
+		       sizeof(od_scram_cache_entry_t *) * OD_SCRAM_CACHE_SZ);
+	}
+
+	od_scram_cache_entry_t **set;
+	set = &cache->slots[(entry->hash %
+			     (OD_SCRAM_CACHE_SZ / OD_SCRAM_CACHE_WAYS)) *
+			    OD_SCRAM_CACHE_WAYS];
+
+	/* replace the same key stored concurrently, otherwise evict lru */
+	int victim = OD_SCRAM_CACHE_WAYS - 1;
+	for (int i = 0; i < OD_SCRAM_CACHE_WAYS; i++) {
+		if (od_scram_cache_match(set[i], entry->hash, key, key_len)) {
+			victim = i;
+			break;
+		}
+	}
+	od_scram_cache_entry_t *prev = set[victim];
+	memmove(&set[1], &set[0], sizeof(*set) * victim);
+	set[0] = entry;
+	pthread_mutex_unlock(&cache->lock);
+
+	if (prev) {
+		od_scram_cache_entry_free(prev);
+	}
+	return OK_RESPONSE;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+/*
+ * Odyssey.
+ *
+ * Scalable PostgreSQL connection pooler.
+ */
+
+/*
+ * SCRAM keys cache.
+ *
+ * SaltedPassword is PBKDF2 with thousands of HMAC rounds and dominates
+ * CPU during reconnect storms. Derived keys are kept in a bounded
+ * four-way set associative table keyed by opaque byte strings, the key
+ * layout is up to the caller (see scram.c). Each set keeps the most
+ * recently used entry first and evicts the last one. Slots are
+ * allocated on first use, since storages are copied for every cancel
+ * request.
+ */
+
+typedef struct od_scram_cache_entry od_scram_cache_entry_t;
+typedef struct od_scram_cache od_scram_cache_t;
+
+#define OD_SCRAM_CACHE_SZ 1024
+#define OD_SCRAM_CACHE_WAYS 4
+
+struct od_scram_cache_entry {
+	od_hash_t hash;
+	uint32_t key_len;
+	uint32_t value_len;
+	uint8_t data[];
+};
+
+struct od_scram_cache {
+	pthread_mutex_t lock;
+	od_scram_cache_entry_t **slots;
+	od_atomic_u64_t hits;
+	od_atomic_u64_t misses;
+};
+
+od_scram_cache_t *od_scram_cache_create(void);
+void od_scram_cache_free(od_scram_cache_t *);
+
+/* drop all cached keys, e.g. on reload */
+void od_scram_cache_invalidate(od_scram_cache_t *);
+
+/* returns 1 and copies value on hit, 0 on miss */
+int od_scram_cache_get(od_scram_cache_t *, void *, uint32_t, void *,
+		       uint32_t);
+int od_scram_cache_put(od_scram_cache_t *, void *, uint32_t, void *,
+		       uint32_t);
@@ -30,12 +30,14 @@ struct od_server {
 	od_stat_state_t stats_state;
 
 	od_multi_pool_element_t *pool_element;
+	/* endpoint of the last attach, for latency stats */
+	od_storage_endpoint_t *endpoint;
 
 	uint64_t sync_request;
 	uint64_t sync_reply;
 
 	/* to swallow some internal msgs */
-	machine_msg_t *parse_msg;
+	od_pstmt_t *parse_stmt;
 	int idle_time;
 
 	kiwi_key_t key;
@@ -47,7 +49,7 @@ struct od_server {
 	od_route_t *route;
 
 	/* allocated prepared statements ids */
-	od_hashmap_t *prep_stmts;
+	od_pstmt_map_t *prep_stmts;
 	int sync_point;
 	machine_msg_t *sync_point_deploy_msg;
 
@@ -57,14 +59,16 @@ struct od_server {
 	int offline;
 	uint64_t init_time_us;
 	bool synced_settings;
+	/* client and server vars fingerprints of the last deploy with
+	 * nothing to set */
+	uint64_t synced_client_vars;
+	uint64_t synced_server_vars;
 
 	od_list_t link;
 
 	int need_startup;
 };
 
-static const size_t OD_SERVER_DEFAULT_HASHMAP_SZ = 420;
-
 static inline void od_server_init(od_server_t *server, int reserve_prep_stmts)
 {
 	memset(server, 0, sizeof(od_server_t));
@@ -82,12 +86,15 @@ static inline void od_server_init(od_server_t *server, int reserve_prep_stmts)
 	server->sync_reply = 0;
 	server->sync_point = 0;
 	server->sync_point_deploy_msg = NULL;
-	server->parse_msg = NULL;
+	server->parse_stmt = NULL;
 	server->init_time_us = machine_time_us();
 	server->error_connect = NULL;
 	server->offline = 0;
 	server->synced_settings = false;
+	server->synced_client_vars = 0;
+	server->synced_server_vars = 0;
 	server->pool_element = NULL;
+	server->endpoint = NULL;
 	server->bind_failed = 0;
 	server->need_startup = 1;
 	od_stat_state_init(&server->stats_state);
@@ -107,7 +114,7 @@ static inline void od_server_init(od_server_t *server, int reserve_prep_stmts)
 
 	if (reserve_prep_stmts) {
 		server->prep_stmts =
-			od_hashmap_create(OD_SERVER_DEFAULT_HASHMAP_SZ);
+			od_pstmt_map_create(&od_global_get()->pstmts);
 	} else {
 		server->prep_stmts = NULL;
 	}
@@ -126,8 +133,12 @@ static inline void od_server_free(od_server_t *server)
 {
 	od_relay_free(&server->relay);
 	od_io_free(&server->io);
+	if (server->parse_stmt) {
+		od_pstmt_store_release(&server->global->pstmts,
+				       server->parse_stmt);
+	}
 	if (server->prep_stmts) {
-		od_hashmap_free(server->prep_stmts);
+		od_pstmt_map_free(server->prep_stmts);
 	}
 #ifdef POSTGRESQL_FOUND
 	od_scram_state_free(&server->scram_state);
@@ -150,6 +161,14 @@ static inline int od_server_in_deploy(od_server_t *server)
 	return server->deploy_sync > 0;
 }
 
+/* server was configured for client vars, no need to compare them again */
+static inline int od_server_vars_synced(od_server_t *server,
+					kiwi_vars_t *client_vars)
+{
+	return server->synced_client_vars == client_vars->fingerprint &&
+	       server->synced_server_vars == server->vars.fingerprint;
+}
+
 static inline int od_server_in_sync_point(od_server_t *server)
 {
 	return server->sync_point > 0;
@@ -175,4 +194,5 @@ static inline int od_server_reload(od_attribute_unused() od_server_t *server)
 
 od_server_pool_t *od_server_pool(od_server_t *server);
 const od_address_t *od_server_pool_address(od_server_t *server);
+/* caller must hold the pool element lock */
 void od_server_set_pool_state(od_server_t *server, od_server_state_t state);
@@ -122,6 +122,29 @@ OD_SERVER_POOL_SET_DECLARE(ldap, od_ldap_server_t)
 
 OD_SERVER_POOL_NEXT_DECLARE(pg, od_server_t)
 
+/* recently released idle servers checked for matching client vars */
+#define OD_SERVER_POOL_VARS_SCAN 8
+
+/*
+ * Prefer idle server which needs no SET for the client vars,
+ * otherwise the most recently released one.
+ */
+static inline od_server_t *od_pg_server_pool_next_vars(od_server_pool_t *pool,
+							kiwi_vars_t *vars)
+{
+	int scanned = 0;
+	od_list_t *i;
+	od_list_foreach(&pool->idle, i)
+	{
+		od_server_t *server = od_container_of(i, od_server_t, link);
+		if (od_server_vars_synced(server, vars))
+			return server;
+		if (++scanned == OD_SERVER_POOL_VARS_SCAN)
+			break;
+	}
+	return od_pg_server_pool_next(pool, OD_SERVER_IDLE);
+}
+
 #ifdef LDAP_FOUND
 OD_SERVER_POOL_NEXT_DECLARE(ldap, od_ldap_server_t)
 #endif
@@ -36,6 +36,9 @@ od_system_gracefully_killer_invoke(od_system_t *system,
 	}
 	instance->shutdown_worker_id = mid;
 
+	/* let idle clients notice the shutdown */
+	od_worker_pool_wakeup(system->global->worker_pool);
+
 	return OK_RESPONSE;
 }
 
@@ -109,9 +112,11 @@ void od_system_shutdown(od_system_t *system, od_instance_t *instance)
 	od_cron_stop(system->global->cron);
 
 	od_worker_pool_stop(worker_pool);
+	od_crypto_pool_stop(&system->global->crypto_pool);
 
 	/* Prevent OpenSSL usage during deinitialization */
 	od_worker_pool_wait();
+	od_crypto_pool_free(&system->global->crypto_pool);
 
 	od_extension_free(&instance->logger, system->global->extensions);
 
@@ -9,7 +9,10 @@
 #define QUANTILES_WINDOW 2
 #define QUANTILES_COMPRESSION 100
 
+#define OD_STAT_CACHELINE_SIZE 64
+
 typedef struct od_stat_state od_stat_state_t;
+typedef struct od_stat_shard od_stat_shard_t;
 typedef struct od_stat od_stat_t;
 
 struct od_stat_state {
@@ -17,6 +20,34 @@ struct od_stat_state {
 	uint64_t tx_time_start;
 };
 
+/*
+ * Per-worker part of route stats.
+ *
+ * Counters are updated only by the owner worker thread, so no atomic
+ * read-modify-write is needed. The last shard is shared by
+ * non-worker threads and is updated atomically.
+ *
+ * Histograms are accumulated here and merged into the route histograms
+ * window by od_stat_merge_shards().
+ */
+struct od_stat_shard {
+	od_atomic_u64_t count_query;
+	od_atomic_u64_t count_tx;
+
+	od_atomic_u64_t query_time;
+	od_atomic_u64_t tx_time;
+
+	od_atomic_u64_t recv_server;
+	od_atomic_u64_t recv_client;
+	od_atomic_u64_t count_parse;
+	od_atomic_u64_t count_parse_reuse;
+
+	bool shared;
+	pthread_mutex_t lock;
+	td_histogram_t *transaction_hgram;
+	td_histogram_t *query_hgram;
+} __attribute__((aligned(OD_STAT_CACHELINE_SIZE)));
+
 struct od_stat {
 	bool enable_quantiles;
 	uint8_t current_tdigest;
@@ -34,6 +65,10 @@ struct od_stat {
 
 	td_histogram_t *transaction_hgram[QUANTILES_WINDOW];
 	td_histogram_t *query_hgram[QUANTILES_WINDOW];
+
+	/* set only for route stats, snapshots have no shards */
+	od_stat_shard_t *shards;
+	int shards_count;
 };
 
 static inline void od_stat_state_init(od_stat_state_t *state)
@@ -46,11 +81,109 @@ static inline void od_stat_init(od_stat_t *stat)
 	memset(stat, 0, sizeof(*stat));
 }
 
+static inline void od_stat_shards_free(od_stat_t *stat)
+{
+	if (stat->shards == NULL)
+		return;
+	for (int i = 0; i < stat->shards_count; ++i) {
+		od_stat_shard_t *shard = &stat->shards[i];
+		td_safe_free(shard->transaction_hgram);
+		td_safe_free(shard->query_hgram);
+		pthread_mutex_destroy(&shard->lock);
+	}
+	od_free(stat->shards);
+	stat->shards = NULL;
+	stat->shards_count = 0;
+}
+
+/* one shard per worker plus one shared */
+static inline int od_stat_shards_create(od_stat_t *stat, int workers)
+{
+	int count = workers + 1;
+	size_t size = sizeof(od_stat_shard_t) * count;
+	od_stat_shard_t *shards;
+	shards = aligned_alloc(OD_STAT_CACHELINE_SIZE, size);
+	if (shards == NULL)
+		return NOT_OK_RESPONSE;
+	memset(shards, 0, size);
+	stat->shards = shards;
+	stat->shards_count = count;
+
+	for (int i = 0; i < count; ++i) {
+		od_stat_shard_t *shard = &shards[i];
+		shard->shared = i == count - 1;
+		pthread_mutex_init(&shard->lock, NULL);
+		if (!stat->enable_quantiles)
+			continue;
+		shard->transaction_hgram = td_new(QUANTILES_COMPRESSION);
+		shard->query_hgram = td_new(QUANTILES_COMPRESSION);
+		if (shard->transaction_hgram == NULL ||
+		    shard->query_hgram == NULL) {
+			od_stat_shards_free(stat);
+			return NOT_OK_RESPONSE;
+		}
+	}
+	return OK_RESPONSE;
+}
+
 static inline void od_stat_free(od_stat_t *stat)
 {
 	for (size_t i = 0; i < QUANTILES_WINDOW; ++i) {
-		td_free(stat->transaction_hgram[i]);
-		td_free(stat->query_hgram[i]);
+		td_safe_free(stat->transaction_hgram[i]);
+		td_safe_free(stat->query_hgram[i]);
+	}
+	od_stat_shards_free(stat);
+}
+
+static inline od_stat_shard_t *od_stat_shard(od_stat_t *stat)
+{
+	od_stat_shard_t *shared = &stat->shards[stat->shards_count - 1];
+
+	od_thread_global **gl = od_thread_global_get();
+	if (gl == NULL || *gl == NULL)
+		return shared;
+	int wid = (*gl)->wid;
+	if (wid < 0 || wid >= stat->shards_count - 1)
+		return shared;
+	return &stat->shards[wid];
+}
+
+static inline void od_stat_shard_add(od_stat_shard_t *shard,
+				     od_atomic_u64_t *counter, uint64_t value)
+{
+	if (od_unlikely(shard->shared)) {
+		od_atomic_u64_add(counter, value);
+		return;
+	}
+	/* single writer, plain store is enough for readers */
+	uint64_t current = __atomic_load_n(counter, __ATOMIC_RELAXED);
+	__atomic_store_n(counter, current + value, __ATOMIC_RELAXED);
+}
+
+static inline void od_stat_shard_hgram_add(od_stat_shard_t *shard,
+					   td_histogram_t *hgram,
+					   int64_t value)
+{
+	pthread_mutex_lock(&shard->lock);
+	td_add(hgram, value, 1);
+	pthread_mutex_unlock(&shard->lock);
+}
+
+/* move histograms accumulated by workers into the current window */
+static inline void od_stat_merge_shards(od_stat_t *stat)
+{
+	if (stat->shards == NULL || !stat->enable_quantiles)
+		return;
+	uint8_t current = stat->current_tdigest;
+	for (int i = 0; i < stat->shards_count; ++i) {
+		od_stat_shard_t *shard = &stat->shards[i];
+		pthread_mutex_lock(&shard->lock);
+		td_merge(stat->transaction_hgram[current],
+			 shard->transaction_hgram);
+		td_reset(shard->transaction_hgram);
+		td_merge(stat->query_hgram[current], shard->query_hgram);
+		td_reset(shard->query_hgram);
+		pthread_mutex_unlock(&shard->lock);
 	}
 }
 
@@ -65,27 +198,30 @@ static inline void od_stat_query_start(od_stat_state_t *state)
 
 static inline void od_stat_parse(od_stat_t *stat)
 {
-	od_atomic_u64_inc(&stat->count_parse);
+	od_stat_shard_t *shard = od_stat_shard(stat);
+	od_stat_shard_add(shard, &shard->count_parse, 1);
 }
 
 static inline void od_stat_parse_reuse(od_stat_t *stat)
 {
-	od_atomic_u64_inc(&stat->count_parse_reuse);
+	od_stat_shard_t *shard = od_stat_shard(stat);
+	od_stat_shard_add(shard, &shard->count_parse_reuse, 1);
 }
 
 static inline void od_stat_query_end(od_stat_t *stat, od_stat_state_t *state,
 				     int in_transaction, int64_t *query_time)
 {
+	od_stat_shard_t *shard = od_stat_shard(stat);
 	int64_t diff;
 	if (state->query_time_start) {
 		diff = machine_time_us() - state->query_time_start;
 		if (diff > 0) {
 			*query_time = diff;
-			od_atomic_u64_add(&stat->query_time, diff);
-			od_atomic_u64_inc(&stat->count_query);
+			od_stat_shard_add(shard, &shard->query_time, diff);
+			od_stat_shard_add(shard, &shard->count_query, 1);
 			if (stat->enable_quantiles) {
-				td_add(stat->query_hgram[stat->current_tdigest],
-				       diff, 1);
+				od_stat_shard_hgram_add(
+					shard, shard->query_hgram, diff);
 			}
 		}
 		state->query_time_start = 0;
@@ -97,12 +233,11 @@ static inline void od_stat_query_end(od_stat_t *stat, od_stat_state_t *state,
 	if (state->tx_time_start) {
 		diff = machine_time_us() - state->tx_time_start;
 		if (diff > 0) {
-			od_atomic_u64_add(&stat->tx_time, diff);
-			od_atomic_u64_inc(&stat->count_tx);
+			od_stat_shard_add(shard, &shard->tx_time, diff);
+			od_stat_shard_add(shard, &shard->count_tx, 1);
 			if (stat->enable_quantiles) {
-				td_add(stat->transaction_hgram
-					       [stat->current_tdigest],
-				       diff, 1);
+				od_stat_shard_hgram_add(
+					shard, shard->transaction_hgram, diff);
 			}
 		}
 		state->tx_time_start = 0;
@@ -111,12 +246,30 @@ static inline void od_stat_query_end(od_stat_t *stat, od_stat_state_t *state,
 
 static inline void od_stat_recv_server(od_stat_t *stat, uint64_t bytes)
 {
-	od_atomic_u64_add(&stat->recv_server, bytes);
+	od_stat_shard_t *shard = od_stat_shard(stat);
+	od_stat_shard_add(shard, &shard->recv_server, bytes);
 }
 
 static inline void od_stat_recv_client(od_stat_t *stat, uint64_t bytes)
 {
-	od_atomic_u64_add(&stat->recv_client, bytes);
+	od_stat_shard_t *shard = od_stat_shard(stat);
+	od_stat_shard_add(shard, &shard->recv_client, bytes);
+}
+
+static inline void od_stat_sum_shards(od_stat_t *sum, od_stat_t *stat)
+{
+	for (int i = 0; i < stat->shards_count; ++i) {
+		od_stat_shard_t *shard = &stat->shards[i];
+		sum->count_query += od_atomic_u64_of(&shard->count_query);
+		sum->count_tx += od_atomic_u64_of(&shard->count_tx);
+		sum->query_time += od_atomic_u64_of(&shard->query_time);
+		sum->tx_time += od_atomic_u64_of(&shard->tx_time);
+		sum->recv_client += od_atomic_u64_of(&shard->recv_client);
+		sum->recv_server += od_atomic_u64_of(&shard->recv_server);
+		sum->count_parse += od_atomic_u64_of(&shard->count_parse);
+		sum->count_parse_reuse +=
+			od_atomic_u64_of(&shard->count_parse_reuse);
+	}
 }
 
 static inline void od_stat_copy(od_stat_t *dst, od_stat_t *src)
@@ -129,6 +282,7 @@ static inline void od_stat_copy(od_stat_t *dst, od_stat_t *src)
 	dst->recv_server = od_atomic_u64_of(&src->recv_server);
 	dst->count_parse = od_atomic_u64_of(&src->count_parse);
 	dst->count_parse_reuse = od_atomic_u64_of(&src->count_parse_reuse);
+	od_stat_sum_shards(dst, src);
 }
 
 static inline void od_stat_sum(od_stat_t *sum, od_stat_t *stat)
@@ -141,6 +295,7 @@ static inline void od_stat_sum(od_stat_t *sum, od_stat_t *stat)
 	sum->recv_server += od_atomic_u64_of(&stat->recv_server);
 	sum->count_parse += od_atomic_u64_of(&stat->count_parse);
 	sum->count_parse_reuse += od_atomic_u64_of(&stat->count_parse_reuse);
+	od_stat_sum_shards(sum, stat);
 }
 
 static inline void od_stat_update_of(od_atomic_u64_t *prev,
@@ -55,6 +55,44 @@ void od_storage_endpoint_status_set(od_storage_endpoint_status_t *status,
 	pthread_spin_unlock(&status->values_lock);
 }
 
+void od_storage_endpoint_stat_init(od_storage_endpoint_stat_t *stat)
+{
+	stat->connect_ewma_us = 0;
+	stat->query_ewma_us = 0;
+}
+
+void od_storage_endpoint_ewma_update(od_atomic_u64_t *ewma, uint64_t sample)
+{
+	/* zero is reserved for endpoints without samples */
+	if (sample == 0) {
+		sample = 1;
+	}
+
+	for (;;) {
+		uint64_t prev = od_atomic_u64_of(ewma);
+		uint64_t value = sample;
+		if (prev) {
+			int shift = OD_STORAGE_ENDPOINT_EWMA_SHIFT;
+			value = prev - (prev >> shift) + (sample >> shift);
+			if (value == 0) {
+				value = 1;
+			}
+		}
+		if (od_atomic_u64_cas(ewma, prev, value) == prev) {
+			return;
+		}
+	}
+}
+
+uint64_t od_storage_endpoint_latency(od_storage_endpoint_t *endpoint)
+{
+	uint64_t latency = od_atomic_u64_of(&endpoint->stat.query_ewma_us);
+	if (latency == 0) {
+		latency = od_atomic_u64_of(&endpoint->stat.connect_ewma_us);
+	}
+	return latency;
+}
+
 od_storage_watchdog_t *od_storage_watchdog_allocate(od_global_t *global)
 {
 	od_storage_watchdog_t *watchdog;
@@ -170,9 +208,8 @@ od_rule_storage_t *od_rules_storage_allocate(void)
 	storage->endpoints_status_poll_interval_ms = 1000;
 	atomic_init(&storage->rr_counter, 0);
 
-#define OD_STORAGE_DEFAULT_HASHMAP_SZ 420u
-
-	storage->acache = od_hashmap_create(OD_STORAGE_DEFAULT_HASHMAP_SZ);
+	storage->acache = od_auth_cache_create();
+	storage->scram_cache = od_scram_cache_create();
 
 	od_list_init(&storage->link);
 	return storage;
@@ -206,7 +243,11 @@ void od_rules_storage_free(od_rule_storage_t *storage)
 	}
 
 	if (storage->acache) {
-		od_hashmap_free(storage->acache);
+		od_auth_cache_free(storage->acache);
+	}
+
+	if (storage->scram_cache) {
+		od_scram_cache_free(storage->scram_cache);
 	}
 
 	od_list_unlink(&storage->link);
@@ -233,7 +274,9 @@ od_rule_storage_t *od_rules_storage_copy(od_rule_storage_t *storage)
 			goto error;
 	}
 	copy->port = storage->port;
+	copy->endpoints_balancing = storage->endpoints_balancing;
 	copy->tls_opts->tls_mode = storage->tls_opts->tls_mode;
+	copy->tls_opts->tls_ktls = storage->tls_opts->tls_ktls;
 	if (storage->tls_opts->tls) {
 		copy->tls_opts->tls = strdup(storage->tls_opts->tls);
 		if (copy->tls_opts->tls == NULL)
@@ -282,6 +325,7 @@ od_rule_storage_t *od_rules_storage_copy(od_rule_storage_t *storage)
 			}
 			od_storage_endpoint_status_init(
 				&copy->endpoints[i].status);
+			od_storage_endpoint_stat_init(&copy->endpoints[i].stat);
 		}
 	}
 
@@ -542,6 +586,7 @@ int od_storage_parse_endpoints(const char *host_str,
 		od_address_t *result_addr = &result[i].address;
 		od_address_init(result_addr);
 		od_address_move(result_addr, &addrs[i]);
+		od_storage_endpoint_stat_init(&result[i].stat);
 	}
 
 	od_free(addrs);
@@ -56,21 +56,52 @@ void od_storage_endpoint_status_get(od_storage_endpoint_status_t *status,
 				    od_storage_endpoint_status_t *out);
 void od_storage_endpoint_status_set(od_storage_endpoint_status_t *status,
 				    od_storage_endpoint_status_t *value);
+/* smoothing factor of endpoint latency is 1 / 2^shift */
+#define OD_STORAGE_ENDPOINT_EWMA_SHIFT 3
+
+typedef struct {
+	/* zero until the first sample */
+	od_atomic_u64_t connect_ewma_us;
+	od_atomic_u64_t query_ewma_us;
+} od_storage_endpoint_stat_t;
+
+void od_storage_endpoint_stat_init(od_storage_endpoint_stat_t *stat);
+void od_storage_endpoint_ewma_update(od_atomic_u64_t *ewma, uint64_t sample);
+
 struct od_storage_endpoint {
 	od_address_t address;
 
 	od_storage_endpoint_status_t status;
+	od_storage_endpoint_stat_t stat;
 };
 
+/* query latency if known, connect latency otherwise */
+uint64_t od_storage_endpoint_latency(od_storage_endpoint_t *endpoint);
+
 int od_storage_parse_endpoints(const char *host_str,
 			       od_storage_endpoint_t **out, size_t *count);
 
-typedef struct od_auth_cache_value od_auth_cache_value_t;
-struct od_auth_cache_value {
-	uint64_t timestamp;
-	char *passwd;
-	uint32_t passwd_len;
-};
+typedef enum {
+	OD_STORAGE_BALANCING_RANDOM,
+	OD_STORAGE_BALANCING_ROUND_ROBIN,
+	OD_STORAGE_BALANCING_LEAST_CONNECTIONS,
+	OD_STORAGE_BALANCING_LATENCY,
+} od_storage_balancing_t;
+
+static inline char *od_storage_balancing_to_str(od_storage_balancing_t b)
+{
+	switch (b) {
+	case OD_STORAGE_BALANCING_RANDOM:
+		return "random";
+	case OD_STORAGE_BALANCING_ROUND_ROBIN:
+		return "round_robin";
+	case OD_STORAGE_BALANCING_LEAST_CONNECTIONS:
+		return "least_connections";
+	case OD_STORAGE_BALANCING_LATENCY:
+		return "latency";
+	}
+	return "unknown";
+}
 
 struct od_rule_storage {
 	od_tls_opts_t *tls_opts;
@@ -90,11 +121,14 @@ struct od_rule_storage {
 	int server_max_routing;
 	od_storage_watchdog_t *watchdog;
 
-	od_hashmap_t *acache;
+	od_auth_cache_t *acache;
+	od_scram_cache_t *scram_cache;
 
 	od_list_t link;
 
 	int endpoints_status_poll_interval_ms;
+	/* order of suitable endpoints of the same priority */
+	od_storage_balancing_t endpoints_balancing;
 };
 
 /* storage API */
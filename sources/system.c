@@ -9,6 +9,8 @@
 #include <machinarium.h>
 #include <odyssey.h>
 
+#include <linux/filter.h>
+
 static inline od_retcode_t od_system_server_pre_stop(od_system_server_t *server)
 {
 	/* shutdown */
@@ -36,11 +38,21 @@ static inline void od_system_server(void *arg)
 			break;
 		}
 
+		/*
+		 * worker must notice server closing by itself to be able
+		 * to finish, so wake up periodically
+		 */
+		uint32_t timeout = UINT32_MAX;
+		if (server->worker)
+			timeout = 1000;
+
 		/* accepted client io is not attached to epoll context yet */
 		machine_io_t *client_io;
 		int rc;
 		rc = machine_accept(server->io, &client_io,
-				    server->config->backlog, 0, UINT32_MAX);
+				    server->config->backlog, 0, timeout);
+		if (rc == -1 && server->worker && machine_timedout())
+			continue;
 		if (rc == -1) {
 			od_error(&instance->logger, "server", NULL, NULL,
 				 "accept failed: %s",
@@ -91,15 +103,23 @@ static inline void od_system_server(void *arg)
 		client->time_accept = 0;
 		client->time_accept = machine_time_us();
 
-		/* create new client event and pass it to worker pool */
-		machine_msg_t *msg;
-		msg = machine_msg_create(sizeof(od_client_t *));
-		machine_msg_set_type(msg, OD_MSG_CLIENT_NEW);
-		memcpy(machine_msg_data(msg), &client, sizeof(od_client_t *));
-
-		od_worker_pool_t *worker_pool = server->global->worker_pool;
 		od_atomic_u32_inc(&router->clients_routing);
-		od_worker_pool_feed(worker_pool, msg);
+		if (server->worker) {
+			/* accepted by worker, start client right here */
+			od_atomic_u32_inc(&server->worker->clients_active);
+			od_worker_client_start(server->worker, client);
+		} else {
+			/* create new client event and pass it to worker pool */
+			machine_msg_t *msg;
+			msg = machine_msg_create(sizeof(od_client_t *));
+			machine_msg_set_type(msg, OD_MSG_CLIENT_NEW);
+			memcpy(machine_msg_data(msg), &client,
+			       sizeof(od_client_t *));
+
+			od_worker_pool_t *worker_pool;
+			worker_pool = server->global->worker_pool;
+			od_worker_pool_feed(worker_pool, msg);
+		}
 		bool warning_emitted = false;
 		while (od_atomic_u32_of(&router->clients_routing) >=
 		       (uint32_t)instance->config.client_max_routing) {
@@ -126,6 +146,7 @@ od_system_server_t *od_system_server_init(void)
 
 	server->io = NULL;
 	server->tls = NULL;
+	server->worker = NULL;
 	od_id_generate(&server->sid, "sid");
 	atomic_init(&server->closed, false);
 	server->pre_exited = false;
@@ -133,6 +154,29 @@ od_system_server_t *od_system_server_init(void)
 	return server;
 }
 
+int od_system_server_attach(od_system_server_t *server)
+{
+	od_instance_t *instance = server->global->instance;
+
+	int rc;
+	rc = machine_io_attach(server->io);
+	if (rc == -1) {
+		od_error(&instance->logger, "server", NULL, NULL,
+			 "failed to attach server io: %s",
+			 machine_error(server->io));
+		return NOT_OK_RESPONSE;
+	}
+
+	int64_t coroutine_id;
+	coroutine_id = machine_coroutine_create(od_system_server, server);
+	if (coroutine_id == -1) {
+		od_error(&instance->logger, "server", NULL, NULL,
+			 "failed to start server coroutine");
+		return NOT_OK_RESPONSE;
+	}
+	return OK_RESPONSE;
+}
+
 void od_system_server_free(od_system_server_t *server)
 {
 	if (server->io) {
@@ -151,9 +195,40 @@ void od_system_server_free(od_system_server_t *server)
 	od_free(server);
 }
 
+/*
+ * Steer connections to the SO_REUSEPORT socket by cpu, which handled
+ * the incoming packet, so accept happens close to the softirq.
+ */
+static inline int od_system_server_steer_cpu(od_system_server_t *server)
+{
+#ifdef SO_ATTACH_REUSEPORT_CBPF
+	od_instance_t *instance = server->global->instance;
+	struct sock_filter code[] = {
+		/* A = cpu id */
+		{ BPF_LD | BPF_W | BPF_ABS, 0, 0, SKF_AD_OFF + SKF_AD_CPU },
+		/* A = A % workers */
+		{ BPF_ALU | BPF_MOD | BPF_K, 0, 0,
+		  (uint32_t)instance->config.workers },
+		/* return A */
+		{ BPF_RET | BPF_A, 0, 0, 0 },
+	};
+	struct sock_fprog prog = {
+		.len = sizeof(code) / sizeof(code[0]),
+		.filter = code,
+	};
+	return setsockopt(machine_fd(server->io), SOL_SOCKET,
+			  SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog));
+#else
+	(void)server;
+	errno = ENOTSUP;
+	return -1;
+#endif
+}
+
 static inline od_retcode_t od_system_server_start(od_system_t *system,
 						  od_config_listen_t *config,
-						  struct addrinfo *addr)
+						  struct addrinfo *addr,
+						  od_worker_t *worker)
 {
 	od_instance_t *instance;
 	od_system_server_t *server;
@@ -171,6 +246,7 @@ static inline od_retcode_t od_system_server_start(od_system_t *system,
 	server->config = config;
 	server->addr = addr;
 	server->global = system->global;
+	server->worker = worker;
 
 	/* create server tls */
 	if (server->config->tls_opts->tls_mode != OD_CONFIG_TLS_DISABLE) {
@@ -214,7 +290,7 @@ static inline od_retcode_t od_system_server_start(od_system_t *system,
 
 	/* bind */
 	int rc;
-	if (instance->config.bindwith_reuseport) {
+	if (instance->config.bindwith_reuseport || worker) {
 		rc = machine_bind(server->io, saddr,
 				  MM_BINDWITH_SO_REUSEPORT |
 					  MM_BINDWITH_SO_REUSEADDR);
@@ -248,15 +324,58 @@ static inline od_retcode_t od_system_server_start(od_system_t *system,
 		}
 	}
 
-	od_log(&instance->logger, "server", NULL, NULL, "listening on %s",
-	       addr_name);
+	if (worker == NULL) {
+		od_log(&instance->logger, "server", NULL, NULL,
+		       "listening on %s", addr_name);
 
-	int64_t coroutine_id;
-	coroutine_id = machine_coroutine_create(od_system_server, server);
-	if (coroutine_id == -1) {
-		od_error(&instance->logger, "system", NULL, NULL,
-			 "failed to start server coroutine");
-		goto error;
+		int64_t coroutine_id;
+		coroutine_id =
+			machine_coroutine_create(od_system_server, server);
+		if (coroutine_id == -1) {
+			od_error(&instance->logger, "system", NULL, NULL,
+				 "failed to start server coroutine");
+			goto error;
+		}
+	} else {
+		/*
+		 * listen right away, so next sockets of the SO_REUSEPORT
+		 * group could be bound and start listening too
+		 */
+		rc = machine_listen(server->io, config->backlog);
+		if (rc == -1) {
+			od_error(&instance->logger, "server", NULL, NULL,
+				 "listen on '%s' failed: %s", addr_name,
+				 machine_error(server->io));
+			goto error;
+		}
+
+		/* program is attached to the whole group of sockets */
+		if (instance->config.workers_reuseport_cpu &&
+		    od_system_server_steer_cpu(server) == -1) {
+			od_error(&instance->logger, "server", NULL, NULL,
+				 "failed to set cpu steering for '%s': %s",
+				 addr_name, strerror(errno));
+		}
+
+		od_log(&instance->logger, "server", NULL, NULL,
+		       "listening on %s (worker[%d])", addr_name, worker->id);
+
+		/* accept loop is started by the worker */
+		rc = machine_io_detach(server->io);
+		if (rc == -1) {
+			od_error(&instance->logger, "server", NULL, NULL,
+				 "failed to detach server io: %s",
+				 machine_error(server->io));
+			goto error;
+		}
+		machine_msg_t *msg;
+		msg = machine_msg_create(sizeof(od_system_server_t *));
+		if (msg == NULL)
+			goto error;
+		machine_msg_set_type(msg, OD_MSG_SYSTEM_SERVER_NEW);
+		memcpy(machine_msg_data(msg), &server,
+		       sizeof(od_system_server_t *));
+		machine_channel_write(worker->task_channel, msg);
 	}
 
 	/* register server in list for possible TLS reload */
@@ -278,6 +397,27 @@ error:
 	return NOT_OK_RESPONSE;
 }
 
+/* start listen server, either once or in every worker */
+static inline int od_system_server_start_tcp(od_system_t *system,
+					     od_config_listen_t *listen,
+					     struct addrinfo *addr)
+{
+	od_instance_t *instance = system->global->instance;
+	if (!instance->config.workers_reuseport)
+		return od_system_server_start(system, listen, addr, NULL);
+
+	od_worker_pool_t *worker_pool = system->global->worker_pool;
+	int binded = 0;
+	for (uint32_t i = 0; i < worker_pool->count; i++) {
+		int rc;
+		rc = od_system_server_start(system, listen, addr,
+					    &worker_pool->pool[i]);
+		if (rc == 0)
+			binded++;
+	}
+	return binded > 0 ? 0 : -1;
+}
+
 static inline int od_system_listen(od_system_t *system)
 {
 	od_instance_t *instance = system->global->instance;
@@ -291,7 +431,7 @@ static inline int od_system_listen(od_system_t *system)
 		/* unix socket */
 		int rc;
 		if (listen->host == NULL) {
-			rc = od_system_server_start(system, listen, NULL);
+			rc = od_system_server_start(system, listen, NULL, NULL);
 			if (rc == 0)
 				binded++;
 			continue;
@@ -326,14 +466,14 @@ static inline int od_system_listen(od_system_t *system)
 
 		/* listen resolved addresses */
 		if (host) {
-			rc = od_system_server_start(system, listen, ai);
+			rc = od_system_server_start_tcp(system, listen, ai);
 			if (rc == 0) {
 				binded++;
 			}
 			continue;
 		}
 		while (ai) {
-			rc = od_system_server_start(system, listen, ai);
+			rc = od_system_server_start_tcp(system, listen, ai);
 			if (rc == 0)
 				binded++;
 			ai = ai->ai_next;
@@ -517,6 +657,10 @@ void od_system_config_reload(od_system_t *system)
 	od_log(&instance->logger, "rules", NULL, NULL, "reconfigure rules");
 	int updates;
 	updates = od_router_reconfigure(router, &rules);
+	if (updates > 0) {
+		/* obsolete clients are killed */
+		od_worker_pool_wakeup(system->global->worker_pool);
+	}
 
 	od_log(&instance->logger, "rules", NULL, NULL,
 	       "dispatching storage watchdogs");
@@ -531,6 +675,9 @@ void od_system_config_reload(od_system_t *system)
 	       "%d routes created/deleted and scheduled for removal", updates);
 
 	od_rules_groups_checkers_run(&instance->logger, &router->rules);
+
+	/* warm up pools of added rules */
+	od_prewarm_start(system->global);
 }
 
 static inline void od_system(void *arg)
@@ -553,6 +700,16 @@ static inline void od_system(void *arg)
 	if (rc == -1)
 		return;
 
+	/* start crypto threads */
+	rc = od_crypto_pool_start(&system->global->crypto_pool,
+				  instance->config.crypto_workers,
+				  instance->config.crypto_queue_limit);
+	if (rc == -1) {
+		od_error(&instance->logger, "system", NULL, NULL,
+			 "failed to start crypto workers");
+		return;
+	}
+
 	/* start signal handler coroutine */
 	int64_t mid;
 	mid = machine_create("sighandler", od_system_signal_handler, system);
@@ -579,6 +736,9 @@ static inline void od_system(void *arg)
 	}
 
 	od_rules_groups_checkers_run(&instance->logger, &router->rules);
+
+	/* open server connections before clients come */
+	od_prewarm_start(system->global);
 }
 
 void od_system_init(od_system_t *system)
@@ -14,6 +14,8 @@ struct od_system_server {
 	od_config_listen_t *config;
 	struct addrinfo *addr;
 	od_global_t *global;
+	/* worker, accepting on its own SO_REUSEPORT socket */
+	od_worker_t *worker;
 	od_list_t link;
 	od_id_t sid;
 
@@ -23,6 +25,7 @@ struct od_system_server {
 
 void od_system_server_free(od_system_server_t *server);
 od_system_server_t *od_system_server_init(void);
+int od_system_server_attach(od_system_server_t *server);
 
 struct od_system {
 	int64_t machine;
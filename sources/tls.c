@@ -9,6 +9,56 @@
 #include <machinarium.h>
 #include <odyssey.h>
 
+typedef struct {
+	machine_io_t *io;
+	machine_tls_t *tls;
+	uint32_t timeout;
+	int detached;
+} od_tls_handshake_t;
+
+static int od_tls_handshake_task(void *arg)
+{
+	od_tls_handshake_t *handshake = arg;
+	if (!handshake->detached) {
+		return machine_set_tls(handshake->io, handshake->tls,
+				       handshake->timeout);
+	}
+
+	/* handshake waits for the peer on the machine running it */
+	int rc = machine_io_attach(handshake->io);
+	if (rc == -1)
+		return -1;
+	rc = machine_set_tls(handshake->io, handshake->tls,
+			     handshake->timeout);
+	if (machine_io_detach(handshake->io) == -1)
+		rc = -1;
+	return rc;
+}
+
+static inline int od_tls_handshake(od_global_t *global,
+				   od_crypto_stage_t stage, machine_io_t *io,
+				   machine_tls_t *tls, uint32_t timeout)
+{
+	od_crypto_pool_t *pool = &global->crypto_pool;
+
+	od_tls_handshake_t handshake;
+	handshake.io = io;
+	handshake.tls = tls;
+	handshake.timeout = timeout;
+	handshake.detached = od_crypto_pool_enabled(pool);
+
+	if (handshake.detached && machine_io_detach(io) == -1)
+		return -1;
+
+	int rc;
+	rc = od_crypto_pool_run(pool, stage, od_tls_handshake_task,
+				&handshake);
+
+	if (handshake.detached && machine_io_attach(io) == -1)
+		return -1;
+	return rc;
+}
+
 machine_tls_t *od_tls_frontend(od_config_listen_t *config)
 {
 	int rc;
@@ -53,6 +103,7 @@ machine_tls_t *od_tls_frontend(od_config_listen_t *config)
 			return NULL;
 		}
 	}
+	machine_tls_set_ktls(tls, config->tls_opts->tls_ktls);
 	return tls;
 }
 
@@ -103,8 +154,9 @@ int od_tls_frontend_accept(od_client_t *client, od_logger_t *logger,
 			return -1; /* prevent possible buffer, protecting against CVE-2021-23214-like attacks */
 		}
 
-		rc = machine_set_tls(client->io.io, tls,
-				     config->client_login_timeout);
+		rc = od_tls_handshake(client->global, OD_CRYPTO_TLS_FRONTEND,
+				      client->io.io, tls,
+				      config->client_login_timeout);
 		if (rc == -1) {
 			od_error(logger, "tls", client, NULL,
 				 "error: %s, login time %d us",
@@ -174,6 +226,7 @@ machine_tls_t *od_tls_backend(od_tls_opts_t *opts)
 			return NULL;
 		}
 	}
+	machine_tls_set_ktls(tls, opts->tls_ktls);
 	return tls;
 }
 
@@ -214,7 +267,8 @@ int od_tls_backend_connect(od_server_t *server, od_logger_t *logger,
 			return -1; /* prevent possible buffer, protecting against CVE-2021-23222-like attacks */
 		}
 
-		rc = machine_set_tls(server->io.io, server->tls, UINT32_MAX);
+		rc = od_tls_handshake(od_global_get(), OD_CRYPTO_TLS_BACKEND,
+				      server->io.io, server->tls, UINT32_MAX);
 		if (rc == -1) {
 			od_error(logger, "tls", NULL, server, "error: %s",
 				 od_io_error(&server->io));
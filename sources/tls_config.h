@@ -39,6 +39,7 @@ struct od_tls_opts {
 	char *tls_key_file;
 	char *tls_cert_file;
 	char *tls_protocols;
+	int tls_ktls;
 };
 
 typedef struct od_tls_opts od_tls_opts_t;
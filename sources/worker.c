@@ -12,11 +12,103 @@
 #include <prom_metric.h>
 #endif
 
+static inline void od_worker_client(void *arg)
+{
+	od_client_t *client = arg;
+	od_global_t *global = client->global;
+	od_thread_global **gl = od_thread_global_get();
+	od_worker_t *worker = &global->worker_pool->pool[(*gl)->wid];
+
+	/* unlinked when client is freed */
+	od_list_append(&worker->clients, &client->link_worker);
+	od_frontend(client);
+
+	od_atomic_u32_dec(&worker->clients_active);
+}
+
+int od_worker_client_start(od_worker_t *worker, od_client_t *client)
+{
+	od_instance_t *instance = worker->global->instance;
+	od_router_t *router = worker->global->router;
+
+	client->global = worker->global;
+
+	/* for NULL-terminator and prefix, just in case */
+	char coro_name[10 + OD_ID_LEN];
+	od_id_write_to_string(&client->id, coro_name, 10 + OD_ID_LEN);
+
+	int64_t coroutine_id;
+	coroutine_id = machine_coroutine_create_sized(
+		od_worker_client, client, coro_name,
+		instance->config.client_coroutine_stack_size);
+	if (coroutine_id == -1) {
+		od_error(&instance->logger, "worker", client, NULL,
+			 "failed to create coroutine");
+		od_io_close(&client->io);
+		od_client_free(client);
+		od_atomic_u32_dec(&router->clients_routing);
+		od_atomic_u32_dec(&worker->clients_active);
+		return -1;
+	}
+	client->coroutine_id = coroutine_id;
+
+	worker->clients_processed++;
+	return 0;
+}
+
+/*
+ * Client coroutines sleep on io_cond until io or their idle deadline.
+ * Kill, pause and shutdown do not change io, so wake up coroutines
+ * which have to act on them.
+ */
+static inline void od_worker_wakeup_clients(od_worker_t *worker)
+{
+	od_global_t *global = worker->global;
+	od_instance_t *instance = global->instance;
+	bool all = od_global_is_paused(global) ||
+		   instance->shutdown_worker_id != INVALID_COROUTINE_ID;
+
+	od_list_t *i;
+	od_list_foreach(&worker->clients, i)
+	{
+		od_client_t *client;
+		client = od_container_of(i, od_client_t, link_worker);
+		if (client->io_cond == NULL)
+			continue;
+		if (!all && !od_atomic_u64_of(&client->killed))
+			continue;
+		client->wakeup = 1;
+		machine_cond_signal(client->io_cond);
+	}
+}
+
+/* publish coroutine stacks usage for SHOW WORKERS */
+static inline int od_worker_stack_stat(od_worker_t *worker,
+				       machine_stack_stat_t *stat)
+{
+	int count = machine_stack_stat(stat, MACHINE_STACK_CLASSES_MAX);
+	uint64_t used = 0;
+	uint64_t hot = 0;
+	uint64_t reclaimed = 0;
+	uint64_t hwm = 0;
+	for (int i = 0; i < count; i++) {
+		used += stat[i].count_used;
+		hot += stat[i].count_hot;
+		reclaimed += stat[i].count_reclaimed;
+		if (stat[i].hwm > hwm)
+			hwm = stat[i].hwm;
+	}
+	od_atomic_u64_set(&worker->stacks_used, used);
+	od_atomic_u64_set(&worker->stacks_hot, hot);
+	od_atomic_u64_set(&worker->stacks_reclaimed, reclaimed);
+	od_atomic_u64_set(&worker->stack_hwm, hwm);
+	return count;
+}
+
 static inline void od_worker(void *arg)
 {
 	od_worker_t *worker = arg;
 	od_instance_t *instance = worker->global->instance;
-	od_router_t *router = worker->global->router;
 
 	/* thread global initialization */
 	od_thread_global **gl = od_thread_global_get();
@@ -30,8 +122,21 @@ static inline void od_worker(void *arg)
 	}
 
 	(*gl)->wid = worker->id;
+	od_readahead_pool_attach(&worker->readahead_pool);
+
+	/* let cron sample cpu time of the worker thread */
+	if (pthread_getcpuclockid(pthread_self(), &worker->cpu_clock) == 0)
+		od_atomic_u32_set(&worker->cpu_clock_set, 1);
+
+	if (instance->config.poller == OD_CONFIG_POLLER_IO_URING &&
+	    strcmp(machine_poller(), "io_uring") != 0) {
+		od_log(&instance->logger, "worker", NULL, NULL,
+		       "worker[%d] io_uring is not available, using %s",
+		       worker->id, machine_poller());
+	}
 
 	bool run = true;
+	machine_stack_stat_t stack_stat[MACHINE_STACK_CLASSES_MAX];
 
 	while (run) {
 		uint32_t task_wait_timout_ms = 10 * 1000;
@@ -40,6 +145,7 @@ static inline void od_worker(void *arg)
 		/* Inverse priorities of cliend routing to decrease chances of timeout */
 		msg = machine_channel_read_back(worker->task_channel,
 						task_wait_timout_ms);
+		int stack_classes = od_worker_stack_stat(worker, stack_stat);
 		if (msg == NULL) {
 			od_log(&instance->logger, "worker", NULL, NULL,
 			       "worker[%d]: task channel is empty for %u ms",
@@ -53,27 +159,13 @@ static inline void od_worker(void *arg)
 		case OD_MSG_CLIENT_NEW: {
 			od_client_t *client;
 			client = *(od_client_t **)machine_msg_data(msg);
-			client->global = worker->global;
-
-			/* for NULL-terminator and prefix, just in case */
-			char coro_name[10 + OD_ID_LEN];
-			od_id_write_to_string(&client->id, coro_name,
-					      10 + OD_ID_LEN);
-
-			int64_t coroutine_id;
-			coroutine_id = machine_coroutine_create_named(
-				od_frontend, client, coro_name);
-			if (coroutine_id == -1) {
-				od_error(&instance->logger, "worker", client,
-					 NULL, "failed to create coroutine");
-				od_io_close(&client->io);
-				od_client_free(client);
-				od_atomic_u32_dec(&router->clients_routing);
-				break;
-			}
-			client->coroutine_id = coroutine_id;
-
-			worker->clients_processed++;
+			od_worker_client_start(worker, client);
+			break;
+		}
+		case OD_MSG_SYSTEM_SERVER_NEW: {
+			od_system_server_t *server;
+			server = *(od_system_server_t **)machine_msg_data(msg);
+			od_system_server_attach(server);
 			break;
 		}
 		case OD_MSG_STAT: {
@@ -92,20 +184,43 @@ static inline void od_worker(void *arg)
 				worker->id, msg_allocated, msg_cache_count,
 				msg_cache_gc_count, msg_cache_size,
 				count_coroutine, count_coroutine_cache,
-				worker->clients_processed);
+				worker->clients_processed,
+				od_atomic_u32_of(&worker->clients_active),
+				od_atomic_u32_of(&worker->cpu_load));
+			od_prom_metrics_write_worker_stack_stat(
+				((od_cron_t *)(worker->global->cron))->metrics,
+				worker->id, stack_stat, stack_classes);
 #endif
 			od_log(&instance->logger, "stats", NULL, NULL,
 			       "worker[%d]: msg (%" PRIu64
 			       " allocated, %" PRIu64 " cached, %" PRIu64
 			       " freed, %" PRIu64 " cache_size), "
 			       "coroutines (%" PRIu64 " active, %" PRIu64
-			       " cached), clients_processed: %" PRIu64,
+			       " cached), clients_processed: %" PRIu64
+			       ", clients_active: %u, cpu: %.1f%%",
 			       worker->id, msg_allocated, msg_cache_count,
 			       msg_cache_gc_count, msg_cache_size,
 			       count_coroutine, count_coroutine_cache,
-			       worker->clients_processed);
+			       worker->clients_processed,
+			       od_atomic_u32_of(&worker->clients_active),
+			       od_atomic_u32_of(&worker->cpu_load) / 10.0);
+			for (int i = 0; i < stack_classes; i++) {
+				od_log(&instance->logger, "stats", NULL, NULL,
+				       "worker[%d]: stacks of %" PRIu64
+				       " bytes (%" PRIu64 " used, %" PRIu64
+				       " hot, %" PRIu64 " reclaimed, %" PRIu64
+				       " mapped, %" PRIu64 " hwm)",
+				       worker->id, stack_stat[i].size,
+				       stack_stat[i].count_used,
+				       stack_stat[i].count_hot,
+				       stack_stat[i].count_reclaimed,
+				       stack_stat[i].mapped, stack_stat[i].hwm);
+			}
 			break;
 		}
+		case OD_MSG_CLIENT_WAKEUP:
+			od_worker_wakeup_clients(worker);
+			break;
 		case OD_MSG_SHUTDOWN:
 			od_log(&instance->logger, "worker", NULL, NULL,
 			       "worker[%d]: shutdown message received",
@@ -120,6 +235,8 @@ static inline void od_worker(void *arg)
 		machine_msg_free(msg);
 	}
 
+	od_readahead_pool_attach(NULL);
+	od_readahead_pool_free(&worker->readahead_pool);
 	od_thread_global_free(*gl);
 
 	od_log(&instance->logger, "worker", NULL, NULL, "worker[%d] stopped",
@@ -132,6 +249,19 @@ void od_worker_init(od_worker_t *worker, od_global_t *global, int id)
 	worker->id = id;
 	worker->global = global;
 	worker->clients_processed = 0;
+	od_list_init(&worker->clients);
+	od_config_t *config = &global->instance->config;
+	od_readahead_pool_init(&worker->readahead_pool, config->readahead,
+			       config->readahead_max);
+	worker->clients_active = 0;
+	worker->cpu_load = 0;
+	worker->cpu_clock_set = 0;
+	worker->cpu_time_ns = 0;
+	worker->cpu_sample_time_us = 0;
+	worker->stacks_used = 0;
+	worker->stacks_hot = 0;
+	worker->stacks_reclaimed = 0;
+	worker->stack_hwm = 0;
 }
 
 int od_worker_start(od_worker_t *worker)
@@ -165,3 +295,35 @@ void od_worker_shutdown(od_worker_t *worker)
 	machine_msg_set_type(msg, OD_MSG_SHUTDOWN);
 	machine_channel_write(worker->task_channel, msg);
 }
+
+/*
+ * Update cpu load of the worker thread, in per mille of a single cpu.
+ *
+ * Called periodically by cron, load is smoothed with the previous
+ * value to avoid dispatch flapping between workers.
+ */
+void od_worker_update_load(od_worker_t *worker)
+{
+	if (!od_atomic_u32_of(&worker->cpu_clock_set))
+		return;
+
+	struct timespec ts;
+	if (clock_gettime(worker->cpu_clock, &ts) == -1)
+		return;
+	uint64_t cpu_time_ns = ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+	uint64_t now_us = machine_time_us();
+
+	if (worker->cpu_sample_time_us != 0 &&
+	    now_us > worker->cpu_sample_time_us) {
+		uint64_t cpu_us = (cpu_time_ns - worker->cpu_time_ns) / 1000;
+		uint64_t load = cpu_us * 1000 /
+				(now_us - worker->cpu_sample_time_us);
+		if (load > 1000)
+			load = 1000;
+		load = (od_atomic_u32_of(&worker->cpu_load) + load) / 2;
+		od_atomic_u32_set(&worker->cpu_load, (uint32_t)load);
+	}
+
+	worker->cpu_time_ns = cpu_time_ns;
+	worker->cpu_sample_time_us = now_us;
+}
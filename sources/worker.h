@@ -6,16 +6,36 @@
  * Scalable PostgreSQL connection pooler.
  */
 
-typedef struct od_worker od_worker_t;
-
 struct od_worker {
 	int64_t machine;
 	int id;
 	machine_channel_t *task_channel;
 	uint64_t clients_processed;
 	od_global_t *global;
+
+	/* client coroutines of the worker machine */
+	od_list_t clients;
+
+	/* free readahead buffers of the worker machine */
+	od_readahead_pool_t readahead_pool;
+
+	/* load, used by workers dispatch policy */
+	od_atomic_u32_t clients_active;
+	od_atomic_u32_t cpu_load;
+	od_atomic_u32_t cpu_clock_set;
+	clockid_t cpu_clock;
+	uint64_t cpu_time_ns;
+	uint64_t cpu_sample_time_us;
+
+	/* coroutine stacks, sampled by the worker machine */
+	od_atomic_u64_t stacks_used;
+	od_atomic_u64_t stacks_hot;
+	od_atomic_u64_t stacks_reclaimed;
+	od_atomic_u64_t stack_hwm;
 };
 
 void od_worker_init(od_worker_t *, od_global_t *, int);
 int od_worker_start(od_worker_t *);
 void od_worker_shutdown(od_worker_t *);
+void od_worker_update_load(od_worker_t *);
+int od_worker_client_start(od_worker_t *, od_client_t *);
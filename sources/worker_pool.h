@@ -79,8 +79,7 @@ od_worker_pool_wait_gracefully_shutdown(od_worker_pool_t *pool)
 	}
 }
 
-static inline void od_worker_pool_feed(od_worker_pool_t *pool,
-				       machine_msg_t *msg)
+static inline uint32_t od_worker_pool_round_robin(od_worker_pool_t *pool)
 {
 	uint32_t next;
 	uint32_t oldValue;
@@ -94,7 +93,122 @@ static inline void od_worker_pool_feed(od_worker_pool_t *pool,
 			break;
 	}
 
+	return next;
+}
+
+/*
+ * Scan all workers, starting from the round robin position, so equally
+ * loaded workers are still fed in turn.
+ */
+static inline uint32_t od_worker_pool_least_clients(od_worker_pool_t *pool)
+{
+	uint32_t start = od_worker_pool_round_robin(pool);
+	uint32_t next = start;
+	uint32_t min = od_atomic_u32_of(&pool->pool[start].clients_active);
+
+	for (uint32_t i = 1; i < pool->count && min > 0; i++) {
+		uint32_t id = (start + i) % pool->count;
+		uint32_t clients;
+		clients = od_atomic_u32_of(&pool->pool[id].clients_active);
+		if (clients < min) {
+			min = clients;
+			next = id;
+		}
+	}
+
+	return next;
+}
+
+/* compare by cpu load, use active clients when cpu load is close */
+static inline int od_worker_pool_cpu_less(od_worker_t *a, od_worker_t *b)
+{
+	uint32_t load_a = od_atomic_u32_of(&a->cpu_load);
+	uint32_t load_b = od_atomic_u32_of(&b->cpu_load);
+
+	/* per mille */
+	if (load_a + 50 < load_b)
+		return 1;
+	if (load_b + 50 < load_a)
+		return 0;
+
+	return od_atomic_u32_of(&a->clients_active) <
+	       od_atomic_u32_of(&b->clients_active);
+}
+
+/*
+ * Power of two random choices: pick the less loaded of two random
+ * workers. Avoids herding on a single worker, when load counters
+ * are not updated yet.
+ */
+static inline uint32_t od_worker_pool_power_of_two(od_worker_pool_t *pool,
+						   int cpu)
+{
+	uint32_t a = (uint32_t)machine_lrand48() % pool->count;
+	uint32_t b = (uint32_t)machine_lrand48() % (pool->count - 1);
+	if (b >= a)
+		b++;
+
+	od_worker_t *worker_a = &pool->pool[a];
+	od_worker_t *worker_b = &pool->pool[b];
+
+	if (cpu) {
+		if (od_worker_pool_cpu_less(worker_b, worker_a))
+			return b;
+		return a;
+	}
+
+	if (od_atomic_u32_of(&worker_b->clients_active) <
+	    od_atomic_u32_of(&worker_a->clients_active))
+		return b;
+	return a;
+}
+
+static inline void od_worker_pool_feed(od_worker_pool_t *pool,
+				       machine_msg_t *msg)
+{
+	od_instance_t *instance = pool->pool[0].global->instance;
+
+	uint32_t next = 0;
+	if (pool->count > 1) {
+		switch (instance->config.workers_policy) {
+		case OD_CONFIG_WORKERS_POLICY_LEAST_CLIENTS:
+			next = od_worker_pool_least_clients(pool);
+			break;
+		case OD_CONFIG_WORKERS_POLICY_POWER_OF_TWO:
+			next = od_worker_pool_power_of_two(pool, 0);
+			break;
+		case OD_CONFIG_WORKERS_POLICY_CPU:
+			next = od_worker_pool_power_of_two(pool, 1);
+			break;
+		default:
+			next = od_worker_pool_round_robin(pool);
+			break;
+		}
+	}
+
 	od_worker_t *worker;
 	worker = &pool->pool[next];
+	if (machine_msg_type(msg) == OD_MSG_CLIENT_NEW)
+		od_atomic_u32_inc(&worker->clients_active);
 	machine_channel_write(worker->task_channel, msg);
 }
+
+/* let workers wake up clients affected by kill, pause or shutdown */
+static inline void od_worker_pool_wakeup(od_worker_pool_t *pool)
+{
+	for (uint32_t i = 0; i < pool->count; i++) {
+		od_worker_t *worker = &pool->pool[i];
+		machine_msg_t *msg;
+		msg = machine_msg_create(0);
+		if (msg == NULL)
+			continue;
+		machine_msg_set_type(msg, OD_MSG_CLIENT_WAKEUP);
+		machine_channel_write(worker->task_channel, msg);
+	}
+}
+
+static inline void od_worker_pool_update_load(od_worker_pool_t *pool)
+{
+	for (uint32_t i = 0; i < pool->count; i++)
+		od_worker_update_load(&pool->pool[i]);
+}
@@ -13,23 +13,44 @@
 #include <inttypes.h>
 #include <math.h>
 #include <unistd.h>
+#include <stdatomic.h>
 #include <sys/time.h>
 #include <time.h>
 
 #include <machinarium.h>
 #include <kiwi.h>
+#include <sources/atomic.h>
 #include <sources/readahead.h>
 #include <sources/io.h>
 
 #include "histogram.h"
 
+typedef struct stress_worker stress_worker_t;
+
 typedef struct {
 	int id;
 	od_io_t io;
 	int coroutine_id;
 	int processed;
+	stress_worker_t *worker;
 } stress_client_t;
 
+struct stress_worker {
+	int id;
+	int64_t machine_id;
+	int clients_count;
+	stress_client_t *clients;
+	od_histogram_t histogram;
+};
+
+typedef enum {
+	STRESS_MODE_QUERY,
+	/* connect, login and disconnect on every op */
+	STRESS_MODE_RECONNECT,
+	/* connect and stay idle, measure pooler cpu usage */
+	STRESS_MODE_IDLE
+} stress_mode_t;
+
 typedef struct {
 	char *dbname;
 	char *user;
@@ -37,46 +58,38 @@ typedef struct {
 	char *port;
 	int time_to_run;
 	int clients;
+	int workers;
+	stress_mode_t mode;
+	/* pooler process to measure cpu usage of */
+	int pid;
 } stress_t;
 
 static stress_t stress;
 static od_histogram_t stress_histogram;
-static int stress_run;
+static volatile int stress_run;
+static atomic_int stress_connected;
 
-static inline void stress_client_main(void *arg)
+static inline int stress_client_connect(stress_client_t *client,
+					struct addrinfo *ai)
 {
-	stress_client_t *client = arg;
-
 	/* create client io */
 	od_io_prepare(&client->io, machine_io_create(), 8192);
 	if (client->io.io == NULL) {
 		printf("client %d: failed to create io\n", client->id);
-		return;
+		return -1;
 	}
 
 	machine_set_nodelay(client->io.io, 1);
 	machine_set_keepalive(client->io.io, 1, 7200, 75, 9, 0);
 
-	/* resolve host */
-	struct addrinfo *ai = NULL;
-	int rc;
-	rc = machine_getaddrinfo(stress.host, stress.port, NULL, &ai,
-				 UINT32_MAX);
-	if (rc == -1) {
-		printf("client %d: failed to resolve host\n", client->id);
-		return;
-	}
-
 	/* connect */
+	int rc;
 	rc = machine_connect(client->io.io, ai->ai_addr, UINT32_MAX);
-	freeaddrinfo(ai);
 	if (rc == -1) {
 		printf("client %d: failed to connect\n", client->id);
-		return;
+		return -1;
 	}
 
-	printf("client %d: connected\n", client->id);
-
 	/* handle client startup */
 	kiwi_fe_arg_t argv[] = { { "user", 5 },
 				 { stress.user, strlen(stress.user) + 1 },
@@ -86,27 +99,27 @@ static inline void stress_client_main(void *arg)
 	machine_msg_t *msg;
 	msg = kiwi_fe_write_startup_message(NULL, 4, argv);
 	if (msg == NULL)
-		return;
+		return -1;
 
 	rc = od_write(&client->io, msg);
 	if (rc == -1) {
 		printf("client %d: write error: %s\n", client->id,
 		       machine_error(client->io.io));
-		return;
+		return -1;
 	}
 
 	rc = machine_write_stop(client->io.io);
 	if (rc == -1) {
 		printf("client %d: write error: %s\n", client->id,
 		       machine_error(client->io.io));
-		return;
+		return -1;
 	}
 
 	for (;;) {
 		msg = od_read(&client->io, UINT32_MAX);
 		if (msg == NULL) {
 			printf("read error");
-			return;
+			return -1;
 		}
 		kiwi_be_type_t type = *(char *)machine_msg_data(msg);
 
@@ -114,7 +127,7 @@ static inline void stress_client_main(void *arg)
 			printf("Error response: %s\n",
 			       (char *)machine_msg_data(msg) + 5);
 			machine_msg_free(msg);
-			return;
+			return -1;
 		}
 		machine_msg_free(msg);
 
@@ -122,11 +135,65 @@ static inline void stress_client_main(void *arg)
 			break;
 	}
 
+	return 0;
+}
+
+static inline void stress_client_disconnect(stress_client_t *client)
+{
+	machine_msg_t *msg;
+	msg = kiwi_fe_write_terminate(NULL);
+	if (msg == NULL)
+		return;
+	int rc;
+	rc = od_write(&client->io, msg);
+	if (rc == -1) {
+		printf("client %d: write error: %s\n", client->id,
+		       machine_error(client->io.io));
+		return;
+	}
+
+	machine_close(client->io.io);
+}
+
+static inline void stress_client_reconnect(stress_client_t *client,
+					   struct addrinfo *ai)
+{
+	od_histogram_t *histogram = &client->worker->histogram;
+
+	while (stress_run) {
+		int start_time = od_histogram_time_us();
+
+		int rc = stress_client_connect(client, ai);
+		if (rc == -1)
+			return;
+
+		int execution_time = od_histogram_time_us() - start_time;
+		od_histogram_add(histogram, execution_time);
+		client->processed++;
+
+		stress_client_disconnect(client);
+		machine_io_free(client->io.io);
+		client->io.io = NULL;
+		od_readahead_free(&client->io.readahead);
+		od_readahead_init(&client->io.readahead);
+	}
+}
+
+static inline void stress_client_query(stress_client_t *client,
+				       struct addrinfo *ai)
+{
+	od_histogram_t *histogram = &client->worker->histogram;
+
+	int rc = stress_client_connect(client, ai);
+	if (rc == -1)
+		return;
+
 	printf("client %d: ready\n", client->id);
 
 	char query[] = "select generate_series(1,10,1)";
 
 	/* oltp */
+	machine_msg_t *msg;
 	while (stress_run) {
 		int start_time = od_histogram_time_us();
 
@@ -160,8 +227,7 @@ static inline void stress_client_main(void *arg)
 			if (type == KIWI_BE_READY_FOR_QUERY) {
 				int execution_time =
 					od_histogram_time_us() - start_time;
-				od_histogram_add(&stress_histogram,
-						 execution_time);
+				od_histogram_add(histogram, execution_time);
 				client->processed++;
 				break;
 			}
@@ -169,58 +235,213 @@ static inline void stress_client_main(void *arg)
 	}
 
 	/* finish */
-	msg = kiwi_fe_write_terminate(NULL);
-	if (msg == NULL)
+	stress_client_disconnect(client);
+}
+
+static inline void stress_client_idle(stress_client_t *client,
+				      struct addrinfo *ai)
+{
+	int rc = stress_client_connect(client, ai);
+	if (rc == -1)
 		return;
-	rc = od_write(&client->io, msg);
+	atomic_fetch_add(&stress_connected, 1);
+
+	while (stress_run)
+		machine_sleep(1000);
+
+	stress_client_disconnect(client);
+}
+
+static inline void stress_client_main(void *arg)
+{
+	stress_client_t *client = arg;
+
+	/* resolve host */
+	struct addrinfo *ai = NULL;
+	int rc;
+	rc = machine_getaddrinfo(stress.host, stress.port, NULL, &ai,
+				 UINT32_MAX);
 	if (rc == -1) {
-		printf("client %d: write error: %s\n", client->id,
-		       machine_error(client->io.io));
+		printf("client %d: failed to resolve host\n", client->id);
 		return;
 	}
 
-	machine_close(client->io.io);
+	switch (stress.mode) {
+	case STRESS_MODE_QUERY:
+		stress_client_query(client, ai);
+		break;
+	case STRESS_MODE_RECONNECT:
+		stress_client_reconnect(client, ai);
+		break;
+	case STRESS_MODE_IDLE:
+		stress_client_idle(client, ai);
+		break;
+	}
+	freeaddrinfo(ai);
+
 	printf("client %d: done (%d processed)\n", client->id,
 	       client->processed);
 }
 
-static inline void stress_main(void *arg)
+static inline void stress_worker_main(void *arg)
+{
+	stress_worker_t *worker = arg;
+
+	/* create clients */
+	int i = 0;
+	for (; i < worker->clients_count; i++) {
+		stress_client_t *client = &worker->clients[i];
+		client->coroutine_id =
+			machine_coroutine_create(stress_client_main, client);
+	}
+
+	/* wait for completion */
+	for (i = 0; i < worker->clients_count; i++) {
+		stress_client_t *client = &worker->clients[i];
+		machine_join(client->coroutine_id);
+		if (client->io.io)
+			machine_io_free(client->io.io);
+	}
+}
+
+static inline void stress_histogram_merge(od_histogram_t *dst,
+					  od_histogram_t *src)
+{
+	if (src->count == 0)
+		return;
+	if (dst->count == 0 || dst->min > src->min)
+		dst->min = src->min;
+	if (dst->max < src->max)
+		dst->max = src->max;
+	dst->total += src->total;
+	dst->count += src->count;
+	for (int i = 0; i < OD_HISTOGRAM_COUNT; i++)
+		dst->buckets[i] += src->buckets[i];
+}
+
+/* user and system cpu time of the process in clock ticks */
+static inline int stress_cpu_ticks(int pid, uint64_t *ticks)
+{
+	char path[64];
+	snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+	FILE *file = fopen(path, "r");
+	if (file == NULL)
+		return -1;
+	char buf[1024];
+	size_t size = fread(buf, 1, sizeof(buf) - 1, file);
+	fclose(file);
+	buf[size] = 0;
+
+	/* skip pid and comm, utime and stime are 14th and 15th fields */
+	char *pos = strrchr(buf, ')');
+	if (pos == NULL)
+		return -1;
+	unsigned long long utime, stime;
+	if (sscanf(pos + 2,
+		   "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu",
+		   &utime, &stime) != 2)
+		return -1;
+	*ticks = utime + stime;
+	return 0;
+}
+
+static inline void stress_idle_measure(stress_t *stress)
 {
-	stress_t *stress = arg;
+	/* wait for clients to connect, no more than a minute */
+	for (int i = 0; i < 600; i++) {
+		if (atomic_load(&stress_connected) == stress->clients)
+			break;
+		usleep(100 * 1000);
+	}
+	int connected = atomic_load(&stress_connected);
+	printf("idle clients connected: %d\n", connected);
+
+	uint64_t start_ticks = 0;
+	if (stress->pid && stress_cpu_ticks(stress->pid, &start_ticks) == -1) {
+		printf("failed to read cpu usage of pid %d\n", stress->pid);
+		stress->pid = 0;
+	}
 
+	sleep(stress->time_to_run);
+
+	uint64_t end_ticks;
+	if (stress->pid && stress_cpu_ticks(stress->pid, &end_ticks) == 0) {
+		double cpu_sec = (double)(end_ticks - start_ticks);
+		cpu_sec /= sysconf(_SC_CLK_TCK);
+		printf("pooler cpu: %.2f sec in %d sec (%.2f%%) with %d idle "
+		       "clients\n",
+		       cpu_sec, stress->time_to_run,
+		       cpu_sec * 100.0 / stress->time_to_run, connected);
+	}
+}
+
+static inline int stress_main(stress_t *stress)
+{
 	stress_client_t *clients;
 	clients = calloc(stress->clients, sizeof(stress_client_t));
 	if (clients == NULL)
-		return;
+		return -1;
+
+	stress_worker_t *workers;
+	workers = calloc(stress->workers, sizeof(stress_worker_t));
+	if (workers == NULL) {
+		free(clients);
+		return -1;
+	}
 
 	stress_run = 1;
 
-	/* create workers */
+	/* spread clients between workers */
 	int i = 0;
-	for (; i < stress->clients; i++) {
-		stress_client_t *client = &clients[i];
-		client->id = i;
-		client->coroutine_id =
-			machine_coroutine_create(stress_client_main, client);
+	int offset = 0;
+	for (; i < stress->workers; i++) {
+		stress_worker_t *worker = &workers[i];
+		worker->id = i;
+		worker->clients = &clients[offset];
+		worker->clients_count = stress->clients / stress->workers;
+		if (i < stress->clients % stress->workers)
+			worker->clients_count++;
+		od_histogram_init(&worker->histogram);
+		for (int j = 0; j < worker->clients_count; j++) {
+			stress_client_t *client = &worker->clients[j];
+			client->id = offset + j;
+			client->worker = worker;
+		}
+		offset += worker->clients_count;
+	}
+
+	for (i = 0; i < stress->workers; i++) {
+		stress_worker_t *worker = &workers[i];
+		worker->machine_id = machine_create("stresser",
+						    stress_worker_main, worker);
 	}
 
 	/* give time for work */
-	machine_sleep(stress->time_to_run * 1000);
+	if (stress->mode == STRESS_MODE_IDLE)
+		stress_idle_measure(stress);
+	else
+		sleep(stress->time_to_run);
 
 	stress_run = 0;
 
 	/* wait for completion and calculate stats */
-	for (i = 0; i < stress->clients; i++) {
-		stress_client_t *client = &clients[i];
-		machine_join(client->coroutine_id);
-		if (client->io.io)
-			machine_io_free(client->io.io);
+	int rc = 0;
+	for (i = 0; i < stress->workers; i++) {
+		stress_worker_t *worker = &workers[i];
+		if (worker->machine_id == -1) {
+			rc = -1;
+			continue;
+		}
+		machine_wait(worker->machine_id);
+		stress_histogram_merge(&stress_histogram, &worker->histogram);
 	}
+	free(workers);
 	free(clients);
 
 	/* result */
 	od_histogram_print(&stress_histogram, stress->clients,
 			   stress->time_to_run);
+	return rc;
 }
 
 int main(int argc, char *argv[])
@@ -237,9 +458,11 @@ int main(int argc, char *argv[])
 	stress.port = "6432";
 	stress.time_to_run = 5;
 	stress.clients = 10;
+	stress.workers = 1;
+	stress.mode = STRESS_MODE_QUERY;
 
 	int opt;
-	while ((opt = getopt(argc, argv, "d:u:h:p:t:c:")) != -1) {
+	while ((opt = getopt(argc, argv, "d:u:h:p:t:c:w:riP:")) != -1) {
 		switch (opt) {
 		/* database */
 		case 'd':
@@ -265,9 +488,25 @@ int main(int argc, char *argv[])
 		case 'c':
 			stress.clients = atoi(optarg);
 			break;
+			/* workers */
+		case 'w':
+			stress.workers = atoi(optarg);
+			break;
+			/* reconnect mode */
+		case 'r':
+			stress.mode = STRESS_MODE_RECONNECT;
+			break;
+			/* idle mode */
+		case 'i':
+			stress.mode = STRESS_MODE_IDLE;
+			break;
+			/* pooler pid */
+		case 'P':
+			stress.pid = atoi(optarg);
+			break;
 		default:
 			printf("PostgreSQL benchmarking.\n\n");
-			printf("usage: %s [duhptc]\n", argv[0]);
+			printf("usage: %s [duhptcwriP]\n", argv[0]);
 			printf("  \n");
 			printf("  -d <database>   database name\n");
 			printf("  -u <user>       user name\n");
@@ -275,6 +514,10 @@ int main(int argc, char *argv[])
 			printf("  -p <port>       server port\n");
 			printf("  -t <time>       time to run (seconds)\n");
 			printf("  -c <clients>    number of clients\n");
+			printf("  -w <workers>    number of worker threads\n");
+			printf("  -r              reconnect on every op, measures logins/sec\n");
+			printf("  -i              connect and stay idle\n");
+			printf("  -P <pid>        pooler pid, cpu usage in idle mode\n");
 			return 1;
 		}
 	}
@@ -282,18 +525,27 @@ int main(int argc, char *argv[])
 	printf("PostgreSQL benchmarking.\n\n");
 	printf("time to run: %d secs\n", stress.time_to_run);
 	printf("clients:     %d\n", stress.clients);
+	printf("workers:     %d\n", stress.workers);
+	char *mode = "query";
+	if (stress.mode == STRESS_MODE_RECONNECT)
+		mode = "reconnect";
+	else if (stress.mode == STRESS_MODE_IDLE)
+		mode = "idle";
+	printf("mode:        %s\n", mode);
 	printf("database:    %s\n", stress.dbname);
 	printf("user:        %s\n", stress.user);
 	printf("host:        %s\n", stress.host);
 	printf("port:        %s\n", stress.port);
 	printf("\n");
 
-	machinarium_init();
+	if (stress.workers <= 0 || stress.clients <= 0) {
+		printf("workers and clients must be positive\n");
+		return 1;
+	}
 
-	int64_t machine;
-	machine = machine_create("stresser", stress_main, &stress);
+	machinarium_init();
 
-	int rc = machine_wait(machine);
+	int rc = stress_main(&stress);
 
 	machinarium_free();
 	return rc;
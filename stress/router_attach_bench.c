@@ -0,0 +1,291 @@
+/*
+ * Odyssey.
+ *
+ * Scalable PostgreSQL connection pooler.
+ */
+
+/*
+ * Route server pool contention benchmark.
+ *
+ * Worker machines run client coroutines of a single transaction pooling
+ * route, every coroutine attaches to an idle server of the route and
+ * detaches from it in a loop, as every transaction does. Servers are
+ * preallocated and are not connected, so only router and server pool
+ * bookkeeping is measured.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <kiwi.h>
+#include <machinarium.h>
+#include <odyssey.h>
+
+typedef struct {
+	od_router_t *router;
+	od_route_t *route;
+	od_storage_endpoint_t *endpoints;
+	int endpoints_count;
+	int clients;
+	int cycles;
+	int id;
+	od_atomic_u64_t *failed;
+} bench_worker_t;
+
+static od_global_t bench_global;
+static od_instance_t bench_instance;
+
+static inline double bench_time_sec(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static inline int bench_io_prepare(od_io_t *io)
+{
+	od_io_init(io);
+	/* never connected, attach to event loop is a no-op failure */
+	machine_io_t *io_obj = machine_io_create();
+	if (io_obj == NULL)
+		return -1;
+	return od_io_prepare(io, io_obj, 0);
+}
+
+typedef struct {
+	bench_worker_t *worker;
+	int n;
+} bench_client_arg_t;
+
+static void bench_client(void *arg)
+{
+	bench_client_arg_t *client_arg = arg;
+	bench_worker_t *worker = client_arg->worker;
+	od_route_t *route = worker->route;
+
+	od_client_t *client = od_client_allocate();
+	if (client == NULL || bench_io_prepare(&client->io) == -1)
+		abort();
+	client->global = &bench_global;
+	client->route = route;
+
+	od_route_lock(route);
+	od_client_pool_set(&route->client_pool, client, OD_CLIENT_PENDING);
+	od_route_unlock(route);
+
+	od_storage_endpoint_t *endpoint;
+	endpoint = &worker->endpoints[client_arg->n % worker->endpoints_count];
+	for (int i = 0; i < worker->cycles; i++) {
+		od_router_status_t status;
+		status = od_router_attach(worker->router, client, false,
+					  &endpoint->address);
+		if (status != OD_ROUTER_OK) {
+			od_atomic_u64_inc(worker->failed);
+			continue;
+		}
+		od_router_detach(worker->router, client);
+	}
+
+	od_route_lock(route);
+	od_client_pool_set(&route->client_pool, client, OD_CLIENT_UNDEF);
+	od_route_unlock(route);
+	machine_io_free(client->io.io);
+	od_client_free(client);
+}
+
+static void bench_worker(void *arg)
+{
+	bench_worker_t *worker = arg;
+	bench_client_arg_t *args;
+	args = calloc(worker->clients, sizeof(bench_client_arg_t));
+	int64_t *ids = calloc(worker->clients, sizeof(int64_t));
+	if (args == NULL || ids == NULL)
+		abort();
+
+	for (int i = 0; i < worker->clients; i++) {
+		args[i].worker = worker;
+		args[i].n = worker->id * worker->clients + i;
+		ids[i] = machine_coroutine_create(bench_client, &args[i]);
+		if (ids[i] == -1)
+			abort();
+	}
+	for (int i = 0; i < worker->clients; i++)
+		machine_join(ids[i]);
+
+	free(args);
+	free(ids);
+}
+
+typedef struct {
+	od_route_t *route;
+	od_storage_endpoint_t *endpoints;
+	int endpoints_count;
+	int servers;
+} bench_setup_t;
+
+/* servers init needs machine context */
+static void bench_servers_create(void *arg)
+{
+	bench_setup_t *setup = arg;
+	od_route_t *route = setup->route;
+	od_storage_endpoint_t *endpoints = setup->endpoints;
+	int endpoints_count = setup->endpoints_count;
+	int servers = setup->servers;
+
+	for (int e = 0; e < endpoints_count; e++) {
+		od_multi_pool_element_t *element;
+		element = od_multi_pool_get_or_create(route->server_pools,
+						      &endpoints[e].address);
+		if (element == NULL)
+			abort();
+		for (int i = 0; i < servers; i++) {
+			od_server_t *server = od_server_allocate(0);
+			if (server == NULL ||
+			    bench_io_prepare(&server->io) == -1)
+				abort();
+			od_id_generate(&server->id, "s");
+			server->global = &bench_global;
+			server->route = route;
+			server->pool_element = element;
+			od_multi_pool_element_lock(element);
+			od_server_set_pool_state(server, OD_SERVER_IDLE);
+			od_multi_pool_element_unlock(element);
+		}
+	}
+}
+
+static inline double bench_run(od_router_t *router, od_route_t *route,
+				od_storage_endpoint_t *endpoints,
+				int endpoints_count, int threads, int clients,
+				int cycles)
+{
+	od_atomic_u64_t failed = 0;
+	bench_worker_t *workers = calloc(threads, sizeof(bench_worker_t));
+	int64_t *ids = calloc(threads, sizeof(int64_t));
+	if (workers == NULL || ids == NULL)
+		abort();
+
+	double start = bench_time_sec();
+	for (int i = 0; i < threads; i++) {
+		workers[i].router = router;
+		workers[i].route = route;
+		workers[i].endpoints = endpoints;
+		workers[i].endpoints_count = endpoints_count;
+		workers[i].clients = clients;
+		workers[i].cycles = cycles;
+		workers[i].id = i;
+		workers[i].failed = &failed;
+		ids[i] = machine_create("router_bench", bench_worker,
+					&workers[i]);
+		if (ids[i] == -1)
+			abort();
+	}
+	for (int i = 0; i < threads; i++)
+		machine_wait(ids[i]);
+	double elapsed = bench_time_sec() - start;
+
+	free(workers);
+	free(ids);
+
+	if (failed) {
+		printf("%" PRIu64 " attaches failed\n", failed);
+		abort();
+	}
+	return (double)threads * clients * cycles / elapsed;
+}
+
+int main(int argc, char *argv[])
+{
+	int threads = 4;
+	int clients = 64;
+	int servers = 16;
+	int endpoints_count = 1;
+	int cycles = 20000;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "t:c:s:e:n:")) != -1) {
+		switch (opt) {
+		case 't':
+			threads = atoi(optarg);
+			break;
+		case 'c':
+			clients = atoi(optarg);
+			break;
+		case 's':
+			servers = atoi(optarg);
+			break;
+		case 'e':
+			endpoints_count = atoi(optarg);
+			break;
+		case 'n':
+			cycles = atoi(optarg);
+			break;
+		default:
+			printf("usage: %s [-t threads] [-c clients per thread] "
+			       "[-s servers per endpoint] [-e endpoints] "
+			       "[-n cycles per client]\n",
+			       argv[0]);
+			return 1;
+		}
+	}
+	if (threads < 1 || clients < 1 || servers < 1 || cycles < 1 ||
+	    endpoints_count < 1 || endpoints_count > OD_STORAGE_MAX_ENDPOINTS)
+		return 1;
+
+	machinarium_init();
+
+	memset(&bench_instance, 0, sizeof(bench_instance));
+	memset(&bench_global, 0, sizeof(bench_global));
+	bench_global.instance = &bench_instance;
+
+	od_router_t router;
+	memset(&router, 0, sizeof(router));
+
+	od_rules_t rules;
+	od_rules_init(&rules);
+	od_rule_t *rule = od_rules_add(&rules);
+	if (rule == NULL)
+		return 1;
+	rule->pool->pool_type = OD_RULE_POOL_TRANSACTION;
+	rule->pool->size = servers * endpoints_count;
+	rule->pool->timeout = 0;
+	rule->storage = od_rules_storage_allocate();
+	if (rule->storage == NULL)
+		return 1;
+	rule->storage->server_max_routing = 1;
+
+	char hosts[OD_STORAGE_MAX_ENDPOINTS * 24];
+	int pos = 0;
+	for (int i = 0; i < endpoints_count; i++) {
+		pos += snprintf(hosts + pos, sizeof(hosts) - pos, "%s10.0.%d.1",
+				i ? "," : "", i);
+	}
+	od_storage_endpoint_t *endpoints;
+	size_t count;
+	if (od_storage_parse_endpoints(hosts, &endpoints, &count) != 0)
+		return 1;
+
+	od_route_t *route = od_route_allocate();
+	if (route == NULL)
+		return 1;
+	route->rule = rule;
+	bench_setup_t setup = { route, endpoints, endpoints_count, servers };
+	int64_t id = machine_create("router_bench_setup", bench_servers_create,
+				    &setup);
+	if (id == -1)
+		return 1;
+	machine_wait(id);
+
+	printf("threads: %d, clients per thread: %d, endpoints: %d, "
+	       "servers per endpoint: %d\n\n",
+	       threads, clients, endpoints_count, servers);
+
+	double rate = bench_run(&router, route, endpoints, endpoints_count,
+				threads, clients, cycles);
+	printf("attach/detach: %12.0f cycles/sec\n", rate);
+
+	machinarium_free();
+	return 0;
+}
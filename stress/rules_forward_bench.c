@@ -0,0 +1,207 @@
+/*
+ * Odyssey.
+ *
+ * Scalable PostgreSQL connection pooler.
+ */
+
+/*
+ * Rules forwarding microbenchmark.
+ *
+ * Loads generated rules the same way config reload does and measures
+ * od_rules_forward() throughput with full rules scan and with compiled
+ * rules index, checking that both agree on every lookup.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <kiwi.h>
+#include <machinarium.h>
+#include <odyssey.h>
+
+typedef struct {
+	char db[64];
+	char user[64];
+	struct sockaddr_storage addr;
+} bench_client_t;
+
+static inline void bench_rule_add(od_rules_t *rules, char *db, char *user,
+				  char *range)
+{
+	od_rule_t *rule = od_rules_add(rules);
+	if (rule == NULL)
+		abort();
+	rule->pool->routing = OD_RULE_POOL_CLIENT_VISIBLE;
+
+	rule->db_is_default = db == NULL;
+	rule->db_name = strdup(db ? db : "default");
+	rule->db_name_len = strlen(rule->db_name);
+	rule->user_is_default = user == NULL;
+	rule->user_name = strdup(user ? user : "default");
+	rule->user_name_len = strlen(rule->user_name);
+
+	if (range == NULL) {
+		rule->address_range = od_address_range_create_default();
+		return;
+	}
+
+	char addr[64];
+	strcpy(addr, range);
+	char *prefix = strchr(addr, '/');
+	*prefix++ = 0;
+	rule->address_range.string_value = strdup(range);
+	rule->address_range.string_value_len = strlen(range);
+	if (od_address_read(&rule->address_range.addr, addr) == -1 ||
+	    od_address_range_read_prefix(&rule->address_range, prefix) == -1)
+		abort();
+}
+
+static inline void bench_rules_generate(od_rules_t *rules, int count)
+{
+	char db[64];
+	char user[64];
+	char range[64];
+	for (int i = 0; i < count; i++) {
+		snprintf(db, sizeof(db), "db%d", i % (count / 10 + 1));
+		snprintf(user, sizeof(user), "user%d", i);
+		switch (i % 10) {
+		case 0:
+			bench_rule_add(rules, db, NULL, NULL);
+			break;
+		case 1:
+			snprintf(range, sizeof(range), "10.%d.0.0/16",
+				 i % 256);
+			bench_rule_add(rules, db, user, range);
+			break;
+		case 2:
+			bench_rule_add(rules, NULL, user, NULL);
+			break;
+		default:
+			bench_rule_add(rules, db, user, NULL);
+			break;
+		}
+	}
+	bench_rule_add(rules, NULL, NULL, "10.0.0.0/8");
+	bench_rule_add(rules, NULL, NULL, NULL);
+}
+
+static inline double bench_time_sec(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static inline double bench_run(od_rules_t *rules, bench_client_t *clients,
+			       int clients_count, int iterations,
+			       int sequential)
+{
+	double start = bench_time_sec();
+	for (int n = 0; n < iterations; n++) {
+		bench_client_t *client = &clients[n % clients_count];
+		od_rule_t *rule;
+		rule = od_rules_forward(rules, client->db, client->user,
+					&client->addr, 0, sequential);
+		if (rule == NULL)
+			abort();
+	}
+	return iterations / (bench_time_sec() - start);
+}
+
+int main(int argc, char *argv[])
+{
+	int rules_count = 10000;
+	int iterations = 100000;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "r:n:")) != -1) {
+		switch (opt) {
+		case 'r':
+			rules_count = atoi(optarg);
+			break;
+		case 'n':
+			iterations = atoi(optarg);
+			break;
+		default:
+			printf("usage: %s [-r rules] [-n iterations]\n",
+			       argv[0]);
+			return 1;
+		}
+	}
+
+	/* load rules as reload does */
+	od_rules_t src;
+	od_rules_t rules;
+	od_rules_init(&src);
+	od_rules_init(&rules);
+	bench_rules_generate(&src, rules_count);
+
+	od_list_t added, deleted, to_drop;
+	od_list_init(&added);
+	od_list_init(&deleted);
+	od_list_init(&to_drop);
+	od_rules_merge(&rules, &src, &added, &deleted, &to_drop);
+	if (!rules.index.valid) {
+		printf("failed to build rules index\n");
+		return 1;
+	}
+
+	int clients_count = 1024;
+	bench_client_t *clients = calloc(clients_count, sizeof(*clients));
+	if (clients == NULL)
+		return 1;
+	srand(0);
+	for (int i = 0; i < clients_count; i++) {
+		bench_client_t *client = &clients[i];
+		int n = rand() % (rules_count + rules_count / 10);
+		snprintf(client->db, sizeof(client->db), "db%d",
+			 n % (rules_count / 10 + 1));
+		snprintf(client->user, sizeof(client->user), "user%d", n);
+		char addr[64];
+		snprintf(addr, sizeof(addr), "10.%d.%d.1", rand() % 256,
+			 rand() % 256);
+		od_address_read(&client->addr, addr);
+	}
+
+	/* both ways must choose the same rule */
+	for (int sequential = 0; sequential <= 1; sequential++) {
+		for (int i = 0; i < clients_count; i++) {
+			bench_client_t *client = &clients[i];
+			od_rule_t *indexed;
+			indexed = od_rules_forward(&rules, client->db,
+						   client->user, &client->addr,
+						   0, sequential);
+			rules.index.valid = 0;
+			od_rule_t *scanned;
+			scanned = od_rules_forward(&rules, client->db,
+						   client->user, &client->addr,
+						   0, sequential);
+			rules.index.valid = 1;
+			if (indexed != scanned) {
+				printf("mismatch for %s.%s (sequential %d)\n",
+				       client->db, client->user, sequential);
+				return 1;
+			}
+		}
+	}
+
+	printf("rules: %d, iterations: %d\n\n", rules_count, iterations);
+	for (int sequential = 0; sequential <= 1; sequential++) {
+		rules.index.valid = 0;
+		double scan = bench_run(&rules, clients, clients_count,
+					iterations / 100 + 1, sequential);
+		rules.index.valid = 1;
+		double index = bench_run(&rules, clients, clients_count,
+					 iterations, sequential);
+		printf("%-10s routing: scan %12.0f forwards/sec, "
+		       "index %12.0f forwards/sec\n",
+		       sequential ? "sequential" : "default", scan, index);
+	}
+
+	free(clients);
+	od_rules_free(&rules);
+	od_rules_free(&src);
+	return 0;
+}
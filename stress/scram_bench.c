@@ -0,0 +1,178 @@
+/*
+ * Odyssey.
+ *
+ * Scalable PostgreSQL connection pooler.
+ */
+
+/*
+ * SCRAM login throughput benchmark.
+ *
+ * Runs the pooler side of SCRAM-SHA-256 for every login: server keys
+ * derivation from auth_query plain password (frontend) and client
+ * proof for the server connection (backend), with and without derived
+ * keys cache, and reports logins/sec per core.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <kiwi.h>
+#include <machinarium.h>
+#include <odyssey.h>
+
+typedef struct {
+	od_scram_cache_t *cache;
+	int users;
+	int logins;
+	int seed;
+	int failed;
+} bench_worker_t;
+
+static inline double bench_time_sec(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static inline int bench_login(od_scram_cache_t *cache, char *user,
+			      char *password)
+{
+	/* client -> pooler */
+	od_scram_state_t frontend;
+	od_scram_state_init(&frontend);
+	frontend.cache = cache;
+	int rc = od_scram_init_from_plain_password(&frontend, password, user);
+	if (rc == -1) {
+		od_scram_state_free(&frontend);
+		return -1;
+	}
+
+	/* pooler -> server, server uses the same salt for a user */
+	od_scram_state_t backend;
+	od_scram_state_init(&backend);
+	backend.cache = cache;
+	machine_msg_t *msg;
+	msg = od_scram_create_client_first_message(&backend);
+	if (msg == NULL) {
+		od_scram_state_free(&frontend);
+		return -1;
+	}
+	machine_msg_free(msg);
+
+	char server_first[256];
+	int size = od_snprintf(server_first, sizeof(server_first),
+			       "r=%sserver,s=%s,i=%d", backend.client_nonce,
+			       frontend.salt, frontend.iterations);
+	msg = od_scram_create_client_final_message(&backend, password,
+						   server_first, size);
+	rc = msg == NULL ? -1 : 0;
+	if (msg)
+		machine_msg_free(msg);
+
+	od_scram_state_free(&backend);
+	od_scram_state_free(&frontend);
+	return rc;
+}
+
+static void bench_worker(void *arg)
+{
+	bench_worker_t *worker = arg;
+	char user[64];
+	char password[64];
+	unsigned int seed = worker->seed;
+	for (int i = 0; i < worker->logins; i++) {
+		int n = rand_r(&seed) % worker->users;
+		snprintf(user, sizeof(user), "user%d", n);
+		snprintf(password, sizeof(password), "password%d", n);
+		if (bench_login(worker->cache, user, password) == -1)
+			worker->failed++;
+	}
+}
+
+static inline double bench_run(od_scram_cache_t *cache, int threads,
+			       int users, int logins)
+{
+	bench_worker_t *workers = calloc(threads, sizeof(bench_worker_t));
+	int64_t *ids = calloc(threads, sizeof(int64_t));
+	if (workers == NULL || ids == NULL)
+		abort();
+
+	double start = bench_time_sec();
+	for (int i = 0; i < threads; i++) {
+		workers[i].cache = cache;
+		workers[i].users = users;
+		workers[i].logins = logins;
+		workers[i].seed = i;
+		ids[i] = machine_create("scram_bench", bench_worker,
+					&workers[i]);
+		if (ids[i] == -1)
+			abort();
+	}
+	for (int i = 0; i < threads; i++)
+		machine_wait(ids[i]);
+	double elapsed = bench_time_sec() - start;
+
+	for (int i = 0; i < threads; i++) {
+		if (workers[i].failed) {
+			printf("%d logins failed\n", workers[i].failed);
+			abort();
+		}
+	}
+	free(workers);
+	free(ids);
+
+	/* workers are cpu bound, one per core */
+	return (double)logins / elapsed;
+}
+
+int main(int argc, char *argv[])
+{
+	int threads = 1;
+	int users = 100;
+	int logins = 1000;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "t:u:n:")) != -1) {
+		switch (opt) {
+		case 't':
+			threads = atoi(optarg);
+			break;
+		case 'u':
+			users = atoi(optarg);
+			break;
+		case 'n':
+			logins = atoi(optarg);
+			break;
+		default:
+			printf("usage: %s [-t threads] [-u users] "
+			       "[-n logins per thread]\n",
+			       argv[0]);
+			return 1;
+		}
+	}
+	if (threads < 1 || users < 1 || logins < 1)
+		return 1;
+
+	machinarium_init();
+
+	printf("threads: %d, users: %d, logins per thread: %d\n\n", threads,
+	       users, logins);
+
+	double uncached = bench_run(NULL, threads, users, logins);
+	printf("no cache:   %10.0f logins/sec per core\n", uncached);
+
+	od_scram_cache_t *cache = od_scram_cache_create();
+	if (cache == NULL)
+		return 1;
+	double cached = bench_run(cache, threads, users, logins);
+	printf("keys cache: %10.0f logins/sec per core "
+	       "(hits %" PRIu64 ", misses %" PRIu64 ")\n",
+	       cached, cache->hits, cache->misses);
+	od_scram_cache_free(cache);
+
+	machinarium_free();
+	return 0;
+}
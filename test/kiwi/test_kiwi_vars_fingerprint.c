@@ -0,0 +1,68 @@
+#include <kiwi.h>
+#include <odyssey_test.h>
+
+void test_vars_fingerprint_order()
+{
+	kiwi_vars_t a;
+	kiwi_vars_t b;
+
+	kiwi_vars_init(&a);
+	kiwi_vars_init(&b);
+	test(a.fingerprint == b.fingerprint);
+
+	kiwi_vars_set(&a, KIWI_VAR_TIMEZONE, "UTC", 4);
+	test(a.fingerprint != b.fingerprint);
+	kiwi_vars_set(&a, KIWI_VAR_SEARCH_PATH, "public", 7);
+
+	/* same vars set in another order */
+	kiwi_vars_set(&b, KIWI_VAR_SEARCH_PATH, "public", 7);
+	kiwi_vars_set(&b, KIWI_VAR_TIMEZONE, "UTC", 4);
+	test(a.fingerprint == b.fingerprint);
+
+	/* overwritten value */
+	kiwi_vars_set(&b, KIWI_VAR_TIMEZONE, "CET", 4);
+	test(a.fingerprint != b.fingerprint);
+	kiwi_vars_update(&b, "TimeZone", 9, "UTC", 4);
+	test(a.fingerprint == b.fingerprint);
+
+	/* same value of another var */
+	kiwi_vars_unset(&b, KIWI_VAR_SEARCH_PATH);
+	kiwi_vars_set(&b, KIWI_VAR_APPLICATION_NAME, "public", 7);
+	test(a.fingerprint != b.fingerprint);
+
+	kiwi_vars_unset(&a, KIWI_VAR_TIMEZONE);
+	kiwi_vars_unset(&a, KIWI_VAR_SEARCH_PATH);
+	test(a.fingerprint == 0);
+}
+
+void test_vars_fingerprint_deployable()
+{
+	kiwi_vars_t client;
+	kiwi_vars_t server;
+
+	kiwi_vars_init(&client);
+	kiwi_vars_init(&server);
+
+	/* never deployed vars do not change fingerprint */
+	kiwi_vars_set(&client, KIWI_VAR_COMPRESSION, "on", 3);
+	kiwi_vars_set(&client, KIWI_VAR_ODYSSEY_TARGET_SESSION_ATTRS,
+		      "read-write", 11);
+	test(client.fingerprint == 0);
+
+	kiwi_vars_set(&client, KIWI_VAR_DATESTYLE, "ISO", 4);
+	kiwi_vars_set(&server, KIWI_VAR_DATESTYLE, "ISO", 4);
+	test(client.fingerprint == server.fingerprint);
+
+	/* equal fingerprints, nothing to deploy */
+	char query[512];
+	test(kiwi_vars_cas(&client, &server, query, sizeof(query)) == 0);
+
+	kiwi_vars_override(&client, &server);
+	test(client.fingerprint == server.fingerprint);
+}
+
+void kiwi_test_vars_fingerprint()
+{
+	test_vars_fingerprint_order();
+	test_vars_fingerprint_deployable();
+}
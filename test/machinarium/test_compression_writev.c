@@ -0,0 +1,178 @@
+
+#include <machinarium.h>
+#include <odyssey_test.h>
+
+#include <string.h>
+#include <arpa/inet.h>
+
+#define TEST_PACKETS 1000
+#define TEST_PACKET_SIZE 100
+#define TEST_LARGE_SIZE (1024 * 1024)
+#define TEST_TOTAL (TEST_PACKETS * TEST_PACKET_SIZE + TEST_LARGE_SIZE)
+
+static char algorithm;
+
+static inline void test_fill(char *data, int size, int offset)
+{
+	for (int i = 0; i < size; i++)
+		data[i] = 'a' + (offset + i) % 13;
+}
+
+static void server(void *arg)
+{
+	(void)arg;
+	machine_io_t *server = machine_io_create();
+	test(server != NULL);
+
+	struct sockaddr_in sa;
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = inet_addr("127.0.0.1");
+	sa.sin_port = htons(7778);
+	int rc;
+	rc = machine_bind(server, (struct sockaddr *)&sa,
+			  MM_BINDWITH_SO_REUSEADDR);
+	test(rc == 0);
+
+	machine_io_t *client;
+	rc = machine_accept(server, &client, 16, 1, UINT32_MAX);
+	test(rc == 0);
+
+	rc = machine_set_compression(client, algorithm);
+	test(rc == 0);
+
+	/* many small packets written as one iovec */
+	char *packets = malloc(TEST_PACKETS * TEST_PACKET_SIZE);
+	test(packets != NULL);
+	test_fill(packets, TEST_PACKETS * TEST_PACKET_SIZE, 0);
+
+	machine_iov_t *iov = machine_iov_create();
+	test(iov != NULL);
+	for (int i = 0; i < TEST_PACKETS; i++)
+		machine_iov_add_pointer(iov, packets + i * TEST_PACKET_SIZE,
+					TEST_PACKET_SIZE);
+
+	machine_cond_t *on_write = machine_cond_create();
+	test(on_write != NULL);
+	rc = machine_write_start(client, on_write);
+	test(rc == 0);
+	while (machine_iov_pending(iov)) {
+		rc = machine_writev_raw(client, iov);
+		if (rc == -1) {
+			int errno_ = machine_errno();
+			test(errno_ == EAGAIN || errno_ == EWOULDBLOCK ||
+			     errno_ == EINTR);
+			machine_cond_wait(on_write, UINT32_MAX);
+		}
+	}
+	rc = machine_write_stop(client);
+	test(rc == 0);
+	machine_cond_free(on_write);
+	machine_iov_free(iov);
+
+	/* large message */
+	machine_msg_t *msg;
+	msg = machine_msg_create(TEST_LARGE_SIZE);
+	test(msg != NULL);
+	test_fill(machine_msg_data(msg), TEST_LARGE_SIZE,
+		  TEST_PACKETS * TEST_PACKET_SIZE);
+	rc = machine_write(client, msg, UINT32_MAX);
+	test(rc == 0);
+
+	uint64_t tx_raw, tx, rx_raw, rx;
+	test(machine_compression_stat(client, &tx_raw, &tx, &rx_raw, &rx) ==
+	     algorithm);
+	test(tx_raw == TEST_TOTAL);
+	test(tx > 0 && tx < tx_raw);
+
+	/* wait for client to read everything */
+	msg = machine_read(client, 1, UINT32_MAX);
+	test(msg == NULL);
+
+	free(packets);
+
+	rc = machine_close(client);
+	test(rc == 0);
+	machine_io_free(client);
+
+	rc = machine_close(server);
+	test(rc == 0);
+	machine_io_free(server);
+}
+
+static void client(void *arg)
+{
+	(void)arg;
+	machine_io_t *client = machine_io_create();
+	test(client != NULL);
+
+	struct sockaddr_in sa;
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = inet_addr("127.0.0.1");
+	sa.sin_port = htons(7778);
+	int rc;
+	rc = machine_connect(client, (struct sockaddr *)&sa, UINT32_MAX);
+	test(rc == 0);
+
+	rc = machine_set_compression(client, algorithm);
+	test(rc == 0);
+
+	machine_msg_t *msg;
+	msg = machine_read(client, TEST_TOTAL, UINT32_MAX);
+	test(msg != NULL);
+
+	char *expected = malloc(TEST_TOTAL);
+	test(expected != NULL);
+	test_fill(expected, TEST_TOTAL, 0);
+	test(memcmp(machine_msg_data(msg), expected, TEST_TOTAL) == 0);
+	free(expected);
+	machine_msg_free(msg);
+
+	uint64_t tx_raw, tx, rx_raw, rx;
+	test(machine_compression_stat(client, &tx_raw, &tx, &rx_raw, &rx) ==
+	     algorithm);
+	test(rx_raw == TEST_TOTAL);
+	test(rx > 0 && rx < rx_raw);
+
+	rc = machine_close(client);
+	test(rc == 0);
+	machine_io_free(client);
+}
+
+static void test_cs(void *arg)
+{
+	(void)arg;
+	/* 'f' - zstd, 'z' - zlib, 'l' - lz4, whatever is built in */
+	char algorithms[] = "fzl";
+	for (char *name = algorithms; *name; name++) {
+		char alg[2] = { *name, 0 };
+		algorithm = machine_compression_choose_alg(alg);
+		if (algorithm == MM_ZPQ_NO_COMPRESSION)
+			continue;
+
+		int server_id;
+		server_id = machine_coroutine_create(server, NULL);
+		test(server_id != -1);
+
+		int client_id;
+		client_id = machine_coroutine_create(client, NULL);
+		test(client_id != -1);
+
+		machine_join(client_id);
+		machine_join(server_id);
+	}
+}
+
+void machinarium_test_compression_writev(void)
+{
+	machinarium_init();
+
+	int id;
+	id = machine_create("test", test_cs, NULL);
+	test(id != -1);
+
+	int rc;
+	rc = machine_wait(id);
+	test(rc != -1);
+
+	machinarium_free();
+}
@@ -0,0 +1,86 @@
+#include <machinarium.h>
+#include <odyssey_test.h>
+
+#include <arpa/inet.h>
+
+static void test_client(void *arg)
+{
+	(void)arg;
+	machine_io_t *client = machine_io_create();
+	test(client != NULL);
+
+	struct sockaddr_in sa;
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = inet_addr("127.0.0.1");
+	sa.sin_port = htons(7779);
+	int rc;
+	rc = machine_connect(client, (struct sockaddr *)&sa, UINT32_MAX);
+	test(rc == 0);
+
+	rc = machine_close(client);
+	test(rc == 0);
+	machine_io_free(client);
+}
+
+static void test_server(void *arg)
+{
+	(void)arg;
+	struct sockaddr_in sa;
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = inet_addr("127.0.0.1");
+	sa.sin_port = htons(7779);
+
+	/* every socket of the group must listen before next one is bound */
+	machine_io_t *server[2];
+	int rc;
+	for (int i = 0; i < 2; i++) {
+		server[i] = machine_io_create();
+		test(server[i] != NULL);
+		rc = machine_bind(server[i], (struct sockaddr *)&sa,
+				  MM_BINDWITH_SO_REUSEADDR |
+					  MM_BINDWITH_SO_REUSEPORT);
+		test(rc == 0);
+		rc = machine_listen(server[i], 16);
+		test(rc == 0);
+	}
+
+	int64_t id;
+	id = machine_coroutine_create(test_client, NULL);
+	test(id != -1);
+
+	/* connection is accepted by one of the sockets */
+	int accepted = 0;
+	for (int i = 0; i < 2; i++) {
+		machine_io_t *client;
+		rc = machine_accept(server[i], &client, 16, 1, 100);
+		if (rc == -1) {
+			test(machine_timedout());
+			continue;
+		}
+		accepted++;
+		machine_close(client);
+		machine_io_free(client);
+	}
+	test(accepted == 1);
+
+	for (int i = 0; i < 2; i++) {
+		rc = machine_close(server[i]);
+		test(rc == 0);
+		machine_io_free(server[i]);
+	}
+}
+
+void machinarium_test_listen_reuseport(void)
+{
+	machinarium_init();
+
+	int id;
+	id = machine_create("test", test_server, NULL);
+	test(id != -1);
+
+	int rc;
+	rc = machine_wait(id);
+	test(rc != -1);
+
+	machinarium_free();
+}
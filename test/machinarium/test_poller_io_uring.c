@@ -0,0 +1,127 @@
+
+#include <machinarium.h>
+#include <odyssey_test.h>
+
+#include <string.h>
+#include <arpa/inet.h>
+
+/* io_uring poller is optional: loop must fall back to epoll */
+
+static int packets = 10000;
+static int packet_size = 64;
+
+static void server(void *arg)
+{
+	(void)arg;
+	machine_io_t *server = machine_io_create();
+	test(server != NULL);
+
+	struct sockaddr_in sa;
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = inet_addr("127.0.0.1");
+	sa.sin_port = htons(7778);
+	int rc;
+	rc = machine_bind(server, (struct sockaddr *)&sa,
+			  MM_BINDWITH_SO_REUSEADDR);
+	test(rc == 0);
+
+	machine_io_t *client;
+	rc = machine_accept(server, &client, 16, 1, UINT32_MAX);
+	test(rc == 0);
+
+	/* echo every packet back */
+	for (;;) {
+		machine_msg_t *msg;
+		msg = machine_read(client, packet_size, UINT32_MAX);
+		if (msg == NULL)
+			break;
+		rc = machine_write(client, msg, UINT32_MAX);
+		test(rc == 0);
+	}
+
+	rc = machine_close(client);
+	test(rc == 0);
+	machine_io_free(client);
+
+	rc = machine_close(server);
+	test(rc == 0);
+	machine_io_free(server);
+}
+
+static void client(void *arg)
+{
+	(void)arg;
+	machine_io_t *client = machine_io_create();
+	test(client != NULL);
+
+	struct sockaddr_in sa;
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = inet_addr("127.0.0.1");
+	sa.sin_port = htons(7778);
+	int rc;
+	rc = machine_connect(client, (struct sockaddr *)&sa, UINT32_MAX);
+	test(rc == 0);
+
+	int i;
+	for (i = 0; i < packets; i++) {
+		machine_msg_t *msg;
+		msg = machine_msg_create(0);
+		test(msg != NULL);
+		rc = machine_msg_write(msg, NULL, packet_size);
+		test(rc == 0);
+		memset(machine_msg_data(msg), 'a' + i % 26, packet_size);
+		rc = machine_write(client, msg, UINT32_MAX);
+		test(rc == 0);
+
+		msg = machine_read(client, packet_size, UINT32_MAX);
+		test(msg != NULL);
+		char *data = machine_msg_data(msg);
+		test(data[0] == 'a' + i % 26);
+		test(data[packet_size - 1] == 'a' + i % 26);
+		machine_msg_free(msg);
+	}
+
+	/* read must time out with nothing to read */
+	machine_msg_t *msg;
+	msg = machine_read(client, packet_size, 10);
+	test(msg == NULL);
+	test(machine_timedout());
+
+	rc = machine_close(client);
+	test(rc == 0);
+	machine_io_free(client);
+}
+
+static void test_cs(void *arg)
+{
+	(void)arg;
+	const char *poller = machine_poller();
+	test(strcmp(poller, "io_uring") == 0 || strcmp(poller, "epoll") == 0);
+
+	int rc;
+	rc = machine_coroutine_create(server, NULL);
+	test(rc != -1);
+
+	rc = machine_coroutine_create(client, NULL);
+	test(rc != -1);
+
+	/* timers must fire with no io activity */
+	machine_sleep(10);
+}
+
+void machinarium_test_poller_io_uring(void)
+{
+	machinarium_set_poller(MACHINE_POLLER_IO_URING);
+	machinarium_init();
+
+	int id;
+	id = machine_create("test", test_cs, NULL);
+	test(id != -1);
+
+	int rc;
+	rc = machine_wait(id);
+	test(rc != -1);
+
+	machinarium_free();
+	machinarium_set_poller(MACHINE_POLLER_EPOLL);
+}
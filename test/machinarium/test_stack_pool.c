@@ -0,0 +1,89 @@
+#include <machinarium.h>
+#include <odyssey_test.h>
+#include <string.h>
+#include <unistd.h>
+
+static void test_deep(void *arg)
+{
+	(void)arg;
+	/* volatile stores are kept at any optimization level */
+	volatile char buf[8192];
+	for (size_t i = 0; i < sizeof(buf); i++)
+		buf[i] = (char)0xff;
+}
+
+static void test_sleeper(void *arg)
+{
+	(void)arg;
+	machine_sleep(10);
+}
+
+static void test_stacks(void *arg)
+{
+	(void)arg;
+	uint64_t page_size = sysconf(_SC_PAGESIZE);
+	machine_stack_stat_t stat[MACHINE_STACK_CLASSES_MAX];
+
+	/* main coroutine stack */
+	int count = machine_stack_stat(stat, MACHINE_STACK_CLASSES_MAX);
+	test(count == 1);
+	test(stat[0].size == 4 * page_size);
+	test(stat[0].count_used == 1);
+	test(stat[0].mapped > 0);
+
+	int64_t id = machine_coroutine_create(test_deep, NULL);
+	test(id != -1);
+	test(machine_join(id) == 0);
+	machine_sleep(0);
+
+	count = machine_stack_stat(stat, MACHINE_STACK_CLASSES_MAX);
+	test(count == 1);
+	test(stat[0].count_used == 1);
+	test(stat[0].count_hot == 1);
+	test(stat[0].hwm >= 8192);
+	test(stat[0].hwm < 4 * page_size);
+
+	/* stack size class of its own */
+	id = machine_coroutine_create_sized(test_deep, NULL, "big", 16);
+	test(id != -1);
+	test(machine_join(id) == 0);
+	machine_sleep(0);
+
+	count = machine_stack_stat(stat, MACHINE_STACK_CLASSES_MAX);
+	test(count == 2);
+	test(stat[1].size == 16 * page_size);
+	test(stat[1].count_used == 0);
+	test(stat[1].count_hot == 1);
+	test(stat[1].hwm >= 8192);
+
+	/* idle stacks over the hot limit are reclaimed */
+	for (int i = 0; i < 100; i++) {
+		id = machine_coroutine_create(test_sleeper, NULL);
+		test(id != -1);
+	}
+	count = machine_stack_stat(stat, MACHINE_STACK_CLASSES_MAX);
+	test(stat[0].count_used == 101);
+	machine_sleep(100);
+
+	count = machine_stack_stat(stat, MACHINE_STACK_CLASSES_MAX);
+	test(stat[0].count_used == 1);
+	test(stat[0].count_hot == 64);
+	test(stat[0].count_reclaimed > 0);
+
+	machine_stop_current();
+}
+
+void machinarium_test_stack_pool(void)
+{
+	machinarium_init();
+
+	int id;
+	id = machine_create("test", test_stacks, NULL);
+	test(id != -1);
+
+	int rc;
+	rc = machine_wait(id);
+	test(rc != -1);
+
+	machinarium_free();
+}
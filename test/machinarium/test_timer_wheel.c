@@ -0,0 +1,118 @@
+#include <machinarium.h>
+#include <assert.h>
+#include <macro.h>
+#include <list.h>
+#include <timer.h>
+#include <clock.h>
+#include <odyssey_test.h>
+
+static uint64_t fired_last;
+static int fired_count;
+static int fired_wrong;
+
+static void test_timer_wheel_cb(mm_timer_t *timer)
+{
+	mm_clock_t *clock = timer->clock;
+	/* fired in timeout order exactly at timeout */
+	if (timer->timeout < fired_last || timer->timeout != clock->time_ms)
+		fired_wrong++;
+	fired_last = timer->timeout;
+	fired_count++;
+}
+
+static void test_timer_wheel_run(mm_clock_t *clock, uint64_t until)
+{
+	while (clock->time_ms < until) {
+		uint64_t deadline;
+		if (mm_clock_deadline(clock, &deadline) == -1)
+			break;
+		/* poll wakes up exactly at deadline */
+		test(deadline >= clock->time_ms);
+		if (deadline > until)
+			deadline = until;
+		clock->time_ms = deadline;
+		mm_clock_step(clock);
+	}
+}
+
+/*
+ * Step may leave the wheel right on a boundary of a coarse slot, which
+ * is not cascaded yet, its timers must not be missed by the deadline.
+ */
+static void test_timer_wheel_boundary(int level, uint32_t interval)
+{
+	mm_clock_t clock;
+	mm_clock_init(&clock);
+	clock.time_ms = 100;
+
+	mm_timer_t timer;
+	mm_timer_init(&timer, test_timer_wheel_cb, NULL, interval);
+	mm_clock_timer_add(&clock, &timer);
+	test(timer.slot / MM_CLOCK_WHEEL_SLOTS == level);
+
+	/* io wakeup one millisecond before the boundary */
+	int shift = level * MM_CLOCK_WHEEL_BITS;
+	uint64_t boundary = ((clock.time_ms >> shift) + 1) << shift;
+	clock.time_ms = boundary - 1;
+	mm_clock_step(&clock);
+	test(clock.wheel_time == boundary);
+
+	uint64_t deadline;
+	test(mm_clock_deadline(&clock, &deadline) == 0);
+	test(deadline <= timer.timeout);
+
+	fired_last = 0;
+	fired_count = 0;
+	fired_wrong = 0;
+	test_timer_wheel_run(&clock, timer.timeout + 1);
+	test(fired_count == 1);
+	test(fired_wrong == 0);
+
+	mm_clock_free(&clock);
+}
+
+void machinarium_test_timer_wheel(void)
+{
+	test_timer_wheel_boundary(1, 65);
+	test_timer_wheel_boundary(2, 5000);
+
+	mm_clock_t clock;
+	mm_clock_init(&clock);
+	clock.time_ms = 123456789;
+
+	int count = 1000;
+	mm_timer_t timers[count];
+	uint32_t seed = 1;
+	for (int i = 0; i < count; i++) {
+		seed = seed * 1103515245 + 12345;
+		/* from milliseconds up to hours */
+		uint32_t interval = seed % (1U << (i % 24));
+		mm_timer_init(&timers[i], test_timer_wheel_cb, NULL, interval);
+		mm_clock_timer_add(&clock, &timers[i]);
+	}
+	test(clock.timers_count == count);
+
+	/* every third timer is stopped */
+	for (int i = 0; i < count; i += 3)
+		mm_clock_timer_del(&clock, &timers[i]);
+	int left = clock.timers_count;
+	test(left == count - (count + 2) / 3);
+
+	fired_last = 0;
+	fired_count = 0;
+	fired_wrong = 0;
+	test_timer_wheel_run(&clock, clock.time_ms + (1ULL << 24));
+	test(fired_count == left);
+	test(fired_wrong == 0);
+	test(clock.timers_count == 0);
+
+	/* already due timer fires on next step */
+	mm_timer_t timer;
+	mm_timer_init(&timer, test_timer_wheel_cb, NULL, 0);
+	mm_clock_timer_add(&clock, &timer);
+	mm_clock_step(&clock);
+	test(timer.active == 0);
+	test(fired_count == left + 1);
+
+	mm_clock_free(&clock);
+}
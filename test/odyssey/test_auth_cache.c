@@ -0,0 +1,212 @@
+#include "odyssey.h"
+#include <odyssey_test.h>
+
+static od_auth_cache_policy_t test_auth_cache_policy = {
+	.ttl = 1000, .negative_ttl = 100, .refresh = 500
+};
+
+static void test_auth_cache_put_password(od_auth_cache_t *cache, char *user,
+					 char *passwd, uint64_t now)
+{
+	kiwi_password_t password;
+	password.password = passwd;
+	password.password_len = strlen(passwd) + 1;
+	test(od_auth_cache_put(cache, user, strlen(user) + 1,
+			       OD_AUTH_CACHE_PASSWORD, &password,
+			       now) == OK_RESPONSE);
+}
+
+static od_auth_cache_result_t test_auth_cache_get(od_auth_cache_t *cache,
+						  char *user, uint64_t now,
+						  kiwi_password_t *password,
+						  int *refresh)
+{
+	kiwi_password_init(password);
+	return od_auth_cache_get(cache, user, strlen(user) + 1,
+				 &test_auth_cache_policy, now, password,
+				 refresh);
+}
+
+static void test_auth_cache_ttl(void *arg)
+{
+	(void)arg;
+	od_auth_cache_t *cache = od_auth_cache_create();
+	test(cache != NULL);
+
+	kiwi_password_t password;
+	int refresh;
+
+	/* first lookup becomes a leader */
+	test(test_auth_cache_get(cache, "alice", 0, &password, &refresh) ==
+	     OD_AUTH_CACHE_MISS);
+	test_auth_cache_put_password(cache, "alice", "secret", 0);
+
+	test(test_auth_cache_get(cache, "alice", 100, &password, &refresh) ==
+	     OD_AUTH_CACHE_HIT);
+	test(refresh == 0);
+	test(strcmp(password.password, "secret") == 0);
+	kiwi_password_free(&password);
+
+	/* stale hit schedules exactly one refresh */
+	test(test_auth_cache_get(cache, "alice", 600, &password, &refresh) ==
+	     OD_AUTH_CACHE_HIT);
+	test(refresh == 1);
+	kiwi_password_free(&password);
+	test(test_auth_cache_get(cache, "alice", 700, &password, &refresh) ==
+	     OD_AUTH_CACHE_HIT);
+	test(refresh == 0);
+	kiwi_password_free(&password);
+	test_auth_cache_put_password(cache, "alice", "renewed", 700);
+
+	test(test_auth_cache_get(cache, "alice", 1500, &password, &refresh) ==
+	     OD_AUTH_CACHE_HIT);
+	test(strcmp(password.password, "renewed") == 0);
+	test(refresh == 1);
+	kiwi_password_free(&password);
+
+	/* failed refresh keeps previous password */
+	test(od_auth_cache_put(cache, "alice", 6, OD_AUTH_CACHE_EMPTY, NULL,
+			       1600) == OK_RESPONSE);
+	test(test_auth_cache_get(cache, "alice", 1650, &password, &refresh) ==
+	     OD_AUTH_CACHE_HIT);
+	test(strcmp(password.password, "renewed") == 0);
+	test(refresh == 1);
+	kiwi_password_free(&password);
+	test(od_auth_cache_put(cache, "alice", 6, OD_AUTH_CACHE_EMPTY, NULL,
+			       1650) == OK_RESPONSE);
+
+	/* expired */
+	test(test_auth_cache_get(cache, "alice", 1700, &password, &refresh) ==
+	     OD_AUTH_CACHE_MISS);
+	test(od_auth_cache_put(cache, "alice", 6, OD_AUTH_CACHE_EMPTY, NULL,
+			       1700) == OK_RESPONSE);
+
+	/* negative entries */
+	test(test_auth_cache_get(cache, "bob", 0, &password, &refresh) ==
+	     OD_AUTH_CACHE_MISS);
+	test(od_auth_cache_put(cache, "bob", 4, OD_AUTH_CACHE_NOT_FOUND, NULL,
+			       0) == OK_RESPONSE);
+	test(test_auth_cache_get(cache, "bob", 50, &password, &refresh) ==
+	     OD_AUTH_CACHE_HIT_NOT_FOUND);
+	test(test_auth_cache_get(cache, "bob", 150, &password, &refresh) ==
+	     OD_AUTH_CACHE_MISS);
+	test(od_auth_cache_put(cache, "bob", 4, OD_AUTH_CACHE_EMPTY, NULL,
+			       150) == OK_RESPONSE);
+
+	/* reload drops cached passwords */
+	od_auth_cache_invalidate(cache);
+	test(test_auth_cache_get(cache, "alice", 1700, &password, &refresh) ==
+	     OD_AUTH_CACHE_MISS);
+	test(od_auth_cache_put(cache, "alice", 6, OD_AUTH_CACHE_EMPTY, NULL,
+			       1700) == OK_RESPONSE);
+
+	/* grow */
+	char user[32];
+	for (int i = 0; i < 1000; i++) {
+		od_snprintf(user, sizeof(user), "user%d", i);
+		test_auth_cache_put_password(cache, user, user, 0);
+	}
+	/* bob was dropped on reload */
+	test(od_auth_cache_count(cache) == 1001);
+	for (int i = 0; i < 1000; i++) {
+		od_snprintf(user, sizeof(user), "user%d", i);
+		test(test_auth_cache_get(cache, user, 1, &password,
+					 &refresh) == OD_AUTH_CACHE_HIT);
+		test(strcmp(password.password, user) == 0);
+		kiwi_password_free(&password);
+	}
+
+	test(cache->hits == 1005);
+	test(cache->negative_hits == 1);
+	test(cache->misses == 5);
+	test(cache->refreshes == 3);
+
+	/* expired entries are dropped instead of growing the table */
+	uint32_t size = cache->size;
+	for (int i = 0; i < 5000; i++) {
+		uint64_t now = 2000 + (uint64_t)i * 10;
+		od_snprintf(user, sizeof(user), "unknown%d", i);
+		test(test_auth_cache_get(cache, user, now, &password,
+					 &refresh) == OD_AUTH_CACHE_MISS);
+		test(od_auth_cache_put(cache, user, strlen(user) + 1,
+				       OD_AUTH_CACHE_NOT_FOUND, NULL,
+				       now) == OK_RESPONSE);
+	}
+	test(cache->size == size);
+	test(od_auth_cache_count(cache) <= size);
+
+	od_auth_cache_free(cache);
+}
+
+typedef struct {
+	od_auth_cache_t *cache;
+	int result;
+} test_auth_cache_waiter_t;
+
+static void test_auth_cache_waiter(void *arg)
+{
+	test_auth_cache_waiter_t *waiter = arg;
+	kiwi_password_t password;
+	int refresh;
+	waiter->result = test_auth_cache_get(waiter->cache, "carol", 10,
+					     &password, &refresh);
+	if (waiter->result == OD_AUTH_CACHE_HIT) {
+		test(strcmp(password.password, "carol") == 0);
+		kiwi_password_free(&password);
+	}
+}
+
+static void test_auth_cache_single_flight(void *arg)
+{
+	(void)arg;
+	od_auth_cache_t *cache = od_auth_cache_create();
+	test(cache != NULL);
+
+	kiwi_password_t password;
+	int refresh;
+	test(test_auth_cache_get(cache, "carol", 0, &password, &refresh) ==
+	     OD_AUTH_CACHE_MISS);
+
+	test_auth_cache_waiter_t waiters[4];
+	for (int i = 0; i < 4; i++) {
+		waiters[i].cache = cache;
+		waiters[i].result = -1;
+		test(machine_coroutine_create(test_auth_cache_waiter,
+					      &waiters[i]) != -1);
+	}
+
+	/* let waiters park on in-flight lookup */
+	machine_sleep(50);
+	for (int i = 0; i < 4; i++) {
+		test(waiters[i].result == -1);
+	}
+	test(cache->waits == 4);
+
+	test_auth_cache_put_password(cache, "carol", "carol", 0);
+
+	/* waiters are woken up and served from cache */
+	machine_sleep(50);
+	for (int i = 0; i < 4; i++) {
+		test(waiters[i].result == OD_AUTH_CACHE_HIT);
+	}
+	test(cache->misses == 1);
+
+	od_auth_cache_free(cache);
+}
+
+void odyssey_test_auth_cache(void)
+{
+	machinarium_init();
+
+	int id;
+	id = machine_create("test_auth_cache_ttl", test_auth_cache_ttl, NULL);
+	test(id != -1);
+	test(machine_wait(id) != -1);
+
+	id = machine_create("test_auth_cache_single_flight",
+			    test_auth_cache_single_flight, NULL);
+	test(id != -1);
+	test(machine_wait(id) != -1);
+
+	machinarium_free();
+}
@@ -0,0 +1,108 @@
+#include "odyssey.h"
+#include <odyssey_test.h>
+
+typedef struct {
+	od_crypto_pool_t *pool;
+	uint64_t caller;
+	uint64_t executor;
+	int value;
+	int result;
+} test_crypto_pool_task_t;
+
+static int test_crypto_pool_function(void *arg)
+{
+	test_crypto_pool_task_t *task = arg;
+	task->executor = machine_self();
+	/* let other tasks run on the same crypto machine */
+	machine_sleep(10);
+	return task->value * 2;
+}
+
+static void test_crypto_pool_caller(void *arg)
+{
+	test_crypto_pool_task_t *task = arg;
+	task->caller = machine_self();
+	task->result = od_crypto_pool_run(task->pool, OD_CRYPTO_SCRAM_BACKEND,
+					  test_crypto_pool_function, task);
+}
+
+static void test_crypto_pool_inline(void *arg)
+{
+	(void)arg;
+	od_crypto_pool_t pool;
+	od_crypto_pool_init(&pool);
+	test(od_crypto_pool_start(&pool, 0, 0) == OK_RESPONSE);
+	test(!od_crypto_pool_enabled(&pool));
+
+	test_crypto_pool_task_t task;
+	memset(&task, 0, sizeof(task));
+	task.pool = &pool;
+	task.value = 21;
+	test_crypto_pool_caller(&task);
+	test(task.result == 42);
+	test(task.executor == task.caller);
+
+	od_crypto_stat_t *stat = &pool.stat[OD_CRYPTO_SCRAM_BACKEND];
+	test(stat->inline_count == 1);
+	test(stat->exec.count == 1);
+	test(stat->queue.count == 0);
+	od_crypto_pool_free(&pool);
+}
+
+static void test_crypto_pool_offload(void *arg)
+{
+	(void)arg;
+	od_crypto_pool_t pool;
+	od_crypto_pool_init(&pool);
+	test(od_crypto_pool_start(&pool, 2, 0) == OK_RESPONSE);
+	test(od_crypto_pool_enabled(&pool));
+
+	test_crypto_pool_task_t tasks[16];
+	for (int i = 0; i < 16; i++) {
+		memset(&tasks[i], 0, sizeof(tasks[i]));
+		tasks[i].pool = &pool;
+		tasks[i].value = i;
+		tasks[i].result = -1;
+		test(machine_coroutine_create(test_crypto_pool_caller,
+					      &tasks[i]) != -1);
+	}
+
+	/* tasks sleep concurrently on crypto machines */
+	machine_sleep(200);
+	for (int i = 0; i < 16; i++) {
+		test(tasks[i].result == i * 2);
+		test(tasks[i].executor != 0);
+		test(tasks[i].executor != tasks[i].caller);
+	}
+
+	od_crypto_stat_t *stat = &pool.stat[OD_CRYPTO_SCRAM_BACKEND];
+	test(stat->inline_count == 0);
+	test(stat->exec.count == 16);
+	test(stat->queue.count == 16);
+	test(pool.queued == 0);
+	test(od_hist_quantile(&stat->exec, 0.5) >= 8192);
+
+	od_crypto_pool_stop(&pool);
+	od_crypto_pool_free(&pool);
+}
+
+void odyssey_test_crypto_pool(void)
+{
+	machinarium_init();
+
+	test(od_hist_bucket_le(0) == 64);
+	test(od_hist_bucket_le(OD_HIST_BUCKETS - 1) == 0);
+
+	int id;
+	id = machine_create("test_crypto_pool_inline", test_crypto_pool_inline,
+			    NULL);
+	test(id != -1);
+	test(machine_wait(id) != -1);
+
+	id = machine_create("test_crypto_pool_offload",
+			    test_crypto_pool_offload, NULL);
+	test(id != -1);
+	test(machine_wait(id) != -1);
+
+	machinarium_free();
+}
@@ -0,0 +1,139 @@
+#include "odyssey.h"
+#include <odyssey_test.h>
+
+static void test_multi_pool_free(od_server_pool_t *pool)
+{
+	(void)pool;
+}
+
+static void test_multi_pool_address(od_address_t *address,
+				    od_address_type_t type, char *host,
+				    int port)
+{
+	od_address_init(address);
+	address->type = type;
+	address->host = host;
+	address->port = port;
+}
+
+static void test_multi_pool_waiters(od_multi_pool_element_t *element)
+{
+	od_multi_pool_waiter_t waiters[3];
+	for (int i = 0; i < 3; i++) {
+		waiters[i].start_us = i;
+		waiters[i].priority_class = 0;
+		waiters[i].weight = 1;
+		waiters[i].flag = machine_wait_flag_create();
+		test(waiters[i].flag != NULL);
+		od_multi_pool_element_wait(element, &waiters[i]);
+	}
+	test(element->waiters_count == 3);
+
+	/* cancelled waiter leaves the queue */
+	od_multi_pool_element_wait_cancel(element, &waiters[1]);
+	test(element->waiters_count == 2);
+
+	/* fifo, the oldest waiter gets the server */
+	od_server_t *server = (od_server_t *)&waiters;
+	test(od_multi_pool_element_wake(element, server) == &waiters[0]);
+	test(waiters[0].woken && waiters[0].server == server);
+
+	/* woken waiter is not in the queue any more */
+	od_multi_pool_element_wait_cancel(element, &waiters[0]);
+	test(element->waiters_count == 1);
+
+	test(od_multi_pool_element_wake(element, NULL) == &waiters[2]);
+	test(waiters[2].woken && waiters[2].server == NULL);
+	test(od_multi_pool_element_wake(element, NULL) == NULL);
+	test(element->waiters_count == 0);
+
+	for (int i = 0; i < 3; i++) {
+		machine_wait_flag_destroy(waiters[i].flag);
+	}
+}
+
+static void test_multi_pool_priority(od_multi_pool_element_t *element)
+{
+	/* class 1 is four times heavier than the default one */
+	od_multi_pool_waiter_t waiters[20];
+	for (int i = 0; i < 20; i++) {
+		waiters[i].start_us = i;
+		waiters[i].priority_class = i % 2;
+		waiters[i].weight = i % 2 ? 4 : 1;
+		waiters[i].flag = machine_wait_flag_create();
+		test(waiters[i].flag != NULL);
+		od_multi_pool_element_wait(element, &waiters[i]);
+	}
+
+	int served[2] = { 0, 0 };
+	for (int i = 0; i < 10; i++) {
+		od_multi_pool_waiter_t *waiter;
+		waiter = od_multi_pool_element_wake(element, NULL);
+		test(waiter != NULL);
+		served[waiter->priority_class]++;
+	}
+	test(served[0] == 2 && served[1] == 8);
+
+	/* fifo within a class */
+	test(od_multi_pool_element_wake(element, NULL) == &waiters[17]);
+
+	while (od_multi_pool_element_wake(element, NULL) != NULL)
+		;
+	test(element->waiters_count == 0);
+
+	for (int i = 0; i < 20; i++) {
+		machine_wait_flag_destroy(waiters[i].flag);
+	}
+}
+
+void odyssey_test_multi_pool(void)
+{
+	od_multi_pool_t *mpool;
+	mpool = od_multi_pool_create(OD_STORAGE_MAX_ENDPOINTS,
+				     test_multi_pool_free);
+	test(mpool != NULL);
+
+	od_address_t address;
+	test_multi_pool_address(&address, OD_ADDRESS_TYPE_TCP, "10.0.0.1", 5432);
+	test(od_multi_pool_get(mpool, &address) == NULL);
+
+	od_multi_pool_element_t *element;
+	element = od_multi_pool_get_or_create(mpool, &address);
+	test(element != NULL);
+	test(element->address.host != address.host);
+	test(od_multi_pool_get(mpool, &address) == element);
+	test(od_multi_pool_get_or_create(mpool, &address) == element);
+
+	/* same host on other port and unix socket are other pools */
+	test_multi_pool_address(&address, OD_ADDRESS_TYPE_TCP, "10.0.0.1", 6432);
+	test(od_multi_pool_get(mpool, &address) == NULL);
+	test_multi_pool_address(&address, OD_ADDRESS_TYPE_UNIX, "10.0.0.1", 0);
+	test(od_multi_pool_get(mpool, &address) == NULL);
+
+	/* fill up to capacity, every address keeps its element */
+	char hosts[OD_STORAGE_MAX_ENDPOINTS][32];
+	od_multi_pool_element_t *elements[OD_STORAGE_MAX_ENDPOINTS];
+	elements[0] = element;
+	for (int i = 1; i < OD_STORAGE_MAX_ENDPOINTS; i++) {
+		od_snprintf(hosts[i], sizeof(hosts[i]), "host-%d", i);
+		test_multi_pool_address(&address, OD_ADDRESS_TYPE_TCP,
+					hosts[i], 5432);
+		elements[i] = od_multi_pool_get_or_create(mpool, &address);
+		test(elements[i] != NULL);
+	}
+	for (int i = 1; i < OD_STORAGE_MAX_ENDPOINTS; i++) {
+		test_multi_pool_address(&address, OD_ADDRESS_TYPE_TCP,
+					hosts[i], 5432);
+		test(od_multi_pool_get(mpool, &address) == elements[i]);
+	}
+
+	test_multi_pool_address(&address, OD_ADDRESS_TYPE_TCP, "overflow", 1);
+	test(od_multi_pool_get_or_create(mpool, &address) == NULL);
+
+	test(od_multi_pool_total(mpool) == 0);
+
+	test_multi_pool_waiters(element);
+	test_multi_pool_priority(element);
+
+	od_multi_pool_destroy(mpool);
+}
@@ -0,0 +1,71 @@
+#include "odyssey.h"
+#include <odyssey_test.h>
+
+/* one second of traffic: waits and queries with given averages */
+static void test_pool_controller_tick(od_pool_sample_t *sample, int waits,
+				      uint64_t wait_us, uint64_t latency_us)
+{
+	sample->wait_count += waits;
+	sample->wait_sum_us += waits * wait_us;
+	sample->query_count += 100;
+	sample->query_time_us += 100 * latency_us;
+}
+
+void odyssey_test_pool_controller(void)
+{
+	od_pool_controller_t controller;
+	od_pool_controller_init(&controller, 0, 50);
+	test(od_pool_controller_target(&controller) == 1);
+
+	od_pool_sample_t sample;
+	memset(&sample, 0, sizeof(sample));
+
+	/* clients queue, latency is stable: additive increase */
+	int prev = 1;
+	for (int i = 0; i < 8; i++) {
+		test_pool_controller_tick(&sample, 10, 5000, 1000);
+		sample.waiting = 5;
+		test(od_pool_controller_step(&controller, &sample, 0, 50) ==
+		     OD_POOL_SIZE_GROW);
+		int target = od_pool_controller_target(&controller);
+		test(target > prev);
+		prev = target;
+	}
+	test(controller.latency_base_us >= 1000);
+
+	/* bounded by pool_size */
+	for (int i = 0; i < 20; i++) {
+		test_pool_controller_tick(&sample, 10, 5000, 1000);
+		od_pool_controller_step(&controller, &sample, 0, 50);
+	}
+	test(od_pool_controller_target(&controller) == 50);
+	test(od_pool_controller_step(&controller, &sample, 0, 50) ==
+	     OD_POOL_SIZE_HOLD);
+
+	/* latency triples: backend is saturated, multiplicative decrease */
+	test_pool_controller_tick(&sample, 10, 5000, 3500);
+	test(od_pool_controller_step(&controller, &sample, 0, 50) ==
+	     OD_POOL_SIZE_BACKOFF);
+	test(od_pool_controller_target(&controller) == 38);
+
+	/* nobody waits and servers are idle: release one by one */
+	sample.waiting = 0;
+	test_pool_controller_tick(&sample, 0, 0, 1000);
+	sample.idle = 30;
+	test(od_pool_controller_step(&controller, &sample, 0, 50) ==
+	     OD_POOL_SIZE_SHRINK);
+	test(od_pool_controller_target(&controller) == 37);
+
+	/* down to min_pool_size */
+	for (int i = 0; i < 100; i++) {
+		test_pool_controller_tick(&sample, 0, 0, 1000);
+		od_pool_controller_step(&controller, &sample, 5, 50);
+	}
+	test(od_pool_controller_target(&controller) == 5);
+
+	/* short waits of a busy pool are not a queue */
+	sample.idle = 0;
+	test_pool_controller_tick(&sample, 10, 100, 1000);
+	test(od_pool_controller_step(&controller, &sample, 5, 50) ==
+	     OD_POOL_SIZE_HOLD);
+}
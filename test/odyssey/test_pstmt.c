@@ -0,0 +1,140 @@
+#include "odyssey.h"
+#include <odyssey_test.h>
+
+static od_pstmt_t *test_pstmt_acquire(od_pstmt_store_t *store, char *body)
+{
+	uint32_t len = strlen(body) + 1;
+	return od_pstmt_store_acquire(store, od_murmur_hash(body, len), body,
+				      len);
+}
+
+static void test_pstmt_store_intern(void)
+{
+	od_pstmt_store_t store;
+	test(od_pstmt_store_init(&store) == OK_RESPONSE);
+
+	od_pstmt_t *a = test_pstmt_acquire(&store, "select 1");
+	od_pstmt_t *b = test_pstmt_acquire(&store, "select 1");
+	od_pstmt_t *c = test_pstmt_acquire(&store, "select 2");
+	test(a != NULL && c != NULL);
+	test(a == b);
+	test(a != c);
+	test(a->refs == 2);
+	test(od_pstmt_store_count(&store) == 2);
+
+	od_pstmt_store_release(&store, a);
+	od_pstmt_store_release(&store, b);
+	od_pstmt_store_release(&store, c);
+	test(od_pstmt_store_count(&store) == 0);
+
+	/* grow stripes */
+	char body[64];
+	od_pstmt_t *stmts[10000];
+	for (int i = 0; i < 10000; i++) {
+		od_snprintf(body, sizeof(body), "select %d", i);
+		stmts[i] = test_pstmt_acquire(&store, body);
+		test(stmts[i] != NULL);
+	}
+	test(od_pstmt_store_count(&store) == 10000);
+	for (int i = 0; i < 10000; i++) {
+		od_snprintf(body, sizeof(body), "select %d", i);
+		od_pstmt_t *stmt = test_pstmt_acquire(&store, body);
+		test(stmt == stmts[i]);
+		od_pstmt_store_release(&store, stmt);
+		od_pstmt_store_release(&store, stmts[i]);
+	}
+	test(od_pstmt_store_count(&store) == 0);
+
+	od_pstmt_store_free(&store);
+}
+
+static void test_pstmt_map_client(void)
+{
+	od_pstmt_store_t store;
+	test(od_pstmt_store_init(&store) == OK_RESPONSE);
+
+	od_pstmt_map_t *map = od_pstmt_map_create(&store);
+	test(map != NULL);
+
+	char name[64];
+	char body[64];
+	for (int i = 0; i < 100; i++) {
+		od_snprintf(name, sizeof(name), "stmt_%d", i);
+		od_snprintf(body, sizeof(body), "select %d", i % 10);
+		od_pstmt_t *stmt = test_pstmt_acquire(&store, body);
+		test(od_pstmt_map_set(map, name, strlen(name), stmt) ==
+		     OK_RESPONSE);
+		od_pstmt_store_release(&store, stmt);
+	}
+	test(map->count == 100);
+	test(od_pstmt_store_count(&store) == 10);
+
+	for (int i = 0; i < 100; i++) {
+		od_snprintf(name, sizeof(name), "stmt_%d", i);
+		od_snprintf(body, sizeof(body), "select %d", i % 10);
+		od_pstmt_t *stmt = od_pstmt_map_find(map, name, strlen(name));
+		test(stmt != NULL);
+		test(strcmp(stmt->data, body) == 0);
+		test(stmt->refs == 10);
+	}
+	test(od_pstmt_map_find(map, "stmt_100", 8) == NULL);
+
+	/* named statement can be parsed again only with the same body */
+	od_pstmt_t *prev = od_pstmt_map_find(map, "stmt_0", 6);
+	od_pstmt_t *stmt = test_pstmt_acquire(&store, "select 0");
+	test(stmt == prev);
+	test(od_pstmt_map_set(map, "stmt_0", 6, stmt) == OK_RESPONSE);
+	od_pstmt_store_release(&store, stmt);
+	stmt = test_pstmt_acquire(&store, "select 42");
+	test(od_pstmt_map_set(map, "stmt_0", 6, stmt) == 1);
+	test(od_pstmt_map_find(map, "stmt_0", 6) == prev);
+
+	/* unnamed statement is replaced */
+	od_pstmt_t *unnamed = test_pstmt_acquire(&store, "select 43");
+	test(od_pstmt_map_set(map, "", 1, unnamed) == OK_RESPONSE);
+	od_pstmt_store_release(&store, unnamed);
+	test(od_pstmt_map_set(map, "", 1, stmt) == OK_RESPONSE);
+	od_pstmt_store_release(&store, stmt);
+	test(od_pstmt_map_find(map, "", 1) == stmt);
+	test(map->count == 101);
+
+	od_pstmt_map_free(map);
+	test(od_pstmt_store_count(&store) == 0);
+	od_pstmt_store_free(&store);
+}
+
+static void test_pstmt_map_server(void)
+{
+	od_pstmt_store_t store;
+	test(od_pstmt_store_init(&store) == OK_RESPONSE);
+
+	od_pstmt_map_t *map = od_pstmt_map_create(&store);
+	test(map != NULL);
+
+	od_pstmt_t *a = test_pstmt_acquire(&store, "select 1");
+	od_pstmt_t *b = test_pstmt_acquire(&store, "select 2");
+	test(od_pstmt_map_add(map, a) == 1);
+	test(od_pstmt_map_add(map, a) == 0);
+	test(od_pstmt_map_add(map, b) == 1);
+	test(a->refs == 2);
+
+	od_pstmt_map_empty(map);
+	test(map->count == 0);
+	test(a->refs == 1);
+	test(od_pstmt_map_add(map, a) == 1);
+
+	od_pstmt_store_release(&store, a);
+	od_pstmt_store_release(&store, b);
+	test(od_pstmt_store_count(&store) == 1);
+
+	od_pstmt_map_free(map);
+	test(od_pstmt_store_count(&store) == 0);
+	od_pstmt_store_free(&store);
+}
+
+void odyssey_test_pstmt(void)
+{
+	test_pstmt_store_intern();
+	test_pstmt_map_client();
+	test_pstmt_map_server();
+}
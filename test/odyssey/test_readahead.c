@@ -0,0 +1,117 @@
+#include "odyssey.h"
+#include <odyssey_test.h>
+
+static inline void test_readahead_fill(od_readahead_t *readahead, int unread)
+{
+	/* like read of the whole buffer with a partial header at the end */
+	memset(od_readahead_pos(readahead), 'x', od_readahead_left(readahead));
+	readahead->pos = readahead->size;
+	readahead->pos_read = readahead->size - unread;
+}
+
+static void test_readahead_pool(void *arg)
+{
+	(void)arg;
+	od_readahead_pool_t pool;
+	od_readahead_pool_init(&pool, 8192, 32768);
+	od_readahead_pool_attach(&pool);
+
+	od_readahead_t readahead;
+	od_readahead_init(&readahead);
+	test(od_readahead_prepare(&readahead, 8192) == 0);
+
+	/* nothing is allocated until first read */
+	test(readahead.buf == NULL);
+	test(readahead.size == 0);
+	test(od_readahead_unread(&readahead) == 0);
+	od_readahead_reuse(&readahead);
+	od_readahead_release(&readahead);
+	test(pool.held == 0 && pool.pooled == 0);
+
+	test(od_readahead_acquire(&readahead) == 0);
+	test(readahead.buf != NULL);
+	test(od_readahead_left(&readahead) == 8192);
+	test(pool.held == 8192);
+
+	/* idle connection gives buffer back to the pool */
+	machine_msg_t *buf = readahead.buf;
+	od_readahead_release(&readahead);
+	test(readahead.buf == NULL);
+	test(pool.held == 0 && pool.pooled == 8192);
+	test(od_readahead_acquire(&readahead) == 0);
+	test(readahead.buf == buf);
+	test(pool.held == 8192 && pool.pooled == 0);
+
+	/* buffer filled up, it is doubled and unread bytes are kept */
+	test_readahead_fill(&readahead, 3);
+	char *tail = od_readahead_pos_read(&readahead);
+	tail[0] = 'a';
+	tail[1] = 'b';
+	tail[2] = 'c';
+	od_readahead_reuse(&readahead);
+	test(readahead.size == 16384);
+	test(od_readahead_unread(&readahead) == 3);
+	test(memcmp(od_readahead_pos_read(&readahead), "abc", 3) == 0);
+	test(od_readahead_left(&readahead) == 16384 - 3);
+	test(pool.held == 16384 && pool.pooled == 8192);
+
+	/* not at a packet boundary */
+	od_readahead_release(&readahead);
+	test(readahead.buf != NULL);
+
+	/* growth stops at readahead_max */
+	test_readahead_fill(&readahead, 0);
+	od_readahead_reuse(&readahead);
+	test(readahead.size == 32768);
+	test_readahead_fill(&readahead, 0);
+	od_readahead_reuse(&readahead);
+	test(readahead.size == 32768);
+	test(od_readahead_left(&readahead) == 32768);
+
+	/* grown buffer is freed, not pooled */
+	od_readahead_release(&readahead);
+	test(pool.held == 0 && pool.pooled == 8192);
+
+	/* next read starts with default size again */
+	test(od_readahead_acquire(&readahead) == 0);
+	test(readahead.size == 8192);
+	od_readahead_free(&readahead);
+	test(pool.held == 0 && pool.pooled == 8192);
+
+	od_readahead_pool_attach(NULL);
+	od_readahead_pool_free(&pool);
+	test(pool.pooled == 0 && pool.count == 0);
+
+	/* readahead_max below readahead disables growth */
+	od_readahead_pool_init(&pool, 8192, 4096);
+	od_readahead_pool_attach(&pool);
+	test(od_readahead_acquire(&readahead) == 0);
+	test_readahead_fill(&readahead, 0);
+	od_readahead_reuse(&readahead);
+	test(readahead.size == 8192);
+	od_readahead_free(&readahead);
+	od_readahead_pool_attach(NULL);
+	od_readahead_pool_free(&pool);
+
+	/* machines without a pool are accounted globally */
+	uint64_t unpooled = od_readahead_held_unpooled();
+	test(od_readahead_acquire(&readahead) == 0);
+	test(od_readahead_held_unpooled() == unpooled + 8192);
+	test_readahead_fill(&readahead, 0);
+	od_readahead_reuse(&readahead);
+	test(readahead.size == 8192);
+	od_readahead_free(&readahead);
+	test(od_readahead_held_unpooled() == unpooled);
+}
+
+void odyssey_test_readahead(void)
+{
+	machinarium_init();
+
+	int id;
+	id = machine_create("test_readahead_pool", test_readahead_pool, NULL);
+	test(id != -1);
+	test(machine_wait(id) != -1);
+
+	machinarium_free();
+}
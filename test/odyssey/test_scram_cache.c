@@ -0,0 +1,68 @@
+#include "odyssey.h"
+#include <odyssey_test.h>
+
+static int test_scram_cache_get(od_scram_cache_t *cache, char *key,
+				uint64_t *value)
+{
+	return od_scram_cache_get(cache, key, strlen(key), value,
+				  sizeof(*value));
+}
+
+static void test_scram_cache_put(od_scram_cache_t *cache, char *key,
+				 uint64_t value)
+{
+	test(od_scram_cache_put(cache, key, strlen(key), &value,
+				sizeof(value)) == OK_RESPONSE);
+}
+
+void odyssey_test_scram_cache(void)
+{
+	od_scram_cache_t *cache = od_scram_cache_create();
+	test(cache != NULL);
+
+	uint64_t value = 0;
+	test(test_scram_cache_get(cache, "alice", &value) == 0);
+	test(cache->slots == NULL);
+
+	test_scram_cache_put(cache, "alice", 1);
+	test(test_scram_cache_get(cache, "alice", &value) == 1);
+	test(value == 1);
+
+	/* same key stored twice keeps the latest value */
+	test_scram_cache_put(cache, "alice", 2);
+	test(test_scram_cache_get(cache, "alice", &value) == 1);
+	test(value == 2);
+
+	/* value of other size is a miss */
+	uint32_t short_value;
+	test(od_scram_cache_get(cache, "alice", 5, &short_value,
+				sizeof(short_value)) == 0);
+
+	/* reload drops everything */
+	od_scram_cache_invalidate(cache);
+	test(test_scram_cache_get(cache, "alice", &value) == 0);
+
+	/* cache is bounded, recent keys survive */
+	char key[32];
+	int count = OD_SCRAM_CACHE_SZ * 4;
+	for (int i = 0; i < count; i++) {
+		od_snprintf(key, sizeof(key), "user%d", i);
+		test_scram_cache_put(cache, key, i);
+		test(test_scram_cache_get(cache, key, &value) == 1);
+		test(value == (uint64_t)i);
+	}
+	int hits = 0;
+	for (int i = 0; i < count; i++) {
+		od_snprintf(key, sizeof(key), "user%d", i);
+		if (test_scram_cache_get(cache, key, &value)) {
+			test(value == (uint64_t)i);
+			hits++;
+		}
+	}
+	test(hits > 0 && hits <= OD_SCRAM_CACHE_SZ);
+
+	test(cache->hits == (uint64_t)(2 + count + hits));
+	test(cache->misses == (uint64_t)(3 + count - hits));
+
+	od_scram_cache_free(cache);
+}
@@ -22,6 +22,7 @@ char test_substring[1024] = { 0 };
 /* KIWI */
 extern void kiwi_test_enquote(void);
 extern void kiwi_test_pgoptions(void);
+extern void kiwi_test_vars_fingerprint(void);
 
 /* MACHINARIUM */
 extern void machinarium_test_init(void);
@@ -64,6 +65,7 @@ extern void machinarium_test_connect_cancel1(void);
 extern void machinarium_test_coroutine_names(void);
 extern void machinarium_test_accept_timeout(void);
 extern void machinarium_test_accept_cancel(void);
+extern void machinarium_test_listen_reuseport(void);
 extern void machinarium_test_advice_keepalive_usr_timeout(void);
 extern void machinarium_test_getaddrinfo0(void);
 extern void machinarium_test_getaddrinfo1(void);
@@ -80,6 +82,7 @@ extern void machinarium_test_read_timeout(void);
 extern void machinarium_test_read_cancel(void);
 extern void machinarium_test_read_var(void);
 extern void machinarium_test_tls0(void);
+extern void machinarium_test_tls_ktls(void);
 extern void machinarium_test_tls_unix_socket_no_msg(void);
 extern void machinarium_test_tls_unix_socket(void);
 extern void machinarium_test_tls_read_10mb0(void);
@@ -87,6 +90,8 @@ extern void machinarium_test_tls_read_10mb1(void);
 extern void machinarium_test_tls_read_10mb2(void);
 extern void machinarium_test_tls_read_multithread(void);
 extern void machinarium_test_tls_read_var(void);
+extern void machinarium_test_compression_writev(void);
+extern void machinarium_test_poller_io_uring(void);
 extern void machinarium_test_wait_list_compare_wait_timeout(void);
 extern void machinarium_test_wait_list_compare_wait_wrong_value(void);
 extern void machinarium_test_wait_list_notify_after_compare_wait(void);
@@ -102,6 +107,8 @@ extern void machinarium_test_wait_group_lifetime(void);
 extern void machinarium_test_wait_flag_simple(void);
 extern void machinarium_test_wait_flag_timeout(void);
 extern void machinarium_test_ring_buffer(void);
+extern void machinarium_test_timer_wheel(void);
+extern void machinarium_test_stack_pool(void);
 
 /* TODO: uncomment me
 extern void machinarium_test_mutex_threads(void);
@@ -117,6 +124,13 @@ extern void odyssey_test_hba(void);
 extern void odyssey_test_address_parse(void);
 extern void odyssey_test_address_cmp(void);
 extern void odyssey_test_hashmap(void);
+extern void odyssey_test_pstmt(void);
+extern void odyssey_test_auth_cache(void);
+extern void odyssey_test_scram_cache(void);
+extern void odyssey_test_crypto_pool(void);
+extern void odyssey_test_multi_pool(void);
+extern void odyssey_test_pool_controller(void);
+extern void odyssey_test_readahead(void);
 
 int main(int argc, char *argv[])
 {
@@ -134,6 +148,7 @@ int main(int argc, char *argv[])
 
 	odyssey_test(kiwi_test_enquote);
 	odyssey_test(kiwi_test_pgoptions);
+	odyssey_test(kiwi_test_vars_fingerprint);
 	odyssey_test(machinarium_test_init);
 	odyssey_test(machinarium_test_create0);
 	odyssey_test(machinarium_test_create1);
@@ -173,6 +188,7 @@ int main(int argc, char *argv[])
 	odyssey_test(machinarium_test_connect_cancel1);
 	odyssey_test(machinarium_test_accept_timeout);
 	odyssey_test(machinarium_test_accept_cancel);
+	odyssey_test(machinarium_test_listen_reuseport);
 	odyssey_test(machinarium_test_advice_keepalive_usr_timeout);
 	odyssey_test(machinarium_test_getaddrinfo0);
 	odyssey_test(machinarium_test_getaddrinfo1);
@@ -190,6 +206,7 @@ int main(int argc, char *argv[])
 	odyssey_test(machinarium_test_read_cancel);
 	odyssey_test(machinarium_test_read_var);
 	odyssey_test(machinarium_test_tls0);
+	odyssey_test(machinarium_test_tls_ktls);
 	odyssey_test(machinarium_test_tls_unix_socket_no_msg);
 	odyssey_test(machinarium_test_tls_unix_socket);
 	odyssey_test(machinarium_test_tls_read_10mb0);
@@ -197,6 +214,8 @@ int main(int argc, char *argv[])
 	odyssey_test(machinarium_test_tls_read_10mb2);
 	odyssey_test(machinarium_test_tls_read_multithread);
 	odyssey_test(machinarium_test_tls_read_var);
+	odyssey_test(machinarium_test_compression_writev);
+	odyssey_test(machinarium_test_poller_io_uring);
 	odyssey_test(machinarium_test_wait_list_compare_wait_timeout);
 	odyssey_test(machinarium_test_wait_list_notify_after_compare_wait);
 	odyssey_test(machinarium_test_wait_list_compare_wait_wrong_value);
@@ -213,6 +232,8 @@ int main(int argc, char *argv[])
 	odyssey_test(machinarium_test_wait_flag_simple);
 	odyssey_test(machinarium_test_wait_flag_timeout);
 	odyssey_test(machinarium_test_ring_buffer);
+	odyssey_test(machinarium_test_timer_wheel);
+	odyssey_test(machinarium_test_stack_pool);
 	/* TODO: uncomment me
 	odyssey_test(machinarium_test_mutex_threads);
 	odyssey_test(machinarium_test_mutex_coroutines);
@@ -225,6 +246,13 @@ int main(int argc, char *argv[])
 	odyssey_test(odyssey_test_address_parse);
 	odyssey_test(odyssey_test_address_cmp);
 	odyssey_test(odyssey_test_hashmap);
+	odyssey_test(odyssey_test_pstmt);
+	odyssey_test(odyssey_test_auth_cache);
+	odyssey_test(odyssey_test_scram_cache);
+	odyssey_test(odyssey_test_crypto_pool);
+	odyssey_test(odyssey_test_multi_pool);
+	odyssey_test(odyssey_test_pool_controller);
+	odyssey_test(odyssey_test_readahead);
 
 	return 0;
 }
@@ -60,6 +60,8 @@ struct untyped_kiwi_var {
 
 struct kiwi_vars {
 	kiwi_var_t vars[KIWI_VAR_MAX];
+	/* xor of deployable vars hashes, see kiwi_vars_cas() */
+	uint64_t fingerprint;
 };
 
 static inline void kiwi_var_init(kiwi_var_t *var, char *name, int name_len)
@@ -96,6 +98,30 @@ static inline int kiwi_var_compare(kiwi_var_t *a, kiwi_var_t *b)
 	return memcmp(a->value, b->value, a->value_len) == 0;
 }
 
+/* vars which kiwi_vars_cas() sends to server */
+static inline int kiwi_var_deployable(kiwi_var_t *var)
+{
+	/* we do not support odyssey-to-backend compression yet */
+	return var->type != KIWI_VAR_UNDEF &&
+	       var->type != KIWI_VAR_COMPRESSION &&
+	       var->type != KIWI_VAR_ODYSSEY_TARGET_SESSION_ATTRS;
+}
+
+static inline uint64_t kiwi_var_hash(kiwi_var_t *var)
+{
+	if (!kiwi_var_deployable(var))
+		return 0;
+	/* fnv-1a of type and value, finalized to spread bits for xor */
+	uint64_t hash = 14695981039346656037ULL;
+	hash = (hash ^ (uint64_t)var->type) * 1099511628211ULL;
+	for (int i = 0; i < var->value_len; i++)
+		hash = (hash ^ (unsigned char)var->value[i]) * 1099511628211ULL;
+	hash ^= hash >> 33;
+	hash *= 0xff51afd7ed558ccdULL;
+	hash ^= hash >> 33;
+	return hash;
+}
+
 static inline kiwi_var_t *kiwi_vars_of(kiwi_vars_t *vars, kiwi_var_type_t type)
 {
 	return &vars->vars[type];
@@ -163,17 +189,24 @@ static inline void kiwi_vars_init(kiwi_vars_t *vars)
 	kiwi_var_init(&vars->vars[KIWI_VAR_ODYSSEY_TARGET_SESSION_ATTRS],
 		      "target_session_attrs", sizeof("target_session_attrs"));
 	kiwi_var_init(&vars->vars[KIWI_VAR_ROLE], "role", sizeof("role"));
+	vars->fingerprint = 0;
 }
 
 static inline int kiwi_vars_set(kiwi_vars_t *vars, kiwi_var_type_t type,
 				char *value, int value_len)
 {
-	return kiwi_var_set(kiwi_vars_of(vars, type), type, value, value_len);
+	kiwi_var_t *var = kiwi_vars_of(vars, type);
+	vars->fingerprint ^= kiwi_var_hash(var);
+	int rc = kiwi_var_set(var, type, value, value_len);
+	vars->fingerprint ^= kiwi_var_hash(var);
+	return rc;
 }
 
 static inline void kiwi_vars_unset(kiwi_vars_t *vars, kiwi_var_type_t type)
 {
-	kiwi_var_unset(kiwi_vars_of(vars, type));
+	kiwi_var_t *var = kiwi_vars_of(vars, type);
+	vars->fingerprint ^= kiwi_var_hash(var);
+	kiwi_var_unset(var);
 }
 
 static inline kiwi_var_type_t kiwi_vars_find(kiwi_vars_t *vars, char *name,
@@ -265,11 +298,7 @@ __attribute__((hot)) static inline int kiwi_vars_cas(kiwi_vars_t *client,
 	for (; type < KIWI_VAR_MAX; type++) {
 		kiwi_var_t *var;
 		var = kiwi_vars_of(client, type);
-		/* we do not support odyssey-to-backend compression yet */
-		if (var->type == KIWI_VAR_UNDEF ||
-		    var->type == KIWI_VAR_COMPRESSION ||
-		    var->type ==
-			    KIWI_VAR_ODYSSEY_TARGET_SESSION_ATTRS /* never deploy this one */)
+		if (!kiwi_var_deployable(var))
 			continue;
 		kiwi_var_t *server_var;
 		server_var = kiwi_vars_of(server, type);
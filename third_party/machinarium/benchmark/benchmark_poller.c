@@ -0,0 +1,145 @@
+
+/*
+ * machinarium.
+ *
+ * Cooperative multitasking engine.
+ */
+
+/*
+ * Small request/response round trips over many connections, run
+ * once with epoll poller and once with io_uring poller.
+ */
+
+#include <machinarium.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+
+static int connections = 64;
+static int packet_size = 64;
+static uint64_t requests = 0;
+static int done = 0;
+
+static struct sockaddr_in benchmark_addr(void)
+{
+	struct sockaddr_in sa;
+	memset(&sa, 0, sizeof(sa));
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = inet_addr("127.0.0.1");
+	sa.sin_port = htons(7790);
+	return sa;
+}
+
+static void benchmark_echo(void *arg)
+{
+	machine_io_t *client = arg;
+	for (;;) {
+		machine_msg_t *msg;
+		msg = machine_read(client, packet_size, UINT32_MAX);
+		if (msg == NULL)
+			break;
+		if (machine_write(client, msg, UINT32_MAX) == -1)
+			break;
+	}
+	machine_close(client);
+	machine_io_free(client);
+}
+
+static void benchmark_server(void *arg)
+{
+	(void)arg;
+	machine_io_t *server = machine_io_create();
+	struct sockaddr_in sa = benchmark_addr();
+	machine_bind(server, (struct sockaddr *)&sa, MM_BINDWITH_SO_REUSEADDR);
+
+	for (int i = 0; i < connections; i++) {
+		machine_io_t *client;
+		if (machine_accept(server, &client, connections, 1,
+				   UINT32_MAX) == -1) {
+			printf("accept failed: %s\n", machine_error(server));
+			abort();
+		}
+		machine_coroutine_create(benchmark_echo, client);
+	}
+
+	machine_close(server);
+	machine_io_free(server);
+}
+
+static void benchmark_client(void *arg)
+{
+	(void)arg;
+	machine_io_t *client = machine_io_create();
+	struct sockaddr_in sa = benchmark_addr();
+	if (machine_connect(client, (struct sockaddr *)&sa, UINT32_MAX) == -1) {
+		printf("connect failed: %s\n", machine_error(client));
+		abort();
+	}
+
+	while (!done) {
+		machine_msg_t *msg;
+		msg = machine_msg_create(packet_size);
+		memset(machine_msg_data(msg), 'x', packet_size);
+		if (machine_write(client, msg, UINT32_MAX) == -1)
+			break;
+		msg = machine_read(client, packet_size, UINT32_MAX);
+		if (msg == NULL)
+			break;
+		machine_msg_free(msg);
+		requests++;
+	}
+
+	machine_close(client);
+	machine_io_free(client);
+}
+
+static void benchmark_runner(void *arg)
+{
+	(void)arg;
+	requests = 0;
+	done = 0;
+
+	int server = machine_coroutine_create(benchmark_server, NULL);
+	int *clients = malloc(sizeof(int) * connections);
+	for (int i = 0; i < connections; i++)
+		clients[i] = machine_coroutine_create(benchmark_client, NULL);
+	machine_join(server);
+
+	uint64_t start = machine_time_us();
+	machine_sleep(2000);
+	done = 1;
+	double sec = (machine_time_us() - start) / 1000000.0;
+	uint64_t total = requests;
+
+	for (int i = 0; i < connections; i++)
+		machine_join(clients[i]);
+	free(clients);
+
+	printf("%-8s poller: %10.0f requests/sec\n", machine_poller(),
+	       total / sec);
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc > 1)
+		connections = atoi(argv[1]);
+	if (argc > 2)
+		packet_size = atoi(argv[2]);
+	printf("benchmark started, connections %d, packet size %d.\n",
+	       connections, packet_size);
+
+	int pollers[] = { MACHINE_POLLER_EPOLL, MACHINE_POLLER_IO_URING };
+	for (int i = 0; i < 2; i++) {
+		machinarium_set_poller(pollers[i]);
+		machinarium_init();
+		int id = machine_create("benchmark_poller", benchmark_runner,
+					NULL);
+		machine_wait(id);
+		machinarium_free();
+	}
+
+	printf("done.\n");
+	return 0;
+}
@@ -0,0 +1,103 @@
+
+/*
+ * machinarium.
+ *
+ * Cooperative multitasking engine.
+ */
+
+/*
+ * Timer churn of the machine clock: every client coroutine re-arms
+ * its idle timeout on each activity and every I/O wait arms another
+ * short timer. Measures re-arm rate and expiration cost with 10k,
+ * 100k and 1M armed timers.
+ */
+
+#include <machinarium.h>
+#include <machinarium_private.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static uint64_t fired = 0;
+
+static void benchmark_timer_cb(mm_timer_t *timer)
+{
+	(void)timer;
+	fired++;
+}
+
+static uint64_t benchmark_time_ns(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * (uint64_t)1e9 + t.tv_nsec;
+}
+
+static uint32_t benchmark_interval(int i)
+{
+	/* one of four timers is a long idle timeout, others are I/O waits */
+	if (i % 4 == 0)
+		return 10000 + rand() % 1000;
+	return 1 + rand() % 1000;
+}
+
+static void benchmark_timer(int count)
+{
+	mm_clock_t clock;
+	mm_clock_init(&clock);
+	mm_clock_update(&clock);
+
+	mm_timer_t *timers = malloc(sizeof(mm_timer_t) * count);
+	if (timers == NULL) {
+		printf("out of memory.\n");
+		return;
+	}
+
+	uint64_t start = benchmark_time_ns();
+	for (int i = 0; i < count; i++) {
+		mm_timer_init(&timers[i], benchmark_timer_cb, NULL,
+			      benchmark_interval(i));
+		mm_clock_timer_add(&clock, &timers[i]);
+	}
+	uint64_t add_ns = benchmark_time_ns() - start;
+
+	/* re-arm random timers, as clients do on activity */
+	int rearms = 1000000;
+	start = benchmark_time_ns();
+	for (int i = 0; i < rearms; i++) {
+		int n = rand() % count;
+		mm_clock_timer_del(&clock, &timers[n]);
+		mm_clock_timer_add(&clock, &timers[n]);
+	}
+	uint64_t rearm_ns = benchmark_time_ns() - start;
+
+	/* let one simulated second pass, millisecond by millisecond */
+	fired = 0;
+	start = benchmark_time_ns();
+	for (int i = 0; i < 1000; i++) {
+		clock.time_ms++;
+		mm_clock_step(&clock);
+	}
+	uint64_t step_ns = benchmark_time_ns() - start;
+
+	printf("%8d timers: add %6.1f ns, re-arm %6.1f ns, "
+	       "1 sec of steps %8.3f ms (%" PRIu64 " fired)\n",
+	       count, (double)add_ns / count, (double)rearm_ns / rearms,
+	       (double)step_ns / 1e6, fired);
+
+	for (int i = 0; i < count; i++)
+		mm_clock_timer_del(&clock, &timers[i]);
+	mm_clock_free(&clock);
+	free(timers);
+}
+
+int main(int argc, char *argv[])
+{
+	(void)argc;
+	(void)argv;
+	srand(0);
+	benchmark_timer(10000);
+	benchmark_timer(100000);
+	benchmark_timer(1000000);
+	return 0;
+}
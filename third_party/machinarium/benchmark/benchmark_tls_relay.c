@@ -0,0 +1,202 @@
+
+/*
+ * machinarium.
+ *
+ * Cooperative multitasking engine.
+ */
+
+/*
+ * Relay throughput with and without TLS: writer sends batches of
+ * small packets with machine_writev_raw(), the same way odyssey relay
+ * does, reader drains them with machine_read_raw().
+ */
+
+#include <machinarium.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+
+static char *cert_dir = "../../../test/machinarium";
+static int packet_size = 128;
+static int batch = 256;
+static uint64_t bytes = 0;
+static int writer_done = 0;
+
+static machine_tls_t *benchmark_tls(int server)
+{
+	char path[512];
+	machine_tls_t *tls = machine_tls_create();
+	machine_tls_set_verify(tls, "none");
+	if (server) {
+		snprintf(path, sizeof(path), "%s/server.crt", cert_dir);
+		machine_tls_set_cert_file(tls, path);
+		snprintf(path, sizeof(path), "%s/server.key", cert_dir);
+		machine_tls_set_key_file(tls, path);
+	}
+	snprintf(path, sizeof(path), "%s/ca.crt", cert_dir);
+	machine_tls_set_ca_file(tls, path);
+	return tls;
+}
+
+static struct sockaddr_in benchmark_addr(int port)
+{
+	struct sockaddr_in sa;
+	memset(&sa, 0, sizeof(sa));
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = inet_addr("127.0.0.1");
+	sa.sin_port = htons(port);
+	return sa;
+}
+
+static void benchmark_reader(void *arg)
+{
+	int port = *(int *)arg;
+	int use_tls = port % 2;
+
+	machine_io_t *server = machine_io_create();
+	struct sockaddr_in sa = benchmark_addr(port);
+	machine_bind(server, (struct sockaddr *)&sa, MM_BINDWITH_SO_REUSEADDR);
+
+	machine_io_t *client;
+	if (machine_accept(server, &client, 16, 1, UINT32_MAX) == -1) {
+		printf("accept failed: %s\n", machine_error(server));
+		abort();
+	}
+	machine_tls_t *tls = NULL;
+	if (use_tls) {
+		tls = benchmark_tls(1);
+		if (machine_set_tls(client, tls, UINT32_MAX) == -1) {
+			printf("tls failed: %s\n", machine_error(client));
+			abort();
+		}
+	}
+
+	machine_cond_t *on_read = machine_cond_create();
+	machine_read_start(client, on_read);
+
+	char *buf = malloc(65536);
+	for (;;) {
+		ssize_t rc = machine_read_raw(client, buf, 65536);
+		if (rc > 0) {
+			bytes += rc;
+			continue;
+		}
+		if (rc == 0)
+			break;
+		int errno_ = machine_errno();
+		if (errno_ != EAGAIN && errno_ != EWOULDBLOCK &&
+		    errno_ != EINTR)
+			break;
+		if (writer_done)
+			break;
+		machine_cond_wait(on_read, 100);
+	}
+	free(buf);
+
+	machine_read_stop(client);
+	machine_cond_free(on_read);
+	machine_close(client);
+	machine_io_free(client);
+	machine_close(server);
+	machine_io_free(server);
+	if (tls)
+		machine_tls_free(tls);
+}
+
+static void benchmark_writer(void *arg)
+{
+	int port = *(int *)arg;
+	int use_tls = port % 2;
+
+	machine_io_t *client = machine_io_create();
+	struct sockaddr_in sa = benchmark_addr(port);
+	if (machine_connect(client, (struct sockaddr *)&sa, UINT32_MAX) == -1) {
+		printf("connect failed: %s\n", machine_error(client));
+		abort();
+	}
+	machine_tls_t *tls = NULL;
+	if (use_tls) {
+		tls = benchmark_tls(0);
+		if (machine_set_tls(client, tls, UINT32_MAX) == -1) {
+			printf("tls failed: %s\n", machine_error(client));
+			abort();
+		}
+	}
+
+	char *packet = malloc(packet_size);
+	memset(packet, 'x', packet_size);
+
+	machine_iov_t *iov = machine_iov_create();
+	machine_cond_t *on_write = machine_cond_create();
+	machine_write_start(client, on_write);
+
+	uint64_t start = machine_time_us();
+	while (machine_time_us() - start < 2 * 1000000) {
+		if (!machine_iov_pending(iov)) {
+			for (int i = 0; i < batch; i++)
+				machine_iov_add_pointer(iov, packet,
+							packet_size);
+		}
+		ssize_t rc = machine_writev_raw(client, iov);
+		if (rc > 0)
+			continue;
+		int errno_ = machine_errno();
+		if (errno_ != EAGAIN && errno_ != EWOULDBLOCK &&
+		    errno_ != EINTR) {
+			printf("write failed: %s\n", machine_error(client));
+			break;
+		}
+		machine_cond_wait(on_write, 100);
+	}
+	writer_done = 1;
+
+	machine_write_stop(client);
+	machine_cond_free(on_write);
+	machine_iov_free(iov);
+	free(packet);
+	machine_close(client);
+	machine_io_free(client);
+	if (tls)
+		machine_tls_free(tls);
+}
+
+static void benchmark_runner(void *arg)
+{
+	(void)arg;
+	printf("benchmark started, packet size %d, batch %d.\n", packet_size,
+	       batch);
+
+	/* odd port means tls */
+	int ports[] = { 7780, 7781 };
+	for (int i = 0; i < 2; i++) {
+		bytes = 0;
+		writer_done = 0;
+		uint64_t start = machine_time_us();
+		int r = machine_coroutine_create(benchmark_reader, &ports[i]);
+		int w = machine_coroutine_create(benchmark_writer, &ports[i]);
+		machine_join(w);
+		machine_join(r);
+		double sec = (machine_time_us() - start) / 1000000.0;
+		printf("%-5s relay: %8.1f MB/sec\n", i ? "tls" : "plain",
+		       bytes / sec / (1024 * 1024));
+	}
+
+	printf("done.\n");
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc > 1)
+		packet_size = atoi(argv[1]);
+	if (argc > 2)
+		batch = atoi(argv[2]);
+	if (argc > 3)
+		cert_dir = argv[3];
+	machinarium_init();
+	int id = machine_create("benchmark_tls_relay", benchmark_runner, NULL);
+	machine_wait(id);
+	machinarium_free();
+	return 0;
+}
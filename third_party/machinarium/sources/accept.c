@@ -18,6 +18,32 @@ static void mm_accept_on_read_cb(mm_fd_t *handle)
 	mm_scheduler_wakeup(&mm_self->scheduler, call->coroutine);
 }
 
+MACHINE_API int machine_listen(machine_io_t *obj, int backlog)
+{
+	mm_io_t *io = mm_cast(mm_io_t *, obj);
+	mm_errno_set(0);
+
+	if (io->connected) {
+		mm_errno_set(EINPROGRESS);
+		return -1;
+	}
+	if (io->fd == -1) {
+		mm_errno_set(EBADF);
+		return -1;
+	}
+	if (io->accept_listen)
+		return 0;
+
+	int rc;
+	rc = mm_socket_listen(io->fd, backlog);
+	if (rc == -1) {
+		mm_errno_set(errno);
+		return -1;
+	}
+	io->accept_listen = 1;
+	return 0;
+}
+
 MACHINE_API int machine_accept(machine_io_t *obj, machine_io_t **client,
 			       int backlog, int attach, uint32_t time_ms)
 {
@@ -11,5 +11,6 @@
 
 #cmakedefine HAVE_VALGRIND 1
 #cmakedefine USE_BORINGSSL 1
+#cmakedefine HAVE_IO_URING 1
 
 #endif /* MM_BUILD_H */
@@ -8,25 +8,19 @@
 #include <machinarium.h>
 #include <machinarium_private.h>
 
-static int mm_clock_cmp(mm_timer_t *a, mm_timer_t *b)
-{
-	if (a->timeout == b->timeout) {
-		if (a->seq == b->seq) {
-			assert(a == b);
-			return 0;
-		}
-		return (a->seq > b->seq) ? 1 : -1;
-	} else if (a->timeout > b->timeout) {
-		return 1;
-	}
-	return -1;
+static inline int mm_clock_list_empty(mm_list_t *list)
+{
+	return list->next == list;
 }
 
 void mm_clock_init(mm_clock_t *clock)
 {
-	mm_buf_init(&clock->timers);
+	for (int i = 0; i < MM_CLOCK_WHEEL_LEVELS * MM_CLOCK_WHEEL_SLOTS; i++)
+		mm_list_init(&clock->wheel[i]);
+	memset(clock->wheel_map, 0, sizeof(clock->wheel_map));
+	mm_list_init(&clock->expired);
+	clock->wheel_time = 0;
 	clock->timers_count = 0;
-	clock->timers_seq = 0;
 	clock->active = 0;
 	clock->time_ms = 0;
 	clock->time_ns = 0;
@@ -37,68 +31,62 @@ void mm_clock_init(mm_clock_t *clock)
 
 void mm_clock_free(mm_clock_t *clock)
 {
-	mm_buf_free(&clock->timers);
+	(void)clock;
 }
 
-/*
- * Binary search routine for timer in sorted array.
- * We expect that there is at most only one occurrence of timer in list.
- * If there is not timer in list, we must return first index greater than timer.
- */
-static int mm_clock_get_insert_position(mm_timer_t **list, int count,
-					mm_timer_t *timer)
-{
-	int low = 0, high = count;
-	while (low < high) {
-		int med = low + (high - low) / 2;
-		int cmp = mm_clock_cmp(timer, list[med]);
-		if (cmp == 0)
-			return med;
-		if (cmp > 0) {
-			low = med + 1;
-		} else {
-			high = med;
-		}
+static inline int mm_clock_level_shift(int level)
+{
+	return level * MM_CLOCK_WHEEL_BITS;
+}
+
+static inline void mm_clock_wheel_add(mm_clock_t *clock, mm_timer_t *timer)
+{
+	if (timer->timeout < clock->wheel_time) {
+		timer->slot = -1;
+		mm_list_append(&clock->expired, &timer->link);
+		return;
+	}
+
+	/* level is chosen by distance, slot by absolute timeout */
+	uint64_t delta = timer->timeout - clock->wheel_time;
+	int level = 0;
+	if (delta >= MM_CLOCK_WHEEL_SLOTS) {
+		level = (63 - __builtin_clzll(delta)) / MM_CLOCK_WHEEL_BITS;
+		if (level >= MM_CLOCK_WHEEL_LEVELS)
+			level = MM_CLOCK_WHEEL_LEVELS - 1;
 	}
-	return low;
+	int index = (timer->timeout >> mm_clock_level_shift(level)) &
+		    MM_CLOCK_WHEEL_MASK;
+
+	timer->slot = level * MM_CLOCK_WHEEL_SLOTS + index;
+	mm_list_append(&clock->wheel[timer->slot], &timer->link);
+	clock->wheel_map[level] |= 1ULL << index;
 }
 
-#ifndef NDEBUG
-/* This function only used in asserts */
-static int mm_clock_list_is_sorted(mm_timer_t **list, int count)
+static inline void mm_clock_wheel_unlink(mm_clock_t *clock, mm_timer_t *timer)
 {
-	for (int i = 1; i < count; i++) {
-		if (mm_clock_cmp(list[i - 1], list[i]) >= 0) {
-			return 0;
-		}
+	mm_list_unlink(&timer->link);
+	mm_list_init(&timer->link);
+	if (timer->slot == -1)
+		return;
+	if (mm_clock_list_empty(&clock->wheel[timer->slot])) {
+		int level = timer->slot / MM_CLOCK_WHEEL_SLOTS;
+		int index = timer->slot % MM_CLOCK_WHEEL_SLOTS;
+		clock->wheel_map[level] &= ~(1ULL << index);
 	}
-	return 1;
+	timer->slot = -1;
 }
-#endif
 
 int mm_clock_timer_add(mm_clock_t *clock, mm_timer_t *timer)
 {
-	int count = clock->timers_count;
-	int rc;
-	rc = mm_buf_ensure(&clock->timers, sizeof(mm_timer_t *));
-	if (rc == -1)
-		return -1;
-	mm_timer_t **list;
-	list = (mm_timer_t **)clock->timers.start;
-	mm_buf_advance(&clock->timers, sizeof(mm_timer_t *));
-	timer->seq = clock->timers_seq++;
+	/* empty wheel does not follow the time, catch it up */
+	if (clock->timers_count == 0)
+		clock->wheel_time = clock->time_ms;
 	timer->timeout = clock->time_ms + timer->interval;
 	timer->active = 1;
 	timer->clock = clock;
-	int insert_position = mm_clock_get_insert_position(list, count, timer);
-	/* We are last, or insert position is after us */
-	assert((insert_position == count) ||
-	       mm_clock_cmp(list[insert_position], timer) > 0);
-	memmove(list + insert_position + 1, list + insert_position,
-		sizeof(mm_timer_t *) * (count - insert_position));
-	list[insert_position] = timer;
-	clock->timers_count = count + 1;
-	assert(mm_clock_list_is_sorted(list, clock->timers_count));
+	mm_clock_wheel_add(clock, timer);
+	clock->timers_count++;
 	return 0;
 }
 
@@ -107,61 +95,141 @@ int mm_clock_timer_del(mm_clock_t *clock, mm_timer_t *timer)
 	if (!timer->active)
 		return -1;
 	assert(clock->timers_count >= 1);
-	mm_timer_t **list;
-	list = (mm_timer_t **)clock->timers.start;
-	int i = mm_clock_get_insert_position(list, clock->timers_count, timer);
-	/* We should find timer */
-	assert(list[i] == timer);
-	for (; i < clock->timers_count; i++) {
-		if (list[i] != timer)
-			continue;
-		memmove(list + i, list + i + 1,
-			sizeof(mm_timer_t *) * (clock->timers_count - i - 1));
-		clock->timers.pos -= sizeof(mm_timer_t *);
-		clock->timers_count -= 1;
-		break;
-	}
-	assert(mm_clock_list_is_sorted(list, clock->timers_count));
+	mm_clock_wheel_unlink(clock, timer);
+	clock->timers_count--;
 	timer->active = 0;
 	return 0;
 }
 
-mm_timer_t *mm_clock_timer_min(mm_clock_t *clock)
+/* distance from index to the first non-empty slot, wrapping around */
+static inline int mm_clock_map_next(uint64_t map, int index)
 {
-	if (clock->timers_count == 0)
-		return NULL;
-	mm_timer_t **list;
-	list = (mm_timer_t **)clock->timers.start;
-	return list[0];
+	uint64_t rotated = map >> index;
+	if (index)
+		rotated |= map << (MM_CLOCK_WHEEL_SLOTS - index);
+	return __builtin_ctzll(rotated);
 }
 
-int mm_clock_step(mm_clock_t *clock)
+int mm_clock_deadline(mm_clock_t *clock, uint64_t *deadline)
 {
 	if (clock->timers_count == 0)
+		return -1;
+	if (!mm_clock_list_empty(&clock->expired)) {
+		*deadline = clock->time_ms;
 		return 0;
-	mm_timer_t **list;
-	list = (mm_timer_t **)clock->timers.start;
+	}
+
+	uint64_t now = clock->wheel_time;
+	uint64_t min = UINT64_MAX;
+	if (clock->wheel_map[0]) {
+		/* level 0 slots hold exact timeouts */
+		min = now + mm_clock_map_next(clock->wheel_map[0],
+					      now & MM_CLOCK_WHEEL_MASK);
+	}
+
+	/* coarse slots wake us up for cascade */
+	for (int level = 1; level < MM_CLOCK_WHEEL_LEVELS; level++) {
+		uint64_t map = clock->wheel_map[level];
+		if (map == 0)
+			continue;
+		int shift = mm_clock_level_shift(level);
+		uint64_t current = now >> shift;
+		/*
+		 * current slot is cascaded already, unless step stopped
+		 * right on its boundary
+		 */
+		uint64_t first = current + 1;
+		if ((now & ((1ULL << shift) - 1)) == 0)
+			first = current;
+		int index = first & MM_CLOCK_WHEEL_MASK;
+		uint64_t distance = mm_clock_map_next(map, index);
+		uint64_t cascade = (first + distance) << shift;
+		if (cascade < min)
+			min = cascade;
+	}
+	assert(min != UINT64_MAX);
+	*deadline = min;
+	return 0;
+}
+
+static inline void mm_clock_cascade(mm_clock_t *clock, int level)
+{
+	int index = (clock->wheel_time >> mm_clock_level_shift(level)) &
+		    MM_CLOCK_WHEEL_MASK;
+	mm_list_t *slot = &clock->wheel[level * MM_CLOCK_WHEEL_SLOTS + index];
+	if (mm_clock_list_empty(slot))
+		return;
+
+	/* move timers out first, long ones may land into the same slot */
+	mm_list_t list;
+	mm_list_init(&list);
+	mm_list_t *i, *n;
+	mm_list_foreach_safe(slot, i, n)
+	{
+		mm_list_unlink(i);
+		mm_list_append(&list, i);
+	}
+	clock->wheel_map[level] &= ~(1ULL << index);
+
+	mm_list_foreach_safe(&list, i, n)
+	{
+		mm_timer_t *timer = mm_container_of(i, mm_timer_t, link);
+		mm_list_unlink(i);
+		mm_clock_wheel_add(clock, timer);
+	}
+}
+
+static inline int mm_clock_fire(mm_clock_t *clock, mm_list_t *list)
+{
+	/* callbacks may add or delete timers */
 	int timers_hit = 0;
-	int i = 0;
-	for (; i < clock->timers_count; i++) {
-		mm_timer_t *timer = list[i];
-		if (timer->timeout > clock->time_ms)
-			break;
-		timer->callback(timer);
+	while (!mm_clock_list_empty(list)) {
+		mm_timer_t *timer;
+		timer = mm_container_of(list->next, mm_timer_t, link);
+		mm_clock_wheel_unlink(clock, timer);
+		clock->timers_count--;
 		timer->active = 0;
+		timer->callback(timer);
 		timers_hit++;
 	}
-	if (!timers_hit)
+	return timers_hit;
+}
+
+int mm_clock_step(mm_clock_t *clock)
+{
+	if (clock->timers_count == 0)
 		return 0;
-	int timers_left = clock->timers_count - timers_hit;
-	if (timers_left == 0) {
-		mm_buf_reset(&clock->timers);
-		clock->timers_count = 0;
-		return timers_hit;
+	int timers_hit = mm_clock_fire(clock, &clock->expired);
+
+	while (clock->timers_count > 0 && clock->wheel_time <= clock->time_ms) {
+		uint64_t tick = clock->wheel_time;
+
+		/* cascade coarse slots which time has come */
+		int level = 1;
+		while (level < MM_CLOCK_WHEEL_LEVELS &&
+		       (tick & ((1ULL << mm_clock_level_shift(level)) - 1)) ==
+			       0)
+			level++;
+		while (--level > 0)
+			mm_clock_cascade(clock, level);
+
+		int index = tick & MM_CLOCK_WHEEL_MASK;
+		timers_hit += mm_clock_fire(clock, &clock->wheel[index]);
+
+		/*
+		 * skip ticks with nothing to fire, up to the nearest
+		 * cascade of the first non-empty level
+		 */
+		level = 0;
+		while (level < MM_CLOCK_WHEEL_LEVELS - 1 &&
+		       clock->wheel_map[level] == 0)
+			level++;
+		int shift = mm_clock_level_shift(level);
+		uint64_t next = ((tick >> shift) + 1) << shift;
+		if (next > clock->time_ms + 1)
+			next = clock->time_ms + 1;
+		clock->wheel_time = next;
 	}
-	memmove(list, list + timers_hit, sizeof(mm_timer_t *) * timers_left);
-	clock->timers.pos -= sizeof(mm_timer_t *) * timers_hit;
-	clock->timers_count -= timers_hit;
 	return timers_hit;
 }
 
@@ -8,6 +8,18 @@
 
 typedef struct mm_clock mm_clock_t;
 
+/*
+ * Timers are kept in a hierarchical timing wheel: level 0 has one
+ * slot per millisecond, every next level has slots 64 times coarser,
+ * so long idle timeouts sit in few coarse slots and are cascaded to
+ * finer levels as their time comes. Six levels cover any uint32_t
+ * interval, add and delete are O(1).
+ */
+#define MM_CLOCK_WHEEL_BITS 6
+#define MM_CLOCK_WHEEL_SLOTS (1 << MM_CLOCK_WHEEL_BITS)
+#define MM_CLOCK_WHEEL_MASK (MM_CLOCK_WHEEL_SLOTS - 1)
+#define MM_CLOCK_WHEEL_LEVELS 6
+
 struct mm_clock {
 	int active;
 	int time_cached;
@@ -15,9 +27,14 @@ struct mm_clock {
 	uint64_t time_us;
 	uint64_t time_ns;
 	uint32_t time_sec;
-	mm_buf_t timers;
+	/* next wheel tick to process */
+	uint64_t wheel_time;
+	/* non-empty slots of each level */
+	uint64_t wheel_map[MM_CLOCK_WHEEL_LEVELS];
+	mm_list_t wheel[MM_CLOCK_WHEEL_LEVELS * MM_CLOCK_WHEEL_SLOTS];
+	/* timers added with already passed timeout */
+	mm_list_t expired;
 	int timers_count;
-	int timers_seq;
 };
 
 void mm_clock_init(mm_clock_t *);
@@ -27,7 +44,11 @@ int mm_clock_step(mm_clock_t *);
 int mm_clock_timer_add(mm_clock_t *, mm_timer_t *);
 int mm_clock_timer_del(mm_clock_t *, mm_timer_t *);
 
-mm_timer_t *mm_clock_timer_min(mm_clock_t *);
+/*
+ * Time of the nearest wheel event: timer expiration or coarse slot
+ * cascade. Returns -1 when there are no timers.
+ */
+int mm_clock_deadline(mm_clock_t *, uint64_t *);
 
 static inline void mm_clock_reset(mm_clock_t *clock)
 {
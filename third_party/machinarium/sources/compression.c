@@ -15,18 +15,19 @@ void mm_compression_free(mm_io_t *io)
 int mm_compression_writev(mm_io_t *io, struct iovec *iov, int n,
 			  size_t *processed)
 {
-	int size = mm_iov_size_of(iov, n);
-	char *buffer = mm_malloc(size);
-	if (buffer == NULL) {
-		errno = ENOMEM;
-		return -1;
-	}
-	mm_iovcpy(buffer, iov, n);
+	return mm_zpq_writev(io->zpq_stream, iov, n, processed);
+}
 
-	int rc;
-	rc = mm_zpq_write(io->zpq_stream, buffer, size, processed);
-	mm_free(buffer);
-	return rc;
+MACHINE_API char machine_compression_stat(machine_io_t *obj, uint64_t *tx_raw,
+					  uint64_t *tx, uint64_t *rx_raw,
+					  uint64_t *rx)
+{
+	mm_io_t *io = mm_cast(mm_io_t *, obj);
+	*tx_raw = *tx = *rx_raw = *rx = 0;
+	if (!mm_compression_is_active(io))
+		return MM_ZPQ_NO_COMPRESSION;
+	mm_zpq_stat(io->zpq_stream, tx_raw, tx, rx_raw, rx);
+	return io->compression_algorithm;
 }
 
 /* Returns value > 0 when there is read operation pending. */
@@ -46,7 +47,7 @@ int mm_compression_write_pending(mm_io_t *io)
  * If client request compression, it sends list of supported
  * compression algorithms - client_compression_algorithms.
  * Each compression algorithm is identified
- * by one letter ('f' - Facebook zstd, 'z' - zlib).
+ * by one letter ('f' - Facebook zstd, 'z' - zlib, 'l' - lz4).
  * Return value is the compression algorithm chosen by intersection
  * of client and server supported compression algorithms.
  * If match is not found, return value is MM_ZPQ_NO_COMPRESSION */
@@ -12,19 +12,14 @@
 #include <valgrind/valgrind.h>
 #endif
 
-int mm_contextstack_create(mm_contextstack_t *stack, size_t size,
-			   size_t size_guard)
+int mm_contextstack_create(mm_contextstack_t *stack, mm_stack_pool_t *pool,
+			   size_t size)
 {
-	char *base;
-	base = mmap(0, size_guard + size, PROT_READ | PROT_WRITE,
-		    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-	if (base == MAP_FAILED)
+	stack->stack = mm_stack_pool_get(pool, size);
+	if (stack->stack == NULL)
 		return -1;
-	mprotect(base, size_guard, PROT_NONE);
-	base += size_guard;
-	stack->pointer = base;
+	stack->pointer = stack->stack->pointer;
 	stack->size = size;
-	stack->size_guard = size_guard;
 #ifdef HAVE_VALGRIND
 	stack->valgrind_stack = VALGRIND_STACK_REGISTER(
 		stack->pointer, stack->pointer + stack->size);
@@ -39,6 +34,7 @@ void mm_contextstack_free(mm_contextstack_t *stack)
 #ifdef HAVE_VALGRIND
 	VALGRIND_STACK_DEREGISTER(stack->valgrind_stack);
 #endif
-	char *base = stack->pointer - stack->size_guard;
-	munmap(base, stack->size_guard + stack->size);
+	mm_stack_pool_put(stack->stack);
+	stack->pointer = NULL;
+	stack->stack = NULL;
 }
@@ -11,11 +11,11 @@ typedef struct mm_contextstack mm_contextstack_t;
 struct mm_contextstack {
 	char *pointer;
 	size_t size;
-	size_t size_guard;
+	mm_stack_t *stack;
 #ifdef HAVE_VALGRIND
 	int valgrind_stack;
 #endif
 };
 
-int mm_contextstack_create(mm_contextstack_t *, size_t, size_t);
+int mm_contextstack_create(mm_contextstack_t *, mm_stack_pool_t *, size_t);
 void mm_contextstack_free(mm_contextstack_t *);
@@ -21,7 +21,8 @@ void mm_coroutine_init(mm_coroutine_t *coroutine)
 	mm_list_init(&coroutine->link_join);
 }
 
-mm_coroutine_t *mm_coroutine_allocate(int stack_size, int stack_size_guard)
+mm_coroutine_t *mm_coroutine_allocate(mm_stack_pool_t *stack_pool,
+				      size_t stack_size)
 {
 	mm_coroutine_t *coroutine;
 	coroutine = mm_malloc(sizeof(mm_coroutine_t));
@@ -29,8 +30,7 @@ mm_coroutine_t *mm_coroutine_allocate(int stack_size, int stack_size_guard)
 		return NULL;
 	mm_coroutine_init(coroutine);
 	int rc;
-	rc = mm_contextstack_create(&coroutine->stack, stack_size,
-				    stack_size_guard);
+	rc = mm_contextstack_create(&coroutine->stack, stack_pool, stack_size);
 	if (rc == -1) {
 		mm_free(coroutine);
 		return NULL;
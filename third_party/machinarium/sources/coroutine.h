@@ -31,7 +31,7 @@ struct mm_coroutine {
 	char name[MM_COROUTINE_MAX_NAME_LEN + 1];
 };
 
-mm_coroutine_t *mm_coroutine_allocate(int, int);
+mm_coroutine_t *mm_coroutine_allocate(mm_stack_pool_t *, size_t);
 
 void mm_coroutine_init(mm_coroutine_t *);
 void mm_coroutine_free(mm_coroutine_t *);
@@ -8,14 +8,15 @@
 #include <machinarium.h>
 #include <machinarium_private.h>
 
-void mm_coroutine_cache_init(mm_coroutine_cache_t *cache, int stack_size,
-			     int stack_size_guard, int limit)
+void mm_coroutine_cache_init(mm_coroutine_cache_t *cache,
+			     mm_stack_pool_t *stack_pool, size_t stack_size,
+			     int limit)
 {
 	mm_list_init(&cache->list);
 	cache->count_free = 0;
 	cache->count_total = 0;
+	cache->stack_pool = stack_pool;
 	cache->stack_size = stack_size;
-	cache->stack_size_guard = stack_size_guard;
 	cache->limit = limit;
 }
 
@@ -37,10 +38,14 @@ void mm_coroutine_cache_stat(mm_coroutine_cache_t *cache, uint64_t *count,
 	*count_free = cache->count_free;
 }
 
-mm_coroutine_t *mm_coroutine_cache_pop(mm_coroutine_cache_t *cache)
+mm_coroutine_t *mm_coroutine_cache_pop(mm_coroutine_cache_t *cache,
+				       size_t stack_size)
 {
 	mm_coroutine_t *coroutine;
-	if (cache->count_free > 0) {
+	/* only coroutines with the default stack size are cached */
+	if (stack_size == 0)
+		stack_size = cache->stack_size;
+	if (cache->count_free > 0 && stack_size == cache->stack_size) {
 		mm_list_t *first = mm_list_pop(&cache->list);
 		cache->count_free--;
 		coroutine = mm_container_of(first, mm_coroutine_t, link);
@@ -48,8 +53,7 @@ mm_coroutine_t *mm_coroutine_cache_pop(mm_coroutine_cache_t *cache)
 	}
 	cache->count_total++;
 
-	coroutine = mm_coroutine_allocate(cache->stack_size,
-					  cache->stack_size_guard);
+	coroutine = mm_coroutine_allocate(cache->stack_pool, stack_size);
 	if (coroutine == NULL)
 		cache->count_total--;
 	return coroutine;
@@ -59,7 +63,8 @@ void mm_coroutine_cache_push(mm_coroutine_cache_t *cache,
 			     mm_coroutine_t *coroutine)
 {
 	assert(coroutine->state == MM_CFREE);
-	if (cache->count_free >= cache->limit) {
+	if (cache->count_free >= cache->limit ||
+	    coroutine->stack.size != cache->stack_size) {
 		cache->count_total--;
 		mm_coroutine_free(coroutine);
 		return;
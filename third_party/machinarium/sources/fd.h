@@ -17,6 +17,7 @@ typedef void (*mm_fd_callback_t)(mm_fd_t *);
 struct mm_fd {
 	int fd;
 	int mask;
+	int poll_id;
 	mm_fd_callback_t on_read;
 	void *on_read_arg;
 	mm_fd_callback_t on_write;
@@ -24,6 +24,7 @@ MACHINE_API machine_tls_t *machine_tls_create(void)
 	tls->ca_file = NULL;
 	tls->cert_file = NULL;
 	tls->key_file = NULL;
+	tls->ktls = 0;
 	return (machine_tls_t *)tls;
 }
 
@@ -150,6 +151,14 @@ MACHINE_API int machine_tls_set_key_file(machine_tls_t *obj, char *path)
 	return 0;
 }
 
+MACHINE_API int machine_tls_set_ktls(machine_tls_t *obj, int enable)
+{
+	mm_tls_t *tls = mm_cast(mm_tls_t *, obj);
+	mm_errno_set(0);
+	tls->ktls = enable;
+	return 0;
+}
+
 MACHINE_API int machine_set_tls(machine_io_t *obj, machine_tls_t *tls,
 				uint32_t timeout)
 {
@@ -168,6 +177,12 @@ MACHINE_API int machine_io_is_tls(machine_io_t *obj)
 	return io->tls != NULL;
 }
 
+MACHINE_API int machine_io_ktls(machine_io_t *obj)
+{
+	mm_io_t *io = mm_cast(mm_io_t *, obj);
+	return io->tls_ktls;
+}
+
 MACHINE_API int machine_set_compression(machine_io_t *obj, char algorithm)
 {
 	mm_io_t *io = mm_cast(mm_io_t *, obj);
@@ -181,6 +196,9 @@ MACHINE_API int machine_set_compression(machine_io_t *obj, char algorithm)
 		io->zpq_stream =
 			zpq_create(impl, (mm_zpq_tx_func)mm_io_write,
 				   (mm_zpq_rx_func)mm_io_read, obj, NULL, 0);
+		if (io->zpq_stream == NULL)
+			return -1;
+		io->compression_algorithm = algorithm;
 		return 0;
 	}
 	return -1;
@@ -20,6 +20,7 @@ struct mm_tls {
 	char *ca_file;
 	char *cert_file;
 	char *key_file;
+	int ktls;
 };
 
 struct mm_tls_ctx {
@@ -44,6 +45,8 @@ struct mm_io {
 	/* tls */
 	mm_tls_t *tls;
 	SSL *tls_ssl;
+	char *tls_wbuf;
+	int tls_ktls;
 	int tls_error;
 	char tls_error_msg[128];
 	/* connect */
@@ -57,6 +60,7 @@ struct mm_io {
 	mm_call_t call;
 	/* compression */
 	mm_zpq_stream_t *zpq_stream;
+	char compression_algorithm;
 };
 
 int mm_io_socket_set(mm_io_t *, int);
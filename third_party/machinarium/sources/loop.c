@@ -10,7 +10,12 @@
 
 int mm_loop_init(mm_loop_t *loop)
 {
-	loop->poll = mm_epoll_if.create();
+	loop->poll = NULL;
+	if (machinarium.config.poller == MACHINE_POLLER_IO_URING)
+		loop->poll = mm_uring_if.create();
+	/* io_uring is not available, fall back to epoll */
+	if (loop->poll == NULL)
+		loop->poll = mm_epoll_if.create();
 	if (loop->poll == NULL)
 		return -1;
 	mm_clock_init(&loop->clock);
@@ -51,10 +56,9 @@ int mm_loop_step(mm_loop_t *loop)
 	 this will not create cpu load
 	*/
 	int timeout_ms = 1000;
-	mm_timer_t *next;
-	next = mm_clock_timer_min(&loop->clock);
-	if (next) {
-		int64_t diff = next->timeout - loop->clock.time_ms;
+	uint64_t deadline;
+	if (mm_clock_deadline(&loop->clock, &deadline) == 0) {
+		int64_t diff = deadline - loop->clock.time_ms;
 		if (diff <= 0)
 			timeout_ms = 0;
 		else
@@ -50,12 +50,21 @@ typedef struct machine_ring_buffer machine_ring_buffer_t;
 
 MACHINE_API void machinarium_set_stack_size(int size);
 
+/* guard page below each coroutine stack, enabled by default */
+MACHINE_API void machinarium_set_stack_guard(int enable);
+
 MACHINE_API void machinarium_set_pool_size(int size);
 
 MACHINE_API void machinarium_set_coroutine_cache_size(int size);
 
 MACHINE_API void machinarium_set_msg_cache_gc_size(int size);
 
+/* event loop poller, io_uring falls back to epoll when not available */
+#define MACHINE_POLLER_EPOLL 0
+#define MACHINE_POLLER_IO_URING 1
+
+MACHINE_API void machinarium_set_poller(int poller);
+
 /* main */
 
 MACHINE_API int machinarium_init(void);
@@ -78,6 +87,8 @@ MACHINE_API int machine_wait(uint64_t machine_id);
 
 MACHINE_API int machine_stop(uint64_t machine_id);
 
+MACHINE_API const char *machine_poller(void);
+
 /* time */
 
 MACHINE_API uint64_t machine_time_ms(void);
@@ -91,6 +102,23 @@ machine_stat(uint64_t *coroutine_count, uint64_t *coroutine_cache_count,
 	     uint64_t *msg_allocated, uint64_t *msg_cache_count,
 	     uint64_t *msg_cache_gc_count, uint64_t *msg_cache_size);
 
+/* coroutine stacks of the current machine, per stack size */
+#define MACHINE_STACK_CLASSES_MAX 8
+
+typedef struct {
+	uint64_t size;
+	uint64_t count_used;
+	/* idle stacks kept committed for reuse */
+	uint64_t count_hot;
+	/* idle stacks given back to the kernel */
+	uint64_t count_reclaimed;
+	uint64_t mapped;
+	/* deepest stack use seen, in bytes */
+	uint64_t hwm;
+} machine_stack_stat_t;
+
+MACHINE_API int machine_stack_stat(machine_stack_stat_t *stat, int count);
+
 /* signals */
 
 MACHINE_API int machine_signal_init(sigset_t *, sigset_t *);
@@ -104,6 +132,11 @@ MACHINE_API int64_t machine_coroutine_create(machine_coroutine_t, void *arg);
 MACHINE_API int64_t machine_coroutine_create_named(machine_coroutine_t, void *,
 						   const char *);
 
+/* stack size in pages, 0 means machinarium_set_stack_size() one */
+MACHINE_API int64_t machine_coroutine_create_sized(machine_coroutine_t, void *,
+						   const char *,
+						   int stack_size);
+
 MACHINE_API void machine_sleep(uint32_t time_ms);
 
 MACHINE_API int machine_join(uint64_t coroutine_id);
@@ -192,6 +225,9 @@ MACHINE_API int machine_tls_set_cert_file(machine_tls_t *, char *);
 
 MACHINE_API int machine_tls_set_key_file(machine_tls_t *, char *);
 
+/* kernel tls offload, if supported by the kernel and the cipher */
+MACHINE_API int machine_tls_set_ktls(machine_tls_t *, int enable);
+
 /* io control */
 
 MACHINE_API machine_io_t *machine_io_create(void);
@@ -217,6 +253,12 @@ MACHINE_API int machine_advice_keepalive_usr_timeout(int delay, int interval,
 
 MACHINE_API int machine_set_tls(machine_io_t *, machine_tls_t *, uint32_t);
 MACHINE_API int machine_io_is_tls(machine_io_t *);
+
+#define MACHINE_KTLS_SEND 1
+#define MACHINE_KTLS_RECV 2
+
+/* mask of MACHINE_KTLS_* offloads in use */
+MACHINE_API int machine_io_ktls(machine_io_t *);
 MACHINE_API int machine_set_compression(machine_io_t *, char algorithm);
 
 MACHINE_API int machine_io_verify(machine_io_t *, char *common_name);
@@ -243,6 +285,8 @@ MACHINE_API int machine_connected(machine_io_t *);
 
 MACHINE_API int machine_bind(machine_io_t *, struct sockaddr *, int);
 
+MACHINE_API int machine_listen(machine_io_t *, int backlog);
+
 MACHINE_API int machine_accept(machine_io_t *, machine_io_t **, int backlog,
 			       int attach, uint32_t time_ms);
 
@@ -320,6 +364,11 @@ MACHINE_API ssize_t machine_tls_cert_hash(
 MACHINE_API char
 machine_compression_choose_alg(char *client_compression_algorithms);
 
+/* raw and compressed bytes sent and received, returns the algorithm */
+MACHINE_API char machine_compression_stat(machine_io_t *, uint64_t *tx_raw,
+					  uint64_t *tx, uint64_t *rx_raw,
+					  uint64_t *rx);
+
 /* debug tools */
 
 /*
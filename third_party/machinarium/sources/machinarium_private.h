@@ -77,9 +77,11 @@
 #include "idle.h"
 #include "loop.h"
 #include "epoll.h"
+#include "uring.h"
 #include "socket.h"
 #include "bind.h"
 
+#include "stack_pool.h"
 #include "context_stack.h"
 #include "context.h"
 #include "coroutine.h"
@@ -27,6 +27,7 @@ static inline void machine_instance_free(mm_machine_t *machine)
 	mm_signalmgr_free(&machine->signal_mgr, &machine->loop);
 	mm_loop_shutdown(&machine->loop);
 	mm_scheduler_free(&machine->scheduler);
+	mm_stack_pool_free(&machine->stack_pool);
 }
 
 static inline void free_tls_container(struct mm_tls_ctx *ctx_container)
@@ -92,6 +93,7 @@ MACHINE_API int64_t machine_create(char *name, machine_coroutine_t function,
 	machine->server_tls_ctx = NULL;
 	machine->client_tls_ctx = NULL;
 	machine->name = NULL;
+	machine->thread_global_private = NULL;
 	if (name) {
 		machine->name = strdup(name);
 		if (machine->name == NULL) {
@@ -105,10 +107,11 @@ MACHINE_API int64_t machine_create(char *name, machine_coroutine_t function,
 	mm_msgcache_set_gc_watermark(&machine->msg_cache,
 				     machinarium.config.msg_cache_gc_size);
 
-	mm_coroutine_cache_init(&machine->coroutine_cache,
+	mm_stack_pool_init(&machine->stack_pool, machinarium.config.page_size,
+			   machinarium.config.stack_guard);
+	mm_coroutine_cache_init(&machine->coroutine_cache, &machine->stack_pool,
 				machinarium.config.stack_size *
 					machinarium.config.page_size,
-				machinarium.config.page_size,
 				machinarium.config.coroutine_cache_size);
 
 	mm_scheduler_init(&machine->scheduler);
@@ -192,17 +195,24 @@ MACHINE_API void **machine_thread_private(void)
 	return &(mm_self->thread_global_private);
 }
 
+MACHINE_API const char *machine_poller(void)
+{
+	return mm_self->loop.poll->iface->name;
+}
+
 MACHINE_API void machine_stop_current(void)
 {
 	atomic_store(&mm_self->online, 0);
 }
 
 static inline mm_coroutine_t *
-mm_coroutine_create_internal(machine_coroutine_t function, void *arg)
+mm_coroutine_create_internal(machine_coroutine_t function, void *arg,
+			     size_t stack_size)
 {
 	mm_errno_set(0);
 	mm_coroutine_t *coroutine;
-	coroutine = mm_coroutine_cache_pop(&mm_self->coroutine_cache);
+	coroutine = mm_coroutine_cache_pop(&mm_self->coroutine_cache,
+					   stack_size);
 	if (coroutine == NULL) {
 		mm_errno_set(ENOMEM);
 		return NULL;
@@ -215,7 +225,7 @@ MACHINE_API int64_t machine_coroutine_create(machine_coroutine_t function,
 					     void *arg)
 {
 	mm_coroutine_t *coroutine;
-	coroutine = mm_coroutine_create_internal(function, arg);
+	coroutine = mm_coroutine_create_internal(function, arg, 0);
 	if (coroutine == NULL) {
 		return -1;
 	}
@@ -227,7 +237,7 @@ MACHINE_API int64_t machine_coroutine_create_named(machine_coroutine_t function,
 						   void *arg, const char *name)
 {
 	mm_coroutine_t *coroutine;
-	coroutine = mm_coroutine_create_internal(function, arg);
+	coroutine = mm_coroutine_create_internal(function, arg, 0);
 	if (coroutine == NULL) {
 		return -1;
 	}
@@ -237,6 +247,24 @@ MACHINE_API int64_t machine_coroutine_create_named(machine_coroutine_t function,
 	return coroutine->id;
 }
 
+MACHINE_API int64_t machine_coroutine_create_sized(machine_coroutine_t function,
+						   void *arg, const char *name,
+						   int stack_size)
+{
+	mm_coroutine_t *coroutine;
+	coroutine = mm_coroutine_create_internal(
+		function, arg,
+		(size_t)stack_size * machinarium.config.page_size);
+	if (coroutine == NULL) {
+		return -1;
+	}
+
+	if (name != NULL)
+		mm_coroutine_set_name(coroutine, name);
+
+	return coroutine->id;
+}
+
 MACHINE_API void machine_sleep(uint32_t time_ms)
 {
 	mm_errno_set(0);
@@ -334,3 +362,8 @@ machine_stat(uint64_t *coroutine_count, uint64_t *coroutine_cache_count,
 	mm_msgcache_stat(&mm_self->msg_cache, msg_allocated, msg_cache_gc_count,
 			 msg_cache_count, msg_cache_size);
 }
+
+MACHINE_API int machine_stack_stat(machine_stack_stat_t *stat, int count)
+{
+	return mm_stack_pool_stat(&mm_self->stack_pool, stat, count);
+}
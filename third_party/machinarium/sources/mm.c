@@ -9,9 +9,11 @@
 #include <machinarium_private.h>
 
 static int machinarium_stack_size = 0;
+static int machinarium_stack_guard = 1;
 static int machinarium_pool_size = 0;
 static int machinarium_coroutine_cache_size = 0;
 static int machinarium_msg_cache_gc_size = 0;
+static int machinarium_poller = MACHINE_POLLER_EPOLL;
 static int machinarium_initialized = 0;
 mm_t machinarium;
 
@@ -25,6 +27,11 @@ MACHINE_API void machinarium_set_stack_size(int size)
 	machinarium_stack_size = size;
 }
 
+MACHINE_API void machinarium_set_stack_guard(int enable)
+{
+	machinarium_stack_guard = enable;
+}
+
 MACHINE_API void machinarium_set_pool_size(int size)
 {
 	machinarium_pool_size = size;
@@ -40,6 +47,11 @@ MACHINE_API void machinarium_set_msg_cache_gc_size(int size)
 	machinarium_msg_cache_gc_size = size;
 }
 
+MACHINE_API void machinarium_set_poller(int poller)
+{
+	machinarium_poller = poller;
+}
+
 MACHINE_API int machinarium_init(void)
 {
 	if (machinarium_initialized)
@@ -53,10 +65,12 @@ MACHINE_API int machinarium_init(void)
 
 	machinarium.config.page_size = machinarium_page_size();
 	machinarium.config.stack_size = machinarium_stack_size;
+	machinarium.config.stack_guard = machinarium_stack_guard;
 	machinarium.config.pool_size = machinarium_pool_size;
 	machinarium.config.coroutine_cache_size =
 		machinarium_coroutine_cache_size;
 	machinarium.config.msg_cache_gc_size = machinarium_msg_cache_gc_size;
+	machinarium.config.poller = machinarium_poller;
 
 	mm_machinemgr_init(&machinarium.machine_mgr);
 	mm_tls_engine_init();
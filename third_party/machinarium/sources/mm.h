@@ -12,9 +12,11 @@ typedef struct mm mm_t;
 struct mm_config {
 	int page_size;
 	int stack_size;
+	int stack_guard;
 	int pool_size;
 	int coroutine_cache_size;
 	int msg_cache_gc_size;
+	int poller;
 };
 
 struct mm {
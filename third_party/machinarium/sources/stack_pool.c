@@ -0,0 +1,196 @@
+
+/*
+ * machinarium.
+ *
+ * cooperative multitasking engine.
+ */
+
+#include <machinarium.h>
+#include <machinarium_private.h>
+
+#ifdef HAVE_VALGRIND
+#include <valgrind/valgrind.h>
+#endif
+
+void mm_stack_pool_init(mm_stack_pool_t *pool, size_t page_size, int guard)
+{
+	pool->page_size = page_size;
+	pool->guard = guard;
+	pool->classes_count = 0;
+}
+
+void mm_stack_pool_free(mm_stack_pool_t *pool)
+{
+	for (int i = 0; i < pool->classes_count; i++) {
+		mm_stack_class_t *class = &pool->classes[i];
+		mm_list_t *j, *n;
+		mm_list_foreach_safe(&class->regions, j, n)
+		{
+			mm_stack_region_t *region;
+			region = mm_container_of(j, mm_stack_region_t, link);
+			munmap(region->base, region->size);
+			mm_free(region->stacks);
+			mm_free(region);
+		}
+	}
+	pool->classes_count = 0;
+}
+
+static inline mm_stack_class_t *mm_stack_pool_class(mm_stack_pool_t *pool,
+						    size_t size)
+{
+	for (int i = 0; i < pool->classes_count; i++) {
+		if (pool->classes[i].size == size)
+			return &pool->classes[i];
+	}
+	if (pool->classes_count == MM_STACK_POOL_CLASSES)
+		return NULL;
+
+	mm_stack_class_t *class = &pool->classes[pool->classes_count++];
+	memset(class, 0, sizeof(*class));
+	class->size = size;
+	class->size_slot = size;
+	if (pool->guard)
+		class->size_slot += pool->page_size;
+	class->pool = pool;
+	mm_list_init(&class->free);
+	mm_list_init(&class->regions);
+	return class;
+}
+
+static inline int mm_stack_region_create(mm_stack_class_t *class)
+{
+	mm_stack_pool_t *pool = class->pool;
+
+	int count = MM_STACK_REGION_SIZE / class->size_slot;
+	if (count == 0)
+		count = 1;
+
+	mm_stack_region_t *region = mm_malloc(sizeof(mm_stack_region_t));
+	if (region == NULL)
+		return -1;
+	region->stacks = mm_malloc(sizeof(mm_stack_t) * count);
+	if (region->stacks == NULL) {
+		mm_free(region);
+		return -1;
+	}
+	region->stacks_count = count;
+	region->size = class->size_slot * count;
+
+	/* pages are committed on first touch */
+	region->base = mmap(NULL, region->size, PROT_READ | PROT_WRITE,
+			    MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1,
+			    0);
+	if (region->base == MAP_FAILED) {
+		mm_free(region->stacks);
+		mm_free(region);
+		return -1;
+	}
+#ifdef MADV_NOHUGEPAGE
+	/* transparent huge page would commit stacks nobody touched */
+	madvise(region->base, region->size, MADV_NOHUGEPAGE);
+#endif
+
+	for (int i = 0; i < count; i++) {
+		char *slot = region->base + class->size_slot * i;
+		if (pool->guard) {
+			mprotect(slot, pool->page_size, PROT_NONE);
+			slot += pool->page_size;
+		}
+		mm_stack_t *stack = &region->stacks[i];
+		stack->pointer = slot;
+		stack->class = class;
+		stack->hwm = 0;
+		stack->hot = 0;
+		mm_list_init(&stack->link);
+		mm_list_append(&class->free, &stack->link);
+	}
+	class->count_reclaimed += count;
+	class->mapped += region->size;
+
+	mm_list_init(&region->link);
+	mm_list_append(&class->regions, &region->link);
+	return 0;
+}
+
+mm_stack_t *mm_stack_pool_get(mm_stack_pool_t *pool, size_t size)
+{
+	mm_stack_class_t *class = mm_stack_pool_class(pool, size);
+	if (class == NULL)
+		return NULL;
+	if (class->free.next == &class->free) {
+		if (mm_stack_region_create(class) == -1)
+			return NULL;
+	}
+
+	mm_list_t *first = mm_list_pop(&class->free);
+	mm_stack_t *stack = mm_container_of(first, mm_stack_t, link);
+	if (stack->hot)
+		class->count_hot--;
+	else
+		class->count_reclaimed--;
+	stack->hot = 0;
+	class->count_used++;
+	return stack;
+}
+
+/*
+ * Stacks are zero when mapped or reclaimed, the lowest non-zero word is
+ * the deepest point ever reached. Words above the known high-water mark
+ * are not scanned again.
+ */
+__attribute__((no_sanitize_address)) static inline size_t
+mm_stack_hwm(mm_stack_t *stack)
+{
+#ifdef HAVE_VALGRIND
+	if (RUNNING_ON_VALGRIND)
+		return stack->hwm;
+#endif
+	size_t size = stack->class->size;
+	uint64_t *pos = (uint64_t *)stack->pointer;
+	uint64_t *end = (uint64_t *)(stack->pointer + size - stack->hwm);
+	while (pos < end && *pos == 0)
+		pos++;
+	if (pos == end)
+		return stack->hwm;
+	return size - ((char *)pos - stack->pointer);
+}
+
+void mm_stack_pool_put(mm_stack_t *stack)
+{
+	mm_stack_class_t *class = stack->class;
+
+	stack->hwm = mm_stack_hwm(stack);
+	if (stack->hwm > class->hwm)
+		class->hwm = stack->hwm;
+	class->count_used--;
+
+	if (class->count_hot < MM_STACK_POOL_HOT) {
+		stack->hot = 1;
+		class->count_hot++;
+		mm_list_push(&class->free, &stack->link);
+		return;
+	}
+
+	/* give memory back, next use starts from zero pages */
+	madvise(stack->pointer, class->size, MADV_DONTNEED);
+	stack->hwm = 0;
+	class->count_reclaimed++;
+	mm_list_append(&class->free, &stack->link);
+}
+
+int mm_stack_pool_stat(mm_stack_pool_t *pool, machine_stack_stat_t *stat,
+		       int count)
+{
+	int i;
+	for (i = 0; i < pool->classes_count && i < count; i++) {
+		mm_stack_class_t *class = &pool->classes[i];
+		stat[i].size = class->size;
+		stat[i].count_used = class->count_used;
+		stat[i].count_hot = class->count_hot;
+		stat[i].count_reclaimed = class->count_reclaimed;
+		stat[i].mapped = class->mapped;
+		stat[i].hwm = class->hwm;
+	}
+	return i;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+/*
+ * machinarium.
+ *
+ * cooperative multitasking engine.
+ */
+
+/*
+ * Coroutine stacks are carved from large regions, one set of regions
+ * per stack size class. Freed stacks stay committed while the class
+ * has less than MM_STACK_POOL_HOT idle ones, others are returned to
+ * the kernel with madvise and reused last. Pool is owned by a machine
+ * and is not locked.
+ */
+
+typedef struct mm_stack mm_stack_t;
+typedef struct mm_stack_region mm_stack_region_t;
+typedef struct mm_stack_class mm_stack_class_t;
+typedef struct mm_stack_pool mm_stack_pool_t;
+
+#define MM_STACK_POOL_CLASSES MACHINE_STACK_CLASSES_MAX
+#define MM_STACK_POOL_HOT 64
+#define MM_STACK_REGION_SIZE (2 * 1024 * 1024)
+
+struct mm_stack {
+	/* lowest usable address, guard page is right below */
+	char *pointer;
+	mm_stack_class_t *class;
+	/* deepest use seen since the stack was last reclaimed */
+	size_t hwm;
+	int hot;
+	mm_list_t link;
+};
+
+struct mm_stack_region {
+	char *base;
+	size_t size;
+	mm_stack_t *stacks;
+	int stacks_count;
+	mm_list_t link;
+};
+
+struct mm_stack_class {
+	size_t size;
+	size_t size_slot;
+	mm_stack_pool_t *pool;
+	/* hot stacks first, reclaimed ones at the tail */
+	mm_list_t free;
+	mm_list_t regions;
+	int count_used;
+	int count_hot;
+	int count_reclaimed;
+	size_t mapped;
+	size_t hwm;
+};
+
+struct mm_stack_pool {
+	size_t page_size;
+	int guard;
+	mm_stack_class_t classes[MM_STACK_POOL_CLASSES];
+	int classes_count;
+};
+
+void mm_stack_pool_init(mm_stack_pool_t *, size_t, int);
+void mm_stack_pool_free(mm_stack_pool_t *);
+
+mm_stack_t *mm_stack_pool_get(mm_stack_pool_t *, size_t);
+void mm_stack_pool_put(mm_stack_t *);
+
+int mm_stack_pool_stat(mm_stack_pool_t *, machine_stack_stat_t *, int);
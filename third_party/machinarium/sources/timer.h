@@ -14,10 +14,12 @@ struct mm_timer {
 	int active;
 	uint64_t timeout;
 	uint32_t interval;
-	int seq;
+	/* clock wheel slot, -1 when timer is already due */
+	int slot;
 	mm_timer_callback_t callback;
 	void *arg;
 	void *clock;
+	mm_list_t link;
 };
 
 static inline void mm_timer_init(mm_timer_t *timer, mm_timer_callback_t cb,
@@ -26,8 +28,9 @@ static inline void mm_timer_init(mm_timer_t *timer, mm_timer_callback_t cb,
 	timer->active = 0;
 	timer->interval = interval;
 	timer->timeout = 0;
-	timer->seq = 0;
+	timer->slot = -1;
 	timer->callback = cb;
 	timer->arg = arg;
 	timer->clock = NULL;
+	mm_list_init(&timer->link);
 }
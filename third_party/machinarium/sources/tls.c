@@ -83,13 +83,17 @@ void mm_tls_engine_free(void)
 
 void mm_tls_init(mm_io_t *io)
 {
-	(void)io;
+	io->tls_wbuf = NULL;
+	io->tls_ktls = 0;
 }
 
 void mm_tls_free(mm_io_t *io)
 {
 	if (io->tls_ssl)
 		SSL_free(io->tls_ssl);
+	if (io->tls_wbuf)
+		mm_free(io->tls_wbuf);
+	io->tls_wbuf = NULL;
 }
 
 void mm_tls_error_reset(mm_io_t *io)
@@ -200,6 +204,13 @@ SSL_CTX *mm_tls_get_context(mm_io_t *io, int is_client)
 	SSL_CTX_set_mode(ctx, SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
 	SSL_CTX_set_mode(ctx, SSL_MODE_RELEASE_BUFFERS);
 
+#ifdef MM_TLS_KTLS
+	/* OpenSSL falls back to userspace crypto, if kernel or cipher
+	 * does not support offload */
+	if (io->tls->ktls)
+		SSL_CTX_set_options(ctx, SSL_OP_ENABLE_KTLS);
+#endif
+
 	/* verify mode */
 	int verify = 0;
 	switch (io->tls->verify) {
@@ -451,6 +462,19 @@ error:
 	return -1;
 }
 
+static inline void mm_tls_ktls_probe(mm_io_t *io)
+{
+	io->tls_ktls = 0;
+#ifdef MM_TLS_KTLS
+	if (!io->tls->ktls)
+		return;
+	if (BIO_get_ktls_send(SSL_get_wbio(io->tls_ssl)))
+		io->tls_ktls |= MACHINE_KTLS_SEND;
+	if (BIO_get_ktls_recv(SSL_get_rbio(io->tls_ssl)))
+		io->tls_ktls |= MACHINE_KTLS_RECV;
+#endif
+}
+
 static void mm_tls_handshake_cb(mm_fd_t *handle)
 {
 	mm_machine_t *machine = mm_self;
@@ -513,6 +537,8 @@ int mm_tls_handshake(mm_io_t *io, uint32_t timeout)
 	if (io->call.status != 0)
 		return -1;
 
+	mm_tls_ktls_probe(io);
+
 	if (is_client) {
 		if (io->tls->server) {
 			rc = mm_tls_verify_common_name(io, io->tls->server);
@@ -697,6 +723,9 @@ int mm_tls_handshake(mm_io_t *io, uint32_t timeout)
 int mm_tls_write(mm_io_t *io, char *buf, int size)
 {
 	mm_tls_error_reset(io);
+	/* records are framed and encrypted by the kernel */
+	if (io->tls_ktls & MACHINE_KTLS_SEND)
+		return mm_socket_write(io->fd, buf, size);
 	int rc;
 	rc = SSL_write(io->tls_ssl, buf, size);
 	if (rc > 0)
@@ -710,30 +739,84 @@ int mm_tls_write(mm_io_t *io, char *buf, int size)
 	return -1;
 }
 
+/*
+ * Build next chunk to write starting from iov[*pos].
+ *
+ * Buffers smaller than a record are coalesced into the io write
+ * buffer, larger ones are passed to SSL_write() as is. Chunks depend
+ * only on the data starting from the current position, so a write
+ * retried after SSL_ERROR_WANT_WRITE passes the same data again.
+ */
+static inline int mm_tls_writev_chunk(mm_io_t *io, struct iovec *iov, int n,
+				      int *pos, char **chunk)
+{
+	struct iovec *current = &iov[*pos];
+	if (current->iov_len >= MM_TLS_WRITE_CHUNK) {
+		(*pos)++;
+		*chunk = current->iov_base;
+		if (current->iov_len > INT_MAX)
+			return INT_MAX;
+		return current->iov_len;
+	}
+
+	if (io->tls_wbuf == NULL) {
+		io->tls_wbuf = mm_malloc(MM_TLS_WRITE_CHUNK);
+		if (io->tls_wbuf == NULL)
+			return -1;
+	}
+
+	int size = 0;
+	while (*pos < n && size + iov[*pos].iov_len <= MM_TLS_WRITE_CHUNK) {
+		memcpy(io->tls_wbuf + size, iov[*pos].iov_base,
+		       iov[*pos].iov_len);
+		size += iov[*pos].iov_len;
+		(*pos)++;
+	}
+	*chunk = io->tls_wbuf;
+	return size;
+}
+
 int mm_tls_writev(mm_io_t *io, struct iovec *iov, int n)
 {
 	mm_tls_error_reset(io);
+	if (io->tls_ktls & MACHINE_KTLS_SEND)
+		return mm_socket_writev(io->fd, iov, n);
+
+	int total = 0;
+	int pos = 0;
+	while (pos < n) {
+		char *chunk;
+		int size;
+		size = mm_tls_writev_chunk(io, iov, n, &pos, &chunk);
+		if (size == -1) {
+			if (total > 0)
+				return total;
+			errno = ENOMEM;
+			return -1;
+		}
 
-	int size = mm_iov_size_of(iov, n);
-	char *buffer = mm_malloc(size);
-	if (buffer == NULL) {
-		errno = ENOMEM;
-		return -1;
-	}
-	mm_iovcpy(buffer, iov, n);
+		int rc;
+		rc = SSL_write(io->tls_ssl, chunk, size);
+		if (rc <= 0) {
+			/* report written data, error will be repeated */
+			if (total > 0)
+				return total;
+			int error = SSL_get_error(io->tls_ssl, rc);
+			if (error == SSL_ERROR_WANT_READ ||
+			    error == SSL_ERROR_WANT_WRITE) {
+				errno = EAGAIN;
+				return -1;
+			}
+			mm_tls_error(io, rc, "SSL_write()");
+			return -1;
+		}
+		total += rc;
 
-	int rc;
-	rc = SSL_write(io->tls_ssl, buffer, size);
-	mm_free(buffer);
-	if (rc > 0)
-		return rc;
-	int error = SSL_get_error(io->tls_ssl, rc);
-	if (error == SSL_ERROR_WANT_READ || error == SSL_ERROR_WANT_WRITE) {
-		errno = EAGAIN;
-		return -1;
+		/* partial write, let caller advance and retry */
+		if (rc < size)
+			break;
 	}
-	mm_tls_error(io, rc, "SSL_write()");
-	return -1;
+	return total;
 }
 
 int mm_tls_get_cert_hash(mm_io_t *io,
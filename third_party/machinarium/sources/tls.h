@@ -14,6 +14,14 @@ static inline int mm_tls_is_active(mm_io_t *io)
 	return io->tls_ssl != NULL;
 }
 
+/* kernel tls requires OpenSSL 3.0 built with ktls */
+#if defined(SSL_OP_ENABLE_KTLS) && !defined(OPENSSL_NO_KTLS)
+#define MM_TLS_KTLS
+#endif
+
+/* plain text size of a single TLS record */
+#define MM_TLS_WRITE_CHUNK 16384
+
 void mm_tls_init(mm_io_t *);
 void mm_tls_free(mm_io_t *);
 void mm_tls_error_reset(mm_io_t *);
@@ -0,0 +1,513 @@
+
+/*
+ * machinarium.
+ *
+ * cooperative multitasking engine.
+ */
+
+#include <machinarium.h>
+#include <machinarium_private.h>
+
+#ifdef HAVE_IO_URING
+#include <sys/poll.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+
+#if defined(HAVE_IO_URING) && defined(IORING_ENTER_EXT_ARG) && \
+	defined(__NR_io_uring_setup)
+#define MM_URING 1
+#endif
+
+#ifdef MM_URING
+
+/*
+ * io_uring poller.
+ *
+ * Every watched fd has a one-shot IORING_OP_POLL_ADD request, which is
+ * re-armed after its completion is handled. This keeps level-triggered
+ * semantics of the epoll poller, while mask changes are only queued
+ * to the submission ring and go to the kernel together with the wait
+ * of the next step, in a single io_uring_enter() call.
+ *
+ * Requests are tagged with fd slot and its generation, generation is
+ * bumped on every removal, so completions of removed requests
+ * are ignored.
+ */
+
+#define MM_URING_ENTRIES 1024
+
+typedef struct mm_uring_slot mm_uring_slot_t;
+typedef struct mm_uring mm_uring_t;
+
+struct mm_uring_slot {
+	mm_fd_t *fd;
+	uint32_t gen;
+	int armed;
+	int next;
+};
+
+struct mm_uring {
+	mm_poll_t poll;
+	int fd;
+	/* submission queue */
+	void *sq_ring;
+	size_t sq_ring_size;
+	unsigned *sq_head;
+	unsigned *sq_tail;
+	unsigned *sq_array;
+	unsigned sq_mask;
+	unsigned sq_entries;
+	unsigned sq_tail_local;
+	struct io_uring_sqe *sqes;
+	size_t sqes_size;
+	/* completion queue */
+	void *cq_ring;
+	size_t cq_ring_size;
+	unsigned *cq_head;
+	unsigned *cq_tail;
+	unsigned cq_mask;
+	struct io_uring_cqe *cqes;
+	/* watched fds */
+	mm_uring_slot_t *slots;
+	int slots_size;
+	int slots_free;
+	int count;
+};
+
+static inline uint64_t mm_uring_tag(mm_uring_t *uring, int id)
+{
+	return ((uint64_t)(id + 1) << 32) | uring->slots[id].gen;
+}
+
+static int mm_uring_enter(mm_uring_t *uring, int wait, int timeout)
+{
+	unsigned head = __atomic_load_n(uring->sq_head, __ATOMIC_ACQUIRE);
+	unsigned submit = uring->sq_tail_local - head;
+	__atomic_store_n(uring->sq_tail, uring->sq_tail_local,
+			 __ATOMIC_RELEASE);
+
+	unsigned flags = 0;
+	struct __kernel_timespec ts;
+	struct io_uring_getevents_arg arg;
+	memset(&arg, 0, sizeof(arg));
+	if (wait) {
+		ts.tv_sec = timeout / 1000;
+		ts.tv_nsec = (timeout % 1000) * 1000000LL;
+		arg.ts = (uint64_t)(uintptr_t)&ts;
+		flags |= IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+	} else if (submit == 0) {
+		return 0;
+	}
+
+	int rc;
+	rc = syscall(__NR_io_uring_enter, uring->fd, submit, wait ? 1 : 0,
+		     flags, &arg, sizeof(arg));
+	if (rc == -1) {
+		if (errno == ETIME || errno == EINTR)
+			return 0;
+		return -1;
+	}
+	return 0;
+}
+
+static struct io_uring_sqe *mm_uring_sqe(mm_uring_t *uring)
+{
+	unsigned head = __atomic_load_n(uring->sq_head, __ATOMIC_ACQUIRE);
+	if (uring->sq_tail_local - head == uring->sq_entries) {
+		/* submission queue is full, flush it */
+		if (mm_uring_enter(uring, 0, 0) == -1)
+			return NULL;
+		head = __atomic_load_n(uring->sq_head, __ATOMIC_ACQUIRE);
+		if (uring->sq_tail_local - head == uring->sq_entries)
+			return NULL;
+	}
+	unsigned idx = uring->sq_tail_local & uring->sq_mask;
+	struct io_uring_sqe *sqe = &uring->sqes[idx];
+	memset(sqe, 0, sizeof(*sqe));
+	uring->sq_array[idx] = idx;
+	uring->sq_tail_local++;
+	return sqe;
+}
+
+static int mm_uring_arm(mm_uring_t *uring, int id)
+{
+	mm_uring_slot_t *slot = &uring->slots[id];
+	struct io_uring_sqe *sqe = mm_uring_sqe(uring);
+	if (sqe == NULL)
+		return -1;
+	uint32_t events = 0;
+	if (slot->fd->mask & MM_R)
+		events |= POLLIN;
+	if (slot->fd->mask & MM_W)
+		events |= POLLOUT;
+#if __BYTE_ORDER == __BIG_ENDIAN
+	events = (events << 16) | (events >> 16);
+#endif
+	sqe->opcode = IORING_OP_POLL_ADD;
+	sqe->fd = slot->fd->fd;
+	sqe->poll32_events = events;
+	sqe->user_data = mm_uring_tag(uring, id);
+	slot->armed = 1;
+	return 0;
+}
+
+static int mm_uring_disarm(mm_uring_t *uring, int id)
+{
+	mm_uring_slot_t *slot = &uring->slots[id];
+	if (!slot->armed)
+		return 0;
+	struct io_uring_sqe *sqe = mm_uring_sqe(uring);
+	if (sqe == NULL)
+		return -1;
+	sqe->opcode = IORING_OP_POLL_REMOVE;
+	sqe->fd = -1;
+	sqe->addr = mm_uring_tag(uring, id);
+	sqe->user_data = 0;
+	slot->armed = 0;
+	slot->gen++;
+	return 0;
+}
+
+static int mm_uring_slot_alloc(mm_uring_t *uring)
+{
+	if (uring->slots_free == -1) {
+		int size = uring->slots_size * 2;
+		mm_uring_slot_t *slots;
+		slots = mm_realloc(uring->slots,
+				   sizeof(mm_uring_slot_t) * size);
+		if (slots == NULL)
+			return -1;
+		int i = uring->slots_size;
+		for (; i < size; i++) {
+			slots[i].fd = NULL;
+			slots[i].gen = 0;
+			slots[i].armed = 0;
+			slots[i].next = (i + 1 < size) ? i + 1 : -1;
+		}
+		uring->slots_free = uring->slots_size;
+		uring->slots = slots;
+		uring->slots_size = size;
+	}
+	int id = uring->slots_free;
+	uring->slots_free = uring->slots[id].next;
+	return id;
+}
+
+static void mm_uring_slot_free(mm_uring_t *uring, int id)
+{
+	mm_uring_slot_t *slot = &uring->slots[id];
+	slot->fd = NULL;
+	slot->gen++;
+	slot->next = uring->slots_free;
+	uring->slots_free = id;
+}
+
+static void mm_uring_unmap(mm_uring_t *uring)
+{
+	if (uring->sqes)
+		munmap(uring->sqes, uring->sqes_size);
+	if (uring->cq_ring && uring->cq_ring != uring->sq_ring)
+		munmap(uring->cq_ring, uring->cq_ring_size);
+	if (uring->sq_ring)
+		munmap(uring->sq_ring, uring->sq_ring_size);
+	uring->sqes = NULL;
+	uring->cq_ring = NULL;
+	uring->sq_ring = NULL;
+}
+
+static int mm_uring_map(mm_uring_t *uring, struct io_uring_params *p)
+{
+	uring->sq_ring_size =
+		p->sq_off.array + p->sq_entries * sizeof(unsigned);
+	uring->cq_ring_size =
+		p->cq_off.cqes + p->cq_entries * sizeof(struct io_uring_cqe);
+	int single = p->features & IORING_FEAT_SINGLE_MMAP;
+	if (single) {
+		if (uring->cq_ring_size > uring->sq_ring_size)
+			uring->sq_ring_size = uring->cq_ring_size;
+		uring->cq_ring_size = uring->sq_ring_size;
+	}
+
+	void *ptr;
+	ptr = mmap(NULL, uring->sq_ring_size, PROT_READ | PROT_WRITE,
+		   MAP_SHARED | MAP_POPULATE, uring->fd, IORING_OFF_SQ_RING);
+	if (ptr == MAP_FAILED)
+		return -1;
+	uring->sq_ring = ptr;
+
+	if (single) {
+		uring->cq_ring = uring->sq_ring;
+	} else {
+		ptr = mmap(NULL, uring->cq_ring_size, PROT_READ | PROT_WRITE,
+			   MAP_SHARED | MAP_POPULATE, uring->fd,
+			   IORING_OFF_CQ_RING);
+		if (ptr == MAP_FAILED)
+			return -1;
+		uring->cq_ring = ptr;
+	}
+
+	uring->sqes_size = p->sq_entries * sizeof(struct io_uring_sqe);
+	ptr = mmap(NULL, uring->sqes_size, PROT_READ | PROT_WRITE,
+		   MAP_SHARED | MAP_POPULATE, uring->fd, IORING_OFF_SQES);
+	if (ptr == MAP_FAILED)
+		return -1;
+	uring->sqes = ptr;
+
+	char *sq = uring->sq_ring;
+	uring->sq_head = (unsigned *)(sq + p->sq_off.head);
+	uring->sq_tail = (unsigned *)(sq + p->sq_off.tail);
+	uring->sq_array = (unsigned *)(sq + p->sq_off.array);
+	uring->sq_mask = *(unsigned *)(sq + p->sq_off.ring_mask);
+	uring->sq_entries = *(unsigned *)(sq + p->sq_off.ring_entries);
+	uring->sq_tail_local = *uring->sq_tail;
+
+	char *cq = uring->cq_ring;
+	uring->cq_head = (unsigned *)(cq + p->cq_off.head);
+	uring->cq_tail = (unsigned *)(cq + p->cq_off.tail);
+	uring->cq_mask = *(unsigned *)(cq + p->cq_off.ring_mask);
+	uring->cqes = (struct io_uring_cqe *)(cq + p->cq_off.cqes);
+	return 0;
+}
+
+static void mm_uring_free(mm_poll_t *poll)
+{
+	mm_uring_t *uring = (mm_uring_t *)poll;
+	mm_uring_unmap(uring);
+	if (uring->slots)
+		mm_free(uring->slots);
+	mm_free(poll);
+}
+
+static int mm_uring_shutdown(mm_poll_t *poll)
+{
+	mm_uring_t *uring = (mm_uring_t *)poll;
+	if (uring->fd != -1) {
+		close(uring->fd);
+		uring->fd = -1;
+	}
+	return 0;
+}
+
+static mm_poll_t *mm_uring_create(void)
+{
+	mm_uring_t *uring;
+	uring = mm_malloc(sizeof(mm_uring_t));
+	if (uring == NULL)
+		return NULL;
+	memset(uring, 0, sizeof(mm_uring_t));
+	uring->poll.iface = &mm_uring_if;
+	uring->slots_free = -1;
+
+	struct io_uring_params p;
+	memset(&p, 0, sizeof(p));
+	uring->fd = syscall(__NR_io_uring_setup, MM_URING_ENTRIES, &p);
+	if (uring->fd == -1) {
+		mm_free(uring);
+		return NULL;
+	}
+
+	/* wait with timeout and no dropped completions are required */
+	unsigned features = IORING_FEAT_EXT_ARG | IORING_FEAT_NODROP;
+	if ((p.features & features) != features)
+		goto error;
+
+	if (mm_uring_map(uring, &p) == -1)
+		goto error;
+
+	uring->slots_size = 1024;
+	uring->slots = mm_malloc(sizeof(mm_uring_slot_t) * uring->slots_size);
+	if (uring->slots == NULL)
+		goto error;
+	int i = 0;
+	for (; i < uring->slots_size; i++) {
+		uring->slots[i].fd = NULL;
+		uring->slots[i].gen = 0;
+		uring->slots[i].armed = 0;
+		uring->slots[i].next = (i + 1 < uring->slots_size) ? i + 1 : -1;
+	}
+	uring->slots_free = 0;
+	return &uring->poll;
+
+error:
+	mm_uring_unmap(uring);
+	close(uring->fd);
+	mm_free(uring);
+	return NULL;
+}
+
+static int mm_uring_step(mm_poll_t *poll, int timeout)
+{
+	mm_uring_t *uring = (mm_uring_t *)poll;
+	if (uring->count == 0)
+		return mm_uring_enter(uring, 0, 0);
+
+	/* submit pending requests and wait for completions */
+	int rc;
+	rc = mm_uring_enter(uring, 1, timeout);
+	if (rc == -1)
+		return -1;
+
+	int count = 0;
+	unsigned head = *uring->cq_head;
+	unsigned tail = __atomic_load_n(uring->cq_tail, __ATOMIC_ACQUIRE);
+	while (head != tail) {
+		struct io_uring_cqe *cqe = &uring->cqes[head & uring->cq_mask];
+		uint64_t tag = cqe->user_data;
+		int res = cqe->res;
+		head++;
+		__atomic_store_n(uring->cq_head, head, __ATOMIC_RELEASE);
+
+		/* poll remove completions or stale requests */
+		if (tag == 0)
+			continue;
+		int id = (int)(tag >> 32) - 1;
+		uint32_t gen = (uint32_t)tag;
+		mm_uring_slot_t *slot = &uring->slots[id];
+		if (slot->fd == NULL || slot->gen != gen)
+			continue;
+		slot->armed = 0;
+		count++;
+
+		mm_fd_t *fd = slot->fd;
+		int events = res;
+		if (res < 0)
+			events = POLLERR;
+
+		if ((events & POLLIN) && (fd->mask & MM_R)) {
+			assert(fd->on_read);
+			fd->on_read(fd);
+		}
+
+		/* fd could be modified or removed by the callback */
+		slot = &uring->slots[id];
+		if (slot->fd != fd || slot->gen != gen)
+			continue;
+
+		if ((events & (POLLOUT | POLLERR | POLLHUP)) &&
+		    (fd->mask & MM_W)) {
+			assert(fd->on_write);
+			fd->on_write(fd);
+		}
+
+		slot = &uring->slots[id];
+		if (slot->fd != fd || slot->gen != gen || slot->armed)
+			continue;
+		if (fd->mask)
+			mm_uring_arm(uring, id);
+	}
+	return count;
+}
+
+static int mm_uring_modify(mm_poll_t *poll, mm_fd_t *fd, int mask)
+{
+	if (fd->mask == mask)
+		return 0;
+	mm_uring_t *uring = (mm_uring_t *)poll;
+	int id;
+	if (fd->mask == 0) {
+		id = mm_uring_slot_alloc(uring);
+		if (id == -1)
+			return -1;
+		uring->slots[id].fd = fd;
+		uring->slots[id].armed = 0;
+		fd->poll_id = id;
+		uring->count++;
+	} else {
+		id = fd->poll_id;
+		if (mm_uring_disarm(uring, id) == -1)
+			return -1;
+	}
+
+	if (mask == 0) {
+		mm_uring_slot_free(uring, id);
+		uring->count--;
+		fd->mask = 0;
+		/* let the request release the file before fd is closed */
+		return mm_uring_enter(uring, 0, 0);
+	}
+
+	fd->mask = mask;
+	return mm_uring_arm(uring, id);
+}
+
+static int mm_uring_add(mm_poll_t *poll, mm_fd_t *fd, int mask)
+{
+	return mm_uring_modify(poll, fd, mask);
+}
+
+static int mm_uring_read(mm_poll_t *poll, mm_fd_t *fd, mm_fd_callback_t on_read,
+			 void *arg, int enable)
+{
+	int mask = fd->mask;
+	if (enable)
+		mask |= MM_R;
+	else
+		mask &= ~MM_R;
+	fd->on_read = on_read;
+	fd->on_read_arg = arg;
+	if (mask == fd->mask)
+		return 0;
+	return mm_uring_modify(poll, fd, mask);
+}
+
+static int mm_uring_write(mm_poll_t *poll, mm_fd_t *fd,
+			  mm_fd_callback_t on_write, void *arg, int enable)
+{
+	int mask = fd->mask;
+	if (enable)
+		mask |= MM_W;
+	else
+		mask &= ~MM_W;
+	fd->on_write = on_write;
+	fd->on_write_arg = arg;
+	if (mask == fd->mask)
+		return 0;
+	return mm_uring_modify(poll, fd, mask);
+}
+
+static int mm_uring_read_write(mm_poll_t *poll, mm_fd_t *fd,
+			       mm_fd_callback_t on_event, void *arg, int enable)
+{
+	int mask = fd->mask;
+	if (enable)
+		mask |= MM_W | MM_R;
+	else
+		mask &= ~(MM_W | MM_R);
+	fd->on_write = on_event;
+	fd->on_write_arg = arg;
+	fd->on_read = on_event;
+	fd->on_read_arg = arg;
+	if (mask == fd->mask)
+		return 0;
+	return mm_uring_modify(poll, fd, mask);
+}
+
+static int mm_uring_del(mm_poll_t *poll, mm_fd_t *fd)
+{
+	return mm_uring_read_write(poll, fd, NULL, NULL, 0);
+}
+
+mm_pollif_t mm_uring_if = { .name = "io_uring",
+			    .create = mm_uring_create,
+			    .free = mm_uring_free,
+			    .shutdown = mm_uring_shutdown,
+			    .step = mm_uring_step,
+			    .add = mm_uring_add,
+			    .read = mm_uring_read,
+			    .write = mm_uring_write,
+			    .read_write = mm_uring_read_write,
+			    .del = mm_uring_del };
+
+#else
+
+/* io_uring is not supported by the build, loop falls back to epoll */
+
+static mm_poll_t *mm_uring_create(void)
+{
+	return NULL;
+}
+
+mm_pollif_t mm_uring_if = { .name = "io_uring", .create = mm_uring_create };
+
+#endif
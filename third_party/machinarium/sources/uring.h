@@ -0,0 +1,9 @@
+#pragma once
+
+/*
+ * machinarium.
+ *
+ * cooperative multitasking engine.
+ */
+
+extern mm_pollif_t mm_uring_if;
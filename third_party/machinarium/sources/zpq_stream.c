@@ -5,7 +5,9 @@
  * cooperative multitasking engine.
  */
 #include <unistd.h>
+#include <stdint.h>
 #include "zpq_stream.h"
+#include "memory.h"
 #include <assert.h>
 #include <string.h>
 
@@ -39,13 +41,15 @@ typedef struct {
 	ssize_t (*read)(mm_zpq_stream_t *zs, void *buf, size_t size);
 
 	/*
-	 * Write up to "size" raw (decompressed) bytes.
+	 * Write raw (decompressed) bytes of "n" iovecs, compressing them
+	 * straight from the caller buffers. Stream is flushed after the last
+	 * iovec only.
 	 * Returns number of written raw bytes or error code returned by tx
 	 * function. In the last case amount of written raw bytes is stored in
 	 * *processed.
 	 */
-	ssize_t (*write)(mm_zpq_stream_t *zs, void const *buf, size_t size,
-			 size_t *processed);
+	ssize_t (*writev)(mm_zpq_stream_t *zs, struct iovec *iov, int n,
+			  size_t *processed);
 
 	/*
 	 * Free stream created by create function.
@@ -78,6 +82,11 @@ typedef struct {
 
 struct mm_zpq_stream {
 	zpq_algorithm_t const *algorithm;
+	/* compressed and raw (decompressed) bytes, sent and received */
+	uint64_t tx_total;
+	uint64_t tx_total_raw;
+	uint64_t rx_total;
+	uint64_t rx_total_raw;
 };
 #ifdef MM_BUILD_COMPRESSION
 #ifdef MM_HAVE_ZSTD
@@ -103,10 +112,6 @@ typedef struct zstd_stream {
 	mm_zpq_rx_func rx_func;
 	void *arg;
 	char const *rx_error; /* Decompress error message */
-	size_t tx_total;
-	size_t tx_total_raw;
-	size_t rx_total;
-	size_t rx_total_raw;
 	char tx_buf[MM_ZSTD_BUFFER_SIZE];
 	char rx_buf[MM_ZSTD_BUFFER_SIZE];
 } zstd_stream_t;
@@ -134,8 +139,6 @@ static mm_zpq_stream_t *zstd_create(mm_zpq_tx_func tx_func,
 	zs->tx_not_flushed = 0;
 	zs->rx_error = NULL;
 	zs->arg = arg;
-	zs->tx_total = zs->tx_total_raw = 0;
-	zs->rx_total = zs->rx_total_raw = 0;
 	zs->rx.size = rx_data_size;
 	zs->deferred_rx_call = 0;
 	assert(rx_data_size < MM_ZSTD_BUFFER_SIZE);
@@ -166,7 +169,6 @@ static ssize_t zstd_read(mm_zpq_stream_t *zstream, void *buf, size_t size)
 			/* Return result if we fill requested amount of bytes or read
 			 * operation was performed */
 			if (out.pos != 0) {
-				zs->rx_total_raw += out.pos;
 				zs->rx_buffered = 0;
 				return out.pos;
 			}
@@ -183,24 +185,25 @@ static ssize_t zstd_read(mm_zpq_stream_t *zstream, void *buf, size_t size)
 		if (rc > 0) /* read fetches some data */
 		{
 			zs->rx.size += rc;
-			zs->rx_total += rc;
+			zs->common.rx_total += rc;
 		} else /* read failed */
 		{
-			zs->rx_total_raw += out.pos;
 			return rc;
 		}
 	}
 }
 
-static ssize_t zstd_write(mm_zpq_stream_t *zstream, void const *buf,
-			  size_t size, size_t *processed)
+static ssize_t zstd_writev(mm_zpq_stream_t *zstream, struct iovec *iov,
+			   int n, size_t *processed)
 {
 	zstd_stream_t *zs = (zstd_stream_t *)zstream;
 	ssize_t rc;
+	size_t total = 0; /* Size of iovecs completely consumed by zstd */
+	int i = 0;
 	ZSTD_inBuffer in_buf;
-	in_buf.src = buf;
+	in_buf.src = iov[0].iov_base;
 	in_buf.pos = 0;
-	in_buf.size = size;
+	in_buf.size = iov[0].iov_len;
 
 	do {
 		if (zs->tx.pos == 0) /* Compress buffer is empty */
@@ -208,36 +211,46 @@ static ssize_t zstd_write(mm_zpq_stream_t *zstream, void const *buf,
 			zs->tx.dst =
 				zs->tx_buf; /* Reset pointer to the beginning of buffer */
 
-			if (in_buf.pos <
-			    size) /* Has something to compress in input buffer */
+			/* Compress iovecs one by one until the buffer is full */
+			while (i < n && zs->tx.pos < zs->tx.size) {
+				if (in_buf.pos == in_buf.size) {
+					total += in_buf.size;
+					if (++i == n)
+						break;
+					in_buf.src = iov[i].iov_base;
+					in_buf.pos = 0;
+					in_buf.size = iov[i].iov_len;
+					continue;
+				}
 				ZSTD_compressStream(zs->tx_stream, &zs->tx,
 						    &in_buf);
+			}
 
-			if (in_buf.pos ==
-			    size) /* All data is compressed: flushed internal zstd buffer */
+			if (i ==
+			    n) /* All data is compressed: flushed internal zstd buffer */
 			{
 				zs->tx_not_flushed = ZSTD_flushStream(
 					zs->tx_stream, &zs->tx);
 			}
 		}
+		if (zs->tx.pos == 0) /* Nothing to send yet */
+			continue;
 		rc = zs->tx_func(zs->arg, zs->tx.dst, zs->tx.pos);
 		if (rc > 0) {
 			zs->tx.pos -= rc;
 			zs->tx.dst = (char *)zs->tx.dst + rc;
-			zs->tx_total += rc;
+			zs->common.tx_total += rc;
 		} else {
-			*processed = in_buf.pos;
+			*processed = total + (i < n ? in_buf.pos : 0);
 			zs->tx_buffered = zs->tx.pos;
-			zs->tx_total_raw += in_buf.pos;
 			return rc;
 		}
 		/* repeat sending while there is some data in input or internal zstd
 		 * buffer */
-	} while (in_buf.pos < size || zs->tx_not_flushed);
+	} while (i < n || zs->tx_not_flushed);
 
-	zs->tx_total_raw += in_buf.pos;
 	zs->tx_buffered = zs->tx.pos;
-	return in_buf.pos;
+	return total;
 }
 
 static void zstd_free(mm_zpq_stream_t *zstream)
@@ -392,19 +405,23 @@ static ssize_t zlib_read(mm_zpq_stream_t *zstream, void *buf, size_t size)
 		zs->deferred_rx_call = 0;
 		if (rc > 0) {
 			zs->rx.avail_in += rc;
+			zs->common.rx_total += rc;
 		} else {
 			return rc;
 		}
 	}
 }
 
-static ssize_t zlib_write(mm_zpq_stream_t *zstream, void const *buf,
-			  size_t size, size_t *processed)
+static ssize_t zlib_writev(mm_zpq_stream_t *zstream, struct iovec *iov,
+			   int n, size_t *processed)
 {
 	zlib_stream_t *zs = (zlib_stream_t *)zstream;
 	int rc;
-	zs->tx.next_in = (Bytef *)buf;
-	zs->tx.avail_in = size;
+	size_t total = 0; /* Size of iovecs completely consumed by deflate */
+	int i = 0;
+	_Bool flushed = 0;
+	zs->tx.next_in = (Bytef *)iov[0].iov_base;
+	zs->tx.avail_in = iov[0].iov_len;
 	do {
 		if (zs->tx.avail_out ==
 		    MM_ZLIB_BUFFER_SIZE) /* Compress buffer is empty */
@@ -412,36 +429,50 @@ static ssize_t zlib_write(mm_zpq_stream_t *zstream, void const *buf,
 			zs->tx.next_out =
 				zs->tx_buf; /* Reset pointer to the  beginning of buffer */
 
-			if (zs->tx.avail_in != 0 ||
-			    (zs->tx_deflate_pending >
-			     0)) /* Has something in input or deflate buffer */
-			{
-				rc = deflate(&zs->tx, Z_SYNC_FLUSH);
-				assert(rc == Z_OK);
-				deflatePending(
-					&zs->tx, &zs->tx_deflate_pending,
-					Z_NULL); /* check if any data left in deflate buffer */
-				zs->tx.next_out =
-					zs->tx_buf; /* Reset pointer to the  beginning of buffer */
+			/* Deflate iovecs one by one until the buffer is full,
+			 * sync flush after the last one */
+			while (!flushed && zs->tx.avail_out > 0) {
+				if (zs->tx.avail_in == 0 && i < n - 1) {
+					total += iov[i].iov_len;
+					i++;
+					zs->tx.next_in = (Bytef *)iov[i].iov_base;
+					zs->tx.avail_in = iov[i].iov_len;
+					continue;
+				}
+				int last = i == n - 1;
+				rc = deflate(&zs->tx,
+					     last ? Z_SYNC_FLUSH : Z_NO_FLUSH);
+				assert(rc == Z_OK || rc == Z_BUF_ERROR);
+				if (last && zs->tx.avail_in == 0 &&
+				    zs->tx.avail_out > 0)
+					flushed = 1;
 			}
+			deflatePending(
+				&zs->tx, &zs->tx_deflate_pending,
+				Z_NULL); /* check if any data left in deflate buffer */
+			zs->tx.next_out =
+				zs->tx_buf; /* Reset pointer to the  beginning of buffer */
 		}
+		if (zs->tx.avail_out == MM_ZLIB_BUFFER_SIZE) /* Nothing to send */
+			continue;
 		rc = zs->tx_func(zs->arg, zs->tx.next_out,
 				 MM_ZLIB_BUFFER_SIZE - zs->tx.avail_out);
 		if (rc > 0) {
 			zs->tx.next_out += rc;
 			zs->tx.avail_out += rc;
+			zs->common.tx_total += rc;
 		} else {
-			*processed = size - zs->tx.avail_in;
+			*processed = total + iov[i].iov_len - zs->tx.avail_in;
 			zs->tx_buffered =
 				MM_ZLIB_BUFFER_SIZE - zs->tx.avail_out;
 			return rc;
 		}
 		/* repeat sending while there is some data in input or deflate buffer */
-	} while (zs->tx.avail_in != 0 || zs->tx_deflate_pending > 0);
+	} while (!flushed);
 
 	zs->tx_buffered = MM_ZLIB_BUFFER_SIZE - zs->tx.avail_out;
 
-	return size - zs->tx.avail_in;
+	return total + iov[i].iov_len;
 }
 
 static void zlib_free(mm_zpq_stream_t *zstream)
@@ -483,6 +514,248 @@ static char zlib_name(void)
 	return 'z';
 }
 
+#endif
+
+#ifdef MM_HAVE_LZ4
+
+#include <stdlib.h>
+#include <lz4frame.h>
+
+/* Size of rx buffer and the largest input of one LZ4F_compressUpdate() */
+#define MM_LZ4_BUFFER_SIZE (8 * 1024)
+
+typedef struct lz4_stream {
+	mm_zpq_stream_t common;
+	LZ4F_cctx *tx_ctx;
+	LZ4F_dctx *rx_ctx;
+	LZ4F_preferences_t prefs;
+	/* Compressed data, sized to fit LZ4F_compressBound() of the input */
+	char *tx_buf;
+	size_t tx_buf_size;
+	size_t tx_pos; /* Start of data not yet sent */
+	size_t tx_size; /* End of compressed data */
+	_Bool tx_begun; /* Frame header is written */
+	_Bool tx_not_flushed; /* Data consumed by lz4 context but not flushed */
+	size_t rx_pos;
+	size_t rx_size;
+	_Bool rx_more; /* Decompressed data might be left in lz4 context */
+	/* Flag that the last call of lz4_read did not call the rx_func */
+	_Bool deferred_rx_call;
+	mm_zpq_tx_func tx_func;
+	mm_zpq_rx_func rx_func;
+	void *arg;
+	char const *rx_error; /* Decompress error message */
+	char rx_buf[MM_LZ4_BUFFER_SIZE];
+} lz4_stream_t;
+
+static void lz4_free(mm_zpq_stream_t *zstream);
+
+static mm_zpq_stream_t *lz4_create(mm_zpq_tx_func tx_func,
+				   mm_zpq_rx_func rx_func, void *arg,
+				   char *rx_data, size_t rx_data_size)
+{
+	lz4_stream_t *zs = (lz4_stream_t *)mm_malloc(sizeof(lz4_stream_t));
+	if (zs == NULL)
+		return NULL;
+	memset(zs, 0, sizeof(lz4_stream_t));
+
+	/* fastest level, blocks are linked to keep the ratio for small
+	 * messages */
+	zs->prefs.frameInfo.blockSizeID = LZ4F_max64KB;
+	zs->prefs.frameInfo.blockMode = LZ4F_blockLinked;
+	zs->prefs.compressionLevel = 0;
+	zs->prefs.autoFlush = 0;
+
+	size_t rc;
+	rc = LZ4F_createCompressionContext(&zs->tx_ctx, LZ4F_VERSION);
+	if (LZ4F_isError(rc))
+		goto error;
+	rc = LZ4F_createDecompressionContext(&zs->rx_ctx, LZ4F_VERSION);
+	if (LZ4F_isError(rc))
+		goto error;
+
+	zs->tx_buf_size = LZ4F_HEADER_SIZE_MAX +
+			  LZ4F_compressBound(MM_LZ4_BUFFER_SIZE, &zs->prefs);
+	zs->tx_buf = mm_malloc(zs->tx_buf_size);
+	if (zs->tx_buf == NULL)
+		goto error;
+
+	zs->tx_func = tx_func;
+	zs->rx_func = rx_func;
+	zs->arg = arg;
+	assert(rx_data_size < MM_LZ4_BUFFER_SIZE);
+	memcpy(zs->rx_buf, rx_data, rx_data_size);
+	zs->rx_size = rx_data_size;
+
+	return (mm_zpq_stream_t *)zs;
+error:
+	lz4_free((mm_zpq_stream_t *)zs);
+	return NULL;
+}
+
+static ssize_t lz4_read(mm_zpq_stream_t *zstream, void *buf, size_t size)
+{
+	lz4_stream_t *zs = (lz4_stream_t *)zstream;
+	ssize_t rc;
+
+	for (;;) {
+		/* store the incomplete rx attempt flag */
+		zs->deferred_rx_call = 1;
+		if (zs->rx_pos != zs->rx_size || zs->rx_more) {
+			size_t dst_size = size;
+			size_t src_size = zs->rx_size - zs->rx_pos;
+			size_t hint;
+			hint = LZ4F_decompress(zs->rx_ctx, buf, &dst_size,
+					       zs->rx_buf + zs->rx_pos,
+					       &src_size, NULL);
+			if (LZ4F_isError(hint)) {
+				zs->rx_error = LZ4F_getErrorName(hint);
+				return MM_ZPQ_DECOMPRESS_ERROR;
+			}
+			zs->rx_pos += src_size;
+			if (zs->rx_pos == zs->rx_size)
+				zs->rx_pos = zs->rx_size = 0; /* Reset rx buffer */
+			/* output is full, more might be left in the context */
+			zs->rx_more = dst_size == size;
+			if (dst_size != 0)
+				return dst_size;
+		}
+		rc = zs->rx_func(zs->arg, zs->rx_buf + zs->rx_size,
+				 MM_LZ4_BUFFER_SIZE - zs->rx_size);
+		/* if we've made a call to rx function, reset the deferred rx flag */
+		zs->deferred_rx_call = 0;
+		if (rc > 0) {
+			zs->rx_size += rc;
+			zs->common.rx_total += rc;
+		} else {
+			return rc;
+		}
+	}
+}
+
+static ssize_t lz4_writev(mm_zpq_stream_t *zstream, struct iovec *iov, int n,
+			  size_t *processed)
+{
+	lz4_stream_t *zs = (lz4_stream_t *)zstream;
+	ssize_t rc;
+	size_t total = 0; /* Size of iovecs completely consumed by lz4 */
+	size_t pos = 0; /* Position in the current iovec */
+	int i = 0;
+	_Bool flushed = 0;
+	do {
+		if (zs->tx_pos == zs->tx_size) /* Compress buffer is empty */
+		{
+			zs->tx_pos = zs->tx_size = 0;
+			if (!zs->tx_begun) {
+				size_t size;
+				size = LZ4F_compressBegin(zs->tx_ctx, zs->tx_buf,
+							  zs->tx_buf_size,
+							  &zs->prefs);
+				assert(!LZ4F_isError(size));
+				zs->tx_size += size;
+				zs->tx_begun = 1;
+			}
+
+			/* Compress iovecs by chunks until the buffer is full,
+			 * flush after the last one */
+			while (!flushed) {
+				if (pos == iov[i].iov_len && i < n - 1) {
+					total += iov[i].iov_len;
+					i++;
+					pos = 0;
+					continue;
+				}
+				size_t left = zs->tx_buf_size - zs->tx_size;
+				size_t size;
+				if (pos < iov[i].iov_len) {
+					size_t chunk = iov[i].iov_len - pos;
+					if (chunk > MM_LZ4_BUFFER_SIZE)
+						chunk = MM_LZ4_BUFFER_SIZE;
+					if (left <
+					    LZ4F_compressBound(chunk, &zs->prefs))
+						break;
+					size = LZ4F_compressUpdate(
+						zs->tx_ctx,
+						zs->tx_buf + zs->tx_size, left,
+						(char *)iov[i].iov_base + pos,
+						chunk, NULL);
+					assert(!LZ4F_isError(size));
+					zs->tx_size += size;
+					zs->tx_not_flushed = 1;
+					pos += chunk;
+					continue;
+				}
+				if (left < LZ4F_compressBound(0, &zs->prefs))
+					break;
+				size = LZ4F_flush(zs->tx_ctx,
+						  zs->tx_buf + zs->tx_size, left,
+						  NULL);
+				assert(!LZ4F_isError(size));
+				zs->tx_size += size;
+				zs->tx_not_flushed = 0;
+				flushed = 1;
+			}
+		}
+		if (zs->tx_pos == zs->tx_size) /* Nothing to send */
+			continue;
+		rc = zs->tx_func(zs->arg, zs->tx_buf + zs->tx_pos,
+				 zs->tx_size - zs->tx_pos);
+		if (rc > 0) {
+			zs->tx_pos += rc;
+			zs->common.tx_total += rc;
+		} else {
+			*processed = total + pos;
+			return rc;
+		}
+		/* repeat sending while there is some data in input or lz4 context */
+	} while (!flushed);
+
+	return total + pos;
+}
+
+static void lz4_free(mm_zpq_stream_t *zstream)
+{
+	lz4_stream_t *zs = (lz4_stream_t *)zstream;
+	if (zs != NULL) {
+		if (zs->tx_ctx)
+			LZ4F_freeCompressionContext(zs->tx_ctx);
+		if (zs->rx_ctx)
+			LZ4F_freeDecompressionContext(zs->rx_ctx);
+		if (zs->tx_buf)
+			mm_free(zs->tx_buf);
+		mm_free(zs);
+	}
+}
+
+static char const *lz4_error(mm_zpq_stream_t *zstream)
+{
+	lz4_stream_t *zs = (lz4_stream_t *)zstream;
+	return zs->rx_error;
+}
+
+static size_t lz4_buffered_tx(mm_zpq_stream_t *zstream)
+{
+	lz4_stream_t *zs = (lz4_stream_t *)zstream;
+	return zs != NULL ? zs->tx_size - zs->tx_pos + zs->tx_not_flushed : 0;
+}
+
+static size_t lz4_buffered_rx(mm_zpq_stream_t *zstream)
+{
+	lz4_stream_t *zs = (lz4_stream_t *)zstream;
+	return zs != NULL ? zs->rx_size - zs->rx_pos + zs->rx_more : 0;
+}
+
+static _Bool lz4_deferred_rx(mm_zpq_stream_t *zstream)
+{
+	lz4_stream_t *zs = (lz4_stream_t *)zstream;
+	return zs != NULL ? zs->deferred_rx_call : 0;
+}
+
+static char lz4_name(void)
+{
+	return 'l';
+}
+
 #endif
 #endif
 
@@ -493,12 +766,16 @@ static zpq_algorithm_t const zpq_algorithms[] = {
 
 #ifdef MM_BUILD_COMPRESSION
 #ifdef MM_HAVE_ZSTD
-	{ zstd_name, zstd_create, zstd_read, zstd_write, zstd_free, zstd_error,
-	  zstd_buffered_tx, zstd_buffered_rx, zstd_deferred_rx },
+	{ zstd_name, zstd_create, zstd_read, zstd_writev, zstd_free,
+	  zstd_error, zstd_buffered_tx, zstd_buffered_rx, zstd_deferred_rx },
 #endif
 #ifdef MM_HAVE_ZLIB
-	{ zlib_name, zlib_create, zlib_read, zlib_write, zlib_free, zlib_error,
-	  zlib_buffered_tx, zlib_buffered_rx, zlib_deferred_rx },
+	{ zlib_name, zlib_create, zlib_read, zlib_writev, zlib_free,
+	  zlib_error, zlib_buffered_tx, zlib_buffered_rx, zlib_deferred_rx },
+#endif
+#ifdef MM_HAVE_LZ4
+	{ lz4_name, lz4_create, lz4_read, lz4_writev, lz4_free, lz4_error,
+	  lz4_buffered_tx, lz4_buffered_rx, lz4_deferred_rx },
 #endif
 #endif
 	{ NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL }
@@ -513,20 +790,54 @@ mm_zpq_stream_t *zpq_create(int algorithm_impl, mm_zpq_tx_func tx_func,
 {
 	mm_zpq_stream_t *stream = zpq_algorithms[algorithm_impl].create(
 		tx_func, rx_func, arg, rx_data, rx_data_size);
-	if (stream)
+	if (stream) {
 		stream->algorithm = &zpq_algorithms[algorithm_impl];
+		stream->tx_total = stream->tx_total_raw = 0;
+		stream->rx_total = stream->rx_total_raw = 0;
+	}
 	return stream;
 }
 
 ssize_t mm_zpq_read(mm_zpq_stream_t *zs, void *buf, size_t size)
 {
-	return zs->algorithm->read(zs, buf, size);
+	ssize_t rc = zs->algorithm->read(zs, buf, size);
+	if (rc > 0)
+		zs->rx_total_raw += rc;
+	return rc;
+}
+
+ssize_t mm_zpq_writev(mm_zpq_stream_t *zs, struct iovec *iov, int n,
+		      size_t *processed)
+{
+	/* empty write flushes buffered data */
+	struct iovec empty = { NULL, 0 };
+	if (n == 0) {
+		iov = &empty;
+		n = 1;
+	}
+	*processed = 0;
+	ssize_t rc = zs->algorithm->writev(zs, iov, n, processed);
+	if (rc > 0)
+		zs->tx_total_raw += rc;
+	else
+		zs->tx_total_raw += *processed;
+	return rc;
 }
 
 ssize_t mm_zpq_write(mm_zpq_stream_t *zs, void const *buf, size_t size,
 		     size_t *processed)
 {
-	return zs->algorithm->write(zs, buf, size, processed);
+	struct iovec iov = { (void *)buf, size };
+	return mm_zpq_writev(zs, &iov, 1, processed);
+}
+
+void mm_zpq_stat(mm_zpq_stream_t *zs, uint64_t *tx_raw, uint64_t *tx,
+		 uint64_t *rx_raw, uint64_t *rx)
+{
+	*tx_raw = zs->tx_total_raw;
+	*tx = zs->tx_total;
+	*rx_raw = zs->rx_total_raw;
+	*rx = zs->rx_total;
 }
 
 void mm_zpq_free(mm_zpq_stream_t *zs)
@@ -557,7 +868,8 @@ _Bool mm_zpq_deferred_rx(mm_zpq_stream_t *zs)
 
 /*
  * Get list of the supported algorithms.
- * Each algorithm is identified by one letter: 'f' - Facebook zstd, 'z' - zlib.
+ * Each algorithm is identified by one letter: 'f' - Facebook zstd, 'z' - zlib,
+ * 'l' - lz4.
  * Algorithm identifies are appended to the provided buffer and terminated by
  * '\0'.
  */
@@ -7,6 +7,8 @@
  */
 
 #include <stdlib.h>
+#include <stdint.h>
+#include <sys/uio.h>
 
 #define MM_ZPQ_IO_ERROR (-1)
 #define MM_ZPQ_DECOMPRESS_ERROR (-2)
@@ -25,6 +27,10 @@ mm_zpq_stream_t *zpq_create(int impl, mm_zpq_tx_func tx_func,
 ssize_t mm_zpq_read(mm_zpq_stream_t *zs, void *buf, size_t size);
 ssize_t mm_zpq_write(mm_zpq_stream_t *zs, void const *buf, size_t size,
 		     size_t *processed);
+ssize_t mm_zpq_writev(mm_zpq_stream_t *zs, struct iovec *iov, int n,
+		      size_t *processed);
+void mm_zpq_stat(mm_zpq_stream_t *zs, uint64_t *tx_raw, uint64_t *tx,
+		 uint64_t *rx_raw, uint64_t *rx);
 char const *mm_zpq_error(mm_zpq_stream_t *zs);
 size_t mm_zpq_buffered_tx(mm_zpq_stream_t *zs);
 size_t mm_zpq_buffered_rx(mm_zpq_stream_t *zs);